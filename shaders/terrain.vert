@@ -1,16 +1,22 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 struct ChunkHeightmapLink {
     ivec2 worldPos;
     uint instanceId;
     uint isVisible;
+    float minHeight;
+    float maxHeight;
+    uint padding0;
+    uint padding1;
 };
 
-layout(set = 0, binding = 0) uniform sampler2DArray heightmapSampler;
-
-layout(std430, set = 0, binding = 1) readonly buffer ChunkBuffer {
+// The bindless heap, see DescriptorHeap
+layout(set = 0, binding = 0) uniform texture2DArray textures2DArray[];
+layout(set = 0, binding = 1) uniform sampler samplers[];
+layout(std430, set = 0, binding = 2) readonly buffer ChunkBuffer {
     ChunkHeightmapLink chunks[];
-} chunkLinkDataBuffer;
+} chunkBuffers[];
 
 layout(location = 0) out vec2 texCoord;
 layout(location = 1) out vec3 debugColor;
@@ -19,6 +25,10 @@ layout(push_constant) uniform PushConstants {
     mat4 lookAt;
     vec3 playerPos;
     float padding;
+    uint heightmapImage;
+    uint heightmapSampler;
+    uint linksBuffer;
+    uint linksFirst;
 } terrain_push;
 
 const int RESOLUTION = 64;
@@ -26,12 +36,8 @@ const float GRID_SIZE = 20.0;
 const float HEIGHT_SCALE = 5.0;
 
 void main() {
-    ChunkHeightmapLink currentChunk = chunkLinkDataBuffer.chunks[gl_InstanceIndex];
-
-    if (currentChunk.isVisible == 0) {
-        gl_Position = vec4(0.0/0.0);
-        return;
-    }
+    // Only chunks terrain_cull.comp let through get drawn, their link index is the draw's firstInstance
+    ChunkHeightmapLink currentChunk = chunkBuffers[terrain_push.linksBuffer].chunks[terrain_push.linksFirst + gl_InstanceIndex];
 
     float chunkOffsetX = float(currentChunk.worldPos.x) * GRID_SIZE;
     float chunkOffsetZ = float(currentChunk.worldPos.y) * GRID_SIZE;
@@ -46,7 +52,10 @@ void main() {
     float localX = u * GRID_SIZE;
     float localZ = v * GRID_SIZE;
 
-    float height = texture(heightmapSampler, vec3(u, v, float(gl_InstanceIndex))).r;
+    // Layers are toroidally addressed by world position, the link knows which one is ours.
+    // Every vertex sits on a texel, fetched as is so TerrainHeightfield matches it exactly.
+    sampler2DArray heightmap = sampler2DArray(textures2DArray[terrain_push.heightmapImage], samplers[terrain_push.heightmapSampler]);
+    float height = texelFetch(heightmap, ivec3(xIndex, zIndex, int(currentChunk.instanceId)), 0).r;
     vec3 finalWorldPos = vec3(localZ + chunkOffsetX, height * HEIGHT_SCALE, localX + chunkOffsetZ);
 
     gl_Position = terrain_push.lookAt * vec4(finalWorldPos, 1.0);
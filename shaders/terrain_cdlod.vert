@@ -0,0 +1,90 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+struct ChunkHeightmapLink {
+    ivec2 worldPos;
+    uint instanceId;
+    uint isVisible;
+    float minHeight;
+    float maxHeight;
+    uint padding0;
+    uint padding1;
+};
+
+struct TerrainLodNode {
+    uint link;
+    uint lod;
+    vec2 origin;
+};
+
+// The bindless heap, see DescriptorHeap
+layout(set = 0, binding = 0) uniform texture2DArray textures2DArray[];
+layout(set = 0, binding = 1) uniform sampler samplers[];
+layout(std430, set = 0, binding = 2) readonly buffer ChunkBuffer {
+    ChunkHeightmapLink chunks[];
+} chunkBuffers[];
+layout(std430, set = 0, binding = 2) readonly buffer NodeBuffer {
+    TerrainLodNode nodes[];
+} nodeBuffers[];
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) out vec3 debugColor;
+
+layout(push_constant) uniform PushConstants {
+    mat4 lookAt;
+    vec3 playerPos;
+    float padding;
+    uint heightmapImage;
+    uint heightmapSampler;
+    uint linksBuffer;
+    uint linksFirst;
+    uint nodesBuffer;
+    uint nodesFirst;
+    float leafRange;
+    float morphStart;
+} terrain_push;
+
+// Gotta match TerrainConfig::Lod and terrain.vert
+const int PATCH_QUADS = 8;
+const int LOD_COUNT = 4;
+const float GRID_SIZE = 20.0;
+const float HEIGHT_SCALE = 5.0;
+
+// Same placement as terrain.vert, uv is the chunk's heightmap uv
+vec3 worldPosition(ChunkHeightmapLink chunk, vec2 uv) {
+    sampler2DArray heightmap = sampler2DArray(textures2DArray[terrain_push.heightmapImage], samplers[terrain_push.heightmapSampler]);
+    float height = texture(heightmap, vec3(uv, float(chunk.instanceId))).r;
+    return vec3(
+        (uv.y + float(chunk.worldPos.x)) * GRID_SIZE,
+        height * HEIGHT_SCALE,
+        (uv.x + float(chunk.worldPos.y)) * GRID_SIZE
+    );
+}
+
+void main() {
+    TerrainLodNode node = nodeBuffers[terrain_push.nodesBuffer].nodes[terrain_push.nodesFirst + gl_InstanceIndex];
+    ChunkHeightmapLink chunk = chunkBuffers[terrain_push.linksBuffer].chunks[terrain_push.linksFirst + node.link];
+
+    float nodeSize = exp2(float(int(node.lod) - (LOD_COUNT - 1)));
+    vec2 grid = vec2(gl_VertexIndex % (PATCH_QUADS + 1), gl_VertexIndex / (PATCH_QUADS + 1));
+    vec3 worldPos = worldPosition(chunk, node.origin + grid / float(PATCH_QUADS) * nodeSize);
+
+    // Towards the end of its range a vertex slides onto the parent's grid, by the time the
+    // parent takes over the odd vertices sit exactly on its edges. Chunks have no parent.
+    float range = terrain_push.leafRange * exp2(float(node.lod));
+    float morph = 0.0;
+    if (int(node.lod) < LOD_COUNT - 1) {
+        float morphStart = range * terrain_push.morphStart;
+        morph = clamp((distance(worldPos, terrain_push.playerPos) - morphStart) / (range - morphStart), 0.0, 1.0);
+    }
+    grid -= fract(grid * 0.5) * 2.0 * morph;
+
+    vec2 uv = node.origin + grid / float(PATCH_QUADS) * nodeSize;
+    texCoord = uv;
+    gl_Position = terrain_push.lookAt * vec4(worldPosition(chunk, uv), 1.0);
+
+    // Checker per chunk, darker the coarser the node
+    bool checker = ((chunk.worldPos.x + chunk.worldPos.y) % 2) == 0;
+    vec3 chunkColor = checker ? vec3(0.8, 0.2, 0.2) : vec3(0.2, 0.2, 0.8);
+    debugColor = chunkColor * (1.0 - 0.15 * float(node.lod));
+}
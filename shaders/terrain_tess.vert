@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) out vec2 outUv;
+layout(location = 1) out uint outLink;
+
+// Gotta match TerrainConfig::Tessellation
+const int PATCHES = 4;
+
+void main() {
+    // Control points only, heights come in terrain_tess.tese once the patch is subdivided
+    int x = gl_VertexIndex % (PATCHES + 1);
+    int z = gl_VertexIndex / (PATCHES + 1);
+    outUv = vec2(x, z) / float(PATCHES);
+
+    // Only chunks terrain_cull.comp let through get drawn, their link index is the draw's firstInstance
+    outLink = uint(gl_InstanceIndex);
+}
@@ -0,0 +1,292 @@
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/BoundedQueue.hpp"
+#include "Utils/WorkStealingDeque.hpp"
+
+namespace JobSystem {
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::function<void()> Fn;
+        Counter* Done;
+    };
+
+    struct alignas(64) ThreadStats {
+        std::atomic<uint64_t> BusyNs = 0;
+        std::atomic<uint64_t> Executed = 0;
+        std::atomic<uint64_t> Stolen = 0;
+    };
+
+    constexpr uint32_t MAIN_THREAD_INDEX = 0;
+    constexpr uint32_t SPINS_BEFORE_SLEEP = 64;
+
+    // Every index handed out comes from FreeJobs, so no queue below can ever overflow
+    std::vector<Job> Jobs(MAX_JOBS);
+    BoundedQueue<uint32_t, MAX_JOBS> FreeJobs;
+    BoundedQueue<uint32_t, MAX_JOBS> MainJobs;
+    // Jobs spawned from threads the system doesn't own
+    BoundedQueue<uint32_t, MAX_JOBS> ExternalJobs;
+
+    // Index 0 is the main thread, workers go from 1
+    std::vector<std::unique_ptr<WorkStealingDeque<uint32_t, MAX_JOBS>>> Deques;
+    std::unique_ptr<ThreadStats[]> Stats;
+
+    std::vector<std::thread> Workers;
+    std::atomic<bool> Running = false;
+    // Bumped on every push, idle workers sleep on it
+    std::atomic<uint32_t> WorkSignal = 0;
+
+    thread_local int32_t ThreadIndex = -1;
+    thread_local uint32_t StealSeed = 0x9E3779B9u;
+
+    uint32_t ThreadCount() {
+        return static_cast<uint32_t>(Deques.size());
+    }
+
+    void Execute(uint32_t JobIndex) {
+        Clock::time_point Begin = Clock::now();
+
+        Job& Current = Jobs[JobIndex];
+        Current.Fn();
+
+        Counter* Done = Current.Done;
+        Current.Fn = nullptr;
+        FreeJobs.TryPush(JobIndex);
+
+        if (ThreadIndex >= 0) {
+            ThreadStats& Self = Stats[ThreadIndex];
+            uint64_t Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - Begin).count();
+            Self.BusyNs.fetch_add(Elapsed, std::memory_order_relaxed);
+            Self.Executed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (Done) {
+            Done->Pending.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    bool TrySteal(uint32_t Self, uint32_t& JobIndex) {
+        uint32_t Count = ThreadCount();
+        if (Count < 2) {
+            return false;
+        }
+
+        // xorshift, just to spread thieves over victims
+        StealSeed ^= StealSeed << 13;
+        StealSeed ^= StealSeed >> 17;
+        StealSeed ^= StealSeed << 5;
+
+        uint32_t Start = StealSeed % Count;
+        for (uint32_t i = 0; i < Count; i++) {
+            uint32_t Victim = (Start + i) % Count;
+            if (Victim != Self && Deques[Victim]->Steal(JobIndex)) {
+                Stats[Self].Stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool FindJob(uint32_t& JobIndex) {
+        if (ThreadIndex < 0) {
+            return ExternalJobs.TryPop(JobIndex);
+        }
+
+        uint32_t Self = static_cast<uint32_t>(ThreadIndex);
+        if (Self == MAIN_THREAD_INDEX && MainJobs.TryPop(JobIndex)) {
+            return true;
+        }
+        if (Deques[Self]->Pop(JobIndex)) {
+            return true;
+        }
+        if (ExternalJobs.TryPop(JobIndex)) {
+            return true;
+        }
+        return TrySteal(Self, JobIndex);
+    }
+
+    bool TryRunOne() {
+        uint32_t JobIndex;
+        if (!FindJob(JobIndex)) {
+            return false;
+        }
+        Execute(JobIndex);
+        return true;
+    }
+
+    void WorkerMain(uint32_t Index) {
+        ThreadIndex = static_cast<int32_t>(Index);
+        StealSeed ^= Index * 0x85EBCA6Bu;
+
+        uint32_t IdleSpins = 0;
+        while (Running.load(std::memory_order_acquire)) {
+            // Read before looking for work, a push in between changes it and wait won't sleep
+            uint32_t Seen = WorkSignal.load(std::memory_order_acquire);
+
+            if (TryRunOne()) {
+                IdleSpins = 0;
+                continue;
+            }
+
+            if (++IdleSpins < SPINS_BEFORE_SLEEP) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            WorkSignal.wait(Seen, std::memory_order_acquire);
+            IdleSpins = 0;
+        }
+    }
+
+    void Create(uint32_t WorkerCount) {
+        if (WorkerCount == 0) {
+            uint32_t HardwareThreads = std::thread::hardware_concurrency();
+            WorkerCount = HardwareThreads > 1 ? HardwareThreads - 1 : 1;
+        }
+        WorkerCount = std::clamp(WorkerCount, 1u, MAX_WORKER_COUNT);
+
+        for (uint32_t i = 0; i < MAX_JOBS; i++) {
+            FreeJobs.TryPush(i);
+        }
+
+        uint32_t Count = WorkerCount + 1;
+        Deques.clear();
+        for (uint32_t i = 0; i < Count; i++) {
+            Deques.push_back(std::make_unique<WorkStealingDeque<uint32_t, MAX_JOBS>>());
+        }
+        Stats = std::make_unique<ThreadStats[]>(Count);
+
+        ThreadIndex = MAIN_THREAD_INDEX;
+        Running.store(true, std::memory_order_release);
+
+        Workers.reserve(WorkerCount);
+        for (uint32_t i = 1; i < Count; i++) {
+            Workers.emplace_back(WorkerMain, i);
+        }
+
+        spdlog::info("Job system started with {} workers", WorkerCount);
+    }
+
+    void Destroy() {
+        // Systems WaitFor their own counters before this, anything left is just flushed
+        while (TryRunOne()) {}
+
+        Running.store(false, std::memory_order_release);
+        WorkSignal.fetch_add(1, std::memory_order_release);
+        WorkSignal.notify_all();
+
+        for (std::thread& Worker : Workers) {
+            Worker.join();
+        }
+        Workers.clear();
+
+        uint32_t JobIndex;
+        while (FreeJobs.TryPop(JobIndex)) {}
+        Deques.clear();
+        ThreadIndex = -1;
+    }
+
+    void Run(std::function<void()> Fn, Counter* Done, Affinity Where) {
+        if (Done) {
+            Done->Pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint32_t JobIndex;
+        while (!FreeJobs.TryPop(JobIndex)) {
+            // Out of job slots, make some room ourselves
+            if (!TryRunOne()) {
+                std::this_thread::yield();
+            }
+        }
+        Jobs[JobIndex] = { .Fn = std::move(Fn), .Done = Done };
+
+        if (Where == Affinity::Main) {
+            MainJobs.TryPush(JobIndex);
+            return;
+        }
+
+        if (ThreadIndex >= 0) {
+            Deques[ThreadIndex]->Push(JobIndex);
+        } else {
+            ExternalJobs.TryPush(JobIndex);
+        }
+
+        WorkSignal.fetch_add(1, std::memory_order_release);
+        WorkSignal.notify_one();
+    }
+
+    void WaitFor(const Counter& Done) {
+        while (!Done.IsDone()) {
+            if (!TryRunOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool IsMainThread() {
+        return ThreadIndex == MAIN_THREAD_INDEX;
+    }
+
+    uint32_t GetWorkerCount() {
+        return static_cast<uint32_t>(Workers.size());
+    }
+
+    std::vector<ThreadActivity> GetThreadActivity() {
+        std::vector<ThreadActivity> Activity(ThreadCount());
+        for (uint32_t i = 0; i < ThreadCount(); i++) {
+            Activity[i] = {
+                .BusyNs = Stats[i].BusyNs.load(std::memory_order_relaxed),
+                .Executed = Stats[i].Executed.load(std::memory_order_relaxed),
+                .Stolen = Stats[i].Stolen.load(std::memory_order_relaxed)
+            };
+        }
+        return Activity;
+    }
+
+    TaskGraph::TaskId TaskGraph::Add(const char* Name, Affinity Where, std::function<void()> Fn) {
+        Task& NewTask = Tasks.emplace_back();
+        NewTask.Name = Name;
+        NewTask.Where = Where;
+        NewTask.Fn = std::move(Fn);
+        return static_cast<TaskId>(Tasks.size() - 1);
+    }
+
+    void TaskGraph::Depend(TaskId Dependent, TaskId DependsOn) {
+        Tasks[DependsOn].Successors.push_back(Dependent);
+        Tasks[Dependent].DependencyCount++;
+    }
+
+    void TaskGraph::Submit(TaskId Id) {
+        Run([this, Id] {
+            Task& Current = Tasks[Id];
+            Current.Fn();
+
+            // Successors are submitted before this job drops Done, so Done can't hit zero
+            // while the graph still has work left
+            for (TaskId Successor : Current.Successors) {
+                if (Tasks[Successor].Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    Submit(Successor);
+                }
+            }
+        }, &Done, Tasks[Id].Where);
+    }
+
+    void TaskGraph::Execute() {
+        for (Task& Current : Tasks) {
+            Current.Remaining.store(Current.DependencyCount, std::memory_order_relaxed);
+        }
+        for (TaskId i = 0; i < Tasks.size(); i++) {
+            if (Tasks[i].DependencyCount == 0) {
+                Submit(i);
+            }
+        }
+        WaitFor(Done);
+    }
+};
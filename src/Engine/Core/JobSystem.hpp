@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+// Engine wide job system.
+//
+// Every thread taking part (the main thread plus WORKER_COUNT workers) owns a work stealing
+// deque, jobs spawned from a thread land on its own deque and idle threads steal from the
+// others. Jobs with Affinity::Main go to a separate queue only the main thread drains, that's
+// where anything touching GLFW, ImGui or the Vulkan queues belongs.
+//
+// Completion is tracked with counters: Run bumps the counter, the job drops it when done and
+// WaitFor keeps running other jobs until it reaches zero, so waiting never idles a core.
+namespace JobSystem {
+    // 0 means hardware_concurrency - 1 workers
+    static constexpr uint32_t WORKER_COUNT = 0;
+    static constexpr uint32_t MAX_WORKER_COUNT = 63;
+
+    // Jobs alive at once, Run helps out until a slot frees up past that
+    static constexpr uint32_t MAX_JOBS = 4096;
+
+    enum class Affinity {
+        Any,
+        Main
+    };
+
+    struct Counter {
+        std::atomic<uint32_t> Pending = 0;
+
+        bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    struct ThreadActivity {
+        uint64_t BusyNs;
+        uint64_t Executed;
+        uint64_t Stolen;
+    };
+
+    // The calling thread becomes the main thread
+    void Create(uint32_t WorkerCount = WORKER_COUNT);
+    void Destroy();
+
+    void Run(std::function<void()> Fn, Counter* Done = nullptr, Affinity Where = Affinity::Any);
+    // Runs other jobs until Done reaches zero. Waiting on Main jobs from a worker never returns.
+    void WaitFor(const Counter& Done);
+
+    bool IsMainThread();
+    uint32_t GetWorkerCount();
+
+    // Totals since Create, index 0 is the main thread
+    std::vector<ThreadActivity> GetThreadActivity();
+
+    // Worker utilization window, main thread (JobSystemUI.cpp, headless tools leave it out)
+    void UpdateUI();
+
+    // Static graph of tasks with dependencies, built once and executed every frame.
+    class TaskGraph {
+    public:
+        using TaskId = uint32_t;
+
+        TaskId Add(const char* Name, Affinity Where, std::function<void()> Fn);
+        // Dependent won't start before DependsOn finished. No cycles, they'd hang Execute.
+        void Depend(TaskId Dependent, TaskId DependsOn);
+
+        // Runs every task once, the caller helps until all of them are done. Must be called
+        // from the main thread if any task has Affinity::Main.
+        void Execute();
+
+    private:
+        struct Task {
+            const char* Name;
+            Affinity Where;
+            std::function<void()> Fn;
+            std::vector<TaskId> Successors;
+            uint32_t DependencyCount = 0;
+            std::atomic<uint32_t> Remaining = 0;
+        };
+
+        // Deque so tasks (and their atomics) never move
+        std::deque<Task> Tasks;
+        Counter Done;
+
+        void Submit(TaskId Id);
+    };
+};
@@ -0,0 +1,79 @@
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+#include <imgui.h>
+
+namespace JobSystem {
+    using Clock = std::chrono::steady_clock;
+
+    // What UpdateUI shows, main thread only
+    struct ThreadSample {
+        uint64_t BusyNs = 0;
+        uint64_t Executed = 0;
+        uint64_t Stolen = 0;
+        float Utilization = 0.0f;
+        float JobsPerFrame = 0.0f;
+    };
+
+    std::vector<ThreadSample> Samples;
+    Clock::time_point LastSample = Clock::now();
+
+    void UpdateUI() {
+        Clock::time_point Now = Clock::now();
+        float ElapsedNs = static_cast<float>(std::chrono::duration_cast<std::chrono::nanoseconds>(Now - LastSample).count());
+        LastSample = Now;
+
+        std::vector<ThreadActivity> Activity = GetThreadActivity();
+        Samples.resize(Activity.size());
+
+        // Smoothed a bit, raw per frame numbers flicker too much to read
+        constexpr float SMOOTHING = 0.1f;
+
+        float TotalUtilization = 0.0f;
+        for (size_t i = 0; i < Activity.size(); i++) {
+            ThreadSample& Sample = Samples[i];
+            const ThreadActivity& Current = Activity[i];
+
+            float Utilization = ElapsedNs > 0.0f ? std::min(float(Current.BusyNs - Sample.BusyNs) / ElapsedNs, 1.0f) : 0.0f;
+            Sample.Utilization += (Utilization - Sample.Utilization) * SMOOTHING;
+            Sample.JobsPerFrame += (float(Current.Executed - Sample.Executed) - Sample.JobsPerFrame) * SMOOTHING;
+
+            Sample.BusyNs = Current.BusyNs;
+            Sample.Executed = Current.Executed;
+            Sample.Stolen = Current.Stolen;
+            TotalUtilization += Sample.Utilization;
+        }
+
+        ImGui::SetNextWindowSize(ImVec2(0.0f, 0.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Job System");
+
+        ImGui::TextDisabled("Threads:");
+        ImGui::Indent();
+        ImGui::Text("Workers: %u + main", GetWorkerCount());
+        ImGui::Text("Busy cores: %.2f", TotalUtilization);
+        ImGui::Unindent();
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        ImGui::TextDisabled("Utilization:");
+        ImGui::Indent();
+        for (size_t i = 0; i < Samples.size(); i++) {
+            const ThreadSample& Sample = Samples[i];
+
+            char Overlay[64];
+            snprintf(Overlay, sizeof(Overlay), "%s%zu %.0f%% (%.1f jobs, %llu stolen)",
+                i == 0 ? "Main " : "Worker ", i,
+                Sample.Utilization * 100.0f, Sample.JobsPerFrame,
+                static_cast<unsigned long long>(Sample.Stolen));
+            ImGui::ProgressBar(Sample.Utilization, ImVec2(260.0f, 0.0f), Overlay);
+        }
+        ImGui::Unindent();
+
+        ImGui::End();
+    }
+};
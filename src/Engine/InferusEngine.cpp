@@ -7,7 +7,10 @@
 
 #include "Engine/Core/Input.hpp"
 #include "Engine/Core/Window.hpp"
+#include "Engine/Core/JobSystem.hpp"
 #include "Engine/Systems/Terrain/TerrainSystem.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+#include "Engine/InferusRenderer/Profiler/GpuProfiler.hpp"
 
 namespace InferusEngine {
     InferusResult Init(){
@@ -19,6 +22,7 @@ namespace InferusEngine {
         }
 
         Input::Create();
+        JobSystem::Create();
 
         auto RendererResult = InferusRenderer.Create();
         if (RendererResult != InferusResult::SUCCESS) {
@@ -26,8 +30,9 @@ namespace InferusEngine {
             return InferusResult::FAIL;
         }
 
-        TerrainSystem::Create(&Camera.Position);
+        TerrainSystem::Create(&Camera.Position, &InferusRenderer.TerrainRenderer.TerrainPushConstants.CameraMVP);
         InferusRenderer.TerrainRenderer.FeedTerrainSystemPointers();
+        InferusRenderer.TerrainRenderer.FeedCamera(&Camera.Position);
         Camera.Init(float(WIDTH)/float(HEIGHT), &InferusRenderer.TerrainRenderer.TerrainPushConstants.CameraMVP);
 
         return InferusResult::SUCCESS;
@@ -37,28 +42,68 @@ namespace InferusEngine {
         Window::Destroy();
         Input::Destroy();
         TerrainSystem::Destroy();
+        JobSystem::Destroy();
         InferusRenderer.Destroy();
     }
 
+    void BuildFrameGraph(JobSystem::TaskGraph& Graph, const float& DeltaTime) {
+        using JobSystem::Affinity;
+
+        // Anything touching GLFW, ImGui or a VkQueue stays on the main thread
+        auto ImGuiBegin = Graph.Add("ImGui begin", Affinity::Main, []{ InferusRenderer.EarlyRender(); });
+        auto CameraUpdate = Graph.Add("Camera", Affinity::Any, [&DeltaTime]{ Camera.Update(DeltaTime); });
+        auto WindowEvents = Graph.Add("Window events", Affinity::Main, []{ Window::Update(); });
+        auto InputPoll = Graph.Add("Input", Affinity::Main, []{ Input::PollInput(); });
+        auto TerrainUpdate = Graph.Add("Terrain", Affinity::Any, []{ TerrainSystem::Update(); });
+        auto TerrainUpload = Graph.Add("Terrain upload", Affinity::Main, []{ InferusRenderer.TerrainRenderer.UploadDirtyChunks(); });
+        auto TerrainUI = Graph.Add("Terrain UI", Affinity::Main, []{ TerrainSystem::UpdateUI(); });
+        auto TerrainRendererUI = Graph.Add("Terrain renderer UI", Affinity::Main, []{ InferusRenderer.TerrainRenderer.UpdateUI(); });
+        auto StatsUI = Graph.Add("Stats UI", Affinity::Main, [&DeltaTime]{ OutFps(DeltaTime); JobSystem::UpdateUI(); GpuProfiler::UpdateUI(); });
+        auto Record = Graph.Add("Record", Affinity::Main, []{ InferusRenderer.LateRender(); });
+
+        // Camera consumes last frame's input, so it has to run before GLFW and the key
+        // callbacks touch it again
+        Graph.Depend(WindowEvents, ImGuiBegin);
+        Graph.Depend(WindowEvents, CameraUpdate);
+        Graph.Depend(InputPoll, WindowEvents);
+
+        Graph.Depend(TerrainUpdate, CameraUpdate);
+        Graph.Depend(TerrainUpload, TerrainUpdate);
+        Graph.Depend(TerrainUpload, WindowEvents);
+        Graph.Depend(TerrainUI, TerrainUpdate);
+        Graph.Depend(TerrainUI, ImGuiBegin);
+        Graph.Depend(TerrainRendererUI, ImGuiBegin);
+        Graph.Depend(StatsUI, ImGuiBegin);
+
+        Graph.Depend(Record, InputPoll);
+        Graph.Depend(Record, TerrainUpload);
+        Graph.Depend(Record, TerrainUI);
+        Graph.Depend(Record, TerrainRendererUI);
+        Graph.Depend(Record, StatsUI);
+    }
+
     void Run() {
+        float DeltaTime = 0.0f;
+        JobSystem::TaskGraph FrameGraph;
+        BuildFrameGraph(FrameGraph, DeltaTime);
+
         auto LastFrameTime = std::chrono::high_resolution_clock::now();
         while (!ShouldClose && !Window::ShouldClose()) {
             auto FrameBegin = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<float> DeltaTimeRaw = LastFrameTime - FrameBegin;
-            float DeltaTime = DeltaTimeRaw.count();
+            std::chrono::duration<float> DeltaTimeRaw = FrameBegin - LastFrameTime;
+            DeltaTime = DeltaTimeRaw.count();
             LastFrameTime = FrameBegin;
 
-            InferusRenderer.EarlyRender();
-            Camera.Update(DeltaTime);
-            Window::Update();
-            TerrainSystem::Update();
-            OutFps(DeltaTime);
-            Input::PollInput();
+            FrameGraph.Execute();
 
-            InferusRenderer.LateRender();
+            // A capture on start is the whole run
+            if (RendererConfig::TerrainRenderer::CAPTURE_ON_START && !InferusRenderer.TerrainRenderer.Capturing) {
+                ShouldClose = true;
+            }
 
             auto FrameEnd = std::chrono::high_resolution_clock::now();
-            auto ElapsedTime = FrameBegin - FrameEnd;
+            auto ElapsedTime = FrameEnd - FrameBegin;
+            TerrainSystem::ReportFrameTime(ElapsedTime, FRAME_TARGET_TIME);
 
             if ( ElapsedTime < FRAME_TARGET_TIME ) {
                 std::this_thread::sleep_for(FRAME_TARGET_TIME - ElapsedTime);
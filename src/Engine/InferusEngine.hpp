@@ -5,6 +5,7 @@
 
 #include "Engine/Types.hpp"
 #include "Engine/Core/Camera3D.hpp"
+#include "Engine/Core/JobSystem.hpp"
 #include "Engine/InferusRenderer/InferusRenderer.hpp"
 
 namespace InferusEngine {
@@ -24,6 +25,8 @@ namespace InferusEngine {
     void Destroy();
 
     void Run();
+    // Per frame task graph, DeltaTime is read every time the graph executes
+    void BuildFrameGraph(JobSystem::TaskGraph& Graph, const float& DeltaTime);
     void OutFps(float DeltaTime);
     void Resize(uint32_t Width, uint32_t Height);
 };
@@ -91,6 +91,13 @@ namespace BufferCreateOptions {
                 .vmaUsage = VMA_MEMORY_USAGE_UNKNOWN,
                 .vmaFlags = 0,
                 .requiredFlags = 0
+            },
+            // INDIRECT
+            {
+                .vkUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                .vmaUsage = VMA_MEMORY_USAGE_UNKNOWN,
+                .vmaFlags = 0,
+                .requiredFlags = 0
             }
         }
     };
@@ -1,35 +1,177 @@
 #include "BufferSystem.hpp"
 
+#include <array>
 #include <vector>
 #include <cassert>
+#include <cstring>
 
 #include <spdlog/spdlog.h>
 
 #include "Engine/InferusRenderer/VulkanContext.hpp"
 #include "Engine/InferusRenderer/RendererConfig.hpp"
 #include "Engine/InferusRenderer/Buffer/BufferCreateOptions.hpp"
+#include "Engine/InferusRenderer/Descriptor/DescriptorHeap.hpp"
 
 namespace BufferSystem {
 
+    using namespace RendererConfig::BufferSystem;
+
     std::vector<Buffer> Data;
     std::vector<Id> FreeIndices;
 
+    // POOL_BLOCK_SIZE buffers small ones are ranges of, VMA's virtual allocator keeps track of
+    // the free space so nothing here talks to the driver once a block exists
+    struct Block {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+        VmaVirtualBlock ranges = VK_NULL_HANDLE;
+    };
+    std::vector<Block> Blocks;
+
+    constexpr size_t MEMORY_TYPE_COUNT = static_cast<size_t>(CreateInfoMemoryType::_BUFFER_MEMORY_TYPE_COUNT_);
+    constexpr size_t USAGE_COUNT = static_cast<size_t>(CreateInfoUsage::_BUFFER_USAGE_COUNT_);
+    // Blocks of each memory type and usage pair
+    std::array<std::vector<uint32_t>, MEMORY_TYPE_COUNT * USAGE_COUNT> Pools;
+
+    // One buffer, a FRAME_ARENA_SIZE region per frame in flight
+    struct FrameArena {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+        uint32_t descriptor = DescriptorHeap::INVALID_INDEX;
+        VkDeviceSize regionBegin = 0;
+        VkDeviceSize head = 0;
+        bool exhausted = false;
+    } Arena;
+
     void clear(Buffer& buffer);
     void* map(VmaAllocation alloc);
     void unmap(VmaAllocation alloc);
 
-    void Create() {
+    void Create(uint32_t framesInFlight) {
 
         Data.clear();
-        Data.reserve(RendererConfig::BufferSystem::DATA_RESERVE_CAPACITY);
+        Data.reserve(DATA_RESERVE_CAPACITY);
         FreeIndices.clear();
-        FreeIndices.reserve(RendererConfig::BufferSystem::FREE_INDICES_RESERVE_CAPACITY);
+        FreeIndices.reserve(FREE_INDICES_RESERVE_CAPACITY);
+        Blocks.clear();
+        for (std::vector<uint32_t>& pool : Pools) {
+            pool.clear();
+        }
+
+        VkBufferCreateInfo arenaCreateInfo{};
+        arenaCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        arenaCreateInfo.size = FRAME_ARENA_SIZE * framesInFlight;
+        arenaCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+        // Coherent, so slices never need flushing
+        VmaAllocationCreateInfo arenaAllocCreateInfo{};
+        arenaAllocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+        arenaAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        arenaAllocCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        VmaAllocationInfo arenaAllocInfo{};
+        Arena = {};
+        if (vmaCreateBuffer(VulkanContext::VmaAllocator, &arenaCreateInfo, &arenaAllocCreateInfo, &Arena.buffer, &Arena.allocation, &arenaAllocInfo) != VK_SUCCESS) {
+            spdlog::error("Frame arena creation failed");
+            return;
+        }
+        Arena.mapped = static_cast<uint8_t*>(arenaAllocInfo.pMappedData);
+        Arena.descriptor = DescriptorHeap::AddStorageBuffer(Arena.buffer, 0, VK_WHOLE_SIZE);
     }
 
     void Destroy() {
         for (Buffer& buffer : Data) {
             clear(buffer);
         }
+
+        for (Block& block : Blocks) {
+            vmaClearVirtualBlock(block.ranges);
+            vmaDestroyVirtualBlock(block.ranges);
+            vmaDestroyBuffer(VulkanContext::VmaAllocator, block.buffer, block.allocation);
+        }
+        Blocks.clear();
+
+        DescriptorHeap::Release(DescriptorHeap::Binding::StorageBuffers, Arena.descriptor);
+        if (Arena.buffer) { vmaDestroyBuffer(VulkanContext::VmaAllocator, Arena.buffer, Arena.allocation); }
+        Arena = {};
+    }
+
+    bool createBlock(const BufferCreateOptions::BufferOptions& options, Block& block) {
+        VkBufferCreateInfo bufferCreateInfo{};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = POOL_BLOCK_SIZE;
+        bufferCreateInfo.usage = options.vkUsage;
+
+        VmaAllocationCreateInfo allocCreateInfo{};
+        allocCreateInfo.usage = options.vmaUsage;
+        allocCreateInfo.requiredFlags = options.requiredFlags;
+        allocCreateInfo.flags = options.vmaFlags;
+
+        VmaAllocationInfo allocInfo{};
+        if (vmaCreateBuffer(VulkanContext::VmaAllocator, &bufferCreateInfo, &allocCreateInfo, &block.buffer, &block.allocation, &allocInfo) != VK_SUCCESS) {
+            spdlog::error("Buffer pool block creation failed");
+            return false;
+        }
+        block.mapped = static_cast<uint8_t*>(allocInfo.pMappedData);
+
+        VmaVirtualBlockCreateInfo rangesCreateInfo{};
+        rangesCreateInfo.size = POOL_BLOCK_SIZE;
+        if (vmaCreateVirtualBlock(&rangesCreateInfo, &block.ranges) != VK_SUCCESS) {
+            spdlog::error("Buffer pool block creation failed");
+            vmaDestroyBuffer(VulkanContext::VmaAllocator, block.buffer, block.allocation);
+            return false;
+        }
+        return true;
+    }
+
+    // A range of the first block of the pool with room, a new block when none has
+    bool suballocate(const CreateInfo& createDesc, const BufferCreateOptions::BufferOptions& options, Buffer& buffer) {
+        std::vector<uint32_t>& pool =
+            Pools[static_cast<size_t>(createDesc.memType) * USAGE_COUNT + static_cast<size_t>(createDesc.usage)];
+
+        VmaVirtualAllocationCreateInfo rangeCreateInfo{};
+        rangeCreateInfo.size = createDesc.size;
+        rangeCreateInfo.alignment = SUBALLOCATION_ALIGNMENT;
+
+        auto tryBlock = [&](uint32_t blockIndex) {
+            Block& block = Blocks[blockIndex];
+            VkDeviceSize offset = 0;
+            if (vmaVirtualAllocate(block.ranges, &rangeCreateInfo, &buffer.range, &offset) != VK_SUCCESS) {
+                return false;
+            }
+            buffer.buffer = block.buffer;
+            buffer.offset = offset;
+            buffer.allocation = block.allocation;
+            buffer.mapped = block.mapped ? block.mapped + offset : nullptr;
+            buffer.block = blockIndex;
+            return true;
+        };
+
+        for (uint32_t blockIndex : pool) {
+            if (tryBlock(blockIndex)) {
+                return true;
+            }
+        }
+
+        Block block{};
+        if (!createBlock(options, block)) {
+            return false;
+        }
+        Blocks.push_back(block);
+        pool.push_back(static_cast<uint32_t>(Blocks.size() - 1));
+        return tryBlock(pool.back());
+    }
+
+    // Storage buffers are reachable bindlessly, just their own range of a pooled block
+    void registerDescriptor(Buffer& buffer) {
+        bool storage = buffer.usage == CreateInfoUsage::SSBO || buffer.usage == CreateInfoUsage::INDIRECT;
+        if (storage && buffer.buffer) {
+            buffer.descriptor = DescriptorHeap::AddStorageBuffer(buffer.buffer, buffer.offset, buffer.size);
+        }
     }
 
     Id add(CreateInfo createDesc) {
@@ -46,6 +188,18 @@ namespace BufferSystem {
 
         BufferCreateOptions::BufferOptions options = BufferCreateOptions::GetBufferOptions(createDesc.memType, createDesc.usage);
 
+        buffer.size = createDesc.size;
+        buffer.memType = createDesc.memType;
+        buffer.usage = createDesc.usage;
+        buffer.block = UINT32_MAX;
+        buffer.descriptor = DescriptorHeap::INVALID_INDEX;
+
+        if (createDesc.size <= SUBALLOCATION_MAX_SIZE && suballocate(createDesc, options, buffer)) {
+            registerDescriptor(buffer);
+            Data[id.index] = buffer;
+            return id;
+        }
+
         VkBufferCreateInfo bufferCreateInfo{};
         bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferCreateInfo.size = static_cast<VkDeviceSize>(createDesc.size);
@@ -56,11 +210,14 @@ namespace BufferSystem {
         allocCreateInfo.requiredFlags = options.requiredFlags;
         allocCreateInfo.flags = options.vmaFlags;
 
-        if (vmaCreateBuffer(VulkanContext::VmaAllocator, &bufferCreateInfo, &allocCreateInfo, &buffer.buffer, &buffer.allocation, nullptr) != VK_SUCCESS) {
+        VmaAllocationInfo allocInfo{};
+        if (vmaCreateBuffer(VulkanContext::VmaAllocator, &bufferCreateInfo, &allocCreateInfo, &buffer.buffer, &buffer.allocation, &allocInfo) != VK_SUCCESS) {
             spdlog::error("Buffer creation failed");
         }
 
-        buffer.size = createDesc.size;
+        buffer.offset = 0;
+        buffer.mapped = allocInfo.pMappedData;
+        registerDescriptor(buffer);
         Data[id.index] = buffer;
 
         return id;
@@ -83,15 +240,24 @@ namespace BufferSystem {
     }
 
     void copy(VkCommandBuffer &cmd, Id srcId, Id dstId, const size_t size) {
+        copy(cmd, srcId, dstId, size, 0, 0);
+    }
+
+    // Offsets are relative to the buffers, not the blocks they live in
+    void copy(VkCommandBuffer &cmd, Id srcId, Id dstId, const size_t size, const VkDeviceSize srcOffset, const VkDeviceSize dstOffset) {
+        Buffer& src = get(srcId);
+        Buffer& dst = get(dstId);
         VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0;
-        copyRegion.dstOffset = 0;
+        copyRegion.srcOffset = src.offset + srcOffset;
+        copyRegion.dstOffset = dst.offset + dstOffset;
         copyRegion.size = size;
-        vkCmdCopyBuffer(cmd, get(srcId).buffer, get(dstId).buffer, 1, &copyRegion);
+        vkCmdCopyBuffer(cmd, src.buffer, dst.buffer, 1, &copyRegion);
     }
 
     void copy(Id srcId, Id dstId, const size_t size) {
-        vmaCopyMemoryToAllocation(VulkanContext::VmaAllocator, map(get(srcId).allocation), get(dstId).allocation, 0, size);
+        Buffer& dst = get(dstId);
+        vmaCopyMemoryToAllocation(VulkanContext::VmaAllocator, map(srcId), dst.allocation, dst.offset, size);
+        unmap(srcId);
     }
 
     void upload(Id dstId, void* upload_Data) {
@@ -105,17 +271,62 @@ namespace BufferSystem {
     }
 
     void upload(Id dstId, const void* upload_Data, const size_t size) {
-        VmaAllocation alloc = get(dstId).allocation;
-        memcpy(map(alloc), upload_Data, size);
-        unmap(alloc);
+        Buffer& buffer = get(dstId);
+        if (buffer.mapped) {
+            memcpy(buffer.mapped, upload_Data, size);
+            vmaFlushAllocation(VulkanContext::VmaAllocator, buffer.allocation, buffer.offset, size);
+            return;
+        }
+
+        memcpy(static_cast<uint8_t*>(map(buffer.allocation)) + buffer.offset, upload_Data, size);
+        unmap(buffer.allocation);
     }
 
+    // Persistently mapped buffers just hand out their pointer, unmap is a no-op for them
     void* map(Id id) {
-        return map(get(id).allocation);
+        Buffer& buffer = get(id);
+        return buffer.mapped ? buffer.mapped : static_cast<uint8_t*>(map(buffer.allocation)) + buffer.offset;
     }
 
     void unmap(Id id) {
-        unmap(get(id).allocation);
+        Buffer& buffer = get(id);
+        if (!buffer.mapped) {
+            unmap(buffer.allocation);
+        }
+    }
+
+    void beginFrame(uint32_t frameIndex) {
+        Arena.regionBegin = VkDeviceSize(frameIndex) * FRAME_ARENA_SIZE;
+        Arena.head = Arena.regionBegin;
+        Arena.exhausted = false;
+    }
+
+    FrameSlice frameAlloc(VkDeviceSize size, VkDeviceSize alignment) {
+        VkDeviceSize offset = (Arena.head + alignment - 1) / alignment * alignment;
+        if (offset + size > Arena.regionBegin + FRAME_ARENA_SIZE) {
+            // Once per frame, whoever asked skips their work for it
+            if (!Arena.exhausted) {
+                spdlog::error("Frame arena exhausted, {} bytes requested", size);
+                Arena.exhausted = true;
+            }
+            return {};
+        }
+        Arena.head = offset + size;
+
+        return FrameSlice{
+            .buffer = Arena.buffer,
+            .offset = offset,
+            .size = size,
+            .mapped = Arena.mapped + offset
+        };
+    }
+
+    VkBuffer frameArenaBuffer() {
+        return Arena.buffer;
+    }
+
+    uint32_t frameArenaDescriptor() {
+        return Arena.descriptor;
     }
 
     void* map(const VmaAllocation alloc) {
@@ -129,9 +340,20 @@ namespace BufferSystem {
         vmaUnmapMemory(VulkanContext::VmaAllocator, alloc);
     }
 
+    // Pooled ones just give their range back, the block stays for the next
     void clear(Buffer& buffer) {
-        if (buffer.buffer) { vmaDestroyBuffer(VulkanContext::VmaAllocator, buffer.buffer, buffer.allocation); }
+        if (buffer.buffer) {
+            DescriptorHeap::Release(DescriptorHeap::Binding::StorageBuffers, buffer.descriptor);
+            if (buffer.block != UINT32_MAX) {
+                vmaVirtualFree(Blocks[buffer.block].ranges, buffer.range);
+            } else {
+                vmaDestroyBuffer(VulkanContext::VmaAllocator, buffer.buffer, buffer.allocation);
+            }
+        }
         buffer.buffer = VK_NULL_HANDLE;
         buffer.allocation = VK_NULL_HANDLE;
+        buffer.range = VK_NULL_HANDLE;
+        buffer.block = UINT32_MAX;
+        buffer.descriptor = DescriptorHeap::INVALID_INDEX;
     }
 }
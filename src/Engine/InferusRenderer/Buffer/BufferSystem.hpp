@@ -23,6 +23,8 @@ namespace BufferSystem {
         SSBO,
         UBO,
         STAGING,
+        // Written by compute as a storage buffer, consumed by indirect draws
+        INDIRECT,
 
         _BUFFER_USAGE_COUNT_
     };
@@ -31,12 +33,30 @@ namespace BufferSystem {
         uint32_t index;
     };
 
+    // Small buffers are ranges of a pooled block's VkBuffer, offset is where they start in it
+    // (0 for dedicated ones). Bindings, descriptors and copies have to add it.
     struct Buffer {
         VkBuffer buffer;
+        VkDeviceSize offset;
         VmaAllocation allocation;
         size_t size;
         CreateInfoMemoryType memType;
         CreateInfoUsage usage;
+        // Host visible memory types stay mapped for the buffer's lifetime, already offset
+        void* mapped;
+        // Pooled ones only
+        VmaVirtualAllocation range;
+        uint32_t block;
+        // Bindless storage buffer index, SSBO and INDIRECT usages only
+        uint32_t descriptor;
+    };
+
+    // Part of the frame arena, valid until the frame it was handed out for comes around again
+    struct FrameSlice {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
     };
 
     struct CreateInfo {
@@ -45,7 +65,8 @@ namespace BufferSystem {
         CreateInfoUsage usage;
     };
 
-    void Create();
+    // framesInFlight regions of the frame arena
+    void Create(uint32_t framesInFlight);
     void Destroy();
 
     Id add(CreateInfo createDesc);
@@ -55,6 +76,7 @@ namespace BufferSystem {
 
     void copy(Id srcId, Id dstId, const size_t size);
     void copy(VkCommandBuffer &cmd, Id srcId, Id dstId, const size_t size);
+    void copy(VkCommandBuffer &cmd, Id srcId, Id dstId, const size_t size, const VkDeviceSize srcOffset, const VkDeviceSize dstOffset);
 
     void upload(Id dstId, void* upload_data);
     void upload(Id dstId, const void* upload_data, const size_t size);
@@ -62,4 +84,15 @@ namespace BufferSystem {
 
     void* map(Id id);
     void unmap(Id id);
+
+    // Per frame linear allocation, for data rewritten every frame. Once the frame's InFlight
+    // fence signalled, everything handed out the last time it was recorded is recycled.
+    void beginFrame(uint32_t frameIndex);
+    // Default alignment suits uniform and storage buffer offsets on any device. An empty slice
+    // when the frame's region is spent.
+    FrameSlice frameAlloc(VkDeviceSize size, VkDeviceSize alignment = 256);
+    // The one buffer behind every slice, and its bindless storage buffer index. Shaders find a
+    // slice at its offset into it.
+    VkBuffer frameArenaBuffer();
+    uint32_t frameArenaDescriptor();
 };
@@ -0,0 +1,221 @@
+#include "DescriptorHeap.hpp"
+
+#include <array>
+#include <vector>
+#include <cassert>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+
+namespace DescriptorHeap {
+    using namespace RendererConfig::DescriptorHeap;
+
+    constexpr uint32_t BINDING_COUNT = 3;
+    constexpr std::array<VkDescriptorType, BINDING_COUNT> TYPES = {
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        VK_DESCRIPTOR_TYPE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+    };
+    constexpr std::array<uint32_t, BINDING_COUNT> CAPACITIES = {
+        MAX_SAMPLED_IMAGES,
+        MAX_SAMPLERS,
+        MAX_STORAGE_BUFFERS
+    };
+
+    // Per binding, indices handed out so far and the released ones to hand out first
+    struct Slots {
+        uint32_t Next = 0;
+        std::vector<uint32_t> Free;
+    };
+    std::array<Slots, BINDING_COUNT> Bindings;
+
+    VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+    VkDescriptorPool Pool = VK_NULL_HANDLE;
+    VkDescriptorSet Set = VK_NULL_HANDLE;
+    VkPipelineLayout SharedPipelineLayout = VK_NULL_HANDLE;
+
+    InferusResult Create() {
+        VkDevice Device = VulkanContext::Device;
+
+        std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> LayoutBindings {};
+        std::array<VkDescriptorBindingFlags, BINDING_COUNT> BindingFlags {};
+        std::array<VkDescriptorPoolSize, BINDING_COUNT> PoolSizes {};
+        for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+            LayoutBindings[i].binding = i;
+            LayoutBindings[i].descriptorType = TYPES[i];
+            LayoutBindings[i].descriptorCount = CAPACITIES[i];
+            LayoutBindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+            LayoutBindings[i].pImmutableSamplers = nullptr;
+
+            // Slots nothing was put in yet are fine as long as no shader reads them, and
+            // filling one in doesn't disturb frames in flight
+            BindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                              VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+            PoolSizes[i] = { .type = TYPES[i], .descriptorCount = CAPACITIES[i] };
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo BindingFlagsCreateInfo {};
+        BindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        BindingFlagsCreateInfo.bindingCount = BINDING_COUNT;
+        BindingFlagsCreateInfo.pBindingFlags = BindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo LayoutCreateInfo {};
+        LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        LayoutCreateInfo.pNext = &BindingFlagsCreateInfo;
+        LayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        LayoutCreateInfo.bindingCount = BINDING_COUNT;
+        LayoutCreateInfo.pBindings = LayoutBindings.data();
+        if (vkCreateDescriptorSetLayout(Device, &LayoutCreateInfo, nullptr, &Layout) != VK_SUCCESS) {
+            spdlog::error("Bindless descriptor set layout creation failed");
+            return InferusResult::FAIL;
+        }
+
+        VkDescriptorPoolCreateInfo PoolCreateInfo {};
+        PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        PoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        PoolCreateInfo.maxSets = 1;
+        PoolCreateInfo.poolSizeCount = BINDING_COUNT;
+        PoolCreateInfo.pPoolSizes = PoolSizes.data();
+        if (vkCreateDescriptorPool(Device, &PoolCreateInfo, nullptr, &Pool) != VK_SUCCESS) {
+            spdlog::error("Bindless descriptor pool creation failed");
+            return InferusResult::FAIL;
+        }
+
+        VkDescriptorSetAllocateInfo AllocInfo {};
+        AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        AllocInfo.descriptorPool = Pool;
+        AllocInfo.descriptorSetCount = 1;
+        AllocInfo.pSetLayouts = &Layout;
+        if (vkAllocateDescriptorSets(Device, &AllocInfo, &Set) != VK_SUCCESS) {
+            spdlog::error("Bindless descriptor set allocation failed");
+            return InferusResult::FAIL;
+        }
+
+        VkPushConstantRange PushConstantRange = {
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .offset = 0,
+            .size = PUSH_CONSTANTS_SIZE
+        };
+
+        VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo {};
+        PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        PipelineLayoutCreateInfo.setLayoutCount = 1;
+        PipelineLayoutCreateInfo.pSetLayouts = &Layout;
+        PipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        PipelineLayoutCreateInfo.pPushConstantRanges = &PushConstantRange;
+        if (vkCreatePipelineLayout(Device, &PipelineLayoutCreateInfo, nullptr, &SharedPipelineLayout) != VK_SUCCESS) {
+            spdlog::error("Shared pipeline layout creation failed");
+            return InferusResult::FAIL;
+        }
+
+        for (Slots& Slot : Bindings) {
+            Slot = {};
+        }
+
+        return InferusResult::SUCCESS;
+    }
+
+    void Destroy() {
+        VkDevice Device = VulkanContext::Device;
+
+        if (SharedPipelineLayout) { vkDestroyPipelineLayout(Device, SharedPipelineLayout, nullptr); }
+        // Frees the set with it
+        if (Pool) { vkDestroyDescriptorPool(Device, Pool, nullptr); }
+        if (Layout) { vkDestroyDescriptorSetLayout(Device, Layout, nullptr); }
+        SharedPipelineLayout = VK_NULL_HANDLE;
+        Pool = VK_NULL_HANDLE;
+        Set = VK_NULL_HANDLE;
+        Layout = VK_NULL_HANDLE;
+    }
+
+    uint32_t Acquire(Binding Kind) {
+        Slots& Slot = Bindings[static_cast<uint32_t>(Kind)];
+        if (!Slot.Free.empty()) {
+            uint32_t Index = Slot.Free.back();
+            Slot.Free.pop_back();
+            return Index;
+        }
+        if (Slot.Next == CAPACITIES[static_cast<uint32_t>(Kind)]) {
+            spdlog::error("Bindless heap binding {} is full", static_cast<uint32_t>(Kind));
+            return INVALID_INDEX;
+        }
+        return Slot.Next++;
+    }
+
+    void Write(Binding Kind, uint32_t Index, const VkDescriptorImageInfo* ImageInfo, const VkDescriptorBufferInfo* BufferInfo) {
+        VkWriteDescriptorSet Write {};
+        Write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        Write.dstSet = Set;
+        Write.dstBinding = static_cast<uint32_t>(Kind);
+        Write.dstArrayElement = Index;
+        Write.descriptorCount = 1;
+        Write.descriptorType = TYPES[static_cast<uint32_t>(Kind)];
+        Write.pImageInfo = ImageInfo;
+        Write.pBufferInfo = BufferInfo;
+        vkUpdateDescriptorSets(VulkanContext::Device, 1, &Write, 0, nullptr);
+    }
+
+    uint32_t AddSampledImage(VkImageView View) {
+        uint32_t Index = Acquire(Binding::SampledImages);
+        if (Index == INVALID_INDEX) {
+            return Index;
+        }
+
+        VkDescriptorImageInfo ImageInfo {};
+        ImageInfo.imageView = View;
+        ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        Write(Binding::SampledImages, Index, &ImageInfo, nullptr);
+        return Index;
+    }
+
+    uint32_t AddSampler(VkSampler Sampler) {
+        uint32_t Index = Acquire(Binding::Samplers);
+        if (Index == INVALID_INDEX) {
+            return Index;
+        }
+
+        VkDescriptorImageInfo ImageInfo {};
+        ImageInfo.sampler = Sampler;
+        Write(Binding::Samplers, Index, &ImageInfo, nullptr);
+        return Index;
+    }
+
+    uint32_t AddStorageBuffer(VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Range) {
+        uint32_t Index = Acquire(Binding::StorageBuffers);
+        if (Index == INVALID_INDEX) {
+            return Index;
+        }
+
+        VkDescriptorBufferInfo BufferInfo {};
+        BufferInfo.buffer = Buffer;
+        BufferInfo.offset = Offset;
+        BufferInfo.range = Range;
+        Write(Binding::StorageBuffers, Index, nullptr, &BufferInfo);
+        return Index;
+    }
+
+    // The stale descriptor stays, partially bound doesn't mind as long as nothing reads it
+    void Release(Binding Kind, uint32_t Index) {
+        if (Index == INVALID_INDEX) {
+            return;
+        }
+        assert(Index < Bindings[static_cast<uint32_t>(Kind)].Next && "Releasing a bindless index never handed out");
+        Bindings[static_cast<uint32_t>(Kind)].Free.push_back(Index);
+    }
+
+    VkPipelineLayout PipelineLayout() {
+        return SharedPipelineLayout;
+    }
+
+    VkDescriptorSetLayout SetLayout() {
+        return Layout;
+    }
+
+    void Bind(VkCommandBuffer cmd, VkPipelineBindPoint BindPoint) {
+        vkCmdBindDescriptorSets(cmd, BindPoint, SharedPipelineLayout, 0, 1, &Set, 0, nullptr);
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Types.hpp"
+
+// Bindless descriptors, one set and one pipeline layout for every pass.
+//
+// The set holds an array per descriptor type, partially bound and updatable after bind, so
+// it's bound once and never rebuilt. ImageSystem and BufferSystem put what they create in
+// here and keep the index, shaders get indices through push constants and pick the resource
+// out of the array. A slot is reused once released, so only release what no frame in flight
+// reads anymore (the same rule as destroying the resource itself).
+namespace DescriptorHeap {
+    enum class Binding : uint32_t {
+        SampledImages = 0,
+        Samplers = 1,
+        StorageBuffers = 2
+    };
+
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    InferusResult Create();
+    // Device idle
+    void Destroy();
+
+    // Views are expected in SHADER_READ_ONLY_OPTIMAL whenever sampled
+    uint32_t AddSampledImage(VkImageView View);
+    uint32_t AddSampler(VkSampler Sampler);
+    uint32_t AddStorageBuffer(VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Range);
+    void Release(Binding Kind, uint32_t Index);
+
+    // Set 0 plus PUSH_CONSTANTS_SIZE bytes of push constants visible to every stage
+    VkPipelineLayout PipelineLayout();
+    VkDescriptorSetLayout SetLayout();
+    void Bind(VkCommandBuffer cmd, VkPipelineBindPoint BindPoint);
+};
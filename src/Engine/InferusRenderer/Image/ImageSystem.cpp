@@ -5,6 +5,7 @@
 
 #include "Engine/InferusRenderer/VulkanContext.hpp"
 #include "Engine/InferusRenderer/RendererConfig.hpp"
+#include "Engine/InferusRenderer/Descriptor/DescriptorHeap.hpp"
 
 namespace ImageSystem {
 
@@ -12,10 +13,12 @@ namespace ImageSystem {
     std::vector<Id> FreeIndices;
 
     void clear(Image& image) {
+        if (image.image) { DescriptorHeap::Release(DescriptorHeap::Binding::SampledImages, image.descriptor); }
         if (image.imageView) { vkDestroyImageView(VulkanContext::Device, image.imageView, nullptr); }
         if (image.image) { vmaDestroyImage(VulkanContext::VmaAllocator, image.image, image.allocation); }
         image.image = VK_NULL_HANDLE;
         image.imageView = VK_NULL_HANDLE;
+        image.descriptor = DescriptorHeap::INVALID_INDEX;
     }
 
     void Create() {
@@ -26,7 +29,7 @@ namespace ImageSystem {
     }
 
     void Destroy() {
-        for (auto image: Data) {
+        for (Image& image: Data) {
             clear(image);
         }
     }
@@ -53,7 +56,7 @@ namespace ImageSystem {
         createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        createInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        createInfo.usage = imageDesc.usage;
         createInfo.extent.width = imageDesc.width;
         createInfo.extent.height = imageDesc.height;
         createInfo.arrayLayers = imageDesc.arrayLayers;
@@ -88,6 +91,9 @@ namespace ImageSystem {
         image.depth = imageDesc.depth;
         image.format = imageDesc.format;
         image.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image.descriptor = (imageDesc.usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+            ? DescriptorHeap::AddSampledImage(image.imageView)
+            : DescriptorHeap::INVALID_INDEX;
 
         Data[id.index] = image;
         return id;
@@ -27,6 +27,8 @@ namespace ImageSystem {
         uint8_t arrayLayers;
         VkFormat format;
         VkImageLayout layout;
+        // Bindless sampled image index, sampled usage only
+        uint32_t descriptor;
     };
 
     struct Id {
@@ -1,5 +1,6 @@
 #include "InferusRenderer.hpp"
 
+#include <array>
 #include <cstdint>
 #include <algorithm>
 
@@ -8,15 +9,31 @@
 #include "Engine/Core/Window.hpp"
 #include "Engine/InferusRenderer/Recipes.hpp"
 #include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/PipelineCache.hpp"
+#include "Engine/InferusRenderer/PipelineManager.hpp"
 #include "Engine/InferusRenderer/Image/ImageSystem.hpp"
 #include "Engine/InferusRenderer/Buffer/BufferSystem.hpp"
+#include "Engine/InferusRenderer/Upload/UploadSystem.hpp"
+#include "Engine/InferusRenderer/Profiler/GpuProfiler.hpp"
+#include "Engine/InferusRenderer/Descriptor/DescriptorHeap.hpp"
 
 using namespace VulkanContext; // Yes, I know
 
 InferusResult InferusRenderer::Create() {
     VulkanContext::Create();
-    // Memory resources management systems
-    BufferSystem::Create();
+    PipelineCache::Create();
+    PipelineManager::Create();
+    // Memory resources management systems, registering into the bindless heap
+    if (DescriptorHeap::Create() != InferusResult::SUCCESS) {
+        spdlog::error("Bindless descriptor heap creation failed");
+        return InferusResult::FAIL;
+    }
+    BufferSystem::Create(MAX_FRAMES_IN_FLIGHT);
+    GpuProfiler::Create(MAX_FRAMES_IN_FLIGHT, RendererConfig::UploadSystem::BATCH_COUNT);
+    if (UploadSystem::Create() != InferusResult::SUCCESS) {
+        spdlog::error("Upload system creation failed");
+        return InferusResult::FAIL;
+    }
     BufferSystem::Id CreationWiseStagingBuffer;
     {
         BufferSystem::CreateInfo CreationWiseStagingBufferCreateDesc = {
@@ -110,18 +127,6 @@ InferusResult InferusRenderer::Create() {
         .minDepth = 0.0f, .maxDepth = 1.0f
     };
 
-    ColorAttachment = Recipes::ColorAttachment::Terrain();
-
-    RenderingInfo = {};
-    RenderingInfo.renderArea = {
-        .offset = { 0, 0 },
-        .extent = Extent
-    };
-    RenderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
-    RenderingInfo.layerCount = 1;
-    RenderingInfo.colorAttachmentCount = 1;
-    RenderingInfo.pColorAttachments = &ColorAttachment;
-
     PipelineCmdBeginInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .pNext = nullptr,
@@ -129,13 +134,6 @@ InferusResult InferusRenderer::Create() {
         .pInheritanceInfo = nullptr
     };
 
-    PipelineCmdSubmitInfo = {};
-    PipelineCmdSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    PipelineCmdSubmitInfo.waitSemaphoreCount = 1;
-    PipelineCmdSubmitInfo.pWaitDstStageMask = G_PIPELINE_WAIT_STAGES;
-    PipelineCmdSubmitInfo.commandBufferCount = 1;
-    PipelineCmdSubmitInfo.signalSemaphoreCount = 1;
-
     if (
         ImGuiRenderer::Create(*this) !=  InferusResult::SUCCESS
     ) {
@@ -149,17 +147,87 @@ InferusResult InferusRenderer::Create() {
         spdlog::error("Terrain Renderer creation failed");
         return InferusResult::FAIL;
     }
+    TerrainRenderer.Resize(Extent);
+
+    if (BuildFrameGraph() != InferusResult::SUCCESS) {
+        spdlog::error("Frame graph creation failed");
+        return InferusResult::FAIL;
+    }
     return InferusResult::SUCCESS;
 }
 
+InferusResult InferusRenderer::BuildFrameGraph() {
+    RenderGraph::ImageDesc SwapchainDesc = {
+        .Format = SurfaceFormat.format,
+        .Extent = { 0, 0 },
+        .Layers = 1,
+        .Mips = 1,
+        .Aspect = VK_IMAGE_ASPECT_COLOR_BIT
+    };
+    // Cleared every frame, whatever the last present left in it doesn't matter
+    SwapchainTarget = FrameGraph.ImportImage("Swapchain", SwapchainDesc, RenderGraph::Usage::Present, true);
+
+    // Uploads hand layers back in SHADER_READ_ONLY, so between frames that's where it is
+    RenderGraph::ResourceId Heightmap =
+        FrameGraph.ImportImage("Heightmap", TerrainRenderer.HeightmapImageId, RenderGraph::Usage::SampledGraphics);
+    // Host written, the submit makes it visible
+    RenderGraph::ResourceId FrameArena = FrameGraph.ImportBuffer("Frame arena", RenderGraph::Usage::StorageReadGraphics);
+    FrameGraph.BindBuffer(FrameArena, BufferSystem::frameArenaBuffer());
+
+    // Only ever touched by the GPU, the draws of a frame are rebuilt before anything reads them
+    const BufferSystem::Buffer& Draws = BufferSystem::get(TerrainRenderer.DrawsBufferId);
+    const BufferSystem::Buffer& DrawCount = BufferSystem::get(TerrainRenderer.DrawCountBufferId);
+    RenderGraph::ResourceId TerrainDraws = FrameGraph.ImportBuffer("Terrain draws", RenderGraph::Usage::IndirectRead);
+    RenderGraph::ResourceId TerrainDrawCount = FrameGraph.ImportBuffer("Terrain draw count", RenderGraph::Usage::IndirectRead);
+    FrameGraph.BindBuffer(TerrainDraws, Draws.buffer, Draws.offset, Draws.size);
+    FrameGraph.BindBuffer(TerrainDrawCount, DrawCount.buffer, DrawCount.offset, DrawCount.size);
+
+    RenderGraph::PassId CullResetPass = FrameGraph.AddPass("Terrain cull reset", [this](VkCommandBuffer cmd) {
+        TerrainRenderer.ResetDrawCount(cmd);
+    });
+    FrameGraph.Use(CullResetPass, TerrainDrawCount, RenderGraph::Usage::TransferDst);
+
+    RenderGraph::PassId CullPass = FrameGraph.AddPass("Terrain cull", [this](VkCommandBuffer cmd) {
+        GpuProfiler::Scope Profiled(cmd, "Terrain cull");
+        TerrainRenderer.Cull(cmd);
+    });
+    FrameGraph.Use(CullPass, FrameArena, RenderGraph::Usage::StorageReadCompute);
+    FrameGraph.Use(CullPass, TerrainDraws, RenderGraph::Usage::StorageWriteCompute);
+    FrameGraph.Use(CullPass, TerrainDrawCount, RenderGraph::Usage::StorageWriteCompute);
+
+    RenderGraph::PassId MainPass = FrameGraph.AddPass("Main", [this](VkCommandBuffer cmd) {
+        vkCmdSetViewport(cmd, 0, 1, &Viewport);
+        vkCmdSetScissor(cmd, 0, 1, &Scissor);
+
+        {
+            GpuProfiler::Scope Profiled(cmd, "Terrain");
+            TerrainRenderer.Render(cmd);
+        }
+        GpuProfiler::Scope Profiled(cmd, "ImGui");
+        ImGuiRenderer::LateRender(cmd);
+    });
+    FrameGraph.ColorAttachment(MainPass, SwapchainTarget, Recipes::ColorAttachment::Terrain());
+    FrameGraph.Use(MainPass, Heightmap, RenderGraph::Usage::SampledGraphics);
+    FrameGraph.Use(MainPass, FrameArena, RenderGraph::Usage::StorageReadGraphics);
+    FrameGraph.Use(MainPass, TerrainDraws, RenderGraph::Usage::IndirectRead);
+    FrameGraph.Use(MainPass, TerrainDrawCount, RenderGraph::Usage::IndirectRead);
+
+    return FrameGraph.Compile(Extent);
+}
+
 void InferusRenderer::Destroy() {
     vkDeviceWaitIdle(Device);
 
+    PipelineManager::Destroy();
+    FrameGraph.Destroy();
     TerrainRenderer.Destroy();
     ImGuiRenderer::Destroy();
 
+    UploadSystem::Destroy();
+    GpuProfiler::Destroy();
     BufferSystem::Destroy();
     ImageSystem::Destroy();
+    DescriptorHeap::Destroy();
 
     for (FrameData &Frame : Frames) {
         if (Frame.ImageAvailable) { vkDestroySemaphore(Device, Frame.ImageAvailable, nullptr); }
@@ -170,6 +238,7 @@ void InferusRenderer::Destroy() {
     CleanupSwapchainImages();
     DestroySwapchain(Swapchain);
 
+    PipelineCache::Destroy();
     VulkanContext::Destroy();
 }
 
@@ -232,11 +301,11 @@ void InferusRenderer::Resize(uint32_t Width, uint32_t Height) {
     Scissor.extent = Extent;
     Viewport.width = static_cast<float>(Extent.width);
     Viewport.height = static_cast<float>(Extent.height);
-    RenderingInfo.renderArea = {
-        .offset = { 0, 0 },
-        .extent = Extent
-    };
     RecreateSwapchain(Swapchain);
+    TerrainRenderer.Resize(Extent);
+    if (FrameGraph.Compile(Extent) != InferusResult::SUCCESS) {
+        throw std::runtime_error("Frame graph recompilation failed");
+    }
 }
 
 void InferusRenderer::EarlyRender() {
@@ -249,6 +318,13 @@ void InferusRenderer::LateRender() {
 
     vkWaitForFences(Device, 1, &TargetFrame.InFlight, VK_TRUE, UINT64_MAX);
 
+    // Frame boundary, pipelines that finished compiling are swapped in for this frame and
+    // the frame's arena region, statistics and timestamp queries are free again
+    PipelineManager::BeginFrame();
+    BufferSystem::beginFrame(TargetFrameIndex);
+    GpuProfiler::BeginFrame(TargetFrameIndex);
+    TerrainRenderer.BeginFrame(TargetFrameIndex);
+
     VkResult result = vkAcquireNextImageKHR(
         Device,
         Swapchain,
@@ -266,63 +342,47 @@ void InferusRenderer::LateRender() {
 
     vkResetFences(Device, 1, &TargetFrame.InFlight);
 
-    VkImageMemoryBarrier RenderingBarrier =
-        Recipes::ImageMemoryBarrier::Rendering::EnableRendering(SwapchainImages[TargetImageViewIndex].Image);
-    VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-    vkCmdPipelineBarrier(
-        cmd,
-        srcStage,
-        dstStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &RenderingBarrier
-    );
-
-    ColorAttachment.imageView = SwapchainImages[TargetImageViewIndex].ImageView;
-    vkCmdBeginRendering(cmd, &RenderingInfo);
-    vkCmdSetViewport(cmd, 0, 1, &Viewport);
-    vkCmdSetScissor(cmd, 0, 1, &Scissor);
-
-    // Actual frame begins
-
-    TerrainRenderer.Render(cmd);
-
-    ImGuiRenderer::LateRender(cmd);
-
-    // Actual frame ends
-
-    vkCmdEndRendering(cmd);
-
-    VkImageMemoryBarrier PresentingBarrier =
-        Recipes::ImageMemoryBarrier::Rendering::EnablePresenting(SwapchainImages[TargetImageViewIndex].Image);
-    VkPipelineStageFlags srcStage2 = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    VkPipelineStageFlags dstStage2 = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-
-    vkCmdPipelineBarrier(
-        cmd,
-        srcStage2,
-        dstStage2,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &PresentingBarrier
-    );
+    SwapchainImage& Target = SwapchainImages[TargetImageViewIndex];
+    FrameGraph.BindImage(SwapchainTarget, Target.Image, Target.ImageView);
+    {
+        GpuProfiler::Scope Profiled(cmd, "Frame");
+        // Ownership of whatever the uploads since the last frame wrote comes first
+        UploadSystem::RecordAcquires(cmd);
+        FrameGraph.Execute(cmd);
+    }
 
     vkEndCommandBuffer(cmd);
 
-    VkSemaphore RenderWaitSemaphores[] = { TargetFrame.ImageAvailable };
-    VkSemaphore RenderSignalSemaphores[] = { SwapchainImages[TargetImageViewIndex].RenderFinished };
-
-    PipelineCmdSubmitInfo.pCommandBuffers = &cmd;
-    PipelineCmdSubmitInfo.pWaitSemaphores = RenderWaitSemaphores;
-    PipelineCmdSubmitInfo.pSignalSemaphores = RenderSignalSemaphores;
-
-    PresentInfo.pWaitSemaphores = RenderSignalSemaphores;
-
-    vkQueueSubmit(Graphics.Queue, 1, &PipelineCmdSubmitInfo, TargetFrame.InFlight);
+    // The frame waits for the image and for the uploads it acquired, and signals the frame
+    // timeline so later uploads know when it's done reading
+    std::array<VkSemaphoreSubmitInfo, 2> RenderWaits {};
+    RenderWaits[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    RenderWaits[0].semaphore = TargetFrame.ImageAvailable;
+    RenderWaits[0].stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    uint32_t RenderWaitCount = UploadSystem::FrameWait(RenderWaits[1]) ? 2 : 1;
+
+    std::array<VkSemaphoreSubmitInfo, 2> RenderSignals {};
+    RenderSignals[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    RenderSignals[0].semaphore = Target.RenderFinished;
+    RenderSignals[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    RenderSignals[1] = UploadSystem::FrameSignal();
+
+    VkCommandBufferSubmitInfo RenderCmdInfo {};
+    RenderCmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+    RenderCmdInfo.commandBuffer = cmd;
+
+    VkSubmitInfo2 RenderSubmitInfo {};
+    RenderSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+    RenderSubmitInfo.waitSemaphoreInfoCount = RenderWaitCount;
+    RenderSubmitInfo.pWaitSemaphoreInfos = RenderWaits.data();
+    RenderSubmitInfo.commandBufferInfoCount = 1;
+    RenderSubmitInfo.pCommandBufferInfos = &RenderCmdInfo;
+    RenderSubmitInfo.signalSemaphoreInfoCount = static_cast<uint32_t>(RenderSignals.size());
+    RenderSubmitInfo.pSignalSemaphoreInfos = RenderSignals.data();
+
+    PresentInfo.pWaitSemaphores = &Target.RenderFinished;
+
+    vkQueueSubmit2(Graphics.Queue, 1, &RenderSubmitInfo, TargetFrame.InFlight);
     vkQueuePresentKHR(Present.Queue, &PresentInfo);
 
     TargetFrameIndex = (TargetFrameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
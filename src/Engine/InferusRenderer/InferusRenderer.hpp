@@ -9,6 +9,7 @@
 #include <vma/vk_mem_alloc.h>
 
 #include "Engine/Types.hpp"
+#include "Engine/InferusRenderer/RenderGraph.hpp"
 #include "Engine/InferusRenderer/Passes/ImGuiRenderer.hpp"
 #include "Engine/InferusRenderer/Passes/TerrainRenderer.hpp"
 
@@ -46,16 +47,14 @@ public:
     uint32_t TargetFrameIndex = 0;
     uint32_t TargetImageViewIndex = 0;
 
-    // Drawing -- I imagine this may be shared between all the other pipelines
-    static constexpr VkPipelineStageFlags G_PIPELINE_WAIT_STAGES[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-
     VkRect2D Scissor {};
     VkViewport Viewport {};
-    VkRenderingAttachmentInfo ColorAttachment {};
-    VkRenderingInfo RenderingInfo {};
+
+    // Barriers and layouts come from the graph, the swapchain image is bound every frame
+    RenderGraph FrameGraph;
+    RenderGraph::ResourceId SwapchainTarget = 0;
 
     VkCommandBufferBeginInfo PipelineCmdBeginInfo {};
-    VkSubmitInfo PipelineCmdSubmitInfo {};
 
     // "Passes"
     TerrainRenderer TerrainRenderer;
@@ -76,6 +75,7 @@ public:
 
 private:
     void RefreshExtent();
+    InferusResult BuildFrameGraph();
 
     void DestroySwapchain(VkSwapchainKHR OldSwapchain);
     void RecreateSwapchain(VkSwapchainKHR OldSwapchain);
@@ -1,6 +1,7 @@
 #include "ImGuiRenderer.hpp"
 
 #include <array>
+#include <chrono>
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -8,6 +9,7 @@
 
 #include "Engine/Core/Window.hpp"
 #include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/PipelineCache.hpp"
 #include "Engine/InferusRenderer/InferusRenderer.hpp"
 
 namespace ImGuiRenderer {
@@ -44,6 +46,7 @@ namespace ImGuiRenderer {
         InitInfo.QueueFamily = VulkanContext::Graphics.Index;
         InitInfo.Queue = VulkanContext::Graphics.Queue;
         InitInfo.PipelineInfoMain = PipelineInfo;
+        InitInfo.PipelineCache = PipelineCache::Cache;
         // InitInfo.DescriptorPool; -- Leave it alone so the backend creates one with .DescriptorPoolSize
         InitInfo.DescriptorPoolSize = IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE;
         InitInfo.MinImageCount = InferusRenderer.SurfaceCapabilities.minImageCount;
@@ -51,7 +54,10 @@ namespace ImGuiRenderer {
         InitInfo.UseDynamicRendering = true;
         InitInfo.MinAllocationSize = 1024 * 1024; // To satisfaz zealous best practices validation layer and waste a little memory.
 
+        // The backend builds its pipeline in here
+        auto PipelineBegin = std::chrono::steady_clock::now();
         ImGui_ImplVulkan_Init(&InitInfo);
+        PipelineCache::LogCreation("ImGui", std::chrono::steady_clock::now() - PipelineBegin);
 
         return InferusResult::SUCCESS;
     }
@@ -1,30 +1,43 @@
 #include "TerrainRenderer.hpp"
 
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include <imgui.h>
 #include <spdlog/spdlog.h>
 
 #include "Engine/InferusRenderer/Recipes.hpp"
 #include "Engine/Systems/Terrain/TerrainConfig.hpp"
 #include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/InferusRenderer.hpp"
 #include "Engine/Systems/Terrain/TerrainSystem.hpp"
+#include "Engine/InferusRenderer/PipelineManager.hpp"
 #include "Engine/InferusRenderer/Image/ImageSystem.hpp"
-#include "Engine/InferusRenderer/ShaderStageBuilder.hpp"
 #include "Engine/InferusRenderer/Buffer/BufferSystem.hpp"
+#include "Engine/InferusRenderer/Upload/UploadSystem.hpp"
+#include "Engine/InferusRenderer/Descriptor/DescriptorHeap.hpp"
+#include "Engine/InferusRenderer/Profiler/GpuProfiler.hpp"
 #include "Engine/Systems/Terrain/PlaneMeshIndicesGenerator.hpp"
 
+namespace {
+    // RendererConfig::TerrainRenderer::Mode order
+    constexpr const char* MODE_NAMES[RendererConfig::TerrainRenderer::MODE_COUNT] = { "Grid", "CDLOD", "Tessellation" };
+}
+
 InferusResult TerrainRenderer::Init(BufferSystem::Id &CreationWiseStagingBuffer) {
 
     VkDevice& Device = VulkanContext::Device;
 
     {
-        VkShaderStageFlags AllStages = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
-
         // Terrain heightmap
         {
             ImageSystem::ImageCreateInfo HeightmapImageCreateDesc;
             HeightmapImageCreateDesc.width = TerrainConfig::Chunk::RESOLUTION;
             HeightmapImageCreateDesc.height = TerrainConfig::Chunk::RESOLUTION;
             HeightmapImageCreateDesc.arrayLayers = TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT;
-            HeightmapImageCreateDesc.format = TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_FORMAT;
+            HeightmapImageCreateDesc.format = HEIGHTMAP_IMAGE_FORMAT;
             HeightmapImageCreateDesc.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
             HeightmapImageId = ImageSystem::add(HeightmapImageCreateDesc);
@@ -32,257 +45,149 @@ InferusResult TerrainRenderer::Init(BufferSystem::Id &CreationWiseStagingBuffer)
             auto HeightmapSamplerInfo = Recipes::SamplerCreateInfo::HeightmapSampler();
             vkCreateSampler(Device, &HeightmapSamplerInfo, nullptr, &HeightmapTextureSampler);
 
-            BufferSystem::CreateInfo HeightmapStagingBufferId_CreateInfo = {
-                .size = TerrainConfig::Heightmap::HEIGHTMAP_ALL_IMAGES_SIZE,
-                .memType = BufferSystem::CreateInfoMemoryType::STAGING_UPLOAD,
-                .usage = BufferSystem::CreateInfoUsage::STAGING
-            };
-            Heightmap_CPU = BufferSystem::add(HeightmapStagingBufferId_CreateInfo);
+            HeightmapMirror.assign(TerrainConfig::Heightmap::HEIGHTMAP_ALL_IMAGES_PIXEL_COUNT, 0);
+
+            RefreshChunkBoxes();
         }
 
-        // Chunk to Heightmap linking
-        {
-            BufferSystem::CreateInfo ChunkHeightmapLinksCPU_CreateDesc = {
-                .size = TerrainConfig::ChunkToHeightmapLinking::LINKING_BUFFER_SIZE,
-                .memType = BufferSystem::CreateInfoMemoryType::STAGING_UPLOAD,
-                .usage = BufferSystem::CreateInfoUsage::STAGING
-            };
-            BufferSystem::CreateInfo ChunkHeightmapLinksGPU_CreateDesc = {
-                .size = TerrainConfig::ChunkToHeightmapLinking::LINKING_BUFFER_SIZE,
-                .memType = BufferSystem::CreateInfoMemoryType::GPU_STATIC,
-                .usage = BufferSystem::CreateInfoUsage::SSBO
-            };
-
-            ChunkHeightmapLinks_CPU = BufferSystem::add(ChunkHeightmapLinksCPU_CreateDesc);
-            ChunkHeightmapLinks_GPU = BufferSystem::add(ChunkHeightmapLinksGPU_CreateDesc);
+        // Everything the shaders read is in the bindless heap, Render hands them the indices
+        HeightmapSamplerIndex = DescriptorHeap::AddSampler(HeightmapTextureSampler);
+        if (HeightmapSamplerIndex == DescriptorHeap::INVALID_INDEX) {
+            spdlog::error("Terrain heightmap sampler registration failed");
+            return InferusResult::FAIL;
         }
 
-        // Terrain System Descriptors
-        {
-            // Heightmap Texture Sampler descriptor
-            auto HeightmapImage = ImageSystem::get(HeightmapImageId);
-            VkDescriptorImageInfo HeightmapTextureDescriptorImageInfo {};
-            HeightmapTextureDescriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            HeightmapTextureDescriptorImageInfo.imageView = HeightmapImage.imageView;
-            HeightmapTextureDescriptorImageInfo.sampler = HeightmapTextureSampler;
-
-            VkDescriptorSetLayoutBinding HeightmapSetLayoutBinding {};
-            HeightmapSetLayoutBinding.binding = 0;
-            HeightmapSetLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            HeightmapSetLayoutBinding.descriptorCount = 1;
-            HeightmapSetLayoutBinding.stageFlags = AllStages;
-            HeightmapSetLayoutBinding.pImmutableSamplers = nullptr;
-
-            VkWriteDescriptorSet HeightmapSamplerWrite {};
-            HeightmapSamplerWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            HeightmapSamplerWrite.dstBinding = 0;
-            HeightmapSamplerWrite.dstArrayElement = 0;
-            HeightmapSamplerWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            HeightmapSamplerWrite.descriptorCount = 1;
-            HeightmapSamplerWrite.pImageInfo = &HeightmapTextureDescriptorImageInfo;
-
-            // Chunk to Heightmap descriptor
-            // TODO: The fact I'm not carrying offsets arround is most definitvelly a bad signal
-            auto ChunkLinkBuffer = BufferSystem::get(ChunkHeightmapLinks_GPU);
-            VkDescriptorBufferInfo ChunkToHeightmapDescriptorBufferInfo {};
-            ChunkToHeightmapDescriptorBufferInfo.buffer = ChunkLinkBuffer.buffer;
-            ChunkToHeightmapDescriptorBufferInfo.offset = 0;
-            ChunkToHeightmapDescriptorBufferInfo.range = ChunkLinkBuffer.size;
-
-            VkDescriptorSetLayoutBinding ChunkLinkBinding {};
-            ChunkLinkBinding.binding = 1;
-            ChunkLinkBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            ChunkLinkBinding.descriptorCount = 1;
-            ChunkLinkBinding.stageFlags = AllStages;
-            ChunkLinkBinding.pImmutableSamplers = nullptr;
-
-            VkWriteDescriptorSet ChunkLinkSSBOWrite {};
-            ChunkLinkSSBOWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            ChunkLinkSSBOWrite.dstBinding = 1;
-            ChunkLinkSSBOWrite.dstArrayElement = 0;
-            ChunkLinkSSBOWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            ChunkLinkSSBOWrite.descriptorCount = 1;
-            ChunkLinkSSBOWrite.pBufferInfo = &ChunkToHeightmapDescriptorBufferInfo;
-
-            // Descriptor layout
-            std::array<VkDescriptorSetLayoutBinding, 2> LayoutBindings = {
-                HeightmapSetLayoutBinding,
-                ChunkLinkBinding
-            };
-            VkDescriptorSetLayoutCreateInfo TerrainDescriptorSetLayoutCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = 0,
-                .bindingCount = static_cast<uint32_t>(LayoutBindings.size()),
-                .pBindings = LayoutBindings.data()
-            };
-            if (
-                vkCreateDescriptorSetLayout(
-                    Device,
-                    &TerrainDescriptorSetLayoutCreateInfo,
-                    nullptr,
-                    &TerrainDescriptorSet.layout
-                ) != VK_SUCCESS
-                )
-            {
-                spdlog::error("Terrain descriptor set layout creation failed");
-                return InferusResult::FAIL;
-            }
+        // Finally the terrain pipeline itself, compiled in the background, Render skips
+        // drawing until it's there
+        PipelineManager::GraphicsDesc TerrainPipelineDesc;
+        TerrainPipelineDesc.Name = "Terrain";
+        TerrainPipelineDesc.VertexShader = "shaders/terrain.vert.spv";
+        TerrainPipelineDesc.FragmentShader = "shaders/terrain.frag.spv";
+        TerrainPipelineDesc.Layout = DescriptorHeap::PipelineLayout();
+
+        TerrainPipelineDesc.VertexInput = Recipes::Pipeline::Parts::VertexInput::Default();
+        TerrainPipelineDesc.InputAssembly = Recipes::Pipeline::Parts::InputAssembly::Default();
+        TerrainPipelineDesc.ViewportState = Recipes::Pipeline::Parts::ViewportState::Default();
+        TerrainPipelineDesc.Rasterization = Recipes::Pipeline::Parts::Rasterization::Default();
+        TerrainPipelineDesc.Multisample = Recipes::Pipeline::Parts::Multisample::Default();
+        TerrainPipelineDesc.DepthStencil = Recipes::Pipeline::Parts::DepthStencil::Default();
 
-            // Descriptor pool
-            VkDescriptorPoolSize SamplerHeightmapPoolSize = {
-                .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = 1
-            };
-            VkDescriptorPoolSize SSBOHeightmapPoolSize = {
-                .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                .descriptorCount = 1
-            };
-            std::array<VkDescriptorPoolSize, 2> PoolSize = {
-                SamplerHeightmapPoolSize,
-                SSBOHeightmapPoolSize
-            };
-
-            VkDescriptorPoolCreateInfo PoolInfo{};
-            PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-            PoolInfo.poolSizeCount = static_cast<uint32_t>(PoolSize.size());
-            PoolInfo.pPoolSizes = PoolSize.data();
-            PoolInfo.maxSets = 1;
-
-            if (vkCreateDescriptorPool(Device, &PoolInfo, nullptr, &TerrainDescriptorSet.pool) != VK_SUCCESS) {
-                spdlog::error("Descriptor pool creation failed");
-                return InferusResult::FAIL;
-            }
+        // TODO: Do I need a depth attachment?
+        // Can I use this instead of picking chunks in order? Compare performance
+        TerrainPipelineDesc.ColorFormats = { VulkanContext::SurfaceFormat.format };
+        TerrainPipelineDesc.BlendAttachments.assign(
+            TerrainPipelineDesc.ColorFormats.size(), Recipes::Pipeline::Parts::ColorBlendAttachmentState::Default()
+        );
+        TerrainPipelineDesc.ColorBlendState = Recipes::Pipeline::Parts::ColorBlendState::Default(TerrainPipelineDesc.BlendAttachments);
 
-            VkDescriptorSetAllocateInfo allocInfo{};
-            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            allocInfo.descriptorPool = TerrainDescriptorSet.pool;
-            allocInfo.descriptorSetCount = 1;
-            allocInfo.pSetLayouts = &TerrainDescriptorSet.layout;
+        // TODO: Check if it's needed since we're already using dynamic rendering
+        TerrainPipelineDesc.DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+        TerrainPipelineId = PipelineManager::Request(TerrainPipelineDesc);
+
+        // Same state, only the vertex shader knows about nodes
+        PipelineManager::GraphicsDesc CdlodPipelineDesc = TerrainPipelineDesc;
+        CdlodPipelineDesc.Name = "Terrain CDLOD";
+        CdlodPipelineDesc.VertexShader = "shaders/terrain_cdlod.vert.spv";
+
+        CdlodPipelineId = PipelineManager::Request(CdlodPipelineDesc);
+
+        if (VulkanContext::TessellationSupported) {
+            PipelineManager::GraphicsDesc TessellationPipelineDesc = TerrainPipelineDesc;
+            TessellationPipelineDesc.Name = "Terrain tessellation";
+            TessellationPipelineDesc.VertexShader = "shaders/terrain_tess.vert.spv";
+            TessellationPipelineDesc.TessControlShader = "shaders/terrain_tess.tesc.spv";
+            TessellationPipelineDesc.TessEvalShader = "shaders/terrain_tess.tese.spv";
+            TessellationPipelineDesc.InputAssembly = Recipes::Pipeline::Parts::InputAssembly::Patches();
+            TessellationPipelineDesc.Tessellation = Recipes::Pipeline::Parts::Tessellation::Quads();
+
+            TessellationPipelineId = PipelineManager::Request(TessellationPipelineDesc);
+        } else if (Mode == RendererConfig::TerrainRenderer::Mode::Tessellation) {
+            spdlog::warn("No tessellation shaders on this device, terrain falls back to the grid");
+            Mode = RendererConfig::TerrainRenderer::Mode::Grid;
+        }
 
-            if (vkAllocateDescriptorSets(Device, &allocInfo, &TerrainDescriptorSet.set) != VK_SUCCESS) {
-                spdlog::error("Descriptor set allocation failed");
-                return InferusResult::FAIL;
-            }
+        PipelineManager::ComputeDesc CullPipelineDesc;
+        CullPipelineDesc.Name = "Terrain cull";
+        CullPipelineDesc.ComputeShader = "shaders/terrain_cull.comp.spv";
+        CullPipelineDesc.Layout = DescriptorHeap::PipelineLayout();
 
-            std::array<VkWriteDescriptorSet, 2> TerrainWrites = {
-                HeightmapSamplerWrite, ChunkLinkSSBOWrite
-            };
-            for (VkWriteDescriptorSet& write : TerrainWrites) {
-                write.dstSet = TerrainDescriptorSet.set;
-            }
+        CullPipelineId = PipelineManager::Request(CullPipelineDesc);
+    }
 
-            vkUpdateDescriptorSets(Device, static_cast<uint32_t>(TerrainWrites.size()), TerrainWrites.data(), 0, nullptr);
-        }
+    // Cull output, rewritten every frame by the GPU alone
+    {
+        BufferSystem::CreateInfo DrawsBufferCreateDescription = {
+            .size = TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT * sizeof(VkDrawIndexedIndirectCommand),
+            .memType = BufferSystem::CreateInfoMemoryType::GPU_STATIC,
+            .usage = BufferSystem::CreateInfoUsage::INDIRECT,
+        };
+        DrawsBufferId = BufferSystem::add(DrawsBufferCreateDescription);
 
-        TerrainPipelineLayout = {};
-        VkPushConstantRange TerrainPushConstantRange = {
-            .stageFlags = AllStages,
-            .offset = 0,
-            .size = static_cast<uint32_t>(sizeof(TerrainPushConstants))
+        BufferSystem::CreateInfo DrawCountBufferCreateDescription = {
+            .size = sizeof(uint32_t),
+            .memType = BufferSystem::CreateInfoMemoryType::GPU_STATIC,
+            .usage = BufferSystem::CreateInfoUsage::INDIRECT,
         };
+        DrawCountBufferId = BufferSystem::add(DrawCountBufferCreateDescription);
 
-        VkPipelineLayoutCreateInfo TerrainPipelineLayoutCreateInfo {};
-        TerrainPipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        TerrainPipelineLayoutCreateInfo.setLayoutCount = 1;
-        TerrainPipelineLayoutCreateInfo.pSetLayouts = &TerrainDescriptorSet.layout;
-        TerrainPipelineLayoutCreateInfo.pPushConstantRanges = &TerrainPushConstantRange;
-        TerrainPipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-        if (vkCreatePipelineLayout(Device, &TerrainPipelineLayoutCreateInfo, nullptr, &TerrainPipelineLayout) != VK_SUCCESS) {
-            spdlog::error("Terrain pipeline layout creation failed");
+        if (
+            BufferSystem::get(DrawsBufferId).descriptor == DescriptorHeap::INVALID_INDEX ||
+            BufferSystem::get(DrawCountBufferId).descriptor == DescriptorHeap::INVALID_INDEX
+        ) {
+            spdlog::error("Terrain cull buffers creation failed");
             return InferusResult::FAIL;
         }
+    }
 
-        // Finally creating the terrain VkPipeline itself
-        // TODO: Check if it's needed since we're already using dynamic rendering
-        std::vector<VkDynamicState> DynamicStates {};
-        DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-        VkPipelineDynamicStateCreateInfo DynamicState {};
-        DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        DynamicState.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
-        DynamicState.pDynamicStates = DynamicStates.data();
-
-        // TODO: Do I need a depth attachment?
-        // Can I use this instead of picking chunks in order? Compare performance
-        VkFormat DepthAttachmentFormat = VK_FORMAT_UNDEFINED;
-
-        std::array<VkFormat, 1> ColorAttachmentFormats = { VulkanContext::SurfaceFormat.format };
-        auto TerrainColorBlendState = Recipes::Pipeline::Parts::ColorBlendAttachmentState::Default();
-        std::vector<VkPipelineColorBlendAttachmentState> TerrainBlendAttachments(ColorAttachmentFormats.size(), TerrainColorBlendState);
-        VkPipelineRenderingCreateInfo RenderingCreateInfo{};
-        RenderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
-        RenderingCreateInfo.colorAttachmentCount = static_cast<uint32_t>(ColorAttachmentFormats.size());
-        RenderingCreateInfo.pColorAttachmentFormats = ColorAttachmentFormats.data();
-        RenderingCreateInfo.depthAttachmentFormat = DepthAttachmentFormat;
-        RenderingCreateInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
-
-        auto VertexInput = Recipes::Pipeline::Parts::VertexInput::Default();
-        auto InputAssembly = Recipes::Pipeline::Parts::InputAssembly::Default();
-        auto ViewportState = Recipes::Pipeline::Parts::ViewportState::Default();
-        auto Rasterization = Recipes::Pipeline::Parts::Rasterization::Default();
-        auto Multisample = Recipes::Pipeline::Parts::Multisample::Default();
-        auto DepthStencil = Recipes::Pipeline::Parts::DepthStencil::Default();
-        auto ColorBlendState = Recipes::Pipeline::Parts::ColorBlendState::Default(TerrainBlendAttachments);
-
-        VkGraphicsPipelineCreateInfo TerrainPipelineCreateInfo {};
-        TerrainPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        TerrainPipelineCreateInfo.pVertexInputState = &VertexInput;
-        TerrainPipelineCreateInfo.pInputAssemblyState = &InputAssembly;
-        TerrainPipelineCreateInfo.pViewportState = &ViewportState;
-        TerrainPipelineCreateInfo.pRasterizationState = &Rasterization;
-        TerrainPipelineCreateInfo.pMultisampleState = &Multisample;
-        TerrainPipelineCreateInfo.pDepthStencilState = &DepthStencil;
-        TerrainPipelineCreateInfo.pColorBlendState = &ColorBlendState;
-        TerrainPipelineCreateInfo.pDynamicState = &DynamicState;
-        TerrainPipelineCreateInfo.layout = TerrainPipelineLayout;
-        TerrainPipelineCreateInfo.basePipelineIndex = -1;
-        TerrainPipelineCreateInfo.pNext = &RenderingCreateInfo;
-
-        // Add shaders
-        std::vector<VkPipelineShaderStageCreateInfo> ShaderStages;
-        std::vector<char> ShaderBuffer;
-        ShaderBuffer.reserve(4096);
-
-        ShaderStages.push_back(
-            ShaderBuilder::CreateShaderStage(
-                VK_SHADER_STAGE_VERTEX_BIT,
-                "shaders/terrain.vert.spv",
-                ShaderBuffer,
-                Device
-            )
-        );
-        ShaderStages.push_back(
-            ShaderBuilder::CreateShaderStage(
-                VK_SHADER_STAGE_FRAGMENT_BIT,
-                "shaders/terrain.frag.spv",
-                ShaderBuffer,
-                Device
-            )
-        );
-
-        TerrainPipelineCreateInfo.stageCount = static_cast<uint32_t>(ShaderStages.size());
-        TerrainPipelineCreateInfo.pStages = ShaderStages.data();
+    // What the terrain draws cost, the readout compares modes with it
+    if (VulkanContext::PipelineStatisticsSupported) {
+        VkQueryPoolCreateInfo StatisticsPoolCreateInfo {};
+        StatisticsPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        StatisticsPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        StatisticsPoolCreateInfo.queryCount = InferusRenderer::MAX_FRAMES_IN_FLIGHT;
+        StatisticsPoolCreateInfo.pipelineStatistics =
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT;
+        if (VulkanContext::TessellationSupported) {
+            StatisticsPoolCreateInfo.pipelineStatistics |= VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+        }
 
-        if (
-            vkCreateGraphicsPipelines(Device, VK_NULL_HANDLE, 1, &TerrainPipelineCreateInfo, nullptr, &TerrainPipeline) != VK_SUCCESS
-            ) {
-            spdlog::error("Terrain Pipeline creation failed.");
-            return InferusResult::FAIL;
+        if (vkCreateQueryPool(Device, &StatisticsPoolCreateInfo, nullptr, &StatisticsPool) != VK_SUCCESS) {
+            spdlog::warn("Terrain statistics query pool creation failed, going without");
+            StatisticsPool = VK_NULL_HANDLE;
         }
+    }
 
-        // TODO: Add caching
-        // As of now just destroy the shader modules
-        for (auto ShaderStage : ShaderStages) {
-            if (ShaderStage.module) { vkDestroyShaderModule(Device, ShaderStage.module, nullptr); }
+    // The whole heightmap starts out readable, the frame graph expects it in SHADER_READ_ONLY
+    // between frames and uploads only ever move single layers out and back. The statistics
+    // queries start out reset, BeginFrame reads them before any frame recorded its own reset.
+    {
+        ImageSystem::Image& HeightmapImage = ImageSystem::get(HeightmapImageId);
+        VkImageMemoryBarrier2 ReadableBarrier = Recipes::ImageMemoryBarrier::Default(HeightmapImage);
+        ReadableBarrier.dstStageMask = VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT;
+        ReadableBarrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        ReadableBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ReadableBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkDependencyInfo Dependency {};
+        Dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        Dependency.imageMemoryBarrierCount = 1;
+        Dependency.pImageMemoryBarriers = &ReadableBarrier;
+
+        VkCommandBuffer GraphicsCmd = VulkanContext::SingleTimeCmdBegin(VulkanContext::Graphics);
+        vkCmdPipelineBarrier2(GraphicsCmd, &Dependency);
+        if (StatisticsPool) {
+            vkCmdResetQueryPool(GraphicsCmd, StatisticsPool, 0, InferusRenderer::MAX_FRAMES_IN_FLIGHT);
         }
+        VulkanContext::SingleTimeCmdSubmit(VulkanContext::Graphics, GraphicsCmd);
+        HeightmapImage.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     }
 
     // --- Creation wise command buffer begins
     VkCommandBuffer TransferCmd = VulkanContext::SingleTimeCmdBegin(VulkanContext::Transfer);
 
-    // Terrain plane mesh indices buffer
-    std::array<uint32_t, TerrainConfig::Chunk::INDICES_COUNT> TerrainPlaneMeshIndices;
-    PlaneMeshIndicesGenerator::GetIndices(TerrainPlaneMeshIndices.data());
+    // Terrain plane mesh indices buffer, generated at compile time in the cache friendly order
+    static constexpr auto TerrainPlaneMeshIndices = PlaneMeshIndicesGenerator::MakeIndices();
 
     BufferSystem::CreateInfo PlaneMeshIndexBufferCreateDescription = {
         .size = TerrainConfig::Chunk::INDICES_BUFFER_SIZE,
@@ -291,6 +196,7 @@ InferusResult TerrainRenderer::Init(BufferSystem::Id &CreationWiseStagingBuffer)
     };
     PlaneMeshIndexBufferId = BufferSystem::add(PlaneMeshIndexBufferCreateDescription);
     PlaneMeshIndexVkBuffer = BufferSystem::get(PlaneMeshIndexBufferId).buffer;
+    PlaneMeshIndexOffset = BufferSystem::get(PlaneMeshIndexBufferId).offset;
 
     BufferSystem::upload(
         TransferCmd,
@@ -303,6 +209,37 @@ InferusResult TerrainRenderer::Init(BufferSystem::Id &CreationWiseStagingBuffer)
     // --- Creation wise command buffer ends
     VulkanContext::SingleTimeCmdSubmit(VulkanContext::Transfer, TransferCmd);
 
+    // Patch indices of the other modes, a submit each since uploads always stage at the
+    // start of the staging buffer
+    auto UploadPatchIndices = [&CreationWiseStagingBuffer](
+        const TerrainConfig::Chunk::Index* Indices, VkDeviceSize Size, BufferSystem::Id& Id, VkBuffer& Buffer, VkDeviceSize& Offset
+    ) {
+        BufferSystem::CreateInfo IndexBufferCreateDescription = {
+            .size = Size,
+            .memType = BufferSystem::CreateInfoMemoryType::GPU_STATIC,
+            .usage = BufferSystem::CreateInfoUsage::INDEX,
+        };
+        Id = BufferSystem::add(IndexBufferCreateDescription);
+        Buffer = BufferSystem::get(Id).buffer;
+        Offset = BufferSystem::get(Id).offset;
+
+        VkCommandBuffer PatchCmd = VulkanContext::SingleTimeCmdBegin(VulkanContext::Transfer);
+        BufferSystem::upload(PatchCmd, CreationWiseStagingBuffer, Id, Indices, Size);
+        VulkanContext::SingleTimeCmdSubmit(VulkanContext::Transfer, PatchCmd);
+    };
+
+    static constexpr auto CdlodPatchIndices = PlaneMeshIndicesGenerator::MakePatchIndices();
+    UploadPatchIndices(
+        CdlodPatchIndices.data(), TerrainConfig::Lod::PATCH_INDICES_BUFFER_SIZE,
+        PatchIndexBufferId, PatchIndexVkBuffer, PatchIndexOffset
+    );
+
+    static constexpr auto TessellationPatchIndices = PlaneMeshIndicesGenerator::MakeTessellationPatchIndices();
+    UploadPatchIndices(
+        TessellationPatchIndices.data(), TerrainConfig::Tessellation::PATCH_INDICES_BUFFER_SIZE,
+        TessellationIndexBufferId, TessellationIndexVkBuffer, TessellationIndexOffset
+    );
+
     // Zeroing terrain push constants
     TerrainPushConstants = {
         .CameraMVP = glm::mat4(0),
@@ -311,145 +248,595 @@ InferusResult TerrainRenderer::Init(BufferSystem::Id &CreationWiseStagingBuffer)
 
     BufferSystem::del(CreationWiseStagingBuffer);
 
+    if (RendererConfig::TerrainRenderer::CAPTURE_ON_START) {
+        StartCapture();
+    }
+
     return InferusResult::SUCCESS;
 }
 
 void TerrainRenderer::Destroy() {
     VkDevice& Device = VulkanContext::Device;
 
-    BufferSystem::del(ChunkHeightmapLinks_CPU);
-    BufferSystem::del(ChunkHeightmapLinks_GPU);
-
-    BufferSystem::del(Heightmap_CPU);
+    HeightmapMirror.clear();
 
     BufferSystem::del(PlaneMeshIndexBufferId);
+    BufferSystem::del(PatchIndexBufferId);
+    BufferSystem::del(TessellationIndexBufferId);
+    if (StatisticsPool) { vkDestroyQueryPool(Device, StatisticsPool, nullptr); }
+    BufferSystem::del(DrawsBufferId);
+    BufferSystem::del(DrawCountBufferId);
 
+    DescriptorHeap::Release(DescriptorHeap::Binding::Samplers, HeightmapSamplerIndex);
     if (HeightmapTextureSampler) { vkDestroySampler(Device, HeightmapTextureSampler, nullptr); }
     ImageSystem::del(HeightmapImageId);
+}
 
-    if (TerrainDescriptorSet.pool) { vkDestroyDescriptorPool(Device, TerrainDescriptorSet.pool, nullptr); }
-    if (TerrainDescriptorSet.layout) { vkDestroyDescriptorSetLayout(Device, TerrainDescriptorSet.layout, nullptr); }
+void TerrainRenderer::FeedTerrainSystemPointers() {
+    // TerrainSystem packs finished chunks straight into the mirror
+    TerrainSystem::FeedTerrainRenderer(HeightmapMirror.data());
 
-    if (TerrainPipeline) { vkDestroyPipeline(Device, TerrainPipeline, nullptr); }
-    if (TerrainPipelineLayout) { vkDestroyPipelineLayout(Device, TerrainPipelineLayout, nullptr); }
+    UploadDirtyChunks();
 }
 
-void TerrainRenderer::FeedTerrainSystemPointers() {
-    QueueContext& Transfer = VulkanContext::Transfer;
-    QueueContext& Graphics = VulkanContext::Graphics;
+void TerrainRenderer::FeedCamera(const glm::vec3* Position) {
+    PlayerPosition = Position;
+}
 
-    TerrainSystem::FeedTerrainRenderer(
-        (ChunkHeightmapLink*)BufferSystem::map(ChunkHeightmapLinks_CPU),
-        (uint16_t*)BufferSystem::map(Heightmap_CPU)
-    );
+void TerrainRenderer::Resize(VkExtent2D Extent) {
+    ViewportHeight = static_cast<float>(Extent.height);
+}
 
-    VkCommandBuffer cmd = VulkanContext::SingleTimeCmdBegin(Transfer);
+void TerrainRenderer::UploadDirtyChunks() {
+    if (!TerrainSystem::HasPendingUpload()) {
+        return;
+    }
 
-    // Copy chunk link buffer
-    BufferSystem::copy(
-        cmd,
-        ChunkHeightmapLinks_CPU,
-        ChunkHeightmapLinks_GPU,
-        TerrainConfig::ChunkToHeightmapLinking::LINKING_BUFFER_SIZE
-    );
-    BufferSystem::unmap(ChunkHeightmapLinks_CPU);
-    BufferSystem::unmap(Heightmap_CPU);
+    // Links go out right away, slots whose layer isn't on the GPU yet get hidden below
+    TerrainSystem::PublishLinks(ChunkHeightmapLinks);
+    RefreshChunkBoxes();
+
+    // A slot refilled twice since the last upload is copied once
+    std::vector<uint32_t> DirtySlots = TerrainSystem::GetDirtySlots();
+    std::sort(DirtySlots.begin(), DirtySlots.end());
+    DirtySlots.erase(std::unique(DirtySlots.begin(), DirtySlots.end()), DirtySlots.end());
+
+    // Layers out of view wait until they come into it, the upload then lands on the very
+    // frame that first shows them
+    FrustumCulling::Frustum View = FrustumCulling::FromMatrix(TerrainPushConstants.CameraMVP);
+    std::erase_if(DirtySlots, [this, &View](uint32_t Slot) {
+        glm::vec3 Min = { ChunkBoxes.MinX[Slot], ChunkBoxes.MinY[Slot], ChunkBoxes.MinZ[Slot] };
+        glm::vec3 Max = { ChunkBoxes.MaxX[Slot], ChunkBoxes.MaxY[Slot], ChunkBoxes.MaxZ[Slot] };
+        return !FrustumCulling::IsVisible(View, Min, Max);
+    });
+
+    std::vector<uint32_t> Uploaded;
+    if (!DirtySlots.empty() && UploadLayers(DirtySlots)) {
+        Uploaded = std::move(DirtySlots);
+    }
+    TerrainSystem::ClearDirtySlots(Uploaded);
+
+    // The frame acquiring the layers is the first to see them visible, whatever is still
+    // dirty keeps showing nothing rather than the slot's previous chunk
+    for (uint32_t Slot : TerrainSystem::GetDirtySlots()) {
+        ChunkHeightmapLinks[Slot].IsVisible = 0;
+    }
+}
+
+bool TerrainRenderer::UploadLayers(const std::vector<uint32_t>& Slots) {
+    // Every upload batch is still in flight, the slots stay dirty and go out with a later frame
+    if (!UploadSystem::Begin()) {
+        return false;
+    }
+
+    // All or nothing, a full ring leaves the batch open for the next try
+    UploadSystem::Staging Staging;
+    if (!UploadSystem::Allocate(Slots.size() * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE, 16, Staging)) {
+        return false;
+    }
+    uint8_t* StagingMapped = static_cast<uint8_t*>(Staging.Mapped);
 
-    // Upload heightmap to staging buffer
-    BufferSystem::Buffer HeightmapStagingBuffer = BufferSystem::get(Heightmap_CPU);
     ImageSystem::Image HeightmapImage = ImageSystem::get(HeightmapImageId);
 
-    // Transfer data to heightmap image
-    VkImageMemoryBarrier barrier1 = Recipes::ImageMemoryBarrier::TransferDest(HeightmapImage);
-    VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    vkCmdPipelineBarrier(
-        cmd,
-        srcStage,
-        dstStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier1
-    );
+    std::vector<VkImageMemoryBarrier2> ToTransferBarriers;
+    std::vector<VkBufferImageCopy> LayerCopies;
+    ToTransferBarriers.reserve(Slots.size());
+    LayerCopies.reserve(Slots.size());
+
+    for (size_t i = 0; i < Slots.size(); i++) {
+        VkDeviceSize LayerOffset = i * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE;
+        memcpy(
+            StagingMapped + LayerOffset,
+            &HeightmapMirror[Slots[i] * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT],
+            TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE
+        );
+
+        // The layer is fully rewritten, so coming from UNDEFINED is fine and spares the
+        // graphics queue from releasing it first
+        ToTransferBarriers.push_back(
+            Recipes::ImageMemoryBarrier::Layer(Recipes::ImageMemoryBarrier::TransferDest(HeightmapImage), Slots[i])
+        );
+        LayerCopies.push_back(
+            Recipes::BufferImageCopy::Layer(HeightmapImage, Slots[i], Staging.Offset + LayerOffset)
+        );
+    }
+
+    VkCommandBuffer cmd = UploadSystem::Cmd();
+
+    VkDependencyInfo Dependency {};
+    Dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    Dependency.imageMemoryBarrierCount = static_cast<uint32_t>(ToTransferBarriers.size());
+    Dependency.pImageMemoryBarriers = ToTransferBarriers.data();
+    vkCmdPipelineBarrier2(cmd, &Dependency);
 
-    VkBufferImageCopy HeightmapCopy = Recipes::BufferImageCopy::Default(HeightmapImage);
     vkCmdCopyBufferToImage(
         cmd,
-        HeightmapStagingBuffer.buffer,
+        Staging.Buffer,
         HeightmapImage.image,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &HeightmapCopy
+        static_cast<uint32_t>(LayerCopies.size()),
+        LayerCopies.data()
     );
 
-    VkImageMemoryBarrier barrier2 = Recipes::ImageMemoryBarrier::ShaderRead(HeightmapImage);
-    barrier2.srcQueueFamilyIndex = Transfer.Index;
-    barrier2.dstQueueFamilyIndex = Graphics.Index;
-    barrier2.dstAccessMask = 0;
-    srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    // Overwritten layers may still be sampled by the last frame that staged them, the copies
+    // wait for it on the GPU. Usually it's long done, the slot's old chunk was unlinked
+    // frames before its replacement got here.
+    uint64_t LastUse = 0;
+    for (uint32_t Slot : Slots) {
+        LastUse = std::max(LastUse, SlotLastFrame[Slot]);
+    }
+    UploadSystem::WaitForFrame(LastUse);
 
-    vkCmdPipelineBarrier(
-        cmd,
-        srcStage,
-        dstStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier2
-    );
+    for (uint32_t Slot : Slots) {
+        UploadSystem::Handoff(
+            Recipes::ImageMemoryBarrier::Layer(Recipes::ImageMemoryBarrier::ShaderRead(HeightmapImage), Slot)
+        );
+    }
+
+    UploadSystem::Submit();
+
+    return true;
+}
+
+void TerrainRenderer::RefreshChunkBoxes() {
+    constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+    constexpr float HEIGHT_SCALE = TerrainConfig::Chunk::HEIGHT_SCALE;
+
+    // From scratch, group bounds only ever grow. Same placement as terrain.vert.
+    ChunkBoxes.Resize(TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT);
+    for (uint32_t i = 0; i < TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT; i++) {
+        const ChunkHeightmapLink& Link = ChunkHeightmapLinks[i];
+        glm::vec3 Min = { Link.WorldPos.x * WORLD_SIZE, Link.MinHeight * HEIGHT_SCALE, Link.WorldPos.y * WORLD_SIZE };
+        glm::vec3 Max = { Min.x + WORLD_SIZE, Link.MaxHeight * HEIGHT_SCALE, Min.z + WORLD_SIZE };
+        ChunkBoxes.Set(i, Min, Max);
+    }
+}
+
+void TerrainRenderer::BeginFrame(uint32_t FrameIndex) {
+    StatisticsQuery = FrameIndex;
+    StatisticsFresh = false;
+
+    if (StatisticsPool) {
+        // Vertex, clipping then tessellation evaluation invocations, bit order. Not ready means
+        // that frame didn't draw terrain, the last numbers stay.
+        uint64_t Results[3] = {};
+        VkResult Result = vkGetQueryPoolResults(
+            VulkanContext::Device,
+            StatisticsPool,
+            StatisticsQuery,
+            1,
+            sizeof(Results),
+            Results,
+            sizeof(Results),
+            VK_QUERY_RESULT_64_BIT
+        );
+        if (Result == VK_SUCCESS) {
+            VertexInvocations = Results[0];
+            Primitives = Results[1];
+            TessellationInvocations = VulkanContext::TessellationSupported ? Results[2] : 0;
+            StatisticsFresh = true;
+        }
+    }
+
+    StepCapture();
+}
+
+void TerrainRenderer::StartCapture() {
+    if (Capturing) {
+        return;
+    }
+    for (CaptureTotals& Totals : CaptureResults) {
+        Totals = {};
+    }
+    CaptureRestore = Mode;
+    Capturing = true;
+    spdlog::info("Capturing terrain modes, {} frames each", RendererConfig::TerrainRenderer::CAPTURE_FRAMES);
+    NextCaptureMode(0);
+}
+
+void TerrainRenderer::StepCapture() {
+    constexpr uint32_t WARMUP = RendererConfig::TerrainRenderer::CAPTURE_WARMUP_FRAMES;
+    constexpr uint32_t FRAMES = RendererConfig::TerrainRenderer::CAPTURE_FRAMES;
+    if (!Capturing) {
+        return;
+    }
+
+    uint32_t Current = static_cast<uint32_t>(Mode);
+    CaptureTotals& Totals = CaptureResults[Current];
+
+    // Frames the statistics missed drew no terrain (its pipeline still compiling), they'd
+    // only drag the averages down
+    if (CaptureFrame >= WARMUP && (StatisticsFresh || !StatisticsPool)) {
+        Totals.Frames++;
+        Totals.FrameMs += GpuProfiler::LatestMs("Frame");
+        Totals.CullMs += GpuProfiler::LatestMs("Terrain cull");
+        Totals.TerrainMs += GpuProfiler::LatestMs("Terrain");
+        Totals.Primitives += static_cast<double>(Primitives);
+        Totals.VertexInvocations += static_cast<double>(VertexInvocations);
+        Totals.TessellationInvocations += static_cast<double>(TessellationInvocations);
+    }
+    CaptureFrame++;
+
+    // A mode that never draws is given up on after twice its frames
+    if (Totals.Frames == FRAMES || CaptureFrame == WARMUP + FRAMES * 2) {
+        Totals.ValidationErrors = VulkanContext::ValidationErrors - CaptureErrorsBefore;
+        NextCaptureMode(Current + 1);
+    }
+}
+
+void TerrainRenderer::NextCaptureMode(uint32_t Next) {
+    using enum RendererConfig::TerrainRenderer::Mode;
+
+    // Its row stays empty on devices without tessellation
+    if (Next == static_cast<uint32_t>(Tessellation) && !VulkanContext::TessellationSupported) {
+        Next++;
+    }
+    if (Next == RendererConfig::TerrainRenderer::MODE_COUNT) {
+        WriteCapture();
+        Mode = CaptureRestore;
+        Capturing = false;
+        return;
+    }
+
+    Mode = static_cast<RendererConfig::TerrainRenderer::Mode>(Next);
+    CaptureFrame = 0;
+    CaptureErrorsBefore = VulkanContext::ValidationErrors;
+}
+
+void TerrainRenderer::WriteCapture() {
+    const char* Path = RendererConfig::TerrainRenderer::CAPTURE_PATH;
+
+    std::ofstream File(Path, std::ios::trunc);
+    File << "mode,frames,frame_ms,cull_ms,terrain_ms,primitives,vertex_invocations,tessellation_invocations,validation_errors\n";
+    for (uint32_t i = 0; i < RendererConfig::TerrainRenderer::MODE_COUNT; i++) {
+        const CaptureTotals& Totals = CaptureResults[i];
+        double PerFrame = 1.0 / std::max(Totals.Frames, 1u);
+        File << MODE_NAMES[i] << ',' << Totals.Frames << ','
+             << Totals.FrameMs * PerFrame << ',' << Totals.CullMs * PerFrame << ',' << Totals.TerrainMs * PerFrame << ','
+             << Totals.Primitives * PerFrame << ',' << Totals.VertexInvocations * PerFrame << ','
+             << Totals.TessellationInvocations * PerFrame << ',' << Totals.ValidationErrors << '\n';
+
+        spdlog::info("{}: {} frames, terrain {:.3f} ms, {:.0f} primitives, {:.0f} vertex and {:.0f} tessellation invocations, {} validation errors",
+                     MODE_NAMES[i], Totals.Frames, Totals.TerrainMs * PerFrame, Totals.Primitives * PerFrame,
+                     Totals.VertexInvocations * PerFrame, Totals.TessellationInvocations * PerFrame, Totals.ValidationErrors);
+    }
+
+    File.flush();
+    if (!File) {
+        spdlog::warn("Couldn't write terrain mode capture {}", Path);
+        return;
+    }
+    spdlog::info("Terrain mode capture written to {}", Path);
+}
+
+void TerrainRenderer::ResetDrawCount(VkCommandBuffer cmd) {
+    const BufferSystem::Buffer& DrawCount = BufferSystem::get(DrawCountBufferId);
+    vkCmdFillBuffer(cmd, DrawCount.buffer, DrawCount.offset, sizeof(uint32_t), 0);
+
+    if (StatisticsPool) {
+        vkCmdResetQueryPool(cmd, StatisticsPool, StatisticsQuery, 1);
+    }
+}
+
+void TerrainRenderer::Cull(VkCommandBuffer cmd) {
+    LodSelection.Clear();
+    StagedInstances = 0;
+    if (PlayerPosition) {
+        TerrainPushConstants.PlayerPosition = glm::vec4(*PlayerPosition, 1.0f);
+    }
+
+    // Skipping leaves the count at zero, Render then draws nothing. CDLOD selects on the
+    // CPU and doesn't need the dispatch.
+    bool Cdlod = Mode == RendererConfig::TerrainRenderer::Mode::Cdlod;
+    VkPipeline CullPipeline = PipelineManager::Get(CullPipelineId);
+    if (!Cdlod && CullPipeline == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // Links in view, in slot order, resident or not
+    uint32_t InstanceCount = TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT;
+    if (RendererConfig::TerrainRenderer::CPU_CULLING) {
+        FrustumCulling::Frustum View = FrustumCulling::FromMatrix(TerrainPushConstants.CameraMVP);
+        VisibleChunks.resize(ChunkBoxes.Count);
+        InstanceCount = FrustumCulling::Cull(View, ChunkBoxes, VisibleChunks.data());
+        if (InstanceCount == 0) {
+            return;
+        }
+    }
+
+    // Staged once, the cull and the vertex shader read the same copy
+    BufferSystem::FrameSlice Links = BufferSystem::frameAlloc(InstanceCount * sizeof(ChunkHeightmapLink));
+    if (!Links.mapped) {
+        return;
+    }
+
+    // Slots staged visible may be sampled until this frame is done, see SlotLastFrame
+    uint64_t Frame = UploadSystem::RecordingFrame();
+    if (RendererConfig::TerrainRenderer::CPU_CULLING) {
+        // Compacted, draws index the staged copy so nothing else needs to know
+        ChunkHeightmapLink* Staged = static_cast<ChunkHeightmapLink*>(Links.mapped);
+        uint32_t Resident = 0;
+        for (uint32_t i = 0; i < InstanceCount; i++) {
+            const ChunkHeightmapLink& Link = ChunkHeightmapLinks[VisibleChunks[i]];
+            if (Link.IsVisible) {
+                Staged[Resident++] = Link;
+                SlotLastFrame[Link.InstanceId] = Frame;
+            }
+        }
+        InstanceCount = Resident;
+    } else {
+        memcpy(Links.mapped, ChunkHeightmapLinks, TerrainConfig::ChunkToHeightmapLinking::LINKING_BUFFER_SIZE);
+        for (const ChunkHeightmapLink& Link : ChunkHeightmapLinks) {
+            if (Link.IsVisible) {
+                SlotLastFrame[Link.InstanceId] = Frame;
+            }
+        }
+    }
 
-    VulkanContext::SingleTimeCmdSubmit(Transfer, cmd);
+    TerrainPushConstants.HeightmapImage = ImageSystem::get(HeightmapImageId).descriptor;
+    TerrainPushConstants.HeightmapSampler = HeightmapSamplerIndex;
+    TerrainPushConstants.LinksBuffer = BufferSystem::frameArenaDescriptor();
+    TerrainPushConstants.LinksFirst = static_cast<uint32_t>(Links.offset / sizeof(ChunkHeightmapLink));
+    StagedInstances = InstanceCount;
+
+    // Vertical projection scale off the matrix, its y row is the view's scaled by it
+    const glm::mat4& ViewProjection = TerrainPushConstants.CameraMVP;
+    float FocalLength = glm::length(glm::vec3(ViewProjection[0][1], ViewProjection[1][1], ViewProjection[2][1]));
+    TerrainPushConstants.FocalPixels = FocalLength * ViewportHeight * 0.5f;
+    TerrainPushConstants.EdgePixels = TessellationEdgePixels;
+
+    if (Cdlod) {
+        SelectLods(static_cast<const ChunkHeightmapLink*>(Links.mapped), InstanceCount);
+        return;
+    }
 
-    cmd = VulkanContext::SingleTimeCmdBegin(Graphics);
+    TerrainCullPushConstants CullPushConstants = {
+        .ViewProjection = TerrainPushConstants.CameraMVP,
+        .LinksBuffer = TerrainPushConstants.LinksBuffer,
+        .LinksFirst = TerrainPushConstants.LinksFirst,
+        .DrawsBuffer = BufferSystem::get(DrawsBufferId).descriptor,
+        .DrawCountBuffer = BufferSystem::get(DrawCountBufferId).descriptor,
+        .InstanceCount = InstanceCount,
+        .IndexCount = Mode == RendererConfig::TerrainRenderer::Mode::Tessellation
+            ? TerrainConfig::Tessellation::PATCH_INDICES_COUNT
+            : TerrainConfig::Chunk::INDICES_COUNT
+    };
 
-    VkImageMemoryBarrier barrier3 = Recipes::ImageMemoryBarrier::ShaderRead(HeightmapImage);
-    barrier3.srcQueueFamilyIndex = Transfer.Index;
-    barrier3.dstQueueFamilyIndex = Graphics.Index;
-    barrier3.srcAccessMask = 0;
-    srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, CullPipeline);
+    DescriptorHeap::Bind(cmd, VK_PIPELINE_BIND_POINT_COMPUTE);
 
-    vkCmdPipelineBarrier(
+    vkCmdPushConstants(
         cmd,
-        srcStage,
-        dstStage,
+        DescriptorHeap::PipelineLayout(),
+        VK_SHADER_STAGE_ALL,
         0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier3
+        sizeof(CullPushConstants),
+        &CullPushConstants
     );
 
-    VulkanContext::SingleTimeCmdSubmit(Graphics, cmd);
+    // Matches local_size_x on terrain_cull.comp
+    constexpr uint32_t GROUP_SIZE = 64;
+    vkCmdDispatch(cmd, (InstanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+}
+
+void TerrainRenderer::SelectLods(const ChunkHeightmapLink* Staged, uint32_t Count) {
+    FrustumCulling::Frustum View = FrustumCulling::FromMatrix(TerrainPushConstants.CameraMVP);
+    glm::vec3 Camera = glm::vec3(TerrainPushConstants.PlayerPosition);
+
+    // Nodes point at the staged copy, non resident links are still staged without CPU culling
+    for (uint32_t i = 0; i < Count; i++) {
+        if (Staged[i].IsVisible) {
+            CdlodQuadtree::SelectChunk(View, Camera, Staged[i], i, LodSelection);
+        }
+    }
+
+    uint32_t NodeCount = LodSelection.NodeCount();
+    if (NodeCount == 0) {
+        return;
+    }
+
+    BufferSystem::FrameSlice Nodes = BufferSystem::frameAlloc(NodeCount * sizeof(TerrainLodNode));
+    if (!Nodes.mapped) {
+        LodSelection.Clear();
+        return;
+    }
+
+    // Part after part, each draw's firstInstance is where its part starts
+    TerrainLodNode* Out = static_cast<TerrainLodNode*>(Nodes.mapped);
+    uint32_t First = 0;
+    for (uint32_t Part = 0; Part < CdlodQuadtree::PART_COUNT; Part++) {
+        const std::vector<TerrainLodNode>& PartNodes = LodSelection.Parts[Part];
+        LodPartsFirst[Part] = First;
+        memcpy(Out + First, PartNodes.data(), PartNodes.size() * sizeof(TerrainLodNode));
+        First += static_cast<uint32_t>(PartNodes.size());
+    }
+
+    TerrainPushConstants.NodesBuffer = BufferSystem::frameArenaDescriptor();
+    TerrainPushConstants.NodesFirst = static_cast<uint32_t>(Nodes.offset / sizeof(TerrainLodNode));
+    TerrainPushConstants.LeafRange = TerrainConfig::Lod::LEAF_RANGE;
+    TerrainPushConstants.MorphStart = TerrainConfig::Lod::MORPH_START;
 }
+
 void TerrainRenderer::Render(VkCommandBuffer cmd) {
-    // TODO: I'm quite unsure on what would be the best way of handling this
-    //vkCmdBindIndexBuffer(cmd, BufferSystem.get(Terrain_PlaneMeshIndexBufferId).buffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdBindIndexBuffer(cmd, PlaneMeshIndexVkBuffer, 0, VK_INDEX_TYPE_UINT32);
+    using enum RendererConfig::TerrainRenderer::Mode;
+
+    PipelineManager::Id PipelineId = TerrainPipelineId;
+    VkBuffer IndexBuffer = PlaneMeshIndexVkBuffer;
+    VkDeviceSize IndexOffset = PlaneMeshIndexOffset;
+    if (Mode == Cdlod) {
+        PipelineId = CdlodPipelineId;
+        IndexBuffer = PatchIndexVkBuffer;
+        IndexOffset = PatchIndexOffset;
+    } else if (Mode == Tessellation) {
+        PipelineId = TessellationPipelineId;
+        IndexBuffer = TessellationIndexVkBuffer;
+        IndexOffset = TessellationIndexOffset;
+    }
+
+    VkPipeline TerrainPipeline = PipelineManager::Get(PipelineId);
+    if (TerrainPipeline == VK_NULL_HANDLE) {
+        return;
+    }
+
+    static_assert(sizeof(TerrainConfig::Chunk::Index) == sizeof(uint16_t), "Index type out of sync");
+    vkCmdBindIndexBuffer(cmd, IndexBuffer, IndexOffset, VK_INDEX_TYPE_UINT16);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, TerrainPipeline);
+    DescriptorHeap::Bind(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
 
     vkCmdPushConstants(
         cmd,
-        TerrainPipelineLayout,
-        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        DescriptorHeap::PipelineLayout(),
+        VK_SHADER_STAGE_ALL,
         0,
         sizeof(TerrainPushConstants),
         &TerrainPushConstants
     );
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, TerrainPipeline);
-    vkCmdBindDescriptorSets(
-        cmd,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        TerrainPipelineLayout,
-        0, // Probably a bad idea the way I carry this binding value lol TEXTURE_SAMPLER_BINDING,
-        1,
-        &TerrainDescriptorSet.set,
-        0,
-        nullptr
-    );
+    if (StatisticsPool) {
+        vkCmdBeginQuery(cmd, StatisticsPool, StatisticsQuery, 0);
+    }
 
-    vkCmdDrawIndexed(cmd, TerrainConfig::Chunk::INDICES_COUNT, TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT, 0, 0, 0);
+    if (Mode == Cdlod) {
+        // Whole patches, then each quarter of the patch for the nodes only partly covered by
+        // their children
+        constexpr uint32_t QUARTER_INDICES = TerrainConfig::Lod::PATCH_INDICES_COUNT / 4;
+        for (uint32_t Part = 0; Part < CdlodQuadtree::PART_COUNT; Part++) {
+            uint32_t NodeCount = static_cast<uint32_t>(LodSelection.Parts[Part].size());
+            if (NodeCount == 0) {
+                continue;
+            }
+            uint32_t IndexCount = Part == 0 ? TerrainConfig::Lod::PATCH_INDICES_COUNT : QUARTER_INDICES;
+            uint32_t FirstIndex = Part == 0 ? 0 : (Part - 1) * QUARTER_INDICES;
+            vkCmdDrawIndexed(cmd, IndexCount, NodeCount, FirstIndex, 0, LodPartsFirst[Part]);
+        }
+    } else {
+        // Grid and tessellation alike, the cull wrote the index count of the mode
+        const BufferSystem::Buffer& Draws = BufferSystem::get(DrawsBufferId);
+        const BufferSystem::Buffer& DrawCount = BufferSystem::get(DrawCountBufferId);
+        vkCmdDrawIndexedIndirectCount(
+            cmd,
+            Draws.buffer,
+            Draws.offset,
+            DrawCount.buffer,
+            DrawCount.offset,
+            TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT,
+            sizeof(VkDrawIndexedIndirectCommand)
+        );
+    }
+
+    if (StatisticsPool) {
+        vkCmdEndQuery(cmd, StatisticsPool, StatisticsQuery);
+    }
 }
 
+void TerrainRenderer::UpdateUI() {
+    using enum RendererConfig::TerrainRenderer::Mode;
+
+    ImGui::SetNextWindowSize(ImVec2(0.0f, 0.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Terrain Renderer");
+
+    // The capture picks the mode while it runs
+    int32_t Selected = static_cast<int32_t>(Mode);
+    ImGui::BeginDisabled(Capturing);
+    ImGui::RadioButton("Grid", &Selected, static_cast<int32_t>(Grid));
+    ImGui::SameLine();
+    ImGui::RadioButton("CDLOD", &Selected, static_cast<int32_t>(Cdlod));
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!VulkanContext::TessellationSupported);
+    ImGui::RadioButton("Tessellation", &Selected, static_cast<int32_t>(Tessellation));
+    ImGui::EndDisabled();
+    ImGui::EndDisabled();
+    Mode = static_cast<RendererConfig::TerrainRenderer::Mode>(Selected);
+
+    if (Mode == Tessellation) {
+        ImGui::SliderFloat("Edge pixels", &TessellationEdgePixels, 2.0f, 64.0f, "%.0f");
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // As of the last frame recorded
+    ImGui::TextDisabled("Geometry:");
+    ImGui::Indent();
+    if (Mode == Cdlod) {
+        ImGui::Text("Triangles: %u", LodSelection.TriangleCount());
+        ImGui::Text("Nodes: %u over %u chunks", LodSelection.NodeCount(), StagedInstances);
+        for (uint32_t Lod = 0; Lod < TerrainConfig::Lod::LOD_COUNT; Lod++) {
+            ImGui::Text("LOD %u: %u nodes", Lod, LodSelection.NodesPerLod[Lod]);
+        }
+    } else if (Mode == Tessellation) {
+        // Subdivided on the GPU, only the statistics below know the triangles
+        uint32_t Patches = TerrainConfig::Tessellation::PATCHES * TerrainConfig::Tessellation::PATCHES;
+        ImGui::Text("Patches: up to %u", StagedInstances * Patches);
+        ImGui::Text("Chunks: up to %u", StagedInstances);
+    } else {
+        // The GPU cull may still drop some
+        uint64_t Triangles = uint64_t(StagedInstances) * (TerrainConfig::Chunk::INDICES_COUNT / 3);
+        ImGui::Text("Triangles: up to %llu", static_cast<unsigned long long>(Triangles));
+        ImGui::Text("Chunks: up to %u", StagedInstances);
+    }
+    ImGui::Unindent();
+
+    if (StatisticsPool) {
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        // A couple frames behind, what the terrain draws actually cost the GPU
+        ImGui::TextDisabled("GPU statistics:");
+        ImGui::Indent();
+        ImGui::Text("Primitives: %llu", static_cast<unsigned long long>(Primitives));
+        ImGui::Text("Vertex invocations: %llu", static_cast<unsigned long long>(VertexInvocations));
+        if (VulkanContext::TessellationSupported) {
+            ImGui::Text("Tessellation invocations: %llu", static_cast<unsigned long long>(TessellationInvocations));
+        }
+        ImGui::Unindent();
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
 
+    // Every mode from where the camera stands, the full numbers go to CAPTURE_PATH
+    ImGui::BeginDisabled(Capturing);
+    if (ImGui::Button("Capture modes")) {
+        StartCapture();
+    }
+    ImGui::EndDisabled();
+    if (Capturing) {
+        ImGui::SameLine();
+        ImGui::Text("%s, frame %u", MODE_NAMES[static_cast<uint32_t>(Mode)], CaptureFrame);
+    } else if (CaptureResults[0].Frames > 0) {
+        ImGui::Indent();
+        ImGui::Text("%-13s %9s %12s", "", "GPU ms", "primitives");
+        for (uint32_t i = 0; i < RendererConfig::TerrainRenderer::MODE_COUNT; i++) {
+            const CaptureTotals& Totals = CaptureResults[i];
+            double PerFrame = 1.0 / std::max(Totals.Frames, 1u);
+            ImGui::Text("%-13s %9.3f %12.0f", MODE_NAMES[i], (Totals.CullMs + Totals.TerrainMs) * PerFrame, Totals.Primitives * PerFrame);
+        }
+        ImGui::Unindent();
+    }
+
+    ImGui::End();
+}
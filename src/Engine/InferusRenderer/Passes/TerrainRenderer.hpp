@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <glm/fwd.hpp>
 #include <glm/ext.hpp>
 #include <vulkan/vulkan.h>
@@ -7,46 +9,138 @@
 class InferusRenderer; // Circular dependency
 
 #include "Engine/Types.hpp"
+#include "Engine/Systems/Terrain/CdlodQuadtree.hpp"
 #include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/FrustumCulling.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+#include "Engine/InferusRenderer/PipelineManager.hpp"
 #include "Engine/InferusRenderer/Image/ImageSystem.hpp"
 #include "Engine/InferusRenderer/Buffer/BufferSystem.hpp"
 
-struct TerrainDescriptorSet {
-    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
-    VkDescriptorSet set = VK_NULL_HANDLE;
-    VkDescriptorPool pool = VK_NULL_HANDLE;
-};
-
+// Matches terrain.vert, terrain_cdlod.vert and terrain_tess.tesc, the bindless indices of what
+// they read come last
 struct TerrainPushConstants {
     glm::mat4 CameraMVP;
     glm::vec4 PlayerPosition;
+    uint32_t HeightmapImage;
+    uint32_t HeightmapSampler;
+    uint32_t LinksBuffer;
+    // Links of this frame start at this element of the frame arena
+    uint32_t LinksFirst;
+    // CDLOD only, this frame's selected nodes and where their morph starts
+    uint32_t NodesBuffer;
+    uint32_t NodesFirst;
+    float LeafRange;
+    float MorphStart;
+    // Tessellation only, projection scale in pixels and the edge length on screen aimed for
+    float FocalPixels;
+    float EdgePixels;
 };
+static_assert(sizeof(TerrainPushConstants) <= RendererConfig::DescriptorHeap::PUSH_CONSTANTS_SIZE);
+
+// Matches terrain_cull.comp
+struct TerrainCullPushConstants {
+    glm::mat4 ViewProjection;
+    uint32_t LinksBuffer;
+    uint32_t LinksFirst;
+    uint32_t DrawsBuffer;
+    uint32_t DrawCountBuffer;
+    uint32_t InstanceCount;
+    uint32_t IndexCount;
+};
+static_assert(sizeof(TerrainCullPushConstants) <= RendererConfig::DescriptorHeap::PUSH_CONSTANTS_SIZE);
 
 class TerrainRenderer {
 public:
-    // Terrain plane mesh
+    // Terrain plane mesh, a range of a pooled index buffer
     BufferSystem::Id PlaneMeshIndexBufferId;
     VkBuffer PlaneMeshIndexVkBuffer;
-
-    // Terrain pipeline
-    VkPipeline TerrainPipeline {};
-    VkPipelineLayout TerrainPipelineLayout {};
-
-    // Heightmap
+    VkDeviceSize PlaneMeshIndexOffset = 0;
+
+    // Terrain pipeline, on the shared bindless layout
+    PipelineManager::Id TerrainPipelineId = PipelineManager::INVALID_ID;
+
+    // What Cull and Render do this frame
+    RendererConfig::TerrainRenderer::Mode Mode = RendererConfig::TerrainRenderer::MODE;
+
+    // CDLOD, one small patch drawn per selected node at every level
+    PipelineManager::Id CdlodPipelineId = PipelineManager::INVALID_ID;
+    BufferSystem::Id PatchIndexBufferId;
+    VkBuffer PatchIndexVkBuffer;
+    VkDeviceSize PatchIndexOffset = 0;
+    // Cull's selection, Render draws it and the UI reads it back
+    CdlodQuadtree::Selection LodSelection;
+    // First node of each part in the frame arena
+    uint32_t LodPartsFirst[CdlodQuadtree::PART_COUNT] {};
+
+    // Tessellation, drawn from the same culled draws as the grid with patches for indices
+    PipelineManager::Id TessellationPipelineId = PipelineManager::INVALID_ID;
+    BufferSystem::Id TessellationIndexBufferId;
+    VkBuffer TessellationIndexVkBuffer;
+    VkDeviceSize TessellationIndexOffset = 0;
+    float TessellationEdgePixels = TerrainConfig::Tessellation::EDGE_PIXELS;
+    float ViewportHeight = 1.0f;
+
+    // Pipeline statistics of the terrain draws, one query per frame in flight, to compare
+    // the modes with. Null on devices without them.
+    VkQueryPool StatisticsPool = VK_NULL_HANDLE;
+    uint32_t StatisticsQuery = 0;
+    // As of the last frame whose query was read back
+    uint64_t VertexInvocations = 0;
+    uint64_t TessellationInvocations = 0;
+    uint64_t Primitives = 0;
+    // Whether the last read back was a frame that drew terrain
+    bool StatisticsFresh = false;
+
+    // Mode capture, see RendererConfig::TerrainRenderer::CAPTURE_FRAMES. Sums over the
+    // measured frames of each mode.
+    struct CaptureTotals {
+        uint32_t Frames = 0;
+        double FrameMs = 0.0;
+        double CullMs = 0.0;
+        double TerrainMs = 0.0;
+        double Primitives = 0.0;
+        double VertexInvocations = 0.0;
+        double TessellationInvocations = 0.0;
+        uint32_t ValidationErrors = 0;
+    };
+    bool Capturing = false;
+    uint32_t CaptureFrame = 0;
+    uint32_t CaptureErrorsBefore = 0;
+    RendererConfig::TerrainRenderer::Mode CaptureRestore = RendererConfig::TerrainRenderer::MODE;
+    CaptureTotals CaptureResults[RendererConfig::TerrainRenderer::MODE_COUNT] {};
+
+    // GPU culling, one indexed draw per chunk that made it through plus how many did
+    PipelineManager::Id CullPipelineId = PipelineManager::INVALID_ID;
+    BufferSystem::Id DrawsBufferId;
+    BufferSystem::Id DrawCountBufferId;
+
+    // Heightmap, texels are the R16 heights the terrain system generates
+    static constexpr VkFormat HEIGHTMAP_IMAGE_FORMAT = VK_FORMAT_R16_UNORM;
     ImageSystem::Id HeightmapImageId;
     VkSampler HeightmapTextureSampler;
-    BufferSystem::Id Heightmap_CPU;
+    uint32_t HeightmapSamplerIndex = UINT32_MAX;
+    // Every layer on the CPU, TerrainSystem packs chunks in and uploads stage from it
+    std::vector<uint16_t> HeightmapMirror;
 
     // Chunk to Heightmap linking
-    ChunkHeightmapLink ChunkHeightmapLinks[TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT];
-    BufferSystem::Id ChunkHeightmapLinks_CPU;
-    BufferSystem::Id ChunkHeightmapLinks_GPU;
-
-    // Terrain descriptor sets
-    TerrainDescriptorSet TerrainDescriptorSet {};
+    // As of the last upload, so a chunk never shows before its layer landed. Cull copies it
+    // into the frame arena every frame.
+    ChunkHeightmapLink ChunkHeightmapLinks[TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT] {};
+    // Frame timeline value of the last frame whose staged links showed each slot, what an
+    // upload overwriting the slot's layer has to wait for
+    uint64_t SlotLastFrame[TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT] {};
+    // World boxes of the links above, refreshed whenever they're published
+    FrustumCulling::Boxes ChunkBoxes;
+    // Cull's scratch, links in view this frame
+    std::vector<uint32_t> VisibleChunks;
 
     // Push constants
     TerrainPushConstants TerrainPushConstants {};
+    // Where the LOD ranges are measured from
+    const glm::vec3* PlayerPosition = nullptr;
+    // What the last Cull staged, for the UI
+    uint32_t StagedInstances = 0;
 
 public:
     TerrainRenderer() = default;
@@ -56,11 +150,39 @@ public:
 
     InferusResult Init(BufferSystem::Id &CreationWiseStagingBufer);
     void FeedTerrainSystemPointers();
+    void FeedCamera(const glm::vec3* Position);
+    void Resize(VkExtent2D Extent);
+    // Pushes the links and the heightmap layers in view TerrainSystem regenerated to the GPU,
+    // layers out of view stay dirty until they come into it
+    void UploadDirtyChunks();
 
     void Destroy();
 
+    // After the frame's fence was waited on (and GpuProfiler::BeginFrame), reads back the
+    // statistics that frame recorded and measures it for a running capture
+    void BeginFrame(uint32_t FrameIndex);
+    // Zeroes the draw count and the frame's statistics, before Cull on the same frame
+    void ResetDrawCount(VkCommandBuffer cmd);
+    // Stages this frame's links and turns the visible ones into indirect draws, or with
+    // CDLOD on selects and stages the nodes to draw instead
+    void Cull(VkCommandBuffer cmd);
+    // Draws whatever Cull let through
     void Render(VkCommandBuffer cmd);
 
-private:
+    void UpdateUI();
 
+    // Draws every mode the device has in turn, Capturing until the results are written
+    void StartCapture();
+
+private:
+    void RefreshChunkBoxes();
+    // Nodes covering the staged links, into the frame arena. Nothing is selected when it's full.
+    void SelectLods(const ChunkHeightmapLink* Staged, uint32_t Count);
+    // Stages and copies the layers, false when the upload has to wait for a later frame
+    bool UploadLayers(const std::vector<uint32_t>& Slots);
+    // After the frame's read backs, measures it and moves on to the next mode when due
+    void StepCapture();
+    // Switches to Next, or writes the results and goes back to the mode from before
+    void NextCaptureMode(uint32_t Next);
+    void WriteCapture();
 };
@@ -0,0 +1,258 @@
+#include "PipelineCache.hpp"
+
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/IO.hpp"
+#include "Utils/Hash.hpp"
+#include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+
+namespace PipelineCache {
+    constexpr uint32_t FILE_MAGIC = 0x48435049; // "IPCH"
+    constexpr uint32_t FILE_VERSION = 1;
+    constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+    // Ours, in front of the driver's blob. The driver checks its own header too but
+    // not every driver survives a truncated or bit flipped blob, hence the hash.
+    struct FileHeader {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VendorID;
+        uint32_t DeviceID;
+        uint32_t DriverVersion;
+        uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t DataSize;
+        uint64_t DataHash;
+    };
+
+    VkPhysicalDeviceProperties Properties {};
+    std::filesystem::path Path;
+    bool Warm = false;
+    // Of the data on disk, Save skips the write when the driver has nothing new
+    uint64_t SavedHash = 0;
+
+    std::unordered_map<std::string, VkShaderModule> ShaderModules;
+
+    std::filesystem::path CachePath() {
+        std::string UUID;
+        for (uint8_t Byte : Properties.pipelineCacheUUID) {
+            UUID += fmt::format("{:02x}", Byte);
+        }
+        return std::filesystem::path(RendererConfig::PipelineCache::DIRECTORY) / fmt::format(
+            "pipelines.{:04x}.{:04x}.{:08x}.{}.bin", Properties.vendorID, Properties.deviceID, Properties.driverVersion, UUID);
+    }
+
+    // The blob as the driver wrote it, empty if the file is missing or doesn't belong to this device/driver
+    std::vector<uint8_t> Load() {
+        std::ifstream File(Path, std::ios::binary | std::ios::ate);
+        if (!File) {
+            return {};
+        }
+
+        size_t FileSize = static_cast<size_t>(File.tellg());
+        FileHeader Header {};
+        File.seekg(0);
+        if (FileSize < sizeof(Header) || !File.read(reinterpret_cast<char*>(&Header), sizeof(Header))) {
+            spdlog::warn("Pipeline cache {} is truncated", Path.string());
+            return {};
+        }
+
+        bool Matches = Header.Magic == FILE_MAGIC && Header.Version == FILE_VERSION
+                    && Header.VendorID == Properties.vendorID && Header.DeviceID == Properties.deviceID
+                    && Header.DriverVersion == Properties.driverVersion
+                    && memcmp(Header.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        if (!Matches || Header.DataSize != FileSize - sizeof(Header)) {
+            spdlog::warn("Pipeline cache {} was written for another device, driver or version", Path.string());
+            return {};
+        }
+
+        std::vector<uint8_t> Data(Header.DataSize);
+        if (!File.read(reinterpret_cast<char*>(Data.data()), std::streamsize(Data.size()))
+            || Hash::Fnv1a(Data.data(), Data.size()) != Header.DataHash)
+        {
+            spdlog::warn("Pipeline cache {} is corrupted", Path.string());
+            return {};
+        }
+
+        // Then the driver's own header, the same checks the spec asks drivers to do
+        VkPipelineCacheHeaderVersionOne DriverHeader {};
+        if (Data.size() < sizeof(DriverHeader)) {
+            spdlog::warn("Pipeline cache {} has no driver header", Path.string());
+            return {};
+        }
+        memcpy(&DriverHeader, Data.data(), sizeof(DriverHeader));
+        bool DriverMatches = DriverHeader.headerSize >= sizeof(DriverHeader) && DriverHeader.headerSize <= Data.size()
+                          && DriverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+                          && DriverHeader.vendorID == Properties.vendorID && DriverHeader.deviceID == Properties.deviceID
+                          && memcmp(DriverHeader.pipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        if (!DriverMatches) {
+            spdlog::warn("Pipeline cache {} has a driver header for another device", Path.string());
+            return {};
+        }
+
+        SavedHash = Header.DataHash;
+        return Data;
+    }
+
+    InferusResult Create() {
+        vkGetPhysicalDeviceProperties(VulkanContext::PhysicalDevice, &Properties);
+        Path = CachePath();
+        SavedHash = 0;
+
+        std::vector<uint8_t> Data = Load();
+
+        VkPipelineCacheCreateInfo CreateInfo {};
+        CreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        CreateInfo.initialDataSize = Data.size();
+        CreateInfo.pInitialData = Data.empty() ? nullptr : Data.data();
+
+        Warm = !Data.empty() && vkCreatePipelineCache(VulkanContext::Device, &CreateInfo, nullptr, &Cache) == VK_SUCCESS;
+        if (!Warm) {
+            // Still worth having, it's saved for the next launch
+            SavedHash = 0;
+            CreateInfo.initialDataSize = 0;
+            CreateInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(VulkanContext::Device, &CreateInfo, nullptr, &Cache) != VK_SUCCESS) {
+                spdlog::warn("Pipeline cache creation failed, pipelines will compile from scratch");
+                Cache = VK_NULL_HANDLE;
+                return InferusResult::SUCCESS;
+            }
+        }
+
+        spdlog::info("Pipeline cache {} ({}, {} bytes)", Path.string(), Warm ? "warm" : "cold", Data.size());
+        return InferusResult::SUCCESS;
+    }
+
+    void Save() {
+        if (Cache == VK_NULL_HANDLE) {
+            return;
+        }
+
+        size_t Size = 0;
+        if (vkGetPipelineCacheData(VulkanContext::Device, Cache, &Size, nullptr) != VK_SUCCESS || Size == 0) {
+            return;
+        }
+        std::vector<uint8_t> Data(Size);
+        if (vkGetPipelineCacheData(VulkanContext::Device, Cache, &Size, Data.data()) != VK_SUCCESS) {
+            return;
+        }
+        Data.resize(Size);
+
+        uint64_t DataHash = Hash::Fnv1a(Data.data(), Data.size());
+        if (DataHash == SavedHash) {
+            return;
+        }
+
+        FileHeader Header = {
+            .Magic = FILE_MAGIC,
+            .Version = FILE_VERSION,
+            .VendorID = Properties.vendorID,
+            .DeviceID = Properties.deviceID,
+            .DriverVersion = Properties.driverVersion,
+            .PipelineCacheUUID = {},
+            .DataSize = Data.size(),
+            .DataHash = DataHash
+        };
+        memcpy(Header.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+        std::error_code Error;
+        std::filesystem::create_directories(Path.parent_path(), Error);
+
+        // Temporary then rename, a killed run never leaves half a cache behind
+        std::filesystem::path Temporary = Path;
+        Temporary += ".tmp";
+        {
+            std::ofstream File(Temporary, std::ios::binary | std::ios::trunc);
+            File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+            File.write(reinterpret_cast<const char*>(Data.data()), std::streamsize(Data.size()));
+            File.flush();
+            if (!File) {
+                spdlog::warn("Couldn't write pipeline cache {}", Temporary.string());
+                return;
+            }
+        }
+        std::filesystem::rename(Temporary, Path, Error);
+        if (Error) {
+            spdlog::warn("Couldn't move pipeline cache {} into place: {}", Path.string(), Error.message());
+            return;
+        }
+
+        SavedHash = DataHash;
+        spdlog::debug("Pipeline cache saved ({} bytes)", Data.size());
+    }
+
+    void Destroy() {
+        Save();
+
+        for (auto& [Filename, Module] : ShaderModules) {
+            vkDestroyShaderModule(VulkanContext::Device, Module, nullptr);
+        }
+        ShaderModules.clear();
+
+        if (Cache) { vkDestroyPipelineCache(VulkanContext::Device, Cache, nullptr); }
+        Cache = VK_NULL_HANDLE;
+        Warm = false;
+    }
+
+    bool IsWarm() {
+        return Warm;
+    }
+
+    VkShaderModule CreateShaderModule(const std::string& Filename) {
+        std::vector<char> Code;
+        uint32_t CodeSize;
+        IO::BinaryRead(Filename, Code, CodeSize);
+
+        uint32_t Magic = 0;
+        if (CodeSize >= sizeof(Magic)) {
+            memcpy(&Magic, Code.data(), sizeof(Magic));
+        }
+        if (CodeSize % sizeof(uint32_t) != 0 || Magic != SPIRV_MAGIC) {
+            throw std::runtime_error("Not a SPIR-V binary: " + Filename);
+        }
+
+        VkShaderModuleCreateInfo ShaderModuleCreateInfo {};
+        ShaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        ShaderModuleCreateInfo.codeSize = CodeSize;
+        ShaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(Code.data());
+
+        VkShaderModule ShaderModule {};
+        if (vkCreateShaderModule(VulkanContext::Device, &ShaderModuleCreateInfo, nullptr, &ShaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("Shader Module creation failed for shader: " + Filename);
+        }
+        return ShaderModule;
+    }
+
+    VkShaderModule GetShaderModule(const std::string& Filename) {
+        auto Found = ShaderModules.find(Filename);
+        if (Found != ShaderModules.end()) {
+            return Found->second;
+        }
+
+        VkShaderModule ShaderModule = CreateShaderModule(Filename);
+        ShaderModules.emplace(Filename, ShaderModule);
+        return ShaderModule;
+    }
+
+    VkShaderModule ReloadShaderModule(const std::string& Filename, VkShaderModule& Replaced) {
+        // Created first, a broken file leaves the old module in place
+        VkShaderModule ShaderModule = CreateShaderModule(Filename);
+
+        VkShaderModule& Slot = ShaderModules[Filename];
+        Replaced = Slot;
+        Slot = ShaderModule;
+        return ShaderModule;
+    }
+
+    void LogCreation(const char* Name, std::chrono::steady_clock::duration Elapsed) {
+        spdlog::info("{} pipeline created in {:.2f} ms ({} cache)",
+            Name, std::chrono::duration<double, std::milli>(Elapsed).count(), Warm ? "warm" : "cold");
+    }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Types.hpp"
+
+// One VkPipelineCache shared by every pass (ImGui included), persisted under
+// RendererConfig::PipelineCache::DIRECTORY. The file is keyed by vendor, device, driver
+// version and pipelineCacheUUID, and both our header and the driver's are checked before
+// the data is handed to the driver, anything off starts a cold cache instead.
+//
+// Shader modules are cached too, by path, so passes sharing a shader read and create it once.
+namespace PipelineCache {
+    inline VkPipelineCache Cache = VK_NULL_HANDLE;
+
+    // Needs VulkanContext, never fails hard, a bad or missing file means a cold cache
+    InferusResult Create();
+    // Saves then destroys the cache and every cached shader module
+    void Destroy();
+
+    // Writes the cache if the driver added anything since it was loaded or last saved
+    void Save();
+
+    // True when the cache started from a valid file
+    bool IsWarm();
+
+    // Created on first use, owned by the cache, don't destroy it. Main thread only.
+    VkShaderModule GetShaderModule(const std::string& Filename);
+    // Rereads the file, Replaced is the module it had before (or null) and is the caller's
+    // to destroy once nothing compiles with it anymore. Throws like GetShaderModule.
+    VkShaderModule ReloadShaderModule(const std::string& Filename, VkShaderModule& Replaced);
+
+    // "<Name> pipeline created in x ms (warm|cold cache)"
+    void LogCreation(const char* Name, std::chrono::steady_clock::duration Elapsed);
+};
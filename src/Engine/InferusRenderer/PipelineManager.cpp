@@ -0,0 +1,482 @@
+#include "PipelineManager.hpp"
+
+#include <array>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/Hash.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/InferusRenderer/PipelineCache.hpp"
+#include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+#include "Engine/InferusRenderer/InferusRenderer.hpp"
+
+namespace PipelineManager {
+    enum class CompileState : uint8_t {
+        Idle,
+        Compiling,
+        // Compiled (or failed) is set, waiting for BeginFrame to pick it up
+        Done
+    };
+
+    struct Entry {
+        // Desc, or Compute when IsCompute
+        GraphicsDesc Desc;
+        ComputeDesc Compute;
+        bool IsCompute = false;
+        // What frames record with, only touched on the main thread
+        VkPipeline Live = VK_NULL_HANDLE;
+        // Written by the compile job before it publishes Done
+        VkPipeline Compiled = VK_NULL_HANDLE;
+        std::atomic<CompileState> State = CompileState::Idle;
+        // A shader changed mid compile, compile again once this one lands
+        bool Stale = false;
+    };
+
+    struct RetiredPipeline {
+        VkPipeline Pipeline;
+        uint64_t Frame;
+    };
+
+    struct WatchedShader {
+        std::filesystem::file_time_type LoadedTime;
+        // Last time seen while different from LoadedTime, reloaded once it holds for a poll
+        std::filesystem::file_time_type SeenTime;
+        std::vector<Id> Users;
+    };
+
+    // Deque so entries (and their atomics) never move while a job holds one
+    std::deque<Entry> Entries;
+    std::unordered_map<uint64_t, Id> ByHash;
+    std::vector<RetiredPipeline> RetiredPipelines;
+    // Replaced by a reload, destroyed once no compile could be using them
+    std::vector<VkShaderModule> RetiredModules;
+    std::unordered_map<std::string, WatchedShader> Shaders;
+
+    JobSystem::Counter Compiles;
+    uint64_t FrameNumber = 0;
+    bool CompiledSinceSave = false;
+    std::chrono::steady_clock::time_point LastPoll;
+
+    // Field by field, the structs carry pointers and padding
+    template <typename... Fields>
+    uint64_t Fold(uint64_t Seed, const Fields&... Values) {
+        ((Seed = Hash::Fnv1a(Values, Seed)), ...);
+        return Seed;
+    }
+
+    uint64_t HashString(const std::string& Text, uint64_t Seed) {
+        return Hash::Fnv1a(Text.data(), Text.size(), Fold(Seed, Text.size()));
+    }
+
+    uint64_t HashStencil(const VkStencilOpState& Op, uint64_t Seed) {
+        return Fold(Seed, Op.failOp, Op.passOp, Op.depthFailOp, Op.compareOp, Op.compareMask, Op.writeMask, Op.reference);
+    }
+
+    uint64_t Hash(const GraphicsDesc& Desc) {
+        uint64_t Result = HashString(Desc.VertexShader, Hash::FNV1A_OFFSET);
+        Result = HashString(Desc.FragmentShader, Result);
+        Result = HashString(Desc.TessControlShader, Result);
+        Result = HashString(Desc.TessEvalShader, Result);
+        Result = Hash::Fnv1a(reinterpret_cast<uintptr_t>(Desc.Layout), Result);
+
+        const VkPipelineVertexInputStateCreateInfo& VertexInput = Desc.VertexInput;
+        Result = Fold(Result, VertexInput.flags, Desc.VertexBindings.size(), Desc.VertexAttributes.size());
+        for (const VkVertexInputBindingDescription& Binding : Desc.VertexBindings) {
+            Result = Fold(Result, Binding.binding, Binding.stride, Binding.inputRate);
+        }
+        for (const VkVertexInputAttributeDescription& Attribute : Desc.VertexAttributes) {
+            Result = Fold(Result, Attribute.location, Attribute.binding, Attribute.format, Attribute.offset);
+        }
+
+        const VkPipelineInputAssemblyStateCreateInfo& InputAssembly = Desc.InputAssembly;
+        Result = Fold(Result, InputAssembly.flags, InputAssembly.topology, InputAssembly.primitiveRestartEnable);
+
+        Result = Fold(Result, Desc.Tessellation.flags, Desc.Tessellation.patchControlPoints);
+
+        const VkPipelineViewportStateCreateInfo& ViewportState = Desc.ViewportState;
+        Result = Fold(Result, ViewportState.flags, ViewportState.viewportCount, ViewportState.scissorCount);
+
+        const VkPipelineRasterizationStateCreateInfo& Rasterization = Desc.Rasterization;
+        Result = Fold(Result, Rasterization.flags, Rasterization.depthClampEnable, Rasterization.rasterizerDiscardEnable,
+            Rasterization.polygonMode, Rasterization.cullMode, Rasterization.frontFace, Rasterization.depthBiasEnable,
+            Rasterization.depthBiasConstantFactor, Rasterization.depthBiasClamp, Rasterization.depthBiasSlopeFactor,
+            Rasterization.lineWidth);
+
+        const VkPipelineMultisampleStateCreateInfo& Multisample = Desc.Multisample;
+        Result = Fold(Result, Multisample.flags, Multisample.rasterizationSamples, Multisample.sampleShadingEnable,
+            Multisample.minSampleShading, Multisample.alphaToCoverageEnable, Multisample.alphaToOneEnable);
+
+        const VkPipelineDepthStencilStateCreateInfo& DepthStencil = Desc.DepthStencil;
+        Result = Fold(Result, DepthStencil.flags, DepthStencil.depthTestEnable, DepthStencil.depthWriteEnable,
+            DepthStencil.depthCompareOp, DepthStencil.depthBoundsTestEnable, DepthStencil.stencilTestEnable,
+            DepthStencil.minDepthBounds, DepthStencil.maxDepthBounds);
+        Result = HashStencil(DepthStencil.front, Result);
+        Result = HashStencil(DepthStencil.back, Result);
+
+        const VkPipelineColorBlendStateCreateInfo& ColorBlendState = Desc.ColorBlendState;
+        Result = Fold(Result, ColorBlendState.flags, ColorBlendState.logicOpEnable, ColorBlendState.logicOp,
+            ColorBlendState.blendConstants[0], ColorBlendState.blendConstants[1],
+            ColorBlendState.blendConstants[2], ColorBlendState.blendConstants[3], Desc.BlendAttachments.size());
+        for (const VkPipelineColorBlendAttachmentState& Blend : Desc.BlendAttachments) {
+            Result = Fold(Result, Blend.blendEnable, Blend.srcColorBlendFactor, Blend.dstColorBlendFactor, Blend.colorBlendOp,
+                Blend.srcAlphaBlendFactor, Blend.dstAlphaBlendFactor, Blend.alphaBlendOp, Blend.colorWriteMask);
+        }
+
+        Result = Fold(Result, Desc.DynamicStates.size());
+        for (VkDynamicState State : Desc.DynamicStates) {
+            Result = Fold(Result, State);
+        }
+
+        Result = Fold(Result, Desc.ColorFormats.size(), Desc.DepthFormat, Desc.StencilFormat);
+        for (VkFormat Format : Desc.ColorFormats) {
+            Result = Fold(Result, Format);
+        }
+        return Result;
+    }
+
+    uint64_t Hash(const ComputeDesc& Desc) {
+        // Can't collide with a graphics pipeline using the same file as its vertex shader
+        uint64_t Result = HashString("compute", Hash::FNV1A_OFFSET);
+        Result = HashString(Desc.ComputeShader, Result);
+        return Hash::Fnv1a(reinterpret_cast<uintptr_t>(Desc.Layout), Result);
+    }
+
+    // Tessellation ones stay null for pipelines without
+    struct GraphicsModules {
+        VkShaderModule Vertex = VK_NULL_HANDLE;
+        VkShaderModule Fragment = VK_NULL_HANDLE;
+        VkShaderModule TessControl = VK_NULL_HANDLE;
+        VkShaderModule TessEval = VK_NULL_HANDLE;
+    };
+
+    // Job side, everything it needs is in the entry or captured, Desc is never written after Request
+    void Compile(Entry& Target, GraphicsModules Modules) {
+        const GraphicsDesc& Desc = Target.Desc;
+
+        VkPipelineVertexInputStateCreateInfo VertexInput = Desc.VertexInput;
+        VertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(Desc.VertexBindings.size());
+        VertexInput.pVertexBindingDescriptions = Desc.VertexBindings.data();
+        VertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(Desc.VertexAttributes.size());
+        VertexInput.pVertexAttributeDescriptions = Desc.VertexAttributes.data();
+
+        VkPipelineColorBlendStateCreateInfo ColorBlendState = Desc.ColorBlendState;
+        ColorBlendState.attachmentCount = static_cast<uint32_t>(Desc.BlendAttachments.size());
+        ColorBlendState.pAttachments = Desc.BlendAttachments.data();
+
+        VkPipelineDynamicStateCreateInfo DynamicState {};
+        DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        DynamicState.dynamicStateCount = static_cast<uint32_t>(Desc.DynamicStates.size());
+        DynamicState.pDynamicStates = Desc.DynamicStates.data();
+
+        VkPipelineRenderingCreateInfo RenderingCreateInfo {};
+        RenderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        RenderingCreateInfo.colorAttachmentCount = static_cast<uint32_t>(Desc.ColorFormats.size());
+        RenderingCreateInfo.pColorAttachmentFormats = Desc.ColorFormats.data();
+        RenderingCreateInfo.depthAttachmentFormat = Desc.DepthFormat;
+        RenderingCreateInfo.stencilAttachmentFormat = Desc.StencilFormat;
+
+        std::array<VkPipelineShaderStageCreateInfo, 4> ShaderStages {};
+        uint32_t StageCount = 0;
+        auto AddStage = [&ShaderStages, &StageCount](VkShaderStageFlagBits Stage, VkShaderModule Module) {
+            VkPipelineShaderStageCreateInfo& ShaderStage = ShaderStages[StageCount++];
+            ShaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            ShaderStage.stage = Stage;
+            ShaderStage.module = Module;
+            ShaderStage.pName = "main";
+        };
+        AddStage(VK_SHADER_STAGE_VERTEX_BIT, Modules.Vertex);
+        bool Tessellated = Modules.TessControl != VK_NULL_HANDLE;
+        if (Tessellated) {
+            AddStage(VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, Modules.TessControl);
+            AddStage(VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, Modules.TessEval);
+        }
+        AddStage(VK_SHADER_STAGE_FRAGMENT_BIT, Modules.Fragment);
+
+        VkGraphicsPipelineCreateInfo CreateInfo {};
+        CreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        CreateInfo.pNext = &RenderingCreateInfo;
+        CreateInfo.stageCount = StageCount;
+        CreateInfo.pStages = ShaderStages.data();
+        CreateInfo.pVertexInputState = &VertexInput;
+        CreateInfo.pInputAssemblyState = &Desc.InputAssembly;
+        CreateInfo.pTessellationState = Tessellated ? &Desc.Tessellation : nullptr;
+        CreateInfo.pViewportState = &Desc.ViewportState;
+        CreateInfo.pRasterizationState = &Desc.Rasterization;
+        CreateInfo.pMultisampleState = &Desc.Multisample;
+        CreateInfo.pDepthStencilState = &Desc.DepthStencil;
+        CreateInfo.pColorBlendState = &ColorBlendState;
+        CreateInfo.pDynamicState = &DynamicState;
+        CreateInfo.layout = Desc.Layout;
+        CreateInfo.basePipelineIndex = -1;
+
+        auto Begin = std::chrono::steady_clock::now();
+        VkPipeline Pipeline = VK_NULL_HANDLE;
+        if (vkCreateGraphicsPipelines(VulkanContext::Device, PipelineCache::Cache, 1, &CreateInfo, nullptr, &Pipeline) != VK_SUCCESS) {
+            spdlog::error("{} pipeline compilation failed", Desc.Name);
+            Pipeline = VK_NULL_HANDLE;
+        } else {
+            PipelineCache::LogCreation(Desc.Name.c_str(), std::chrono::steady_clock::now() - Begin);
+        }
+
+        Target.Compiled = Pipeline;
+        Target.State.store(CompileState::Done, std::memory_order_release);
+    }
+
+    void CompileCompute(Entry& Target, VkShaderModule ComputeModule) {
+        const ComputeDesc& Desc = Target.Compute;
+
+        VkComputePipelineCreateInfo CreateInfo {};
+        CreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        CreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        CreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        CreateInfo.stage.module = ComputeModule;
+        CreateInfo.stage.pName = "main";
+        CreateInfo.layout = Desc.Layout;
+        CreateInfo.basePipelineIndex = -1;
+
+        auto Begin = std::chrono::steady_clock::now();
+        VkPipeline Pipeline = VK_NULL_HANDLE;
+        if (vkCreateComputePipelines(VulkanContext::Device, PipelineCache::Cache, 1, &CreateInfo, nullptr, &Pipeline) != VK_SUCCESS) {
+            spdlog::error("{} pipeline compilation failed", Desc.Name);
+            Pipeline = VK_NULL_HANDLE;
+        } else {
+            PipelineCache::LogCreation(Desc.Name.c_str(), std::chrono::steady_clock::now() - Begin);
+        }
+
+        Target.Compiled = Pipeline;
+        Target.State.store(CompileState::Done, std::memory_order_release);
+    }
+
+    // Main thread, modules come from the cache here so jobs never touch it
+    void StartCompile(Id Pipeline) {
+        Entry& Target = Entries[Pipeline];
+
+        if (Target.IsCompute) {
+            VkShaderModule ComputeModule;
+            try {
+                ComputeModule = PipelineCache::GetShaderModule(Target.Compute.ComputeShader);
+            } catch (const std::runtime_error& Error) {
+                spdlog::error("{} pipeline not compiled: {}", Target.Compute.Name, Error.what());
+                return;
+            }
+
+            Target.Stale = false;
+            Target.State.store(CompileState::Compiling, std::memory_order_relaxed);
+            JobSystem::Run([&Target, ComputeModule]{ CompileCompute(Target, ComputeModule); }, &Compiles);
+            return;
+        }
+
+        GraphicsModules Modules;
+        try {
+            Modules.Vertex = PipelineCache::GetShaderModule(Target.Desc.VertexShader);
+            Modules.Fragment = PipelineCache::GetShaderModule(Target.Desc.FragmentShader);
+            if (!Target.Desc.TessControlShader.empty()) {
+                Modules.TessControl = PipelineCache::GetShaderModule(Target.Desc.TessControlShader);
+                Modules.TessEval = PipelineCache::GetShaderModule(Target.Desc.TessEvalShader);
+            }
+        } catch (const std::runtime_error& Error) {
+            spdlog::error("{} pipeline not compiled: {}", Target.Desc.Name, Error.what());
+            return;
+        }
+
+        Target.Stale = false;
+        Target.State.store(CompileState::Compiling, std::memory_order_relaxed);
+        JobSystem::Run([&Target, Modules]{ Compile(Target, Modules); }, &Compiles);
+    }
+
+    void Watch(const std::string& Filename, Id User) {
+        auto [Found, Inserted] = Shaders.try_emplace(Filename);
+        WatchedShader& Shader = Found->second;
+        if (Inserted) {
+            std::error_code Error;
+            Shader.LoadedTime = Shader.SeenTime = std::filesystem::last_write_time(Filename, Error);
+        }
+        Shader.Users.push_back(User);
+    }
+
+    void Reload(const std::string& Filename, const WatchedShader& Shader) {
+        VkShaderModule Replaced = VK_NULL_HANDLE;
+        try {
+            PipelineCache::ReloadShaderModule(Filename, Replaced);
+        } catch (const std::runtime_error& Error) {
+            // Keeps the old module and pipelines, the next save of the file gets another try
+            spdlog::error("Shader reload failed: {}", Error.what());
+            return;
+        }
+        if (Replaced) {
+            RetiredModules.push_back(Replaced);
+        }
+
+        spdlog::info("Reloading {}, {} pipeline(s) to recompile", Filename, Shader.Users.size());
+        for (Id User : Shader.Users) {
+            if (Entries[User].State.load(std::memory_order_acquire) == CompileState::Idle) {
+                StartCompile(User);
+            } else {
+                Entries[User].Stale = true;
+            }
+        }
+    }
+
+    void PollShaders() {
+        auto Now = std::chrono::steady_clock::now();
+        if (Now - LastPoll < std::chrono::milliseconds(RendererConfig::PipelineManager::SHADER_POLL_INTERVAL_MS)) {
+            return;
+        }
+        LastPoll = Now;
+
+        for (auto& [Filename, Shader] : Shaders) {
+            std::error_code Error;
+            auto Time = std::filesystem::last_write_time(Filename, Error);
+            if (Error || Time == Shader.LoadedTime) {
+                continue;
+            }
+
+            // Still being written if it moved since the last poll
+            if (Time != Shader.SeenTime) {
+                Shader.SeenTime = Time;
+                continue;
+            }
+
+            Shader.LoadedTime = Time;
+            Reload(Filename, Shader);
+        }
+    }
+
+    InferusResult Create() {
+        FrameNumber = 0;
+        CompiledSinceSave = false;
+        LastPoll = std::chrono::steady_clock::now();
+        return InferusResult::SUCCESS;
+    }
+
+    void Destroy() {
+        // JobSystem may already be gone, it runs whatever is left before it goes
+        if (!Compiles.IsDone()) {
+            JobSystem::WaitFor(Compiles);
+        }
+
+        for (Entry& Target : Entries) {
+            if (Target.Live) { vkDestroyPipeline(VulkanContext::Device, Target.Live, nullptr); }
+            if (Target.State.load(std::memory_order_acquire) == CompileState::Done && Target.Compiled) {
+                vkDestroyPipeline(VulkanContext::Device, Target.Compiled, nullptr);
+            }
+        }
+        for (RetiredPipeline& Retired : RetiredPipelines) {
+            vkDestroyPipeline(VulkanContext::Device, Retired.Pipeline, nullptr);
+        }
+        for (VkShaderModule Module : RetiredModules) {
+            vkDestroyShaderModule(VulkanContext::Device, Module, nullptr);
+        }
+
+        Entries.clear();
+        ByHash.clear();
+        RetiredPipelines.clear();
+        RetiredModules.clear();
+        Shaders.clear();
+    }
+
+    Id Request(const GraphicsDesc& Desc) {
+        uint64_t DescHash = Hash(Desc);
+        auto Found = ByHash.find(DescHash);
+        if (Found != ByHash.end()) {
+            return Found->second;
+        }
+
+        Id Pipeline = static_cast<Id>(Entries.size());
+        Entries.emplace_back().Desc = Desc;
+        ByHash.emplace(DescHash, Pipeline);
+
+        Watch(Desc.VertexShader, Pipeline);
+        Watch(Desc.FragmentShader, Pipeline);
+        if (!Desc.TessControlShader.empty()) {
+            Watch(Desc.TessControlShader, Pipeline);
+            Watch(Desc.TessEvalShader, Pipeline);
+        }
+
+        StartCompile(Pipeline);
+        return Pipeline;
+    }
+
+    Id Request(const ComputeDesc& Desc) {
+        uint64_t DescHash = Hash(Desc);
+        auto Found = ByHash.find(DescHash);
+        if (Found != ByHash.end()) {
+            return Found->second;
+        }
+
+        Id Pipeline = static_cast<Id>(Entries.size());
+        Entry& Target = Entries.emplace_back();
+        Target.Compute = Desc;
+        Target.IsCompute = true;
+        ByHash.emplace(DescHash, Pipeline);
+
+        Watch(Desc.ComputeShader, Pipeline);
+
+        StartCompile(Pipeline);
+        return Pipeline;
+    }
+
+    VkPipeline Get(Id Pipeline) {
+        return Pipeline < Entries.size() ? Entries[Pipeline].Live : VK_NULL_HANDLE;
+    }
+
+    void BeginFrame() {
+        FrameNumber++;
+
+        // Swapped out MAX_FRAMES_IN_FLIGHT frames ago, whatever recorded it has been waited on
+        std::erase_if(RetiredPipelines, [](const RetiredPipeline& Retired) {
+            if (Retired.Frame + InferusRenderer::MAX_FRAMES_IN_FLIGHT > FrameNumber) {
+                return false;
+            }
+            vkDestroyPipeline(VulkanContext::Device, Retired.Pipeline, nullptr);
+            return true;
+        });
+
+        // Modules only matter while compiling, none in flight means none of them is used
+        if (Compiles.IsDone()) {
+            for (VkShaderModule Module : RetiredModules) {
+                vkDestroyShaderModule(VulkanContext::Device, Module, nullptr);
+            }
+            RetiredModules.clear();
+        }
+
+        for (Id Pipeline = 0; Pipeline < Entries.size(); Pipeline++) {
+            Entry& Target = Entries[Pipeline];
+            if (Target.State.load(std::memory_order_acquire) != CompileState::Done) {
+                continue;
+            }
+
+            // A failed compile keeps the old pipeline
+            if (Target.Compiled) {
+                if (Target.Live) {
+                    RetiredPipelines.push_back({ .Pipeline = Target.Live, .Frame = FrameNumber });
+                }
+                Target.Live = Target.Compiled;
+                CompiledSinceSave = true;
+            }
+            Target.Compiled = VK_NULL_HANDLE;
+            Target.State.store(CompileState::Idle, std::memory_order_relaxed);
+
+            if (Target.Stale) {
+                StartCompile(Pipeline);
+            }
+        }
+
+        // Everything settled, the next launch gets these warm
+        if (CompiledSinceSave && Compiles.IsDone()) {
+            PipelineCache::Save();
+            CompiledSinceSave = false;
+        }
+
+        if constexpr (RendererConfig::PipelineManager::HOT_RELOAD) {
+            PollShaders();
+        }
+    }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Types.hpp"
+
+// Graphics and compute pipelines built in the background.
+//
+// Passes describe a pipeline by value (shaders plus every Recipes::Pipeline::Parts state)
+// and get an Id back, descriptions hashing the same share one pipeline. Compiles run as
+// jobs against PipelineCache::Cache, BeginFrame swaps finished ones in on the main thread
+// so a frame records with one pipeline from start to end, and the pipeline swapped out
+// is destroyed once the frames in flight that could still use it are done. Until its
+// first compile finishes Get returns VK_NULL_HANDLE, passes skip their draws meanwhile.
+//
+// The .spv files in use are polled for changes, a changed shader is reloaded and every
+// pipeline using it recompiled while frames keep rendering with the old one.
+namespace PipelineManager {
+    using Id = uint32_t;
+    static constexpr Id INVALID_ID = UINT32_MAX;
+
+    struct GraphicsDesc {
+        // For the logs
+        std::string Name;
+        std::string VertexShader;
+        std::string FragmentShader;
+        // Both or neither, Tessellation and a patch list topology come with them
+        std::string TessControlShader;
+        std::string TessEvalShader;
+        VkPipelineLayout Layout = VK_NULL_HANDLE;
+
+        // Recipes::Pipeline::Parts, the pointers in them are ignored and filled in from the vectors below
+        VkPipelineVertexInputStateCreateInfo VertexInput {};
+        VkPipelineInputAssemblyStateCreateInfo InputAssembly {};
+        VkPipelineViewportStateCreateInfo ViewportState {};
+        VkPipelineRasterizationStateCreateInfo Rasterization {};
+        VkPipelineMultisampleStateCreateInfo Multisample {};
+        VkPipelineDepthStencilStateCreateInfo DepthStencil {};
+        VkPipelineColorBlendStateCreateInfo ColorBlendState {};
+        VkPipelineTessellationStateCreateInfo Tessellation {};
+
+        std::vector<VkVertexInputBindingDescription> VertexBindings;
+        std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+        std::vector<VkPipelineColorBlendAttachmentState> BlendAttachments;
+        std::vector<VkDynamicState> DynamicStates;
+
+        // Dynamic rendering
+        std::vector<VkFormat> ColorFormats;
+        VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+        VkFormat StencilFormat = VK_FORMAT_UNDEFINED;
+    };
+
+    struct ComputeDesc {
+        // For the logs
+        std::string Name;
+        std::string ComputeShader;
+        VkPipelineLayout Layout = VK_NULL_HANDLE;
+    };
+
+    InferusResult Create();
+    // Waits for the compiles in flight, the device has to be idle
+    void Destroy();
+
+    // Same hash, same pipeline. The first compile starts right away.
+    Id Request(const GraphicsDesc& Desc);
+    Id Request(const ComputeDesc& Desc);
+    // The pipeline to record with this frame, VK_NULL_HANDLE until it compiled once
+    VkPipeline Get(Id Pipeline);
+
+    // Main thread, once per frame after its fence was waited on and before recording
+    void BeginFrame();
+
+    // Every state field that ends up in the pipeline, not the pointers or the name
+    uint64_t Hash(const GraphicsDesc& Desc);
+    uint64_t Hash(const ComputeDesc& Desc);
+};
@@ -0,0 +1,309 @@
+#include "GpuProfiler.hpp"
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+
+namespace GpuProfiler {
+    using namespace RendererConfig::GpuProfiler;
+
+    enum class Queue : uint8_t { Graphics, Transfer };
+
+    // One pass, its last HISTORY samples in a ring
+    struct Track {
+        const char* Name;
+        Queue Source;
+        std::array<float, HISTORY> SamplesMs {};
+        uint32_t Next = 0;
+        uint32_t Count = 0;
+    };
+
+    // What a frame in flight wrote, the pair i is queries 2i and 2i + 1 of its range
+    struct FrameQueries {
+        uint32_t Used = 0;
+        std::array<uint32_t, MAX_SCOPES> TrackOf {};
+    };
+
+    std::vector<Track> Tracks;
+
+    VkQueryPool FramePool = VK_NULL_HANDLE;
+    std::vector<FrameQueries> Frames;
+    uint32_t Recording = 0;
+    uint64_t FrameMask = 0;
+
+    // A pair per upload batch
+    VkQueryPool UploadPool = VK_NULL_HANDLE;
+    std::vector<bool> UploadPending;
+    uint32_t UploadTrack = 0;
+    uint64_t UploadMask = 0;
+
+    double NsPerTick = 1.0;
+    // Last export, for the panel
+    char ExportStatus[128] = {};
+
+    // Timestamps wrap at their valid bits, differences are taken modulo that
+    uint64_t ValidMask(uint32_t ValidBits) {
+        return ValidBits >= 64 ? ~0ull : (1ull << ValidBits) - 1;
+    }
+
+    VkQueryPool CreatePool(uint32_t Count) {
+        VkQueryPoolCreateInfo PoolCreateInfo {};
+        PoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        PoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        PoolCreateInfo.queryCount = Count;
+
+        VkQueryPool Pool = VK_NULL_HANDLE;
+        if (vkCreateQueryPool(VulkanContext::Device, &PoolCreateInfo, nullptr, &Pool) != VK_SUCCESS) {
+            return VK_NULL_HANDLE;
+        }
+        // Reset from the host, transfer queues can't record vkCmdResetQueryPool
+        vkResetQueryPool(VulkanContext::Device, Pool, 0, Count);
+        return Pool;
+    }
+
+    uint32_t FindTrack(const char* Name, Queue Source) {
+        for (uint32_t i = 0; i < Tracks.size(); i++) {
+            if (Tracks[i].Source == Source && (Tracks[i].Name == Name || std::strcmp(Tracks[i].Name, Name) == 0)) {
+                return i;
+            }
+        }
+        Tracks.push_back({ .Name = Name, .Source = Source });
+        return static_cast<uint32_t>(Tracks.size() - 1);
+    }
+
+    void Push(uint32_t TrackIndex, float Ms) {
+        Track& Target = Tracks[TrackIndex];
+        Target.SamplesMs[Target.Next] = Ms;
+        Target.Next = (Target.Next + 1) % HISTORY;
+        Target.Count = std::min(Target.Count + 1, HISTORY);
+    }
+
+    // Without waiting, false when either end isn't there (the work never ran)
+    bool ReadPair(VkQueryPool Pool, uint32_t First, uint64_t Mask, float& OutMs) {
+        // Begin, its availability, end, its availability
+        uint64_t Results[4] = {};
+        VkResult Result = vkGetQueryPoolResults(
+            VulkanContext::Device,
+            Pool,
+            First,
+            2,
+            sizeof(Results),
+            Results,
+            2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+        );
+        if ((Result != VK_SUCCESS && Result != VK_NOT_READY) || !Results[1] || !Results[3]) {
+            return false;
+        }
+        OutMs = static_cast<float>(double((Results[2] - Results[0]) & Mask) * NsPerTick * 1e-6);
+        return true;
+    }
+
+    struct Summary {
+        float Min = 0.0f;
+        float Avg = 0.0f;
+        float P99 = 0.0f;
+    };
+
+    Summary Summarize(const Track& Source) {
+        if (Source.Count == 0) {
+            return {};
+        }
+        std::array<float, HISTORY> Sorted;
+        std::copy_n(Source.SamplesMs.begin(), Source.Count, Sorted.begin());
+        std::sort(Sorted.begin(), Sorted.begin() + Source.Count);
+
+        double Sum = 0.0;
+        for (uint32_t i = 0; i < Source.Count; i++) {
+            Sum += Sorted[i];
+        }
+        uint32_t P99Index = static_cast<uint32_t>(std::ceil(0.99 * double(Source.Count))) - 1;
+        return { .Min = Sorted[0], .Avg = float(Sum / double(Source.Count)), .P99 = Sorted[P99Index] };
+    }
+
+    InferusResult Create(uint32_t FramesInFlight, uint32_t UploadBatches) {
+        VkPhysicalDeviceProperties Properties;
+        vkGetPhysicalDeviceProperties(VulkanContext::PhysicalDevice, &Properties);
+        NsPerTick = Properties.limits.timestampPeriod;
+
+        uint32_t FamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(VulkanContext::PhysicalDevice, &FamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> Families(FamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(VulkanContext::PhysicalDevice, &FamilyCount, Families.data());
+        uint32_t GraphicsBits = Families[VulkanContext::Graphics.Index].timestampValidBits;
+        uint32_t TransferBits = Families[VulkanContext::Transfer.Index].timestampValidBits;
+
+        if (GraphicsBits > 0) {
+            FramePool = CreatePool(FramesInFlight * MAX_SCOPES * 2);
+            FrameMask = ValidMask(GraphicsBits);
+            Frames.assign(FramesInFlight, {});
+        }
+        if (TransferBits > 0) {
+            UploadPool = CreatePool(UploadBatches * 2);
+            UploadMask = ValidMask(TransferBits);
+            UploadPending.assign(UploadBatches, false);
+            UploadTrack = FindTrack("Uploads", Queue::Transfer);
+        }
+
+        // Only ever a missing readout, never a reason not to start
+        if (!FramePool) {
+            spdlog::warn("No GPU timestamps on the graphics queue, frames go unprofiled");
+        }
+        if (!UploadPool) {
+            spdlog::warn("No GPU timestamps on the transfer queue, uploads go unprofiled");
+        }
+        return InferusResult::SUCCESS;
+    }
+
+    void Destroy() {
+        if (FramePool) { vkDestroyQueryPool(VulkanContext::Device, FramePool, nullptr); }
+        if (UploadPool) { vkDestroyQueryPool(VulkanContext::Device, UploadPool, nullptr); }
+        FramePool = VK_NULL_HANDLE;
+        UploadPool = VK_NULL_HANDLE;
+        Frames.clear();
+        UploadPending.clear();
+        Tracks.clear();
+    }
+
+    void BeginFrame(uint32_t FrameIndex) {
+        Recording = FrameIndex;
+        if (!FramePool) {
+            return;
+        }
+
+        // The fence was waited on, everything this frame index wrote has landed
+        FrameQueries& Frame = Frames[FrameIndex];
+        uint32_t Base = FrameIndex * MAX_SCOPES * 2;
+        for (uint32_t i = 0; i < Frame.Used; i++) {
+            float Ms;
+            if (ReadPair(FramePool, Base + i * 2, FrameMask, Ms)) {
+                Push(Frame.TrackOf[i], Ms);
+            }
+        }
+        if (Frame.Used > 0) {
+            vkResetQueryPool(VulkanContext::Device, FramePool, Base, Frame.Used * 2);
+        }
+        Frame.Used = 0;
+    }
+
+    Scope::Scope(VkCommandBuffer cmd, const char* Name) : Cmd(cmd), EndQuery(UINT32_MAX) {
+        if (!FramePool) {
+            return;
+        }
+        FrameQueries& Frame = Frames[Recording];
+        if (Frame.Used == MAX_SCOPES) {
+            return;
+        }
+
+        uint32_t Query = (Recording * MAX_SCOPES + Frame.Used) * 2;
+        Frame.TrackOf[Frame.Used++] = FindTrack(Name, Queue::Graphics);
+        vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, FramePool, Query);
+        EndQuery = Query + 1;
+    }
+
+    Scope::~Scope() {
+        if (EndQuery != UINT32_MAX) {
+            vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, FramePool, EndQuery);
+        }
+    }
+
+    void BeginUpload(VkCommandBuffer cmd, uint32_t Batch) {
+        if (UploadPool) {
+            vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, UploadPool, Batch * 2);
+        }
+    }
+
+    void EndUpload(VkCommandBuffer cmd, uint32_t Batch) {
+        if (UploadPool) {
+            vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, UploadPool, Batch * 2 + 1);
+            UploadPending[Batch] = true;
+        }
+    }
+
+    void UploadRetired(uint32_t Batch) {
+        if (!UploadPool || !UploadPending[Batch]) {
+            return;
+        }
+        float Ms;
+        if (ReadPair(UploadPool, Batch * 2, UploadMask, Ms)) {
+            Push(UploadTrack, Ms);
+        }
+        vkResetQueryPool(VulkanContext::Device, UploadPool, Batch * 2, 2);
+        UploadPending[Batch] = false;
+    }
+
+    float LatestMs(const char* Name) {
+        for (const Track& Source : Tracks) {
+            if (Source.Source == Queue::Graphics && Source.Count > 0 && std::strcmp(Source.Name, Name) == 0) {
+                return Source.SamplesMs[(Source.Next + HISTORY - 1) % HISTORY];
+            }
+        }
+        return 0.0f;
+    }
+
+    void UpdateUI() {
+        ImGui::SetNextWindowSize(ImVec2(0.0f, 0.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("GPU Profiler");
+
+        // Passes overlap on the GPU, they don't add up to the frame
+        ImGui::TextDisabled("Last %u samples, ms:", HISTORY);
+        ImGui::Indent();
+        ImGui::Text("%-16s %7s %7s %7s", "", "min", "avg", "p99");
+        for (const Track& Source : Tracks) {
+            Summary Stats = Summarize(Source);
+            ImGui::Text("%-16s %7.3f %7.3f %7.3f", Source.Name, Stats.Min, Stats.Avg, Stats.P99);
+        }
+        if (Tracks.empty()) {
+            ImGui::Text("No timestamps on this device");
+        }
+        ImGui::Unindent();
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        if (ImGui::Button("Export CSV")) {
+            if (ExportCsv(CSV_PATH)) {
+                snprintf(ExportStatus, sizeof(ExportStatus), "Written to %s", CSV_PATH);
+            } else {
+                snprintf(ExportStatus, sizeof(ExportStatus), "Couldn't write %s", CSV_PATH);
+            }
+        }
+        if (ExportStatus[0]) {
+            ImGui::SameLine();
+            ImGui::Text("%s", ExportStatus);
+        }
+
+        ImGui::End();
+    }
+
+    bool ExportCsv(const char* Path) {
+        std::ofstream File(Path, std::ios::trunc);
+        File << "pass,queue,sample,gpu_ms\n";
+        for (const Track& Source : Tracks) {
+            // Oldest first
+            uint32_t Oldest = (Source.Next + HISTORY - Source.Count) % HISTORY;
+            for (uint32_t i = 0; i < Source.Count; i++) {
+                File << Source.Name << ',' << (Source.Source == Queue::Graphics ? "graphics" : "transfer") << ','
+                     << i << ',' << Source.SamplesMs[(Oldest + i) % HISTORY] << '\n';
+            }
+        }
+        File.flush();
+        if (!File) {
+            spdlog::warn("Couldn't write GPU profile {}", Path);
+            return false;
+        }
+        spdlog::info("GPU profile written to {}", Path);
+        return true;
+    }
+};
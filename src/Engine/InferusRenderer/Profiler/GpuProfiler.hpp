@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Types.hpp"
+
+// GPU time per pass, from timestamp queries.
+//
+// Frames get a range of queries each per frame in flight, a Scope writes a timestamp pair
+// into the recording frame's range. They're read back the next time that frame index comes
+// round, after its fence, so nothing ever waits on the GPU for them. Upload batches get a
+// pair each the same way, read back once the upload timeline says the batch ran.
+//
+// Every pass keeps its last HISTORY samples, the panel shows min/avg/p99 over them and
+// ExportCsv dumps them. Main thread only, like recording. Devices or queues without
+// timestamps get no pools and every call turns into a no-op.
+namespace GpuProfiler {
+    InferusResult Create(uint32_t FramesInFlight, uint32_t UploadBatches);
+    // Device idle
+    void Destroy();
+
+    // Frame boundary, after FrameIndex's fence: collects what it recorded last time and
+    // frees its queries
+    void BeginFrame(uint32_t FrameIndex);
+
+    // Timestamps around whatever gets recorded in its lifetime. Name is kept as is, a
+    // string literal, the same one every frame.
+    class Scope {
+    public:
+        Scope(VkCommandBuffer cmd, const char* Name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        VkCommandBuffer Cmd;
+        // Second query of the pair, UINT32_MAX when the frame ran out of them
+        uint32_t EndQuery;
+    };
+
+    // Upload batch Batch was just begun / is about to end, on the transfer queue
+    void BeginUpload(VkCommandBuffer cmd, uint32_t Batch);
+    void EndUpload(VkCommandBuffer cmd, uint32_t Batch);
+    // The upload timeline reached the value Batch signals, its timestamps can be read
+    void UploadRetired(uint32_t Batch);
+
+    // Newest sample of a graphics pass, 0 before it has any
+    float LatestMs(const char* Name);
+
+    void UpdateUI();
+    // Every sample still in the history, one row each
+    bool ExportCsv(const char* Path);
+};
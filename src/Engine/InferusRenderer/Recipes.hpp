@@ -30,6 +30,19 @@ namespace Recipes {
                     InputAssembly.primitiveRestartEnable = VK_FALSE;
                     return InputAssembly;
                 }
+                RECIPE VkPipelineInputAssemblyStateCreateInfo Patches() {
+                    VkPipelineInputAssemblyStateCreateInfo InputAssembly = Default();
+                    InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+                    return InputAssembly;
+                }
+            };
+            namespace Tessellation {
+                RECIPE VkPipelineTessellationStateCreateInfo Quads() {
+                    VkPipelineTessellationStateCreateInfo Tessellation {};
+                    Tessellation.sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+                    Tessellation.patchControlPoints = 4;
+                    return Tessellation;
+                }
             };
             namespace Rasterization {
                 RECIPE VkPipelineRasterizationStateCreateInfo Default() {
@@ -210,39 +223,56 @@ namespace Recipes {
             };
             return imageCopy;
        }
+
+       // A single array layer, read from BufferOffset
+       RECIPE VkBufferImageCopy Layer(const ImageSystem::Image& image, uint32_t Layer, VkDeviceSize BufferOffset) {
+            VkBufferImageCopy imageCopy = Default(image);
+            imageCopy.bufferOffset = BufferOffset;
+            imageCopy.imageSubresource.baseArrayLayer = Layer;
+            imageCopy.imageSubresource.layerCount = 1;
+            return imageCopy;
+       }
     };
-    namespace ImageMemoryBarrier {
-        RECIPE VkImageMemoryBarrier RawDefault(VkImage image) {
-            VkImageMemoryBarrier Barrier {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    namespace BufferMemoryBarrier {
+        RECIPE VkBufferMemoryBarrier2 Default(VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Size) {
+            VkBufferMemoryBarrier2 Barrier {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
                 .pNext = nullptr,
-                .srcAccessMask = 0,
-                .dstAccessMask = 0,
-                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .srcQueueFamilyIndex =VK_QUEUE_FAMILY_IGNORED,
+                .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+                .srcAccessMask = VK_ACCESS_2_NONE,
+                .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+                .dstAccessMask = VK_ACCESS_2_NONE,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = image,
-                .subresourceRange {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                }
+                .buffer = Buffer,
+                .offset = Offset,
+                .size = Size
             };
             return Barrier;
         }
 
-        RECIPE VkImageMemoryBarrier Default(const ImageSystem::Image& image) {
-            VkImageMemoryBarrier barrier {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        // Copied into on the transfer queue, read by the vertex shader
+        RECIPE VkBufferMemoryBarrier2 TransferToVertex(VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Size) {
+            VkBufferMemoryBarrier2 Barrier = Default(Buffer, Offset, Size);
+            Barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            Barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            Barrier.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+            Barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+            return Barrier;
+        }
+    };
+    namespace ImageMemoryBarrier {
+        RECIPE VkImageMemoryBarrier2 Default(const ImageSystem::Image& image) {
+            VkImageMemoryBarrier2 barrier {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
                 .pNext = nullptr,
-                .srcAccessMask = 0,
-                .dstAccessMask = 0,
+                .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+                .srcAccessMask = VK_ACCESS_2_NONE,
+                .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+                .dstAccessMask = VK_ACCESS_2_NONE,
                 .oldLayout = image.layout,
                 .newLayout = image.layout,
-                .srcQueueFamilyIndex =VK_QUEUE_FAMILY_IGNORED,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                 .image = image.image,
                 .subresourceRange {
@@ -256,42 +286,36 @@ namespace Recipes {
             return barrier;
         }
 
-        RECIPE VkImageMemoryBarrier TransferDest(const ImageSystem::Image& image) {
-            VkImageMemoryBarrier barrier = Default(image);
+        // Fully rewritten by a copy, whatever was there is dropped. Readers of the old
+        // contents are waited on through a semaphore at the transfer stage.
+        RECIPE VkImageMemoryBarrier2 TransferDest(const ImageSystem::Image& image) {
+            VkImageMemoryBarrier2 barrier = Default(image);
             barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
             barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
 
             return barrier;
         }
 
-        RECIPE VkImageMemoryBarrier ShaderRead(const ImageSystem::Image& image) {
-            VkImageMemoryBarrier barrier = Default(image);
-            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // After the copy, sampled by the vertex or tessellation shaders
+        RECIPE VkImageMemoryBarrier2 ShaderRead(const ImageSystem::Image& image) {
+            VkImageMemoryBarrier2 barrier = Default(image);
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
             barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT;
+            barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
 
             return barrier;
         }
-        namespace Rendering {
-            RECIPE VkImageMemoryBarrier EnableRendering(VkImage Image) {
-                VkImageMemoryBarrier Barrier = RawDefault(Image);
-                Barrier.newLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
-                Barrier.srcAccessMask = 0;
-                Barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-                return Barrier;
-            };
-
-            RECIPE VkImageMemoryBarrier EnablePresenting(VkImage Image) {
-                VkImageMemoryBarrier Barrier = RawDefault(Image);
-                Barrier.oldLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
-                Barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-                Barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-                Barrier.dstAccessMask = 0;
-                return Barrier;
-            };
-        };
+        // Narrows any of the above to a single array layer
+        RECIPE VkImageMemoryBarrier2 Layer(VkImageMemoryBarrier2 Barrier, uint32_t Layer) {
+            Barrier.subresourceRange.baseArrayLayer = Layer;
+            Barrier.subresourceRange.layerCount = 1;
+            return Barrier;
+        }
     };
 };
@@ -0,0 +1,589 @@
+#include "RenderGraph.hpp"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+
+namespace {
+    // Only these need making available, reads in a source access mask do nothing
+    constexpr VkAccessFlags2 WRITE_ACCESS = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                          | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    VkImageUsageFlags UsageFlagsOf(RenderGraph::Usage What) {
+        using Usage = RenderGraph::Usage;
+        switch (What) {
+            case Usage::ColorAttachment: return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            case Usage::DepthAttachment: return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            case Usage::SampledGraphics:
+            case Usage::SampledCompute: return VK_IMAGE_USAGE_SAMPLED_BIT;
+            case Usage::StorageReadGraphics:
+            case Usage::StorageReadCompute:
+            case Usage::StorageWriteCompute: return VK_IMAGE_USAGE_STORAGE_BIT;
+            case Usage::TransferSrc: return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            case Usage::TransferDst: return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            default: return 0;
+        }
+    }
+
+    // What a barrier for one subresource needs, neighbours needing the same get merged
+    struct Step {
+        bool Needed = false;
+        VkPipelineStageFlags2 SrcStage = 0;
+        VkAccessFlags2 SrcAccess = 0;
+        VkImageLayout OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        bool operator==(const Step&) const = default;
+    };
+}
+
+RenderGraph::UsageInfo RenderGraph::Describe(Usage What) {
+    // Pre-rasterization covers tessellation without naming its stages, those are invalid on
+    // devices that don't have it
+    constexpr VkPipelineStageFlags2 GRAPHICS_SHADERS = VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    switch (What) {
+        case Usage::ColorAttachment:
+            return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                     VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, true };
+        case Usage::DepthAttachment:
+            return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                     VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, true };
+        case Usage::SampledGraphics:
+            return { GRAPHICS_SHADERS, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false };
+        case Usage::SampledCompute:
+            return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false };
+        case Usage::StorageReadGraphics:
+            return { GRAPHICS_SHADERS, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false };
+        case Usage::StorageReadCompute:
+            return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false };
+        case Usage::StorageWriteCompute:
+            return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_GENERAL, true };
+        case Usage::IndirectRead:
+            return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+        case Usage::IndexRead:
+            return { VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+        case Usage::TransferSrc:
+            return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false };
+        case Usage::TransferDst:
+            return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true };
+        case Usage::Present:
+            return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false };
+        case Usage::None:
+        default:
+            return { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED, false };
+    }
+}
+
+RenderGraph::ResourceId RenderGraph::ImportImage(const char* Name, const ImageDesc& Desc, Usage Between, bool Discard) {
+    Resource Res {};
+    Res.Name = Name;
+    Res.Imported = true;
+    Res.Discard = Discard;
+    Res.Between = Between;
+    Res.Desc = Desc;
+    Resources.push_back(Res);
+    return static_cast<ResourceId>(Resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::ImportImage(const char* Name, ImageSystem::Id Image, Usage Between) {
+    const ImageSystem::Image& Owned = ImageSystem::get(Image);
+    ImageDesc Desc = {
+        .Format = Owned.format,
+        .Extent = { Owned.width, Owned.height },
+        .Layers = Owned.arrayLayers,
+        .Mips = Owned.mipLevels,
+        .Aspect = VK_IMAGE_ASPECT_COLOR_BIT
+    };
+
+    ResourceId Id = ImportImage(Name, Desc, Between);
+    Resources[Id].Owner = Image;
+    BindImage(Id, Owned.image, Owned.imageView);
+    return Id;
+}
+
+RenderGraph::ResourceId RenderGraph::ImportBuffer(const char* Name, Usage Between) {
+    Resource Res {};
+    Res.Name = Name;
+    Res.IsImage = false;
+    Res.Imported = true;
+    Res.Between = Between;
+    Resources.push_back(Res);
+    return static_cast<ResourceId>(Resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::CreateImage(const char* Name, const ImageDesc& Desc) {
+    Resource Res {};
+    Res.Name = Name;
+    Res.Desc = Desc;
+    Resources.push_back(Res);
+    return static_cast<ResourceId>(Resources.size() - 1);
+}
+
+void RenderGraph::BindImage(ResourceId Id, VkImage Image, VkImageView View) {
+    Resources[Id].Image = Image;
+    Resources[Id].View = View;
+}
+
+void RenderGraph::BindBuffer(ResourceId Id, VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Size) {
+    Resources[Id].Buffer = Buffer;
+    Resources[Id].Offset = Offset;
+    Resources[Id].Size = Size;
+}
+
+RenderGraph::PassId RenderGraph::AddPass(const char* Name, std::function<void(VkCommandBuffer)> Record) {
+    Pass NewPass {};
+    NewPass.Name = Name;
+    NewPass.Record = std::move(Record);
+    Passes.push_back(std::move(NewPass));
+    return static_cast<PassId>(Passes.size() - 1);
+}
+
+void RenderGraph::Use(PassId Id, ResourceId Target, Usage How) {
+    Use(Id, Target, How, Range {});
+}
+
+void RenderGraph::Use(PassId Id, ResourceId Target, Usage How, Range Subresources) {
+    Passes[Id].Accesses.push_back({ Target, How, Subresources });
+}
+
+void RenderGraph::ColorAttachment(PassId Id, ResourceId Target, VkRenderingAttachmentInfo Info) {
+    Use(Id, Target, Usage::ColorAttachment, Range { 0, 1, 0, 1 });
+    Passes[Id].ColorAttachments.push_back({ Target, Info });
+}
+
+void RenderGraph::DepthAttachment(PassId Id, ResourceId Target, VkRenderingAttachmentInfo Info) {
+    Use(Id, Target, Usage::DepthAttachment, Range { 0, 1, 0, 1 });
+    Passes[Id].HasDepth = true;
+    Passes[Id].Depth = { Target, Info };
+}
+
+VkImage RenderGraph::GetImage(ResourceId Id) const {
+    return Resources[Id].Image;
+}
+
+VkImageView RenderGraph::GetImageView(ResourceId Id) const {
+    return Resources[Id].View;
+}
+
+uint32_t RenderGraph::SubresourceCount(const Resource& Res) const {
+    return Res.IsImage ? Res.Desc.Layers * Res.Desc.Mips : 1;
+}
+
+VkExtent2D RenderGraph::ExtentOf(const Resource& Res) const {
+    return Res.Desc.Extent.width == 0 || Res.Desc.Extent.height == 0 ? Extent : Res.Desc.Extent;
+}
+
+InferusResult RenderGraph::CreateTransients() {
+    VkDevice Device = VulkanContext::Device;
+
+    std::vector<ResourceId> Order;
+    for (ResourceId Id = 0; Id < Resources.size(); Id++) {
+        Resource& Res = Resources[Id];
+        if (Res.Imported || Res.FirstPass == UINT32_MAX) {
+            continue;
+        }
+
+        VkExtent2D ImageExtent = ExtentOf(Res);
+        VkImageCreateInfo CreateInfo {};
+        CreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        CreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        CreateInfo.format = Res.Desc.Format;
+        CreateInfo.extent = { ImageExtent.width, ImageExtent.height, 1 };
+        CreateInfo.mipLevels = Res.Desc.Mips;
+        CreateInfo.arrayLayers = Res.Desc.Layers;
+        CreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        CreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        CreateInfo.usage = Res.UsageFlags;
+        CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        CreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(Device, &CreateInfo, nullptr, &Res.Image) != VK_SUCCESS) {
+            spdlog::error("Render graph couldn't create transient image {}", Res.Name);
+            return InferusResult::FAIL;
+        }
+        vkGetImageMemoryRequirements(Device, Res.Image, &Res.Requirements);
+        Order.push_back(Id);
+    }
+
+    // Biggest first, so the smaller ones fit into blocks that are already there
+    std::sort(Order.begin(), Order.end(), [&](ResourceId A, ResourceId B) {
+        return Resources[A].Requirements.size > Resources[B].Requirements.size;
+    });
+
+    for (ResourceId Id : Order) {
+        Resource& Res = Resources[Id];
+
+        uint32_t Chosen = UINT32_MAX;
+        for (uint32_t BlockIndex = 0; RendererConfig::RenderGraph::ALIAS_TRANSIENTS && BlockIndex < Blocks.size(); BlockIndex++) {
+            MemoryBlock& Block = Blocks[BlockIndex];
+            if ((Block.Requirements.memoryTypeBits & Res.Requirements.memoryTypeBits) == 0) {
+                continue;
+            }
+            bool Overlaps = std::any_of(Block.Occupants.begin(), Block.Occupants.end(), [&](ResourceId Other) {
+                return Resources[Other].FirstPass <= Res.LastPass && Res.FirstPass <= Resources[Other].LastPass;
+            });
+            if (!Overlaps) {
+                Chosen = BlockIndex;
+                break;
+            }
+        }
+
+        if (Chosen == UINT32_MAX) {
+            Blocks.push_back({ .Allocation = VK_NULL_HANDLE, .Requirements = Res.Requirements, .Occupants = {} });
+            Chosen = static_cast<uint32_t>(Blocks.size() - 1);
+        } else {
+            VkMemoryRequirements& Shared = Blocks[Chosen].Requirements;
+            Shared.size = std::max(Shared.size, Res.Requirements.size);
+            Shared.alignment = std::max(Shared.alignment, Res.Requirements.alignment);
+            Shared.memoryTypeBits &= Res.Requirements.memoryTypeBits;
+        }
+        Blocks[Chosen].Occupants.push_back(Id);
+        Res.Block = Chosen;
+    }
+
+    VkDeviceSize Unaliased = 0;
+    VkDeviceSize Allocated = 0;
+    for (MemoryBlock& Block : Blocks) {
+        std::sort(Block.Occupants.begin(), Block.Occupants.end(), [&](ResourceId A, ResourceId B) {
+            return Resources[A].FirstPass < Resources[B].FirstPass;
+        });
+
+        VmaAllocationCreateInfo AllocCreateInfo {};
+        AllocCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        if (vmaAllocateMemory(VulkanContext::VmaAllocator, &Block.Requirements, &AllocCreateInfo, &Block.Allocation, nullptr) != VK_SUCCESS) {
+            spdlog::error("Render graph couldn't allocate {} bytes for transients", Block.Requirements.size);
+            return InferusResult::FAIL;
+        }
+        Allocated += Block.Requirements.size;
+
+        for (ResourceId Id : Block.Occupants) {
+            Resource& Res = Resources[Id];
+            Unaliased += Res.Requirements.size;
+            if (vmaBindImageMemory(VulkanContext::VmaAllocator, Block.Allocation, Res.Image) != VK_SUCCESS) {
+                spdlog::error("Render graph couldn't bind transient image {}", Res.Name);
+                return InferusResult::FAIL;
+            }
+
+            VkImageViewCreateInfo ViewCreateInfo {};
+            ViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            ViewCreateInfo.image = Res.Image;
+            ViewCreateInfo.viewType = Res.Desc.Layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            ViewCreateInfo.format = Res.Desc.Format;
+            ViewCreateInfo.subresourceRange = { Res.Desc.Aspect, 0, Res.Desc.Mips, 0, Res.Desc.Layers };
+            if (vkCreateImageView(VulkanContext::Device, &ViewCreateInfo, nullptr, &Res.View) != VK_SUCCESS) {
+                spdlog::error("Render graph couldn't create the view of transient image {}", Res.Name);
+                return InferusResult::FAIL;
+            }
+        }
+    }
+
+    if (!Order.empty()) {
+        spdlog::debug("Render graph transients: {} images in {} blocks, {} KiB ({} KiB without aliasing)",
+            Order.size(), Blocks.size(), Allocated / 1024, Unaliased / 1024);
+    }
+    return InferusResult::SUCCESS;
+}
+
+void RenderGraph::DestroyTransients() {
+    for (Resource& Res : Resources) {
+        if (Res.Imported) {
+            continue;
+        }
+        if (Res.View) { vkDestroyImageView(VulkanContext::Device, Res.View, nullptr); }
+        if (Res.Image) { vkDestroyImage(VulkanContext::Device, Res.Image, nullptr); }
+        Res.View = VK_NULL_HANDLE;
+        Res.Image = VK_NULL_HANDLE;
+        Res.Block = UINT32_MAX;
+    }
+    for (MemoryBlock& Block : Blocks) {
+        if (Block.Allocation) { vmaFreeMemory(VulkanContext::VmaAllocator, Block.Allocation); }
+    }
+    Blocks.clear();
+}
+
+void RenderGraph::Destroy() {
+    DestroyTransients();
+}
+
+void RenderGraph::Transition(ResourceId Id, std::vector<SubresourceState>& State, const Range& Subresources,
+                             const UsageInfo& To, VkPipelineStageFlags2 DstStage)
+{
+    const Resource& Res = Resources[Id];
+
+    auto Advance = [&](SubresourceState& Sub) {
+        Step Out { .Needed = false, .SrcStage = 0, .SrcAccess = 0, .OldLayout = Sub.Layout };
+        bool LayoutChange = Res.IsImage && Sub.Layout != To.Layout;
+
+        if (LayoutChange || To.Write) {
+            // Waits on everything since the last write, transitions count as writes
+            Out.SrcStage = Sub.WriteStage | Sub.ReadStages;
+            Out.SrcAccess = Sub.WriteAccess;
+            Out.Needed = LayoutChange || Out.SrcStage != 0;
+
+            Sub.Layout = Res.IsImage ? To.Layout : Sub.Layout;
+            Sub.WriteStage = To.Stage;
+            Sub.WriteAccess = To.Access & WRITE_ACCESS;
+            Sub.VisibleStages = To.Write ? 0 : To.Stage;
+            Sub.VisibleAccess = To.Write ? 0 : To.Access;
+            Sub.ReadStages = To.Write ? 0 : To.Stage;
+        } else {
+            // Read after read needs nothing, read after write once per stage/access
+            bool Unseen = (To.Stage & ~Sub.VisibleStages) != 0 || (To.Access & ~Sub.VisibleAccess) != 0;
+            if (Sub.WriteStage != 0 && Unseen) {
+                Out.Needed = true;
+                Out.SrcStage = Sub.WriteStage;
+                Out.SrcAccess = Sub.WriteAccess;
+                Sub.VisibleStages |= To.Stage;
+                Sub.VisibleAccess |= To.Access;
+            }
+            Sub.ReadStages |= To.Stage;
+        }
+        return Out;
+    };
+
+    if (!Res.IsImage) {
+        Step Out = Advance(State[0]);
+        if (Out.Needed) {
+            BufferBarriers.push_back({
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .pNext = nullptr,
+                .srcStageMask = Out.SrcStage,
+                .srcAccessMask = Out.SrcAccess,
+                .dstStageMask = DstStage,
+                .dstAccessMask = To.Access,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = VK_NULL_HANDLE,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE
+            });
+            BufferBarrierOwners.push_back(Id);
+        }
+        return;
+    }
+
+    uint32_t BaseLayer = std::min(Subresources.BaseLayer, Res.Desc.Layers);
+    uint32_t LayerCount = std::min(Subresources.LayerCount, Res.Desc.Layers - BaseLayer);
+    uint32_t BaseMip = std::min(Subresources.BaseMip, Res.Desc.Mips);
+    uint32_t MipCount = std::min(Subresources.MipCount, Res.Desc.Mips - BaseMip);
+
+    for (uint32_t Mip = BaseMip; Mip < BaseMip + MipCount; Mip++) {
+        // Runs of layers needing the same barrier become one barrier
+        Step Run {};
+        uint32_t RunStart = BaseLayer;
+        auto Flush = [&](uint32_t RunEnd) {
+            if (!Run.Needed || RunEnd == RunStart) {
+                return;
+            }
+            ImageBarriers.push_back({
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .pNext = nullptr,
+                .srcStageMask = Run.SrcStage,
+                .srcAccessMask = Run.SrcAccess,
+                .dstStageMask = DstStage,
+                .dstAccessMask = To.Access,
+                .oldLayout = Run.OldLayout,
+                .newLayout = To.Layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = VK_NULL_HANDLE,
+                .subresourceRange = { Res.Desc.Aspect, Mip, 1, RunStart, RunEnd - RunStart }
+            });
+            ImageBarrierOwners.push_back(Id);
+        };
+
+        for (uint32_t Layer = BaseLayer; Layer < BaseLayer + LayerCount; Layer++) {
+            Step Out = Advance(State[Mip * Res.Desc.Layers + Layer]);
+            if (Layer == BaseLayer || !(Out == Run)) {
+                Flush(Layer);
+                Run = Out;
+                RunStart = Layer;
+            }
+        }
+        Flush(BaseLayer + LayerCount);
+    }
+}
+
+InferusResult RenderGraph::Compile(VkExtent2D RenderExtent) {
+    Extent = RenderExtent;
+    DestroyTransients();
+
+    // Lifetimes, and what the last pass touching a resource did, the next one sharing its
+    // memory (or itself next frame) has to wait on that
+    std::vector<VkPipelineStageFlags2> LastStages(Resources.size(), 0);
+    std::vector<VkAccessFlags2> LastWrites(Resources.size(), 0);
+    for (Resource& Res : Resources) {
+        Res.FirstPass = UINT32_MAX;
+        Res.LastPass = 0;
+        Res.UsageFlags = 0;
+    }
+    for (uint32_t PassIndex = 0; PassIndex < Passes.size(); PassIndex++) {
+        for (const Access& Used : Passes[PassIndex].Accesses) {
+            Resource& Res = Resources[Used.Resource];
+            Res.FirstPass = std::min(Res.FirstPass, PassIndex);
+            Res.LastPass = std::max(Res.LastPass, PassIndex);
+            Res.UsageFlags |= UsageFlagsOf(Used.How);
+        }
+    }
+    for (uint32_t PassIndex = 0; PassIndex < Passes.size(); PassIndex++) {
+        for (const Access& Used : Passes[PassIndex].Accesses) {
+            if (Resources[Used.Resource].LastPass != PassIndex) {
+                continue;
+            }
+            UsageInfo Info = Describe(Used.How);
+            LastStages[Used.Resource] |= Info.Stage;
+            LastWrites[Used.Resource] |= Info.Access & WRITE_ACCESS;
+        }
+    }
+
+    if (CreateTransients() != InferusResult::SUCCESS) {
+        DestroyTransients();
+        return InferusResult::FAIL;
+    }
+
+    // State at the start of the frame
+    std::vector<std::vector<SubresourceState>> States(Resources.size());
+    for (ResourceId Id = 0; Id < Resources.size(); Id++) {
+        Resource& Res = Resources[Id];
+        SubresourceState Initial {};
+        if (Res.Imported) {
+            UsageInfo Between = Describe(Res.Between);
+            Initial.Layout = Res.Discard ? VK_IMAGE_LAYOUT_UNDEFINED : Between.Layout;
+            if (Between.Write) {
+                Initial.WriteStage = Between.Stage;
+                Initial.WriteAccess = Between.Access & WRITE_ACCESS;
+            } else {
+                Initial.ReadStages = Between.Stage;
+            }
+        } else if (Res.Block != UINT32_MAX) {
+            // Whatever used the memory last, this frame or the previous one
+            const std::vector<ResourceId>& Occupants = Blocks[Res.Block].Occupants;
+            size_t Index = std::find(Occupants.begin(), Occupants.end(), Id) - Occupants.begin();
+            ResourceId Previous = Occupants[(Index + Occupants.size() - 1) % Occupants.size()];
+            Initial.WriteStage = LastStages[Previous];
+            Initial.WriteAccess = LastWrites[Previous];
+        }
+        States[Id].assign(SubresourceCount(Res), Initial);
+    }
+
+    ImageBarriers.clear();
+    ImageBarrierOwners.clear();
+    BufferBarriers.clear();
+    BufferBarrierOwners.clear();
+
+    auto BeginBatch = [&]() {
+        return Batch {
+            .FirstImage = static_cast<uint32_t>(ImageBarriers.size()), .ImageCount = 0,
+            .FirstBuffer = static_cast<uint32_t>(BufferBarriers.size()), .BufferCount = 0
+        };
+    };
+    auto EndBatch = [&](Batch& Into) {
+        Into.ImageCount = static_cast<uint32_t>(ImageBarriers.size()) - Into.FirstImage;
+        Into.BufferCount = static_cast<uint32_t>(BufferBarriers.size()) - Into.FirstBuffer;
+    };
+
+    for (Pass& P : Passes) {
+        P.Barriers = BeginBatch();
+        for (const Access& Used : P.Accesses) {
+            UsageInfo To = Describe(Used.How);
+            Transition(Used.Resource, States[Used.Resource], Used.Subresources, To, To.Stage);
+        }
+        EndBatch(P.Barriers);
+
+        P.ColorInfos.clear();
+        for (const Attachment& Color : P.ColorAttachments) {
+            VkRenderingAttachmentInfo Info = Color.Info;
+            Info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            Info.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+            P.ColorInfos.push_back(Info);
+        }
+        P.DepthInfo = P.Depth.Info;
+        P.DepthInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        P.DepthInfo.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+
+        P.RenderingInfo = {};
+        P.RenderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        P.RenderingInfo.renderArea = { .offset = { 0, 0 }, .extent = Extent };
+        P.RenderingInfo.layerCount = 1;
+        P.RenderingInfo.colorAttachmentCount = static_cast<uint32_t>(P.ColorInfos.size());
+    }
+
+    // Imports go back to what they are between frames, nothing waits on a present
+    FinalBarriers = BeginBatch();
+    for (ResourceId Id = 0; Id < Resources.size(); Id++) {
+        Resource& Res = Resources[Id];
+        if (!Res.Imported || Res.FirstPass == UINT32_MAX) {
+            continue;
+        }
+        UsageInfo To = Describe(Res.Between);
+        Transition(Id, States[Id], Range {}, To, Res.Between == Usage::Present ? VK_PIPELINE_STAGE_2_NONE : To.Stage);
+
+        if (Res.Owner.index != UINT32_MAX) {
+            ImageSystem::get(Res.Owner).layout = To.Layout;
+        }
+    }
+    EndBatch(FinalBarriers);
+
+    uint32_t BatchCount = FinalBarriers.ImageCount + FinalBarriers.BufferCount > 0 ? 1 : 0;
+    for (const Pass& P : Passes) {
+        BatchCount += P.Barriers.ImageCount + P.Barriers.BufferCount > 0 ? 1 : 0;
+    }
+    spdlog::debug("Render graph compiled: {} passes, {} image and {} buffer barriers in {} batches",
+        Passes.size(), ImageBarriers.size(), BufferBarriers.size(), BatchCount);
+    return InferusResult::SUCCESS;
+}
+
+void RenderGraph::Record(VkCommandBuffer cmd, const Batch& Barriers) {
+    if (Barriers.ImageCount == 0 && Barriers.BufferCount == 0) {
+        return;
+    }
+
+    // Handles can change from frame to frame (swapchain), patched right before recording
+    for (uint32_t i = Barriers.FirstImage; i < Barriers.FirstImage + Barriers.ImageCount; i++) {
+        ImageBarriers[i].image = Resources[ImageBarrierOwners[i]].Image;
+    }
+    for (uint32_t i = Barriers.FirstBuffer; i < Barriers.FirstBuffer + Barriers.BufferCount; i++) {
+        const Resource& Res = Resources[BufferBarrierOwners[i]];
+        BufferBarriers[i].buffer = Res.Buffer;
+        BufferBarriers[i].offset = Res.Offset;
+        BufferBarriers[i].size = Res.Size;
+    }
+
+    VkDependencyInfo Dependency {};
+    Dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    Dependency.imageMemoryBarrierCount = Barriers.ImageCount;
+    Dependency.pImageMemoryBarriers = ImageBarriers.data() + Barriers.FirstImage;
+    Dependency.bufferMemoryBarrierCount = Barriers.BufferCount;
+    Dependency.pBufferMemoryBarriers = BufferBarriers.data() + Barriers.FirstBuffer;
+    vkCmdPipelineBarrier2(cmd, &Dependency);
+}
+
+void RenderGraph::Execute(VkCommandBuffer cmd) {
+    for (Pass& P : Passes) {
+        Record(cmd, P.Barriers);
+
+        if (P.ColorInfos.empty() && !P.HasDepth) {
+            P.Record(cmd);
+            continue;
+        }
+
+        for (size_t i = 0; i < P.ColorInfos.size(); i++) {
+            P.ColorInfos[i].imageView = Resources[P.ColorAttachments[i].Resource].View;
+        }
+        P.DepthInfo.imageView = P.HasDepth ? Resources[P.Depth.Resource].View : VK_NULL_HANDLE;
+        P.RenderingInfo.pColorAttachments = P.ColorInfos.data();
+        P.RenderingInfo.pDepthAttachment = P.HasDepth ? &P.DepthInfo : nullptr;
+
+        vkCmdBeginRendering(cmd, &P.RenderingInfo);
+        P.Record(cmd);
+        vkCmdEndRendering(cmd);
+    }
+
+    Record(cmd, FinalBarriers);
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+#include "Engine/Types.hpp"
+#include "Engine/InferusRenderer/Image/ImageSystem.hpp"
+
+// The frame as passes over resources.
+//
+// Passes declare what they touch and how (a Usage, i.e. a stage, access and layout), the
+// graph walks them in the order they were added keeping per subresource state and derives
+// the synchronization2 barriers in between: layout changes, hazards after writes, and
+// nothing at all for reads of something already visible. Each pass gets one batched
+// vkCmdPipelineBarrier2 before it, the frame one more at the end to hand imported images
+// back in the usage they sit in between frames.
+//
+// Built once and compiled once (again after a resize), Execute only patches the per frame
+// handles in (the swapchain image) and records. Transient images are created by Compile,
+// ones whose passes don't overlap share memory.
+class RenderGraph {
+public:
+    using ResourceId = uint32_t;
+    using PassId = uint32_t;
+
+    enum class Usage : uint8_t {
+        // Contents don't matter, for imports that are overwritten every frame
+        None,
+        ColorAttachment,
+        DepthAttachment,
+        // Vertex (tessellation included) and fragment shaders
+        SampledGraphics,
+        SampledCompute,
+        StorageReadGraphics,
+        StorageReadCompute,
+        StorageWriteCompute,
+        IndirectRead,
+        IndexRead,
+        TransferSrc,
+        TransferDst,
+        // Acquired from / handed to the presentation engine, stage is the acquire wait's
+        Present
+    };
+
+    struct UsageInfo {
+        VkPipelineStageFlags2 Stage;
+        VkAccessFlags2 Access;
+        VkImageLayout Layout;
+        bool Write;
+    };
+    static UsageInfo Describe(Usage What);
+
+    static constexpr uint32_t ALL = UINT32_MAX;
+    // Layers and mips a pass touches, ALL reaches the end of the image
+    struct Range {
+        uint32_t BaseLayer = 0;
+        uint32_t LayerCount = ALL;
+        uint32_t BaseMip = 0;
+        uint32_t MipCount = ALL;
+    };
+
+    struct ImageDesc {
+        VkFormat Format = VK_FORMAT_UNDEFINED;
+        // Zero follows the extent the graph was compiled with
+        VkExtent2D Extent = { 0, 0 };
+        uint32_t Layers = 1;
+        uint32_t Mips = 1;
+        VkImageAspectFlags Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    };
+
+    // Outlives the frame and sits in Between outside of it, Discard throws the contents away
+    // when the frame starts (swapchain images). Handles come from BindImage.
+    ResourceId ImportImage(const char* Name, const ImageDesc& Desc, Usage Between, bool Discard = false);
+    // Same, bound for good, the ImageSystem::Image's layout is kept up to date
+    ResourceId ImportImage(const char* Name, ImageSystem::Id Image, Usage Between);
+    ResourceId ImportBuffer(const char* Name, Usage Between);
+    // Only lives during the frame, created by Compile with the usage flags its passes need
+    ResourceId CreateImage(const char* Name, const ImageDesc& Desc);
+
+    void BindImage(ResourceId Target, VkImage Image, VkImageView View);
+    void BindBuffer(ResourceId Target, VkBuffer Buffer, VkDeviceSize Offset = 0, VkDeviceSize Size = VK_WHOLE_SIZE);
+
+    PassId AddPass(const char* Name, std::function<void(VkCommandBuffer)> Record);
+    // The whole resource, or part of an image
+    void Use(PassId Pass, ResourceId Target, Usage How);
+    void Use(PassId Pass, ResourceId Target, Usage How, Range Subresources);
+    // Makes it a rendering pass, Record runs inside vkCmdBeginRendering. Info is a template,
+    // the view and layout are filled in.
+    void ColorAttachment(PassId Pass, ResourceId Target, VkRenderingAttachmentInfo Info);
+    void DepthAttachment(PassId Pass, ResourceId Target, VkRenderingAttachmentInfo Info);
+
+    // Barriers, rendering infos and transients. Again whenever the extent changes, the
+    // device has to be idle then.
+    InferusResult Compile(VkExtent2D RenderExtent);
+    void Execute(VkCommandBuffer cmd);
+    // Device idle, frees the transients
+    void Destroy();
+
+    VkImage GetImage(ResourceId Target) const;
+    VkImageView GetImageView(ResourceId Target) const;
+
+private:
+    struct SubresourceState {
+        VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // Last write (or layout transition) and who has seen it since
+        VkPipelineStageFlags2 WriteStage = 0;
+        VkAccessFlags2 WriteAccess = 0;
+        VkPipelineStageFlags2 VisibleStages = 0;
+        VkAccessFlags2 VisibleAccess = 0;
+        // Reads since the last write, the next write waits on them
+        VkPipelineStageFlags2 ReadStages = 0;
+    };
+
+    struct Resource {
+        std::string Name;
+        bool IsImage = true;
+        bool Imported = false;
+        bool Discard = false;
+        Usage Between = Usage::None;
+        ImageDesc Desc {};
+        ImageSystem::Id Owner { UINT32_MAX };
+
+        VkImage Image = VK_NULL_HANDLE;
+        VkImageView View = VK_NULL_HANDLE;
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceSize Offset = 0;
+        VkDeviceSize Size = VK_WHOLE_SIZE;
+
+        // Transients
+        VkImageUsageFlags UsageFlags = 0;
+        uint32_t FirstPass = UINT32_MAX;
+        uint32_t LastPass = 0;
+        VkMemoryRequirements Requirements {};
+        uint32_t Block = UINT32_MAX;
+    };
+
+    struct Access {
+        ResourceId Resource;
+        Usage How;
+        Range Subresources;
+    };
+
+    struct Attachment {
+        ResourceId Resource;
+        VkRenderingAttachmentInfo Info;
+    };
+
+    struct Batch {
+        uint32_t FirstImage = 0;
+        uint32_t ImageCount = 0;
+        uint32_t FirstBuffer = 0;
+        uint32_t BufferCount = 0;
+    };
+
+    struct Pass {
+        std::string Name;
+        std::function<void(VkCommandBuffer)> Record;
+        std::vector<Access> Accesses;
+        std::vector<Attachment> ColorAttachments;
+        bool HasDepth = false;
+        Attachment Depth {};
+
+        // Compiled
+        Batch Barriers;
+        std::vector<VkRenderingAttachmentInfo> ColorInfos;
+        VkRenderingAttachmentInfo DepthInfo {};
+        VkRenderingInfo RenderingInfo {};
+    };
+
+    // Memory transients take turns in, in FirstPass order
+    struct MemoryBlock {
+        VmaAllocation Allocation = VK_NULL_HANDLE;
+        VkMemoryRequirements Requirements {};
+        std::vector<ResourceId> Occupants;
+    };
+
+    std::vector<Resource> Resources;
+    std::vector<Pass> Passes;
+    std::vector<MemoryBlock> Blocks;
+    VkExtent2D Extent { 0, 0 };
+
+    // Every batch's barriers back to back, the owners say which handle to patch in
+    std::vector<VkImageMemoryBarrier2> ImageBarriers;
+    std::vector<ResourceId> ImageBarrierOwners;
+    std::vector<VkBufferMemoryBarrier2> BufferBarriers;
+    std::vector<ResourceId> BufferBarrierOwners;
+    Batch FinalBarriers;
+
+    uint32_t SubresourceCount(const Resource& Res) const;
+    VkExtent2D ExtentOf(const Resource& Res) const;
+
+    InferusResult CreateTransients();
+    void DestroyTransients();
+
+    // Moves every subresource in the range to To, the barriers that takes are appended
+    void Transition(ResourceId Id, std::vector<SubresourceState>& State, const Range& Subresources,
+                    const UsageInfo& To, VkPipelineStageFlags2 DstStage);
+    void Record(VkCommandBuffer cmd, const Batch& Barriers);
+};
@@ -8,9 +8,77 @@ namespace RendererConfig {
     namespace BufferSystem {
         CONFIG uint32_t DATA_RESERVE_CAPACITY = 100;
         CONFIG uint32_t FREE_INDICES_RESERVE_CAPACITY = 10;
+        // Per frame in flight
+        CONFIG uint64_t FRAME_ARENA_SIZE = 1024 * 1024;
+        // Buffers up to SUBALLOCATION_MAX_SIZE are carved out of blocks shared by everything
+        // with the same memory type and usage, bigger ones get their own
+        CONFIG uint64_t POOL_BLOCK_SIZE = 16 * 1024 * 1024;
+        CONFIG uint64_t SUBALLOCATION_MAX_SIZE = 256 * 1024;
+        // Covers uniform and storage offsets on any device
+        CONFIG uint64_t SUBALLOCATION_ALIGNMENT = 256;
     };
     namespace ImageSystem {
         CONFIG uint32_t DATA_RESERVE_CAPACITY = 100;
         CONFIG uint32_t FREE_INDICES_RESERVE_CAPACITY = 10;
     };
+    namespace DescriptorHeap {
+        // Array sizes of the bindless set, within the update after bind limits of any
+        // desktop GPU
+        CONFIG uint32_t MAX_SAMPLED_IMAGES = 4096;
+        CONFIG uint32_t MAX_SAMPLERS = 64;
+        CONFIG uint32_t MAX_STORAGE_BUFFERS = 4096;
+        // The guaranteed minimum, every pass shares the one range
+        CONFIG uint32_t PUSH_CONSTANTS_SIZE = 128;
+    };
+    namespace PipelineCache {
+        // One file per device and driver, a driver update just starts a new one
+        CONFIG const char* DIRECTORY = "cache";
+    };
+    namespace PipelineManager {
+        // How often the shaders in use are checked for changes, a change is picked up once
+        // the file stopped changing for one interval so a half written .spv is never loaded
+        CONFIG uint32_t SHADER_POLL_INTERVAL_MS = 250;
+        CONFIG bool HOT_RELOAD = true;
+    };
+    namespace UploadSystem {
+        // Staging for everything streamed in, a full ring just pushes uploads to later frames
+        CONFIG uint64_t RING_SIZE = 4 * 1024 * 1024;
+        // Transfer command buffers taking turns
+        CONFIG uint32_t BATCH_COUNT = 4;
+    };
+    namespace TerrainRenderer {
+        // Chunks out of view are dropped on the CPU before the links are staged, so the cull
+        // dispatch only sees what's left. Off, every link is staged and terrain_cull.comp
+        // does all the culling. Uploads are held back for chunks out of view either way.
+        CONFIG bool CPU_CULLING = true;
+        // How chunks are drawn, picked here at startup and switchable from the UI.
+        // Grid: every chunk at full resolution. Cdlod: quadtrees of small patches, finer the
+        // closer they are. Tessellation: a few patches per chunk the GPU subdivides by their
+        // size on screen, falls back to Grid on devices without tessellation shaders.
+        enum class Mode : uint32_t { Grid, Cdlod, Tessellation };
+        CONFIG Mode MODE = Mode::Cdlod;
+        CONFIG uint32_t MODE_COUNT = static_cast<uint32_t>(Mode::Tessellation) + 1;
+
+        // Mode capture, every mode drawn in turn from the same spot with its GPU time,
+        // pipeline statistics and validation errors written to CAPTURE_PATH. The first
+        // CAPTURE_WARMUP_FRAMES of a mode aren't measured, they still read back the last one's.
+        CONFIG uint32_t CAPTURE_WARMUP_FRAMES = 16;
+        CONFIG uint32_t CAPTURE_FRAMES = 256;
+        CONFIG const char* CAPTURE_PATH = "terrain_modes.csv";
+        // Captures right away and closes once it's written, for scripted runs (lavapipe
+        // with validation on). Otherwise it's started from the UI.
+        CONFIG bool CAPTURE_ON_START = false;
+    };
+    namespace GpuProfiler {
+        // Timestamp pairs a frame can record, scopes past that go unmeasured
+        CONFIG uint32_t MAX_SCOPES = 16;
+        // Samples per pass the min/avg/p99 are over, a few seconds worth
+        CONFIG uint32_t HISTORY = 512;
+        CONFIG const char* CSV_PATH = "gpu_profile.csv";
+    };
+    namespace RenderGraph {
+        // Transients whose passes don't overlap share memory, off to rule it out when
+        // something looks corrupted
+        CONFIG bool ALIAS_TRANSIENTS = true;
+    };
 };
@@ -0,0 +1,398 @@
+#include "UploadSystem.hpp"
+
+#include <array>
+#include <deque>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/InferusRenderer/VulkanContext.hpp"
+#include "Engine/InferusRenderer/RendererConfig.hpp"
+#include "Engine/InferusRenderer/Buffer/BufferSystem.hpp"
+#include "Engine/InferusRenderer/Profiler/GpuProfiler.hpp"
+
+namespace UploadSystem {
+    using namespace RendererConfig::UploadSystem;
+
+    struct Batch {
+        VkCommandBuffer Cmd = VK_NULL_HANDLE;
+        // Upload timeline value it signals
+        uint64_t Value = 0;
+        // Ring position when it was submitted, everything before is free once it ran
+        uint64_t RingEnd = 0;
+    };
+
+    // Ring positions only ever grow, the offset is Position % RING_SIZE
+    BufferSystem::Id Ring;
+    VkBuffer RingBuffer = VK_NULL_HANDLE;
+    // Where the ring starts in RingBuffer, in case BufferSystem pooled it
+    VkDeviceSize RingBase = 0;
+    uint8_t* RingMapped = nullptr;
+    uint64_t RingWritten = 0;
+    uint64_t RingRetired = 0;
+
+    VkCommandPool Pool = VK_NULL_HANDLE;
+    std::array<Batch, BATCH_COUNT> Batches;
+    std::deque<uint32_t> InFlight;
+    Batch* Open = nullptr;
+    uint64_t OpenWaitFrame = 0;
+
+    VkSemaphore UploadTimeline = VK_NULL_HANDLE;
+    VkSemaphore FrameTimeline = VK_NULL_HANDLE;
+    uint64_t UploadValue = 0;
+    uint64_t FrameValue = 0;
+
+    bool SharedFamily = true;
+
+    // Open batch's releases, and the acquires waiting for the next frame
+    std::vector<VkImageMemoryBarrier2> ImageReleases;
+    std::vector<VkBufferMemoryBarrier2> BufferReleases;
+    std::vector<VkImageMemoryBarrier2> OpenImageAcquires;
+    std::vector<VkBufferMemoryBarrier2> OpenBufferAcquires;
+    VkPipelineStageFlags2 OpenAcquireStages = VK_PIPELINE_STAGE_2_NONE;
+
+    std::vector<VkImageMemoryBarrier2> ImageAcquires;
+    std::vector<VkBufferMemoryBarrier2> BufferAcquires;
+    VkPipelineStageFlags2 AcquireStages = VK_PIPELINE_STAGE_2_NONE;
+    // Upload value the acquires (or plain barriers) recorded into the current frame need
+    uint64_t AcquireValue = 0;
+    uint64_t FrameWaitValue = 0;
+    VkPipelineStageFlags2 FrameWaitStages = VK_PIPELINE_STAGE_2_NONE;
+
+    VkSemaphore CreateTimeline() {
+        VkSemaphoreTypeCreateInfo TypeInfo {};
+        TypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        TypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        TypeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo CreateInfo {};
+        CreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        CreateInfo.pNext = &TypeInfo;
+
+        VkSemaphore Semaphore = VK_NULL_HANDLE;
+        if (vkCreateSemaphore(VulkanContext::Device, &CreateInfo, nullptr, &Semaphore) != VK_SUCCESS) {
+            return VK_NULL_HANDLE;
+        }
+        return Semaphore;
+    }
+
+    InferusResult Create() {
+        VkDevice Device = VulkanContext::Device;
+        SharedFamily = VulkanContext::Transfer.Index == VulkanContext::Graphics.Index;
+
+        BufferSystem::CreateInfo RingCreateDesc = {
+            .size = RING_SIZE,
+            .memType = BufferSystem::CreateInfoMemoryType::STAGING_UPLOAD,
+            .usage = BufferSystem::CreateInfoUsage::STAGING
+        };
+        Ring = BufferSystem::add(RingCreateDesc);
+        RingBuffer = BufferSystem::get(Ring).buffer;
+        RingBase = BufferSystem::get(Ring).offset;
+        RingMapped = static_cast<uint8_t*>(BufferSystem::map(Ring));
+        RingWritten = 0;
+        RingRetired = 0;
+
+        VkCommandPoolCreateInfo PoolCreateInfo {};
+        PoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        PoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        PoolCreateInfo.queueFamilyIndex = VulkanContext::Transfer.Index;
+        if (vkCreateCommandPool(Device, &PoolCreateInfo, nullptr, &Pool) != VK_SUCCESS) {
+            spdlog::error("Upload command pool creation failed");
+            return InferusResult::FAIL;
+        }
+
+        std::array<VkCommandBuffer, BATCH_COUNT> CommandBuffers {};
+        VkCommandBufferAllocateInfo AllocInfo {};
+        AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        AllocInfo.commandPool = Pool;
+        AllocInfo.commandBufferCount = BATCH_COUNT;
+        if (vkAllocateCommandBuffers(Device, &AllocInfo, CommandBuffers.data()) != VK_SUCCESS) {
+            spdlog::error("Upload command buffers allocation failed");
+            return InferusResult::FAIL;
+        }
+        for (uint32_t i = 0; i < BATCH_COUNT; i++) {
+            Batches[i] = { .Cmd = CommandBuffers[i], .Value = 0, .RingEnd = 0 };
+        }
+
+        UploadTimeline = CreateTimeline();
+        FrameTimeline = CreateTimeline();
+        if (!UploadTimeline || !FrameTimeline) {
+            spdlog::error("Upload timeline semaphores creation failed");
+            return InferusResult::FAIL;
+        }
+        UploadValue = 0;
+        FrameValue = 0;
+
+        return InferusResult::SUCCESS;
+    }
+
+    void Destroy() {
+        VkDevice Device = VulkanContext::Device;
+
+        if (UploadTimeline) { vkDestroySemaphore(Device, UploadTimeline, nullptr); }
+        if (FrameTimeline) { vkDestroySemaphore(Device, FrameTimeline, nullptr); }
+        UploadTimeline = VK_NULL_HANDLE;
+        FrameTimeline = VK_NULL_HANDLE;
+
+        // Frees the command buffers with it
+        if (Pool) { vkDestroyCommandPool(Device, Pool, nullptr); }
+        Pool = VK_NULL_HANDLE;
+        Open = nullptr;
+        InFlight.clear();
+
+        if (RingMapped) {
+            BufferSystem::unmap(Ring);
+            BufferSystem::del(Ring);
+        }
+        RingMapped = nullptr;
+        RingBuffer = VK_NULL_HANDLE;
+    }
+
+    // Frees the ring space and command buffers of every batch the GPU is done with
+    uint64_t Retire() {
+        uint64_t Completed = 0;
+        vkGetSemaphoreCounterValue(VulkanContext::Device, UploadTimeline, &Completed);
+
+        while (!InFlight.empty() && Batches[InFlight.front()].Value <= Completed) {
+            RingRetired = Batches[InFlight.front()].RingEnd;
+            GpuProfiler::UploadRetired(InFlight.front());
+            InFlight.pop_front();
+        }
+        return Completed;
+    }
+
+    bool Begin() {
+        if (Open) {
+            return true;
+        }
+
+        uint64_t Completed = Retire();
+        for (Batch& Candidate : Batches) {
+            if (Candidate.Value > Completed) {
+                continue;
+            }
+
+            vkResetCommandBuffer(Candidate.Cmd, 0);
+            VkCommandBufferBeginInfo BeginInfo {};
+            BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(Candidate.Cmd, &BeginInfo);
+            GpuProfiler::BeginUpload(Candidate.Cmd, static_cast<uint32_t>(&Candidate - Batches.data()));
+
+            Open = &Candidate;
+            OpenWaitFrame = 0;
+            return true;
+        }
+        return false;
+    }
+
+    VkCommandBuffer Cmd() {
+        assert(Open && "No upload batch open");
+        return Open->Cmd;
+    }
+
+    bool Allocate(VkDeviceSize Size, VkDeviceSize Alignment, Staging& Out) {
+        assert(Open && "No upload batch open");
+        if (Size > RING_SIZE) {
+            spdlog::error("Upload of {} bytes doesn't fit the {} byte staging ring", Size, RING_SIZE);
+            return false;
+        }
+
+        Retire();
+
+        uint64_t Offset = RingWritten % RING_SIZE;
+        uint64_t Padding = (Alignment - Offset % Alignment) % Alignment;
+        // Never split across the end, skip to the start instead
+        if (Offset + Padding + Size > RING_SIZE) {
+            Padding = RING_SIZE - Offset;
+        }
+        if (RingWritten + Padding + Size - RingRetired > RING_SIZE) {
+            return false;
+        }
+
+        RingWritten += Padding;
+        Offset = RingWritten % RING_SIZE;
+        RingWritten += Size;
+
+        Out = {
+            .Mapped = RingMapped + Offset,
+            .Buffer = RingBuffer,
+            .Offset = RingBase + Offset,
+            .Size = Size
+        };
+        return true;
+    }
+
+    void WaitForFrame(uint64_t Value) {
+        OpenWaitFrame = std::max(OpenWaitFrame, Value);
+    }
+
+    void Handoff(VkImageMemoryBarrier2 Barrier) {
+        if (SharedFamily) {
+            ImageReleases.push_back(Barrier);
+            OpenAcquireStages |= Barrier.dstStageMask;
+            return;
+        }
+
+        Barrier.srcQueueFamilyIndex = VulkanContext::Transfer.Index;
+        Barrier.dstQueueFamilyIndex = VulkanContext::Graphics.Index;
+
+        VkImageMemoryBarrier2 Release = Barrier;
+        Release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        Release.dstAccessMask = VK_ACCESS_2_NONE;
+        ImageReleases.push_back(Release);
+
+        // Chained to the frame's semaphore wait, which waits at the acquire's stage
+        VkImageMemoryBarrier2 Acquire = Barrier;
+        Acquire.srcStageMask = Barrier.dstStageMask;
+        Acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        OpenImageAcquires.push_back(Acquire);
+        OpenAcquireStages |= Barrier.dstStageMask;
+    }
+
+    void Handoff(VkBufferMemoryBarrier2 Barrier) {
+        if (SharedFamily) {
+            BufferReleases.push_back(Barrier);
+            OpenAcquireStages |= Barrier.dstStageMask;
+            return;
+        }
+
+        Barrier.srcQueueFamilyIndex = VulkanContext::Transfer.Index;
+        Barrier.dstQueueFamilyIndex = VulkanContext::Graphics.Index;
+
+        VkBufferMemoryBarrier2 Release = Barrier;
+        Release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        Release.dstAccessMask = VK_ACCESS_2_NONE;
+        BufferReleases.push_back(Release);
+
+        VkBufferMemoryBarrier2 Acquire = Barrier;
+        Acquire.srcStageMask = Barrier.dstStageMask;
+        Acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        OpenBufferAcquires.push_back(Acquire);
+        OpenAcquireStages |= Barrier.dstStageMask;
+    }
+
+    void Submit() {
+        if (!Open) {
+            return;
+        }
+        VkCommandBuffer cmd = Open->Cmd;
+
+        // Every release of the batch in one go
+        if (!ImageReleases.empty() || !BufferReleases.empty()) {
+            VkDependencyInfo Dependency {};
+            Dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            Dependency.imageMemoryBarrierCount = static_cast<uint32_t>(ImageReleases.size());
+            Dependency.pImageMemoryBarriers = ImageReleases.data();
+            Dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(BufferReleases.size());
+            Dependency.pBufferMemoryBarriers = BufferReleases.data();
+            vkCmdPipelineBarrier2(cmd, &Dependency);
+        }
+        GpuProfiler::EndUpload(cmd, static_cast<uint32_t>(Open - Batches.data()));
+        vkEndCommandBuffer(cmd);
+
+        UploadValue++;
+
+        // A frame that already finished needs no wait at all
+        if (OpenWaitFrame > 0) {
+            uint64_t Completed = 0;
+            vkGetSemaphoreCounterValue(VulkanContext::Device, FrameTimeline, &Completed);
+            if (Completed >= OpenWaitFrame) {
+                OpenWaitFrame = 0;
+            }
+        }
+
+        VkSemaphoreSubmitInfo Wait {};
+        Wait.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        Wait.semaphore = FrameTimeline;
+        Wait.value = OpenWaitFrame;
+        Wait.stageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+
+        VkSemaphoreSubmitInfo Signal {};
+        Signal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        Signal.semaphore = UploadTimeline;
+        Signal.value = UploadValue;
+        Signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+        VkCommandBufferSubmitInfo CmdInfo {};
+        CmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        CmdInfo.commandBuffer = cmd;
+
+        VkSubmitInfo2 SubmitInfo {};
+        SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        SubmitInfo.waitSemaphoreInfoCount = OpenWaitFrame > 0 ? 1 : 0;
+        SubmitInfo.pWaitSemaphoreInfos = &Wait;
+        SubmitInfo.commandBufferInfoCount = 1;
+        SubmitInfo.pCommandBufferInfos = &CmdInfo;
+        SubmitInfo.signalSemaphoreInfoCount = 1;
+        SubmitInfo.pSignalSemaphoreInfos = &Signal;
+
+        if (vkQueueSubmit2(VulkanContext::Transfer.Queue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            spdlog::error("Upload submission failed");
+        }
+
+        Open->Value = UploadValue;
+        Open->RingEnd = RingWritten;
+        InFlight.push_back(static_cast<uint32_t>(Open - Batches.data()));
+        Open = nullptr;
+
+        ImageReleases.clear();
+        BufferReleases.clear();
+        ImageAcquires.insert(ImageAcquires.end(), OpenImageAcquires.begin(), OpenImageAcquires.end());
+        BufferAcquires.insert(BufferAcquires.end(), OpenBufferAcquires.begin(), OpenBufferAcquires.end());
+        OpenImageAcquires.clear();
+        OpenBufferAcquires.clear();
+        AcquireStages |= OpenAcquireStages;
+        OpenAcquireStages = VK_PIPELINE_STAGE_2_NONE;
+        AcquireValue = UploadValue;
+    }
+
+    void RecordAcquires(VkCommandBuffer cmd) {
+        if (!ImageAcquires.empty() || !BufferAcquires.empty()) {
+            VkDependencyInfo Dependency {};
+            Dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            Dependency.imageMemoryBarrierCount = static_cast<uint32_t>(ImageAcquires.size());
+            Dependency.pImageMemoryBarriers = ImageAcquires.data();
+            Dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(BufferAcquires.size());
+            Dependency.pBufferMemoryBarriers = BufferAcquires.data();
+            vkCmdPipelineBarrier2(cmd, &Dependency);
+        }
+        ImageAcquires.clear();
+        BufferAcquires.clear();
+
+        FrameWaitValue = AcquireValue;
+        FrameWaitStages = AcquireStages;
+        AcquireValue = 0;
+        AcquireStages = VK_PIPELINE_STAGE_2_NONE;
+    }
+
+    bool FrameWait(VkSemaphoreSubmitInfo& Out) {
+        if (FrameWaitValue == 0) {
+            return false;
+        }
+
+        Out = {};
+        Out.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        Out.semaphore = UploadTimeline;
+        Out.value = FrameWaitValue;
+        Out.stageMask = FrameWaitStages;
+        FrameWaitValue = 0;
+        return true;
+    }
+
+    VkSemaphoreSubmitInfo FrameSignal() {
+        VkSemaphoreSubmitInfo Signal {};
+        Signal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        Signal.semaphore = FrameTimeline;
+        Signal.value = ++FrameValue;
+        Signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        return Signal;
+    }
+
+    uint64_t RecordingFrame() {
+        return FrameValue + 1;
+    }
+};
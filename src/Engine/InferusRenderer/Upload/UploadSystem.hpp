@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Types.hpp"
+
+// Streaming uploads that never stall the CPU or drain a queue.
+//
+// Data is staged in one persistently mapped ring, copies go into recycled transfer
+// command buffers and every submit signals the upload timeline semaphore, the frame
+// consuming them waits on exactly that value on the GPU. Ownership of what was written
+// moves to the graphics family in batches, the releases close the upload and the
+// matching acquires open the next frame.
+//
+// Frames signal a timeline of their own, so an upload overwriting something a frame may
+// still be reading waits for that frame GPU side. When every command buffer or the whole
+// ring is still in flight Begin/Allocate just say no and the caller retries next frame.
+namespace UploadSystem {
+    struct Staging {
+        void* Mapped;
+        VkBuffer Buffer;
+        VkDeviceSize Offset;
+        VkDeviceSize Size;
+    };
+
+    InferusResult Create();
+    // Device idle
+    void Destroy();
+
+    // Opens a batch (or keeps the open one), false while every command buffer is in flight
+    bool Begin();
+    // Transfer queue command buffer of the open batch
+    VkCommandBuffer Cmd();
+    // Ring space that lives until the open batch ran, false when the ring is full
+    bool Allocate(VkDeviceSize Size, VkDeviceSize Alignment, Staging& Out);
+    // The open batch won't start before the frame signalling FrameValue is done, no wait
+    // at all when it already is
+    void WaitForFrame(uint64_t FrameValue);
+    // Something the batch wrote that frames read: src is the copy's side, dst the frame's,
+    // layouts as usual. Split into release/acquire when the queue families differ.
+    void Handoff(VkImageMemoryBarrier2 Barrier);
+    void Handoff(VkBufferMemoryBarrier2 Barrier);
+    void Submit();
+
+    // Frame side, main thread. The acquires for every batch submitted since the last frame,
+    // at the very start of cmd.
+    void RecordAcquires(VkCommandBuffer cmd);
+    // What the frame waits on for those acquires, false when there's nothing new
+    bool FrameWait(VkSemaphoreSubmitInfo& Out);
+    // What the frame signals, RecordingFrame() until then
+    VkSemaphoreSubmitInfo FrameSignal();
+
+    // Value the frame being recorded will signal
+    uint64_t RecordingFrame();
+};
@@ -44,6 +44,7 @@ namespace VulkanContext {
         switch (messageSeverity) {
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
                 spdlog::error(msg);
+                ValidationErrors++;
                 break;
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
                 spdlog::warn(msg);
@@ -357,6 +358,17 @@ namespace VulkanContext {
         VkPhysicalDeviceFeatures DeviceFeatures{};
         DeviceFeatures.samplerAnisotropy = VK_TRUE;
         DeviceFeatures.sampleRateShading = VK_TRUE;
+        // Culled chunks are drawn as their link's instance
+        DeviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+
+        // Only the terrain's tessellation mode and its statistics want these, it falls back
+        // to another mode without them
+        VkPhysicalDeviceFeatures SupportedFeatures;
+        vkGetPhysicalDeviceFeatures(PhysicalDevice, &SupportedFeatures);
+        TessellationSupported = SupportedFeatures.tessellationShader == VK_TRUE;
+        PipelineStatisticsSupported = SupportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        DeviceFeatures.tessellationShader = SupportedFeatures.tessellationShader;
+        DeviceFeatures.pipelineStatisticsQuery = SupportedFeatures.pipelineStatisticsQuery;
 
         VkPhysicalDeviceFeatures2 DeviceFeatures2{};
         DeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -370,9 +382,28 @@ namespace VulkanContext {
         DynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
         DynamicRenderingFeatures.dynamicRendering = VK_TRUE;
 
+        // Upload and frame timelines, the bindless heap (runtime sized arrays updated after
+        // bind with holes in them), the culled terrain's indirect count draws and the profiler's
+        // query resets from the host. All Vulkan 1.2,
+        // which can't be mixed with the 1.2 extension structs.
+        VkPhysicalDeviceVulkan12Features Vulkan12Features{};
+        Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        Vulkan12Features.timelineSemaphore = VK_TRUE;
+        Vulkan12Features.descriptorIndexing = VK_TRUE;
+        Vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        Vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        Vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        Vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        Vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        Vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        Vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        Vulkan12Features.drawIndirectCount = VK_TRUE;
+        Vulkan12Features.hostQueryReset = VK_TRUE;
+
         DeviceFeatures2.pNext= &Sync2Features;
         Sync2Features.pNext = &DynamicRenderingFeatures;
-        DynamicRenderingFeatures.pNext = nullptr;
+        DynamicRenderingFeatures.pNext = &Vulkan12Features;
+        Vulkan12Features.pNext = nullptr;
 
         VkDeviceCreateInfo DeviceCreateInfo{};
         DeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -30,6 +30,13 @@ namespace VulkanContext {
     inline QueueContext Compute;
     inline std::vector Queues = { &Graphics, &Present, &Transfer, &Compute };
 
+    // Optional features, enabled whenever the device has them
+    inline bool TessellationSupported = false;
+    inline bool PipelineStatisticsSupported = false;
+
+    // Errors the validation layers reported so far, debug builds only
+    inline uint32_t ValidationErrors = 0;
+
     InferusResult Create();
     void Destroy();
 
@@ -0,0 +1,107 @@
+#include "CdlodQuadtree.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace CdlodQuadtree {
+    namespace {
+        constexpr uint32_t TOP_LOD = TerrainConfig::Lod::LOD_COUNT - 1;
+        constexpr uint32_t PATCH_TRIANGLES = TerrainConfig::Lod::PATCH_QUADS * TerrainConfig::Lod::PATCH_QUADS * 2;
+
+        struct Context {
+            const FrustumCulling::Frustum& View;
+            glm::vec3 Camera;
+            const ChunkHeightmapLink& Link;
+            uint32_t LinkIndex;
+            Selection& Out;
+        };
+
+        // Same placement as terrain.vert: v runs along world x, u along world z
+        void NodeBox(const Context& Ctx, float U, float V, float Size, glm::vec3& Min, glm::vec3& Max) {
+            constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+            constexpr float HEIGHT_SCALE = TerrainConfig::Chunk::HEIGHT_SCALE;
+
+            Min = {
+                (Ctx.Link.WorldPos.x + V) * WORLD_SIZE,
+                Ctx.Link.MinHeight * HEIGHT_SCALE,
+                (Ctx.Link.WorldPos.y + U) * WORLD_SIZE
+            };
+            Max = { Min.x + Size * WORLD_SIZE, Ctx.Link.MaxHeight * HEIGHT_SCALE, Min.z + Size * WORLD_SIZE };
+        }
+
+        bool InRange(glm::vec3 Min, glm::vec3 Max, glm::vec3 Camera, float Range) {
+            glm::vec3 Closest = {
+                std::clamp(Camera.x, Min.x, Max.x),
+                std::clamp(Camera.y, Min.y, Max.y),
+                std::clamp(Camera.z, Min.z, Max.z)
+            };
+            glm::vec3 Delta = Closest - Camera;
+            return glm::dot(Delta, Delta) <= Range * Range;
+        }
+
+        void Add(Context& Ctx, uint32_t Part, uint32_t Lod, float U, float V) {
+            Ctx.Out.Parts[Part].push_back({ .Link = Ctx.LinkIndex, .Lod = Lod, .OriginU = U, .OriginV = V });
+            Ctx.Out.NodesPerLod[Lod]++;
+        }
+
+        // False when the node is out of its level's range, the parent covers it then
+        bool SelectNode(Context& Ctx, uint32_t Lod, float U, float V) {
+            float Size = std::ldexp(1.0f, int32_t(Lod) - int32_t(TOP_LOD));
+
+            glm::vec3 Min, Max;
+            NodeBox(Ctx, U, V, Size, Min, Max);
+
+            // The chunk itself is drawn however far away it is
+            if (Lod < TOP_LOD && !InRange(Min, Max, Ctx.Camera, Range(Lod))) {
+                return false;
+            }
+            if (!FrustumCulling::IsVisible(Ctx.View, Min, Max)) {
+                return true;
+            }
+            if (Lod == 0 || !InRange(Min, Max, Ctx.Camera, Range(Lod - 1))) {
+                Add(Ctx, 0, Lod, U, V);
+                return true;
+            }
+
+            float Half = Size * 0.5f;
+            for (uint32_t Quarter = 0; Quarter < 4; Quarter++) {
+                float ChildU = U + (Quarter % 2) * Half;
+                float ChildV = V + (Quarter / 2) * Half;
+                if (!SelectNode(Ctx, Lod - 1, ChildU, ChildV)) {
+                    Add(Ctx, 1 + Quarter, Lod, U, V);
+                }
+            }
+            return true;
+        }
+    }
+
+    void Selection::Clear() {
+        for (std::vector<TerrainLodNode>& Part : Parts) {
+            Part.clear();
+        }
+        std::fill(std::begin(NodesPerLod), std::end(NodesPerLod), 0);
+    }
+
+    uint32_t Selection::NodeCount() const {
+        uint32_t Count = 0;
+        for (const std::vector<TerrainLodNode>& Part : Parts) {
+            Count += static_cast<uint32_t>(Part.size());
+        }
+        return Count;
+    }
+
+    uint32_t Selection::TriangleCount() const {
+        uint32_t Quarters = NodeCount() - static_cast<uint32_t>(Parts[0].size());
+        return static_cast<uint32_t>(Parts[0].size()) * PATCH_TRIANGLES + Quarters * (PATCH_TRIANGLES / 4);
+    }
+
+    float Range(uint32_t Lod) {
+        return TerrainConfig::Lod::LEAF_RANGE * std::ldexp(1.0f, int32_t(Lod));
+    }
+
+    void SelectChunk(const FrustumCulling::Frustum& View, glm::vec3 Camera,
+                     const ChunkHeightmapLink& Link, uint32_t LinkIndex, Selection& Out) {
+        Context Ctx = { .View = View, .Camera = Camera, .Link = Link, .LinkIndex = LinkIndex, .Out = Out };
+        SelectNode(Ctx, TOP_LOD, 0.0f, 0.0f);
+    }
+};
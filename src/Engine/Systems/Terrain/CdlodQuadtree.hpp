@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Systems/Terrain/TerrainTypes.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/FrustumCulling.hpp"
+
+// CDLOD node selection (Strugar, "Continuous Distance-Dependent Level of Detail").
+//
+// Every chunk is the root of a quadtree LOD_COUNT levels deep. A node is split while the
+// next finer level's range (LEAF_RANGE doubling per level) still reaches it, children out
+// of that range leave their quarter to the parent, drawn with the matching quarter of the
+// patch. Ranges measure real distance to the camera, so terrain_cdlod.vert can morph a
+// node's odd vertices onto its parent's grid before the parent takes over: no popping,
+// and neighbours never differ by more than one level, so no cracks either.
+//
+// Nodes can't grow past a chunk, a node spanning chunks would need more than one heightmap
+// layer. The coarsest terrain is a single patch per chunk.
+namespace CdlodQuadtree {
+    // Whole patch, then quarters 0 to 3 as laid out by PlaneMeshIndicesGenerator::MakePatchIndices
+    constexpr uint32_t PART_COUNT = 5;
+
+    struct Selection {
+        std::vector<TerrainLodNode> Parts[PART_COUNT];
+        uint32_t NodesPerLod[TerrainConfig::Lod::LOD_COUNT] {};
+
+        void Clear();
+        uint32_t NodeCount() const;
+        uint32_t TriangleCount() const;
+    };
+
+    // Where a level's nodes give way to their parents
+    float Range(uint32_t Lod);
+
+    // Appends the nodes covering the chunk of Link (LinkIndex is what they'll point at) seen
+    // from Camera, nodes outside View are left out
+    void SelectChunk(const FrustumCulling::Frustum& View, glm::vec3 Camera,
+                     const ChunkHeightmapLink& Link, uint32_t LinkIndex, Selection& Out);
+};
@@ -0,0 +1,204 @@
+#include "ChunkPipeline.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "Utils/BoundedQueue.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Systems/Terrain/ChunkStore.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+
+namespace ChunkPipeline {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t TILE_POOL_SIZE = TerrainConfig::Streaming::TILE_POOL_SIZE;
+    constexpr uint32_t SLOT_COUNT = TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT;
+
+    struct Tile {
+        std::array<uint16_t, TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT> Texels;
+        uint16_t MinHeight;
+        uint16_t MaxHeight;
+    };
+
+    struct Job {
+        glm::ivec2 ChunkPos;
+        uint32_t Slot;
+        uint32_t Epoch;
+        uint32_t Tile;
+    };
+
+    struct QueuedRequest {
+        glm::ivec2 ChunkPos;
+        uint32_t Slot;
+    };
+
+    BatchedNoise::Settings Noise;
+
+    std::vector<Tile> Tiles;
+    std::array<std::atomic<uint32_t>, SLOT_COUNT> SlotEpochs;
+
+    // Tiles bound the work in flight, so none of these queues can overflow
+    BoundedQueue<uint32_t, TILE_POOL_SIZE> FreeTiles;
+    BoundedQueue<Job, TILE_POOL_SIZE> Completions;
+
+    // Owner thread only, requests waiting for a free tile
+    std::vector<QueuedRequest> QueuedRequests;
+
+    // Chunk jobs still running on the job system
+    JobSystem::Counter PendingJobs;
+
+    std::atomic<uint32_t> InFlight = 0;
+    std::atomic<uint64_t> Completed = 0;
+    std::atomic<uint64_t> Cancelled = 0;
+    std::atomic<uint64_t> Generated = 0;
+    std::atomic<uint64_t> GenerationNs = 0;
+
+    bool IsCurrent(const Job& Job) {
+        return SlotEpochs[Job.Slot].load(std::memory_order_relaxed) == Job.Epoch;
+    }
+
+    void ReleaseTile(uint32_t TileIndex) {
+        FreeTiles.TryPush(TileIndex);
+        InFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Noise and post-process stages, runs on whatever job system thread picked it up
+    void ProcessJob(const Job& Current) {
+        if (!IsCurrent(Current)) {
+            Cancelled.fetch_add(1, std::memory_order_relaxed);
+            ReleaseTile(Current.Tile);
+            return;
+        }
+
+        // Noise stage
+        Clock::time_point Begin = Clock::now();
+        Tile& Target = Tiles[Current.Tile];
+        TerrainGenerator::Generate(Noise, Current.ChunkPos, Target.Texels.data());
+
+        if (!IsCurrent(Current)) {
+            Cancelled.fetch_add(1, std::memory_order_relaxed);
+            ReleaseTile(Current.Tile);
+            return;
+        }
+
+        // Post-process stage, for now just the height bounds culling will want
+        TerrainGenerator::ChunkBounds Bounds = TerrainGenerator::Bounds(Target.Texels.data());
+        Target.MinHeight = Bounds.MinHeight;
+        Target.MaxHeight = Bounds.MaxHeight;
+
+        // Write back stage, the frame never waits on it and the OS flushes the pages
+        ChunkStore::Write(Current.ChunkPos, Target.Texels.data());
+
+        // What TerrainSystem budgets a generated chunk at
+        uint64_t Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - Begin).count();
+        GenerationNs.fetch_add(Elapsed, std::memory_order_relaxed);
+        Generated.fetch_add(1, std::memory_order_relaxed);
+
+        Completions.TryPush(Current);
+    }
+
+    // Hands queued requests to the workers while there are tiles for them
+    void Pump() {
+        size_t Submitted = 0;
+        for (; Submitted < QueuedRequests.size(); Submitted++) {
+            uint32_t TileIndex;
+            if (!FreeTiles.TryPop(TileIndex)) {
+                break;
+            }
+
+            const QueuedRequest& Request = QueuedRequests[Submitted];
+            Job NewJob = {
+                .ChunkPos = Request.ChunkPos,
+                .Slot = Request.Slot,
+                .Epoch = SlotEpochs[Request.Slot].load(std::memory_order_relaxed),
+                .Tile = TileIndex
+            };
+
+            InFlight.fetch_add(1, std::memory_order_relaxed);
+            JobSystem::Run([NewJob] { ProcessJob(NewJob); }, &PendingJobs);
+        }
+        QueuedRequests.erase(QueuedRequests.begin(), QueuedRequests.begin() + Submitted);
+    }
+
+    void Create(const BatchedNoise::Settings& NoiseSettings) {
+        Noise = NoiseSettings;
+
+        Tiles.resize(TILE_POOL_SIZE);
+        for (uint32_t i = 0; i < TILE_POOL_SIZE; i++) {
+            FreeTiles.TryPush(i);
+        }
+        for (std::atomic<uint32_t>& Epoch : SlotEpochs) {
+            Epoch.store(0, std::memory_order_relaxed);
+        }
+        QueuedRequests.clear();
+        QueuedRequests.reserve(SLOT_COUNT);
+    }
+
+    void Destroy() {
+        // Outdate every slot so jobs still running bail out at their next stage boundary
+        for (std::atomic<uint32_t>& Epoch : SlotEpochs) {
+            Epoch.fetch_add(1, std::memory_order_relaxed);
+        }
+        JobSystem::WaitFor(PendingJobs);
+
+        // Leave the queues empty for a future Create
+        Job Leftover;
+        while (Completions.TryPop(Leftover)) {}
+        uint32_t TileIndex;
+        while (FreeTiles.TryPop(TileIndex)) {}
+        QueuedRequests.clear();
+        InFlight.store(0, std::memory_order_relaxed);
+    }
+
+    void Cancel(uint32_t Slot) {
+        SlotEpochs[Slot].fetch_add(1, std::memory_order_relaxed);
+        std::erase_if(QueuedRequests, [Slot](const QueuedRequest& Request) { return Request.Slot == Slot; });
+    }
+
+    void Request(glm::ivec2 ChunkPos, uint32_t Slot) {
+        Cancel(Slot);
+        QueuedRequests.push_back({ .ChunkPos = ChunkPos, .Slot = Slot });
+        Pump();
+    }
+
+    uint32_t Drain(uint32_t MaxChunks, const std::function<void(const ChunkResult&)>& Consume) {
+        uint32_t Consumed = 0;
+        Job Finished;
+        while (Consumed < MaxChunks && Completions.TryPop(Finished)) {
+            if (IsCurrent(Finished)) {
+                const Tile& Source = Tiles[Finished.Tile];
+                Consume({
+                    .ChunkPos = Finished.ChunkPos,
+                    .Slot = Finished.Slot,
+                    .MinHeight = Source.MinHeight,
+                    .MaxHeight = Source.MaxHeight,
+                    .Texels = Source.Texels.data()
+                });
+                Completed.fetch_add(1, std::memory_order_relaxed);
+                Consumed++;
+            } else {
+                Cancelled.fetch_add(1, std::memory_order_relaxed);
+            }
+            ReleaseTile(Finished.Tile);
+        }
+
+        // Freed tiles can take queued requests right away
+        Pump();
+        return Consumed;
+    }
+
+    Stats GetStats() {
+        return {
+            .WorkerCount = JobSystem::GetWorkerCount(),
+            .Queued = static_cast<uint32_t>(QueuedRequests.size()),
+            .InFlight = InFlight.load(std::memory_order_relaxed),
+            .Completed = Completed.load(std::memory_order_relaxed),
+            .Cancelled = Cancelled.load(std::memory_order_relaxed),
+            .Generated = Generated.load(std::memory_order_relaxed),
+            .GenerationNs = GenerationNs.load(std::memory_order_relaxed)
+        };
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+// Off-thread chunk generation on top of the job system.
+//
+//  Request (owner) -> Noise (job) -> Post-process (job) -> Write back (job, ChunkStore)
+//      -> completion queue -> Drain (owner, packs into staging) -> Upload (renderer)
+//
+// Every heightmap slot has an epoch that Request bumps, a job whose epoch is no longer
+// current belongs to a chunk that left range (its slot got retargeted) and gets dropped
+// at the next stage boundary. The owner never waits for a job.
+//
+// Request, Cancel and Drain aren't thread safe among themselves, only one thread at a time
+// (TerrainSystem::Update's task) may drive the pipeline. JobSystem must outlive it.
+namespace ChunkPipeline {
+    struct ChunkResult {
+        glm::ivec2 ChunkPos;
+        uint32_t Slot;
+        uint16_t MinHeight;
+        uint16_t MaxHeight;
+        // RESOLUTION * RESOLUTION texels, only valid inside the Drain callback
+        const uint16_t* Texels;
+    };
+
+    struct Stats {
+        uint32_t WorkerCount;
+        uint32_t Queued;        // Waiting for a free tile on the owner side
+        uint32_t InFlight;      // Owned by jobs or sitting in the completion queue
+        uint64_t Completed;
+        uint64_t Cancelled;
+        // Chunks that went all the way through noise, post-process and write back, and the time it took
+        uint64_t Generated;
+        uint64_t GenerationNs;
+    };
+
+    void Create(const BatchedNoise::Settings& NoiseSettings);
+    void Destroy();
+
+    // Retargets Slot to ChunkPos, whatever was queued or in flight for Slot is cancelled
+    void Request(glm::ivec2 ChunkPos, uint32_t Slot);
+    void Cancel(uint32_t Slot);
+
+    // Non blocking. Hands at most MaxChunks finished, still wanted chunks to Consume and
+    // returns how many were handed.
+    uint32_t Drain(uint32_t MaxChunks, const std::function<void(const ChunkResult&)>& Consume);
+
+    Stats GetStats();
+};
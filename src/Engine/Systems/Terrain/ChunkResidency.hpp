@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+
+// Toroidal addressing of the resident chunk set.
+//
+// The resident set is the diamond |dx| + |dz| <= R around the player chunk, which holds
+// R^2 + (R+1)^2 = INSTANCE_COUNT chunks. That diamond tiles the plane over the lattice
+// spanned by (R+1, R) and (-R, R+1), whose determinant is also INSTANCE_COUNT, so
+//      Slot(x, z) = (x + K * z) mod INSTANCE_COUNT,   K = R * (R+1)^-1 mod INSTANCE_COUNT
+// maps every diamond, wherever it's centered, one to one onto [0, INSTANCE_COUNT).
+//
+// In practice: a chunk keeps its heightmap layer / link slot for as long as it stays in
+// range, and a chunk entering the range always lands exactly on the slot freed by the one
+// that just left. Streaming only touches the diamond's perimeter.
+namespace ChunkResidency {
+    constexpr int32_t RADIUS = TerrainConfig::ChunkToHeightmapLinking::DIAMOND_EXPLORATION_RADIUS;
+    constexpr int32_t SLOT_COUNT = TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT;
+
+    constexpr int32_t SLOT_Z_MULTIPLIER = []{
+        // (R+1) is coprime with R^2 + (R+1)^2, brute force its inverse
+        int32_t Inverse = 1;
+        while (((RADIUS + 1) * Inverse) % SLOT_COUNT != 1) {
+            Inverse++;
+        }
+        return (RADIUS * Inverse) % SLOT_COUNT;
+    }();
+
+    static_assert(((RADIUS + 1) + SLOT_Z_MULTIPLIER * RADIUS) % SLOT_COUNT == 0, "(R+1, R) must map to slot 0");
+    static_assert(((-RADIUS) + SLOT_Z_MULTIPLIER * (RADIUS + 1)) % SLOT_COUNT == 0, "(-R, R+1) must map to slot 0");
+
+    constexpr uint32_t Slot(glm::ivec2 ChunkPos) {
+        int64_t Linear = int64_t(ChunkPos.x) + int64_t(SLOT_Z_MULTIPLIER) * int64_t(ChunkPos.y);
+        int64_t Wrapped = Linear % SLOT_COUNT;
+        return static_cast<uint32_t>(Wrapped < 0 ? Wrapped + SLOT_COUNT : Wrapped);
+    }
+
+    constexpr bool InRange(glm::ivec2 Center, glm::ivec2 ChunkPos) {
+        int32_t dx = ChunkPos.x - Center.x;
+        int32_t dz = ChunkPos.y - Center.y;
+        return (dx < 0 ? -dx : dx) + (dz < 0 ? -dz : dz) <= RADIUS;
+    }
+
+    // Calls Fn(glm::ivec2 ChunkPos) for every chunk of the diamond around Center
+    template <typename Fn>
+    inline void ForEachInRange(glm::ivec2 Center, Fn&& Callback) {
+        for (int32_t dx = -RADIUS; dx <= RADIUS; dx++) {
+            int32_t Span = RADIUS - (dx < 0 ? -dx : dx);
+            for (int32_t dz = -Span; dz <= Span; dz++) {
+                Callback(glm::ivec2(Center.x + dx, Center.y + dz));
+            }
+        }
+    }
+};
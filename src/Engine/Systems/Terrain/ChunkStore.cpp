@@ -0,0 +1,347 @@
+#include "ChunkStore.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/Hash.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/HeightmapCodec.hpp"
+
+namespace ChunkStore {
+    constexpr int32_t REGION_SIZE = TerrainConfig::Store::REGION_SIZE;
+    constexpr uint32_t REGION_CHUNK_COUNT = REGION_SIZE * REGION_SIZE;
+    constexpr uint32_t RESOLUTION = TerrainConfig::Chunk::RESOLUTION;
+    constexpr uint32_t RAW_SIZE = TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE;
+    constexpr uint32_t MAX_RECORD_SIZE = HeightmapCodec::MaxEncodedSize(RESOLUTION, RESOLUTION);
+
+    // Cache line aligned records, the decoder reads whole vectors
+    constexpr uint32_t RECORD_ALIGN = 64;
+    constexpr uint32_t PAGE_SIZE = 4096;
+    constexpr uint32_t DATA_OFFSET =
+        (sizeof(RegionHeader) + REGION_CHUNK_COUNT * sizeof(RegionEntry) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    // Every chunk at its worst case, records never run out of room short of crashed writes
+    constexpr uint32_t DATA_CAPACITY = REGION_CHUNK_COUNT * ((MAX_RECORD_SIZE + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1));
+    constexpr size_t REGION_FILE_SIZE = size_t(DATA_OFFSET) + DATA_CAPACITY;
+
+    struct Region {
+        MappedFile File;
+        glm::ivec2 RegionPos;
+        uint64_t LastUse;
+
+        RegionHeader* Header() { return reinterpret_cast<RegionHeader*>(File.Data()); }
+        RegionEntry* Entries() { return reinterpret_cast<RegionEntry*>(File.Data() + sizeof(RegionHeader)); }
+        uint8_t* Record(uint32_t Offset) { return File.Data() + DATA_OFFSET + Offset; }
+    };
+
+    std::filesystem::path Directory;
+    uint64_t CurrentNoiseHash = 0;
+    bool Active = false;
+
+    // Regions are handed out as shared_ptr, evicting one never unmaps it under a reader
+    std::mutex RegionsMutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Region>> Regions;
+    uint64_t UseTick = 0;
+    // Regions opened at least once by this process, WRITING in them is ours from then on
+    std::unordered_set<uint64_t> Recovered;
+
+    std::atomic<uint64_t> Hits = 0;
+    std::atomic<uint64_t> Misses = 0;
+    std::atomic<uint64_t> Writes = 0;
+    std::atomic<uint64_t> RawBytes = 0;
+    std::atomic<uint64_t> StoredBytes = 0;
+
+    int32_t FloorDiv(int32_t Value, int32_t Divisor) {
+        return Value >= 0 ? Value / Divisor : (Value - Divisor + 1) / Divisor;
+    }
+
+    glm::ivec2 RegionOf(glm::ivec2 ChunkPos) {
+        return { FloorDiv(ChunkPos.x, REGION_SIZE), FloorDiv(ChunkPos.y, REGION_SIZE) };
+    }
+
+    uint32_t EntryIndex(glm::ivec2 ChunkPos, glm::ivec2 RegionPos) {
+        int32_t LocalX = ChunkPos.x - RegionPos.x * REGION_SIZE;
+        int32_t LocalZ = ChunkPos.y - RegionPos.y * REGION_SIZE;
+        return static_cast<uint32_t>(LocalZ * REGION_SIZE + LocalX);
+    }
+
+    uint64_t RegionKey(glm::ivec2 RegionPos) {
+        return (uint64_t(uint32_t(RegionPos.x)) << 32) | uint64_t(uint32_t(RegionPos.y));
+    }
+
+    std::filesystem::path RegionPath(glm::ivec2 RegionPos) {
+        return Directory / ("r." + std::to_string(RegionPos.x) + "." + std::to_string(RegionPos.y) + ".ifr");
+    }
+
+    bool IsHeaderValid(const RegionHeader& Header, glm::ivec2 RegionPos) {
+        return Header.Magic == REGION_MAGIC
+            && Header.Version == REGION_VERSION
+            && Header.NoiseHash == CurrentNoiseHash
+            && Header.Resolution == TerrainConfig::Chunk::RESOLUTION
+            && Header.RegionSize == REGION_SIZE
+            && Header.RegionX == RegionPos.x
+            && Header.RegionZ == RegionPos.y
+            && Header.DataOffset == DATA_OFFSET
+            && Header.RecordAlign == RECORD_ALIGN;
+    }
+
+    // RegionsMutex held
+    std::shared_ptr<Region> OpenRegion(glm::ivec2 RegionPos, bool CreateIfMissing) {
+        std::filesystem::path Path = RegionPath(RegionPos);
+
+        std::error_code Error;
+        bool Exists = std::filesystem::exists(Path, Error);
+        if (!Exists && !CreateIfMissing) {
+            return nullptr;
+        }
+
+        auto NewRegion = std::make_shared<Region>();
+        NewRegion->RegionPos = RegionPos;
+        if (!NewRegion->File.Open(Path.string(), REGION_FILE_SIZE)) {
+            spdlog::error("Couldn't map region file {}", Path.string());
+            return nullptr;
+        }
+
+        RegionHeader* Header = NewRegion->Header();
+        if (Exists && !IsHeaderValid(*Header, RegionPos)) {
+            if (!CreateIfMissing) {
+                return nullptr;
+            }
+
+            // Stale (other noise settings or layout), start over from an empty sparse file
+            spdlog::info("Discarding stale region file {}", Path.string());
+            NewRegion->File.Close();
+            std::filesystem::resize_file(Path, 0, Error);
+            if (Error || !NewRegion->File.Open(Path.string(), REGION_FILE_SIZE)) {
+                spdlog::error("Couldn't reset region file {}", Path.string());
+                return nullptr;
+            }
+            Header = NewRegion->Header();
+            Exists = false;
+        }
+
+        if (!Exists) {
+            *Header = {
+                .Magic = REGION_MAGIC,
+                .Version = REGION_VERSION,
+                .NoiseHash = CurrentNoiseHash,
+                .Resolution = TerrainConfig::Chunk::RESOLUTION,
+                .RegionSize = REGION_SIZE,
+                .RegionX = RegionPos.x,
+                .RegionZ = RegionPos.y,
+                .DataOffset = DATA_OFFSET,
+                .RecordAlign = RECORD_ALIGN,
+                .DataEnd = 0,
+                .Reserved = {}
+            };
+        } else if (!Recovered.contains(RegionKey(RegionPos))) {
+            // Writes cut short by a crash never reached PRESENT, let them be redone. Their
+            // records leak, there's no compaction. Only on the first open, reopened after
+            // an eviction a WRITING entry can be a Write still holding the old mapping.
+            RegionEntry* Entries = NewRegion->Entries();
+            for (uint32_t i = 0; i < REGION_CHUNK_COUNT; i++) {
+                uint32_t Expected = WRITING;
+                std::atomic_ref<uint32_t>(Entries[i].State).compare_exchange_strong(Expected, EMPTY, std::memory_order_relaxed);
+            }
+        }
+        Recovered.insert(RegionKey(RegionPos));
+
+        return NewRegion;
+    }
+
+    std::shared_ptr<Region> GetRegion(glm::ivec2 RegionPos, bool CreateIfMissing) {
+        std::lock_guard Lock(RegionsMutex);
+
+        uint64_t Key = RegionKey(RegionPos);
+        auto Found = Regions.find(Key);
+        if (Found != Regions.end()) {
+            Found->second->LastUse = ++UseTick;
+            return Found->second;
+        }
+
+        std::shared_ptr<Region> Opened = OpenRegion(RegionPos, CreateIfMissing);
+        if (!Opened) {
+            return nullptr;
+        }
+
+        if (Regions.size() >= TerrainConfig::Store::MAX_OPEN_REGIONS) {
+            auto Oldest = Regions.begin();
+            for (auto It = Regions.begin(); It != Regions.end(); ++It) {
+                if (It->second->LastUse < Oldest->second->LastUse) {
+                    Oldest = It;
+                }
+            }
+            Regions.erase(Oldest);
+        }
+
+        Opened->LastUse = ++UseTick;
+        Regions.emplace(Key, Opened);
+        return Opened;
+    }
+
+    uint64_t NoiseHash(const BatchedNoise::Settings& NoiseSettings) {
+        uint64_t Result = Hash::Fnv1a(NoiseSettings.Seed);
+        Result = Hash::Fnv1a(NoiseSettings.Frequency, Result);
+        Result = Hash::Fnv1a(NoiseSettings.Octaves, Result);
+        Result = Hash::Fnv1a(NoiseSettings.Lacunarity, Result);
+        Result = Hash::Fnv1a(NoiseSettings.Gain, Result);
+        // Only folded in past the default pair, so stores from before the kinds existed stay valid
+        if (NoiseSettings.Kind != BatchedNoise::NoiseKind::OpenSimplex2 || NoiseSettings.Fractal != BatchedNoise::FractalKind::FBm) {
+            Result = Hash::Fnv1a(static_cast<uint8_t>(NoiseSettings.Kind), Result);
+            Result = Hash::Fnv1a(static_cast<uint8_t>(NoiseSettings.Fractal), Result);
+        }
+        return Result;
+    }
+
+    InferusResult Create(const std::string& StoreDirectory, const BatchedNoise::Settings& NoiseSettings) {
+        Directory = StoreDirectory;
+        CurrentNoiseHash = NoiseHash(NoiseSettings);
+
+        std::error_code Error;
+        std::filesystem::create_directories(Directory, Error);
+        if (Error) {
+            spdlog::error("Chunk store directory {} couldn't be created: {}", StoreDirectory, Error.message());
+            Active = false;
+            return InferusResult::FAIL;
+        }
+
+        Active = true;
+        spdlog::debug("Chunk store at {} (noise hash {:016x})", StoreDirectory, CurrentNoiseHash);
+        return InferusResult::SUCCESS;
+    }
+
+    void Destroy() {
+        std::lock_guard Lock(RegionsMutex);
+        for (auto& [Key, OpenRegion] : Regions) {
+            OpenRegion->File.Flush();
+        }
+        Regions.clear();
+        Active = false;
+    }
+
+    bool IsActive() {
+        return Active;
+    }
+
+    bool Read(glm::ivec2 ChunkPos, uint16_t* Dst) {
+        if (!Active) {
+            return false;
+        }
+
+        glm::ivec2 RegionPos = RegionOf(ChunkPos);
+        std::shared_ptr<Region> Source = GetRegion(RegionPos, false);
+        if (!Source) {
+            Misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint32_t Index = EntryIndex(ChunkPos, RegionPos);
+        RegionEntry& Entry = Source->Entries()[Index];
+        std::atomic_ref<uint32_t> State(Entry.State);
+
+        if (State.load(std::memory_order_acquire) != PRESENT
+            || Entry.WorldX != ChunkPos.x || Entry.WorldZ != ChunkPos.y
+            || Entry.Size > MAX_RECORD_SIZE || Entry.Offset > DATA_CAPACITY - Entry.Size)
+        {
+            Misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Decoded straight into Dst, a corrupt record is just a miss and gets regenerated
+        if (!HeightmapCodec::Decode(Source->Record(Entry.Offset), Entry.Size, RESOLUTION, RESOLUTION, Dst)) {
+            spdlog::warn("Corrupt chunk record at {} {}", ChunkPos.x, ChunkPos.y);
+            Misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Write(glm::ivec2 ChunkPos, const uint16_t* Texels) {
+        if (!Active) {
+            return;
+        }
+
+        glm::ivec2 RegionPos = RegionOf(ChunkPos);
+        std::shared_ptr<Region> Target = GetRegion(RegionPos, true);
+        if (!Target) {
+            return;
+        }
+
+        uint32_t Index = EntryIndex(ChunkPos, RegionPos);
+        RegionEntry& Entry = Target->Entries()[Index];
+        std::atomic_ref<uint32_t> State(Entry.State);
+
+        if (State.load(std::memory_order_relaxed) != EMPTY) {
+            return;     // Don't bother encoding
+        }
+
+        uint8_t Encoded[MAX_RECORD_SIZE];
+        uint32_t Size = static_cast<uint32_t>(HeightmapCodec::Encode(Texels, RESOLUTION, RESOLUTION, Encoded));
+
+        uint32_t Expected = EMPTY;
+        if (!State.compare_exchange_strong(Expected, WRITING, std::memory_order_acquire)) {
+            return;     // Already stored or somebody else is on it
+        }
+
+        uint32_t AlignedSize = (Size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+        uint32_t Offset = std::atomic_ref<uint32_t>(Target->Header()->DataEnd).fetch_add(AlignedSize, std::memory_order_relaxed);
+        if (Offset > DATA_CAPACITY - AlignedSize) {
+            // Only reachable after enough crashed writes leaked their records
+            spdlog::warn("Region {} {} is full, chunk not stored", RegionPos.x, RegionPos.y);
+            State.store(EMPTY, std::memory_order_release);
+            return;
+        }
+
+        memcpy(Target->Record(Offset), Encoded, Size);
+        Entry.WorldX = ChunkPos.x;
+        Entry.WorldZ = ChunkPos.y;
+        Entry.Size = Size;
+        Entry.Offset = Offset;
+
+        State.store(PRESENT, std::memory_order_release);
+        Writes.fetch_add(1, std::memory_order_relaxed);
+        RawBytes.fetch_add(RAW_SIZE, std::memory_order_relaxed);
+        StoredBytes.fetch_add(Size, std::memory_order_relaxed);
+    }
+
+    bool Contains(glm::ivec2 ChunkPos) {
+        if (!Active) {
+            return false;
+        }
+
+        glm::ivec2 RegionPos = RegionOf(ChunkPos);
+        std::shared_ptr<Region> Source = GetRegion(RegionPos, false);
+        if (!Source) {
+            return false;
+        }
+
+        RegionEntry& Entry = Source->Entries()[EntryIndex(ChunkPos, RegionPos)];
+        return std::atomic_ref<uint32_t>(Entry.State).load(std::memory_order_acquire) == PRESENT
+            && Entry.WorldX == ChunkPos.x && Entry.WorldZ == ChunkPos.y;
+    }
+
+    Stats GetStats() {
+        uint32_t OpenRegions;
+        {
+            std::lock_guard Lock(RegionsMutex);
+            OpenRegions = static_cast<uint32_t>(Regions.size());
+        }
+
+        return {
+            .Hits = Hits.load(std::memory_order_relaxed),
+            .Misses = Misses.load(std::memory_order_relaxed),
+            .Writes = Writes.load(std::memory_order_relaxed),
+            .RawBytes = RawBytes.load(std::memory_order_relaxed),
+            .StoredBytes = StoredBytes.load(std::memory_order_relaxed),
+            .OpenRegions = OpenRegions
+        };
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Types.hpp"
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+// Persistent chunk cache, REGION_SIZE x REGION_SIZE chunks per memory mapped region file.
+//
+//  [RegionHeader][RegionEntry * REGION_CHUNK_COUNT][pad to page][record][record]...
+//
+// Chunks are stored HeightmapCodec encoded, each one a RECORD_ALIGN aligned record bump
+// allocated from RegionHeader::DataEnd, so they pack densely in the order they're written.
+// The mapping reserves room for every chunk at its worst case size, but the file is sparse
+// and only pages actually written take disk space. Reading decodes straight out of the
+// mapping (the first touch is a page fault, not a file read). Every header is stamped with
+// the hash of the noise settings, a region baked with other settings is discarded on open.
+//
+// Read and Write are thread safe. Entries go EMPTY -> WRITING -> PRESENT, readers only
+// trust PRESENT and the first writer of a chunk wins.
+namespace ChunkStore {
+    constexpr uint32_t REGION_MAGIC = 0x47524649; // "IFRG"
+    constexpr uint32_t REGION_VERSION = 2;
+
+    enum EntryState : uint32_t {
+        EMPTY = 0,
+        WRITING = 1,
+        PRESENT = 2
+    };
+
+    struct RegionHeader {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t NoiseHash;
+        uint32_t Resolution;
+        int32_t RegionSize;
+        int32_t RegionX;
+        int32_t RegionZ;
+        uint32_t DataOffset;
+        uint32_t RecordAlign;
+        uint32_t DataEnd;   // Next free byte past DataOffset, bumped atomically
+        uint32_t Reserved[5];
+    };
+    static_assert(sizeof(RegionHeader) == 64);
+
+    // Keyed by ChunkHeightmapLink::WorldPos
+    struct RegionEntry {
+        int32_t WorldX;
+        int32_t WorldZ;
+        uint32_t State;
+        uint32_t Size;      // Encoded bytes
+        uint32_t Offset;    // From DataOffset
+        uint32_t Reserved[3];
+    };
+    static_assert(sizeof(RegionEntry) == 32);
+
+    struct Stats {
+        uint64_t Hits;
+        uint64_t Misses;
+        uint64_t Writes;
+        // Chunk bytes before and after encoding, since startup
+        uint64_t RawBytes;
+        uint64_t StoredBytes;
+        uint32_t OpenRegions;
+    };
+
+    // Fails when Directory can't be created, the store stays inactive and Read always misses
+    InferusResult Create(const std::string& Directory, const BatchedNoise::Settings& NoiseSettings);
+    void Destroy();
+    bool IsActive();
+
+    // Copies the stored chunk into Dst (HEIGHTMAP_IMAGE_PIXEL_COUNT texels), false if missing
+    bool Read(glm::ivec2 ChunkPos, uint16_t* Dst);
+    // Stores the chunk unless it's already there
+    void Write(glm::ivec2 ChunkPos, const uint16_t* Texels);
+    // Whether Read would find the chunk, without decoding it
+    bool Contains(glm::ivec2 ChunkPos);
+
+    uint64_t NoiseHash(const BatchedNoise::Settings& NoiseSettings);
+
+    Stats GetStats();
+};
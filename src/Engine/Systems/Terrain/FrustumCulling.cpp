@@ -0,0 +1,212 @@
+#include "FrustumCulling.hpp"
+
+#include <bit>
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+namespace FrustumCulling {
+    namespace {
+        // The box corner each plane is tested against, picked once per call
+        struct PlaneCorner {
+            const float* X;
+            const float* Y;
+            const float* Z;
+            glm::vec4 Plane;
+        };
+
+        void PickCorners(const Frustum& View, const Boxes& Candidates, PlaneCorner* Out) {
+            for (uint32_t p = 0; p < 6; p++) {
+                const glm::vec4& Plane = View.Planes[p];
+                Out[p] = {
+                    .X = Plane.x >= 0.0f ? Candidates.MaxX.data() : Candidates.MinX.data(),
+                    .Y = Plane.y >= 0.0f ? Candidates.MaxY.data() : Candidates.MinY.data(),
+                    .Z = Plane.z >= 0.0f ? Candidates.MaxZ.data() : Candidates.MinZ.data(),
+                    .Plane = Plane
+                };
+            }
+        }
+
+        enum class Containment {
+            Outside,
+            Partial,
+            Inside
+        };
+
+        // Outside when the furthest corner is behind a plane, inside when even the nearest
+        // one is in front of all of them
+        Containment Classify(const Frustum& View, glm::vec3 Min, glm::vec3 Max) {
+            Containment Result = Containment::Inside;
+            for (const glm::vec4& Plane : View.Planes) {
+                glm::vec3 Furthest = {
+                    Plane.x >= 0.0f ? Max.x : Min.x,
+                    Plane.y >= 0.0f ? Max.y : Min.y,
+                    Plane.z >= 0.0f ? Max.z : Min.z
+                };
+                glm::vec3 Nearest = {
+                    Plane.x >= 0.0f ? Min.x : Max.x,
+                    Plane.y >= 0.0f ? Min.y : Max.y,
+                    Plane.z >= 0.0f ? Min.z : Max.z
+                };
+                if ((Plane.x * Furthest.x + Plane.y * Furthest.y) + (Plane.z * Furthest.z + Plane.w) < 0.0f) {
+                    return Containment::Outside;
+                }
+                if ((Plane.x * Nearest.x + Plane.y * Nearest.y) + (Plane.z * Nearest.z + Plane.w) < 0.0f) {
+                    Result = Containment::Partial;
+                }
+            }
+            return Result;
+        }
+
+        // One bit per lane of the batch starting at Base, set when the box is inside
+        uint32_t InsideMask(const PlaneCorner* Corners, uint32_t Base) {
+#if defined(__SSE2__)
+            const __m128 Zero = _mm_setzero_ps();
+            __m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (uint32_t p = 0; p < 6; p++) {
+                const PlaneCorner& Corner = Corners[p];
+                __m128 XY = _mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(Corner.Plane.x), _mm_loadu_ps(Corner.X + Base)),
+                    _mm_mul_ps(_mm_set1_ps(Corner.Plane.y), _mm_loadu_ps(Corner.Y + Base))
+                );
+                __m128 ZW = _mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(Corner.Plane.z), _mm_loadu_ps(Corner.Z + Base)),
+                    _mm_set1_ps(Corner.Plane.w)
+                );
+                Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(XY, ZW), Zero));
+            }
+            return static_cast<uint32_t>(_mm_movemask_ps(Inside));
+#elif defined(__ARM_NEON)
+            uint32x4_t Inside = vdupq_n_u32(~0u);
+            for (uint32_t p = 0; p < 6; p++) {
+                const PlaneCorner& Corner = Corners[p];
+                float32x4_t XY = vaddq_f32(
+                    vmulq_n_f32(vld1q_f32(Corner.X + Base), Corner.Plane.x),
+                    vmulq_n_f32(vld1q_f32(Corner.Y + Base), Corner.Plane.y)
+                );
+                float32x4_t ZW = vaddq_f32(
+                    vmulq_n_f32(vld1q_f32(Corner.Z + Base), Corner.Plane.z),
+                    vdupq_n_f32(Corner.Plane.w)
+                );
+                Inside = vandq_u32(Inside, vcgeq_f32(vaddq_f32(XY, ZW), vdupq_n_f32(0.0f)));
+            }
+            const uint32_t LANE_BITS[WIDTH] = { 1, 2, 4, 8 };
+            return vaddvq_u32(vandq_u32(Inside, vld1q_u32(LANE_BITS)));
+#else
+            uint32_t Mask = 0;
+            for (uint32_t Lane = 0; Lane < WIDTH; Lane++) {
+                bool Inside = true;
+                for (uint32_t p = 0; p < 6; p++) {
+                    const PlaneCorner& Corner = Corners[p];
+                    float XY = Corner.Plane.x * Corner.X[Base + Lane] + Corner.Plane.y * Corner.Y[Base + Lane];
+                    float ZW = Corner.Plane.z * Corner.Z[Base + Lane] + Corner.Plane.w;
+                    Inside &= XY + ZW >= 0.0f;
+                }
+                Mask |= static_cast<uint32_t>(Inside) << Lane;
+            }
+            return Mask;
+#endif
+        }
+    }
+
+    void Boxes::Resize(uint32_t NewCount) {
+        uint32_t Padded = (NewCount + WIDTH - 1) / WIDTH * WIDTH;
+        for (std::vector<float>* Axis : { &MinX, &MinY, &MinZ, &MaxX, &MaxY, &MaxZ }) {
+            Axis->assign(Padded, 0.0f);
+        }
+
+        // Empty groups, the first Set grows them around its box
+        uint32_t Groups = (NewCount + GROUP_SIZE - 1) / GROUP_SIZE;
+        GroupMin.assign(Groups, glm::vec3(std::numeric_limits<float>::max()));
+        GroupMax.assign(Groups, glm::vec3(std::numeric_limits<float>::lowest()));
+        Count = NewCount;
+    }
+
+    void Boxes::Set(uint32_t Index, glm::vec3 Min, glm::vec3 Max) {
+        MinX[Index] = Min.x;
+        MinY[Index] = Min.y;
+        MinZ[Index] = Min.z;
+        MaxX[Index] = Max.x;
+        MaxY[Index] = Max.y;
+        MaxZ[Index] = Max.z;
+
+        glm::vec3& Lower = GroupMin[Index / GROUP_SIZE];
+        glm::vec3& Upper = GroupMax[Index / GROUP_SIZE];
+        Lower = { std::min(Lower.x, Min.x), std::min(Lower.y, Min.y), std::min(Lower.z, Min.z) };
+        Upper = { std::max(Upper.x, Max.x), std::max(Upper.y, Max.y), std::max(Upper.z, Max.z) };
+    }
+
+    Frustum FromMatrix(const glm::mat4& ViewProjection) {
+        // glm is column major, m[column][row]
+        const glm::mat4& m = ViewProjection;
+        glm::vec4 Row0 = { m[0][0], m[1][0], m[2][0], m[3][0] };
+        glm::vec4 Row1 = { m[0][1], m[1][1], m[2][1], m[3][1] };
+        glm::vec4 Row2 = { m[0][2], m[1][2], m[2][2], m[3][2] };
+        glm::vec4 Row3 = { m[0][3], m[1][3], m[2][3], m[3][3] };
+
+        // Same planes as terrain_cull.comp, near is just the third row with 0..1 depth
+        return { .Planes = {
+            Row3 + Row0, Row3 - Row0,
+            Row3 + Row1, Row3 - Row1,
+            Row2,        Row3 - Row2
+        } };
+    }
+
+    bool IsVisible(const Frustum& View, glm::vec3 Min, glm::vec3 Max) {
+        return Classify(View, Min, Max) != Containment::Outside;
+    }
+
+    uint32_t Cull(const Frustum& View, const Boxes& Candidates, uint32_t* Visible) {
+        PlaneCorner Corners[6];
+        PickCorners(View, Candidates, Corners);
+
+        uint32_t Written = 0;
+        for (uint32_t Group = 0; Group * GROUP_SIZE < Candidates.Count; Group++) {
+            uint32_t GroupBegin = Group * GROUP_SIZE;
+            uint32_t GroupEnd = std::min(GroupBegin + GROUP_SIZE, Candidates.Count);
+
+            // Most of a big grid goes away, or is let in, a whole group at a time
+            Containment GroupContainment = Classify(View, Candidates.GroupMin[Group], Candidates.GroupMax[Group]);
+            if (GroupContainment == Containment::Outside) {
+                continue;
+            }
+            if (GroupContainment == Containment::Inside) {
+                for (uint32_t i = GroupBegin; i < GroupEnd; i++) {
+                    Visible[Written++] = i;
+                }
+                continue;
+            }
+
+            for (uint32_t Base = GroupBegin; Base < GroupEnd; Base += WIDTH) {
+                uint32_t Mask = InsideMask(Corners, Base);
+                // The last batch may run into padding
+                if (GroupEnd - Base < WIDTH) {
+                    Mask &= (1u << (GroupEnd - Base)) - 1;
+                }
+
+                while (Mask) {
+                    Visible[Written++] = Base + static_cast<uint32_t>(std::countr_zero(Mask));
+                    Mask &= Mask - 1;
+                }
+            }
+        }
+        return Written;
+    }
+
+    uint32_t CullScalar(const Frustum& View, const Boxes& Candidates, uint32_t* Visible) {
+        uint32_t Written = 0;
+        for (uint32_t i = 0; i < Candidates.Count; i++) {
+            glm::vec3 Min = { Candidates.MinX[i], Candidates.MinY[i], Candidates.MinZ[i] };
+            glm::vec3 Max = { Candidates.MaxX[i], Candidates.MaxY[i], Candidates.MaxZ[i] };
+            if (IsVisible(View, Min, Max)) {
+                Visible[Written++] = i;
+            }
+        }
+        return Written;
+    }
+};
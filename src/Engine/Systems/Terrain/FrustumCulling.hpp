@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Chunk boxes against the camera frustum, a batch of boxes per instruction.
+//
+// Boxes are kept as SoA so one plane is tested against WIDTH boxes at once, and since the
+// plane is the same for every lane the corner furthest along its normal is picked with a
+// scalar branch per plane instead of per box. SSE2 and NEON are baseline on the targets we
+// build for, no runtime dispatch needed unlike BatchedNoise.
+//
+// Every GROUP_SIZE consecutive boxes also share a bounding box, a group fully outside is
+// skipped and one fully inside is let in whole. Worth it as long as neighbouring indices
+// are neighbouring boxes, which holds for chunk grids.
+//
+// Conservative like any plane test: a box straddling two planes near a frustum corner may
+// pass, one fully outside any single plane never does.
+namespace FrustumCulling {
+    // Lanes per batch, Boxes pads its arrays to a multiple of it
+    constexpr uint32_t WIDTH = 4;
+    constexpr uint32_t GROUP_SIZE = 16 * WIDTH;
+
+    // ax + by + cz + d >= 0 is inside, not normalized, only the sign matters
+    struct Frustum {
+        glm::vec4 Planes[6];
+    };
+
+    struct Boxes {
+        std::vector<float> MinX, MinY, MinZ;
+        std::vector<float> MaxX, MaxY, MaxZ;
+        // Only ever grow, a box that shrank leaves its group a bit loose until the next Resize
+        std::vector<glm::vec3> GroupMin, GroupMax;
+        uint32_t Count = 0;
+
+        // Padding lanes are never reported
+        void Resize(uint32_t NewCount);
+        void Set(uint32_t Index, glm::vec3 Min, glm::vec3 Max);
+    };
+
+    // Clip space depth is 0..1 (GLM_FORCE_DEPTH_ZERO_TO_ONE)
+    Frustum FromMatrix(const glm::mat4& ViewProjection);
+
+    bool IsVisible(const Frustum& View, glm::vec3 Min, glm::vec3 Max);
+
+    // Indices of the boxes inside (or straddling) the frustum go to Visible in ascending
+    // order, room for Boxes.Count of them. Returns how many.
+    uint32_t Cull(const Frustum& View, const Boxes& Candidates, uint32_t* Visible);
+    // Same results one box at a time, the benchmark's baseline
+    uint32_t CullScalar(const Frustum& View, const Boxes& Candidates, uint32_t* Visible);
+};
@@ -0,0 +1,281 @@
+#include "HeightmapCodec.hpp"
+
+#include <bit>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define HEIGHTMAP_CODEC_SSE2 1
+#endif
+
+// Tiles are stored little endian, as laid out in memory on every platform we build for
+namespace HeightmapCodec {
+    constexpr uint32_t LANE_VALUES = BLOCK_SIZE / LANES;
+    constexpr uint32_t MAX_WIDTH = 16;
+    // Bytes per packed word row, one uint16 for each lane
+    constexpr uint32_t WORD_ROW_SIZE = LANES * sizeof(uint16_t);
+
+    uint16_t Zigzag(uint16_t Residual) {
+        return static_cast<uint16_t>((Residual << 1) ^ (static_cast<int16_t>(Residual) >> 15));
+    }
+
+    uint16_t Unzigzag(uint16_t Value) {
+        return static_cast<uint16_t>((Value >> 1) ^ (0u - (Value & 1u)));
+    }
+
+    bool FitsBlocks(uint32_t Width, uint32_t Height) {
+        uint32_t Count = Width * Height;
+        return Count > 0 && Width % LANES == 0 && Count % BLOCK_SIZE == 0;
+    }
+
+    size_t PackedSize(const uint8_t* Widths, uint32_t BlockCount) {
+        size_t Size = 1 + BlockCount;
+        for (uint32_t i = 0; i < BlockCount; i++) {
+            Size += size_t(Widths[i]) * WORD_ROW_SIZE;
+        }
+        return Size;
+    }
+
+    size_t Encode(const uint16_t* Texels, uint32_t Width, uint32_t Height, uint8_t* Out) {
+        const size_t RawSize = size_t(Width) * Height * sizeof(uint16_t);
+        auto StoreRaw = [&] {
+            Out[0] = RAW;
+            memcpy(Out + 1, Texels, RawSize);
+            return 1 + RawSize;
+        };
+
+        if (!FitsBlocks(Width, Height)) {
+            return StoreRaw();
+        }
+
+        const uint32_t Count = Width * Height;
+        const uint32_t BlockCount = Count / BLOCK_SIZE;
+
+        // Encoding runs on pipeline workers, one scratch per thread
+        thread_local std::vector<uint16_t> Residuals;
+        Residuals.resize(Count);
+
+        for (uint32_t y = 0; y < Height; y++) {
+            const uint16_t* Row = Texels + size_t(y) * Width;
+            const uint16_t* Up = y > 0 ? Row - Width : nullptr;
+
+            for (uint32_t x = 0; x < Width; x++) {
+                uint16_t W = x > 0 ? Row[x - 1] : 0;
+                uint16_t N = Up ? Up[x] : 0;
+                uint16_t NW = Up && x > 0 ? Up[x - 1] : 0;
+                uint16_t Prediction = static_cast<uint16_t>(W + N - NW);
+                Residuals[size_t(y) * Width + x] = Zigzag(static_cast<uint16_t>(Row[x] - Prediction));
+            }
+        }
+
+        uint8_t* Widths = Out + 1;
+        for (uint32_t Block = 0; Block < BlockCount; Block++) {
+            uint16_t Bits = 0;
+            for (uint32_t i = 0; i < BLOCK_SIZE; i++) {
+                Bits |= Residuals[Block * BLOCK_SIZE + i];
+            }
+            Widths[Block] = static_cast<uint8_t>(std::bit_width(Bits));
+        }
+
+        if (PackedSize(Widths, BlockCount) >= 1 + RawSize) {
+            return StoreRaw();
+        }
+
+        Out[0] = PACKED;
+        uint8_t* Cursor = Widths + BlockCount;
+        for (uint32_t Block = 0; Block < BlockCount; Block++) {
+            const uint32_t BlockWidth = Widths[Block];
+            const uint16_t* Values = Residuals.data() + Block * BLOCK_SIZE;
+
+            // Words[k][l] is the k-th packed word of lane l
+            uint16_t Words[MAX_WIDTH][LANES] = {};
+            for (uint32_t j = 0; j < LANE_VALUES; j++) {
+                uint32_t Bit = j * BlockWidth;
+                uint32_t Word = Bit / 16;
+                uint32_t Shift = Bit % 16;
+
+                for (uint32_t Lane = 0; Lane < LANES && BlockWidth > 0; Lane++) {
+                    uint32_t Value = Values[j * LANES + Lane];
+                    Words[Word][Lane] |= static_cast<uint16_t>(Value << Shift);
+                    if (Shift + BlockWidth > 16) {
+                        Words[Word + 1][Lane] |= static_cast<uint16_t>(Value >> (16 - Shift));
+                    }
+                }
+            }
+
+            memcpy(Cursor, Words, BlockWidth * WORD_ROW_SIZE);
+            Cursor += BlockWidth * WORD_ROW_SIZE;
+        }
+
+        return static_cast<size_t>(Cursor - Out);
+    }
+
+#ifdef HEIGHTMAP_CODEC_SSE2
+    struct RowCursor {
+        uint16_t* Out;
+        uint32_t Width;
+        uint32_t Pos = 0;
+        uint32_t Column = 0;
+        __m128i Carry = _mm_setzero_si128();
+    };
+
+    // Value J of every lane, shifts and masks all fold to immediates
+    template <uint32_t BlockWidth, uint32_t J>
+    __m128i UnpackVector(const uint8_t* Words) {
+        if constexpr (BlockWidth == 0) {
+            return _mm_setzero_si128();
+        } else {
+            constexpr uint32_t Bit = J * BlockWidth;
+            constexpr uint32_t Word = Bit / 16;
+            constexpr uint32_t Shift = Bit % 16;
+
+            const __m128i* Row = reinterpret_cast<const __m128i*>(Words + Word * WORD_ROW_SIZE);
+            __m128i Value = _mm_srli_epi16(_mm_loadu_si128(Row), Shift);
+            if constexpr (Shift + BlockWidth > 16) {
+                Value = _mm_or_si128(Value, _mm_slli_epi16(_mm_loadu_si128(Row + 1), 16 - Shift));
+            }
+            if constexpr (BlockWidth < 16) {
+                Value = _mm_and_si128(Value, _mm_set1_epi16(static_cast<int16_t>((1u << BlockWidth) - 1)));
+            }
+            return Value;
+        }
+    }
+
+    // 8 zigzagged residuals to texels, T = N + running sum of residuals along the row
+    inline void Rebuild(__m128i Zigzagged, RowCursor& Cursor) {
+        const __m128i Zero = _mm_setzero_si128();
+        if (Cursor.Column == 0) {
+            Cursor.Carry = Zero;
+        }
+
+        __m128i Sign = _mm_sub_epi16(Zero, _mm_and_si128(Zigzagged, _mm_set1_epi16(1)));
+        __m128i Sum = _mm_xor_si128(_mm_srli_epi16(Zigzagged, 1), Sign);
+
+        Sum = _mm_add_epi16(Sum, _mm_slli_si128(Sum, 2));
+        Sum = _mm_add_epi16(Sum, _mm_slli_si128(Sum, 4));
+        Sum = _mm_add_epi16(Sum, _mm_slli_si128(Sum, 8));
+        Sum = _mm_add_epi16(Sum, Cursor.Carry);
+        // Broadcast lane 7 for the next 8 texels
+        Cursor.Carry = _mm_shuffle_epi32(_mm_shufflehi_epi16(Sum, 0xFF), 0xFF);
+
+        uint16_t* Dst = Cursor.Out + Cursor.Pos;
+        __m128i Up = Cursor.Pos >= Cursor.Width
+            ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(Dst - Cursor.Width))
+            : Zero;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Dst), _mm_add_epi16(Up, Sum));
+
+        Cursor.Pos += LANES;
+        Cursor.Column += LANES;
+        if (Cursor.Column == Cursor.Width) {
+            Cursor.Column = 0;
+        }
+    }
+
+    // Cursor goes by value, vector stores may alias anything and would pin it to memory
+    template <uint32_t BlockWidth>
+    RowCursor DecodeBlock(const uint8_t* Words, RowCursor Cursor) {
+        [&]<uint32_t... J>(std::integer_sequence<uint32_t, J...>) {
+            (Rebuild(UnpackVector<BlockWidth, J>(Words), Cursor), ...);
+        }(std::make_integer_sequence<uint32_t, LANE_VALUES>{});
+        return Cursor;
+    }
+
+    using BlockDecoder = RowCursor (*)(const uint8_t*, RowCursor);
+
+    constexpr auto BLOCK_DECODERS = []<uint32_t... B>(std::integer_sequence<uint32_t, B...>) {
+        return std::array<BlockDecoder, sizeof...(B)>{ &DecodeBlock<B>... };
+    }(std::make_integer_sequence<uint32_t, MAX_WIDTH + 1>{});
+
+    void DecodeBlocks(const uint8_t* Widths, uint32_t BlockCount, uint32_t Width, uint16_t* Out) {
+        RowCursor Cursor = { .Out = Out, .Width = Width };
+        const uint8_t* Words = Widths + BlockCount;
+        for (uint32_t Block = 0; Block < BlockCount; Block++) {
+            Cursor = BLOCK_DECODERS[Widths[Block]](Words, Cursor);
+            Words += Widths[Block] * WORD_ROW_SIZE;
+        }
+    }
+
+    const char* DecoderName() {
+        return "SSE2";
+    }
+#else
+    void DecodeBlocks(const uint8_t* Widths, uint32_t BlockCount, uint32_t Width, uint16_t* Out) {
+        const uint8_t* Words = Widths + BlockCount;
+        for (uint32_t Block = 0; Block < BlockCount; Block++) {
+            const uint32_t BlockWidth = Widths[Block];
+            const uint32_t Mask = (1u << BlockWidth) - 1;
+            uint16_t* Values = Out + Block * BLOCK_SIZE;
+
+            uint16_t Packed[MAX_WIDTH + 1][LANES] = {};
+            memcpy(Packed, Words, BlockWidth * WORD_ROW_SIZE);
+            Words += BlockWidth * WORD_ROW_SIZE;
+
+            for (uint32_t j = 0; j < LANE_VALUES; j++) {
+                uint32_t Bit = j * BlockWidth;
+                uint32_t Word = Bit / 16;
+                uint32_t Shift = Bit % 16;
+
+                for (uint32_t Lane = 0; Lane < LANES; Lane++) {
+                    uint32_t Value = (Packed[Word][Lane] | (uint32_t(Packed[Word + 1][Lane]) << 16)) >> Shift;
+                    Values[j * LANES + Lane] = static_cast<uint16_t>(Value & Mask);
+                }
+            }
+        }
+
+        const uint32_t Height = BlockCount * BLOCK_SIZE / Width;
+        for (uint32_t y = 0; y < Height; y++) {
+            uint16_t* Row = Out + size_t(y) * Width;
+            const uint16_t* Up = y > 0 ? Row - Width : nullptr;
+            uint16_t Sum = 0;
+            for (uint32_t x = 0; x < Width; x++) {
+                Sum = static_cast<uint16_t>(Sum + Unzigzag(Row[x]));
+                Row[x] = static_cast<uint16_t>((Up ? Up[x] : 0) + Sum);
+            }
+        }
+    }
+
+    const char* DecoderName() {
+        return "Scalar";
+    }
+#endif
+
+    bool Decode(const uint8_t* Data, size_t Size, uint32_t Width, uint32_t Height, uint16_t* Out) {
+        const size_t RawSize = size_t(Width) * Height * sizeof(uint16_t);
+        if (Size < 1) {
+            return false;
+        }
+
+        if (Data[0] == RAW) {
+            if (Size != 1 + RawSize) {
+                return false;
+            }
+            memcpy(Out, Data + 1, RawSize);
+            return true;
+        }
+
+        if (Data[0] != PACKED || !FitsBlocks(Width, Height)) {
+            return false;
+        }
+
+        const uint32_t BlockCount = Width * Height / BLOCK_SIZE;
+        if (Size < 1 + size_t(BlockCount)) {
+            return false;
+        }
+
+        const uint8_t* Widths = Data + 1;
+        for (uint32_t i = 0; i < BlockCount; i++) {
+            if (Widths[i] > MAX_WIDTH) {
+                return false;
+            }
+        }
+        if (PackedSize(Widths, BlockCount) != Size) {
+            return false;
+        }
+
+        DecodeBlocks(Widths, BlockCount, Width, Out);
+        return true;
+    }
+};
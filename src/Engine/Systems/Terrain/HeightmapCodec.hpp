@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Lossless codec for R16 heightmap tiles.
+//
+//  - Every texel is predicted from its neighbours as W + N - NW (plane fit, wrapping mod 2^16)
+//  - Residuals are zigzagged so small negatives stay small
+//  - Blocks of BLOCK_SIZE residuals are bit packed with the width of the widest one
+//
+// Packing is vertical (the SIMD-BP128 layout): a block is 8 lanes of 16 values, lane l
+// holds residuals l, l + 8, l + 16... so one unpack step yields 8 consecutive texels. Since
+// T - N = (T - N)[left] + residual, a row is rebuilt from the row above with a prefix sum,
+// there's no serial dependency on the left texel to stall the decoder.
+//
+// Encoded tile: [Mode][block widths, one byte each][packed blocks]. Tiles that wouldn't get
+// smaller (or don't fit the block layout) are stored RAW.
+namespace HeightmapCodec {
+    constexpr uint32_t LANES = 8;
+    constexpr uint32_t BLOCK_SIZE = LANES * 16;
+
+    enum Mode : uint8_t {
+        RAW = 0,
+        PACKED = 1
+    };
+
+    // Worst case, what Out of Encode has to hold
+    constexpr size_t MaxEncodedSize(uint32_t Width, uint32_t Height) {
+        return 1 + size_t(Width) * Height * sizeof(uint16_t);
+    }
+
+    // Returns the encoded size in bytes
+    size_t Encode(const uint16_t* Texels, uint32_t Width, uint32_t Height, uint8_t* Out);
+    // False if Data isn't a valid Width x Height tile, Out is garbage then
+    bool Decode(const uint8_t* Data, size_t Size, uint32_t Width, uint32_t Height, uint16_t* Out);
+
+    const char* DecoderName();
+};
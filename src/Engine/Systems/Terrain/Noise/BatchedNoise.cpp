@@ -0,0 +1,113 @@
+#include "BatchedNoise.hpp"
+
+#include <atomic>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoiseKernel.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define BATCHED_NOISE_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define BATCHED_NOISE_NEON
+#endif
+
+namespace BatchedNoise {
+    namespace Simd {
+#ifdef BATCHED_NOISE_X86
+        GenerateGridFn Select_SSE41(NoiseKind Kind, FractalKind Fractal);
+        GenerateGridFn Select_AVX2(NoiseKind Kind, FractalKind Fractal);
+#endif
+#ifdef BATCHED_NOISE_NEON
+        GenerateGridFn Select_NEON(NoiseKind Kind, FractalKind Fractal);
+#endif
+    };
+
+    // Resolved on first use, chunk workers may race on it but they'd all store the same value
+    std::atomic<Isa> ActiveIsa { Isa::_ISA_COUNT_ };
+
+    // A table lookup, cheap next to even the smallest grid
+    GenerateGridFn GetGenerateFn(Isa Target, const Settings& NoiseSettings) {
+        switch (Target) {
+#ifdef BATCHED_NOISE_X86
+            case Isa::AVX2:  return Simd::Select_AVX2(NoiseSettings.Kind, NoiseSettings.Fractal);
+            case Isa::SSE41: return Simd::Select_SSE41(NoiseSettings.Kind, NoiseSettings.Fractal);
+#endif
+#ifdef BATCHED_NOISE_NEON
+            case Isa::NEON:  return Simd::Select_NEON(NoiseSettings.Kind, NoiseSettings.Fractal);
+#endif
+            default:         return Kernel::Select<Kernel::ScalarLanes>(NoiseSettings.Kind, NoiseSettings.Fractal);
+        }
+    }
+
+    bool IsSupported(Isa Target) {
+        switch (Target) {
+            case Isa::Scalar:
+                return true;
+#ifdef BATCHED_NOISE_X86
+            case Isa::SSE41:
+                return __builtin_cpu_supports("sse4.1");
+            case Isa::AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+#ifdef BATCHED_NOISE_NEON
+            case Isa::NEON:
+                return true;
+#endif
+            default:
+                return false;
+        }
+    }
+
+    Isa DetectIsa() {
+        for (Isa Candidate : { Isa::AVX2, Isa::NEON, Isa::SSE41 }) {
+            if (IsSupported(Candidate)) {
+                return Candidate;
+            }
+        }
+        return Isa::Scalar;
+    }
+
+    Isa GetIsa() {
+        Isa Current = ActiveIsa.load(std::memory_order_relaxed);
+        if (Current == Isa::_ISA_COUNT_) {
+            Current = DetectIsa();
+            ActiveIsa.store(Current, std::memory_order_relaxed);
+        }
+        return Current;
+    }
+
+    void ForceIsa(Isa Target) {
+        ActiveIsa.store(IsSupported(Target) ? Target : Isa::Scalar, std::memory_order_relaxed);
+    }
+
+    const char* IsaName(Isa Target) {
+        switch (Target) {
+            case Isa::Scalar: return "Scalar";
+            case Isa::SSE41:  return "SSE4.1";
+            case Isa::AVX2:   return "AVX2";
+            case Isa::NEON:   return "NEON";
+            default:          return "Unknown";
+        }
+    }
+
+    const char* NoiseKindName(NoiseKind Kind) {
+        switch (Kind) {
+            case NoiseKind::OpenSimplex2: return "OpenSimplex2";
+            case NoiseKind::Perlin:       return "Perlin";
+            case NoiseKind::Value:        return "Value";
+            default:                      return "Unknown";
+        }
+    }
+
+    const char* FractalKindName(FractalKind Fractal) {
+        switch (Fractal) {
+            case FractalKind::None:   return "None";
+            case FractalKind::FBm:    return "FBm";
+            case FractalKind::Ridged: return "Ridged";
+            default:                  return "Unknown";
+        }
+    }
+
+    void GenerateGrid(const Settings& NoiseSettings, const GridDesc& Grid, uint16_t* Out) {
+        GetGenerateFn(GetIsa(), NoiseSettings)(NoiseSettings, Grid, Out);
+    }
+};
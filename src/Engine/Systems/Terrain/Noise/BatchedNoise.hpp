@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+// Grid batched FastNoiseLite::GetNoise (2D), evaluated a whole row of lanes at a time and
+// remapped straight into R16 heights on the same pass.
+//
+// FastNoiseLite branches on noise type and fractal type for every sample, here the pair
+// are template parameters instead and octaves loop at runtime. Each Isa has a table of
+// kernels for every combination, GenerateGrid picks one per call from the settings, so
+// the editor can change them freely.
+//
+// Tolerance: the lane math mirrors FastNoiseLite operation by operation (same constants,
+// same evaluation order, no FMA), so every Isa is bit-exact with GetNoise and with the
+// scalar fallback. That needs FMA contraction off for the kernels, the fallback and the
+// translation unit evaluating GetNoise alike, xmake builds all of them -ffp-contract=off.
+// The only deviation is on quantization: the original static_cast is undefined outside
+// [0, 65535], here values are saturated to that range instead.
+namespace BatchedNoise {
+    enum class Isa {
+        Scalar,
+        SSE41,
+        AVX2,
+        NEON,
+
+        _ISA_COUNT_
+    };
+
+    enum class NoiseKind : uint8_t {
+        OpenSimplex2,
+        Perlin,
+        Value,
+
+        _NOISE_KIND_COUNT_
+    };
+
+    enum class FractalKind : uint8_t {
+        None,
+        FBm,
+        Ridged,
+
+        _FRACTAL_KIND_COUNT_
+    };
+
+    // Mirrors the FastNoiseLite setters (no weighted strength)
+    struct Settings {
+        int32_t Seed = 1337;
+        float Frequency = 0.01f;
+        int32_t Octaves = 3;
+        float Lacunarity = 2.0f;
+        float Gain = 0.5f;
+        NoiseKind Kind = NoiseKind::OpenSimplex2;
+        FractalKind Fractal = FractalKind::FBm;
+    };
+
+    // Row r samples X = OriginX + r, column c samples Z = OriginZ + c.
+    // Output is row-major: Out[r * Cols + c].
+    struct GridDesc {
+        int32_t OriginX = 0;
+        int32_t OriginZ = 0;
+        uint32_t Rows = 0;
+        uint32_t Cols = 0;
+    };
+
+    using GenerateGridFn = void(*)(const Settings&, const GridDesc&, uint16_t*);
+
+    void GenerateGrid(const Settings& NoiseSettings, const GridDesc& Grid, uint16_t* Out);
+
+    // Picks the widest Isa the running CPU supports, called lazily by GenerateGrid
+    Isa DetectIsa();
+    Isa GetIsa();
+    // Mostly for benchmarking, falls back to Scalar if the Isa isn't available
+    void ForceIsa(Isa Target);
+
+    bool IsSupported(Isa Target);
+    const char* IsaName(Isa Target);
+    const char* NoiseKindName(NoiseKind Kind);
+    const char* FractalKindName(FractalKind Fractal);
+};
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+// Lane generic kernel, each Simd/*.cpp instantiates Generate with its own lane traits
+// compiled under the matching target flags. A lane traits type provides:
+//   F / I / M          float, int32 and comparison mask vectors
+//   WIDTH              lane count
+//   SetF, SetI, Iota, ToFloat, FastFloor, Add, Sub, Mul, AddI, MulI, Xor, And, Sra15,
+//   Shl19, Greater, Select, SelectI, Gather, StoreU16
+//
+// Everything here is written to follow FastNoiseLite's Single* and GenFractal* functions
+// expression by expression, don't "simplify" the arithmetic or the results drift.
+//
+// Noise kind and fractal kind are template parameters, so every entry of the dispatch
+// table (see Select) runs without any per sample branching.
+//
+// Internal linkage on purpose, the Simd/*.cpp files are built with different target flags
+// and must not end up sharing a ScalarLanes instantiation through the linker.
+namespace BatchedNoise::Kernel {
+namespace {
+    // FastNoiseLite::Lookup<float>::Gradients2D, it's private over there
+    alignas(64) inline constexpr float GRADIENTS_2D[256] = {
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+        -0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f,
+    };
+
+    constexpr int32_t PRIME_X = 501125321;
+    constexpr int32_t PRIME_Y = 1136930381;
+    constexpr int32_t HASH_MULTIPLIER = 0x27d4eb2d;
+    constexpr int32_t GRADIENT_MASK = 127 << 1;
+
+    constexpr float SQRT3 = 1.7320508075688772935274463415059f;
+    constexpr float F2 = 0.5f * (SQRT3 - 1);
+    constexpr float G2 = (3 - SQRT3) / 6;
+    constexpr float C_FROM_T = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2));
+    constexpr float C_FROM_A = (float)(-2 * (1 - 2 * G2) * (1 - 2 * G2));
+    constexpr float SIMPLEX_SCALE = 99.83685446303647f;
+    constexpr float PERLIN_SCALE = 1.4247691104677813f;
+    constexpr float VALUE_SCALE = 1 / 2147483648.0f;
+
+    // FastNoiseLite::CalculateFractalBounding
+    inline float FractalBounding(const Settings& NoiseSettings) {
+        float Gain = NoiseSettings.Gain < 0 ? -NoiseSettings.Gain : NoiseSettings.Gain;
+        float Amp = Gain;
+        float AmpFractal = 1.0f;
+        for (int32_t i = 1; i < NoiseSettings.Octaves; i++) {
+            AmpFractal += Amp;
+            Amp *= Gain;
+        }
+        return 1 / AmpFractal;
+    }
+
+    template <typename L>
+    inline typename L::F Lerp(typename L::F a, typename L::F b, typename L::F t) {
+        return L::Add(a, L::Mul(t, L::Sub(b, a)));
+    }
+
+    template <typename L>
+    inline typename L::F InterpQuintic(typename L::F t) {
+        typename L::F Inner = L::Add(L::Mul(t, L::Sub(L::Mul(t, L::SetF(6.0f)), L::SetF(15.0f))), L::SetF(10.0f));
+        return L::Mul(L::Mul(L::Mul(t, t), t), Inner);
+    }
+
+    template <typename L>
+    inline typename L::F InterpHermite(typename L::F t) {
+        return L::Mul(L::Mul(t, t), L::Sub(L::SetF(3.0f), L::Mul(L::SetF(2.0f), t)));
+    }
+
+    template <typename L>
+    inline typename L::F Abs(typename L::F f) {
+        return L::Select(L::Greater(L::SetF(0.0f), f), L::Sub(L::SetF(0.0f), f), f);
+    }
+
+    template <typename L>
+    inline typename L::I HashCoord(typename L::I Seed, typename L::I XPrimed, typename L::I YPrimed) {
+        return L::MulI(L::Xor(L::Xor(Seed, XPrimed), YPrimed), L::SetI(HASH_MULTIPLIER));
+    }
+
+    template <typename L>
+    inline typename L::F GradCoord(typename L::I Seed, typename L::I XPrimed, typename L::I YPrimed, typename L::F Xd, typename L::F Yd) {
+        typename L::I Hash = HashCoord<L>(Seed, XPrimed, YPrimed);
+        Hash = L::Xor(Hash, L::Sra15(Hash));
+        Hash = L::And(Hash, L::SetI(GRADIENT_MASK));
+
+        typename L::F Xg = L::Gather(GRADIENTS_2D, Hash);
+        typename L::F Yg = L::Gather(GRADIENTS_2D + 1, Hash);
+
+        return L::Add(L::Mul(Xd, Xg), L::Mul(Yd, Yg));
+    }
+
+    template <typename L>
+    inline typename L::F ValCoord(typename L::I Seed, typename L::I XPrimed, typename L::I YPrimed) {
+        typename L::I Hash = HashCoord<L>(Seed, XPrimed, YPrimed);
+        Hash = L::MulI(Hash, Hash);
+        Hash = L::Xor(Hash, L::Shl19(Hash));
+        return L::Mul(L::ToFloat(Hash), L::SetF(VALUE_SCALE));
+    }
+
+    // Falloff^4 * gradient, zeroed where the falloff is not positive
+    template <typename L>
+    inline typename L::F Contribution(typename L::F Falloff, typename L::F Gradient) {
+        typename L::F Falloff2 = L::Mul(Falloff, Falloff);
+        typename L::F Value = L::Mul(L::Mul(Falloff2, Falloff2), Gradient);
+        return L::Select(L::Greater(Falloff, L::SetF(0.0f)), Value, L::SetF(0.0f));
+    }
+
+    // FastNoiseLite::SingleSimplex, coordinates already skewed
+    template <typename L>
+    inline typename L::F SingleSimplex(typename L::I Seed, typename L::F X, typename L::F Y) {
+        using F = typename L::F;
+        using I = typename L::I;
+
+        I i = L::FastFloor(X);
+        I j = L::FastFloor(Y);
+        F Xi = L::Sub(X, L::ToFloat(i));
+        F Yi = L::Sub(Y, L::ToFloat(j));
+
+        F t = L::Mul(L::Add(Xi, Yi), L::SetF(G2));
+        F X0 = L::Sub(Xi, t);
+        F Y0 = L::Sub(Yi, t);
+
+        i = L::MulI(i, L::SetI(PRIME_X));
+        j = L::MulI(j, L::SetI(PRIME_Y));
+
+        F a = L::Sub(L::Sub(L::SetF(0.5f), L::Mul(X0, X0)), L::Mul(Y0, Y0));
+        F n0 = Contribution<L>(a, GradCoord<L>(Seed, i, j, X0, Y0));
+
+        F c = L::Add(L::Mul(L::SetF(C_FROM_T), t), L::Add(L::SetF(C_FROM_A), a));
+        F X2 = L::Add(X0, L::SetF(2 * G2 - 1));
+        F Y2 = L::Add(Y0, L::SetF(2 * G2 - 1));
+        F n2 = Contribution<L>(c, GradCoord<L>(Seed, L::AddI(i, L::SetI(PRIME_X)), L::AddI(j, L::SetI(PRIME_Y)), X2, Y2));
+
+        // Both branches of the middle vertex, picked per lane
+        typename L::M UpperTriangle = L::Greater(Y0, X0);
+        F X1 = L::Select(UpperTriangle, L::Add(X0, L::SetF(G2)), L::Add(X0, L::SetF(G2 - 1)));
+        F Y1 = L::Select(UpperTriangle, L::Add(Y0, L::SetF(G2 - 1)), L::Add(Y0, L::SetF(G2)));
+        I I1 = L::SelectI(UpperTriangle, i, L::AddI(i, L::SetI(PRIME_X)));
+        I J1 = L::SelectI(UpperTriangle, L::AddI(j, L::SetI(PRIME_Y)), j);
+        F b = L::Sub(L::Sub(L::SetF(0.5f), L::Mul(X1, X1)), L::Mul(Y1, Y1));
+        F n1 = Contribution<L>(b, GradCoord<L>(Seed, I1, J1, X1, Y1));
+
+        return L::Mul(L::Add(L::Add(n0, n1), n2), L::SetF(SIMPLEX_SCALE));
+    }
+
+    // FastNoiseLite::SinglePerlin
+    template <typename L>
+    inline typename L::F SinglePerlin(typename L::I Seed, typename L::F X, typename L::F Y) {
+        using F = typename L::F;
+        using I = typename L::I;
+
+        I X0 = L::FastFloor(X);
+        I Y0 = L::FastFloor(Y);
+
+        F Xd0 = L::Sub(X, L::ToFloat(X0));
+        F Yd0 = L::Sub(Y, L::ToFloat(Y0));
+        F Xd1 = L::Sub(Xd0, L::SetF(1.0f));
+        F Yd1 = L::Sub(Yd0, L::SetF(1.0f));
+
+        F Xs = InterpQuintic<L>(Xd0);
+        F Ys = InterpQuintic<L>(Yd0);
+
+        X0 = L::MulI(X0, L::SetI(PRIME_X));
+        Y0 = L::MulI(Y0, L::SetI(PRIME_Y));
+        I X1 = L::AddI(X0, L::SetI(PRIME_X));
+        I Y1 = L::AddI(Y0, L::SetI(PRIME_Y));
+
+        F Xf0 = Lerp<L>(GradCoord<L>(Seed, X0, Y0, Xd0, Yd0), GradCoord<L>(Seed, X1, Y0, Xd1, Yd0), Xs);
+        F Xf1 = Lerp<L>(GradCoord<L>(Seed, X0, Y1, Xd0, Yd1), GradCoord<L>(Seed, X1, Y1, Xd1, Yd1), Xs);
+
+        return L::Mul(Lerp<L>(Xf0, Xf1, Ys), L::SetF(PERLIN_SCALE));
+    }
+
+    // FastNoiseLite::SingleValue
+    template <typename L>
+    inline typename L::F SingleValue(typename L::I Seed, typename L::F X, typename L::F Y) {
+        using F = typename L::F;
+        using I = typename L::I;
+
+        I X0 = L::FastFloor(X);
+        I Y0 = L::FastFloor(Y);
+
+        F Xs = InterpHermite<L>(L::Sub(X, L::ToFloat(X0)));
+        F Ys = InterpHermite<L>(L::Sub(Y, L::ToFloat(Y0)));
+
+        X0 = L::MulI(X0, L::SetI(PRIME_X));
+        Y0 = L::MulI(Y0, L::SetI(PRIME_Y));
+        I X1 = L::AddI(X0, L::SetI(PRIME_X));
+        I Y1 = L::AddI(Y0, L::SetI(PRIME_Y));
+
+        F Xf0 = Lerp<L>(ValCoord<L>(Seed, X0, Y0), ValCoord<L>(Seed, X1, Y0), Xs);
+        F Xf1 = Lerp<L>(ValCoord<L>(Seed, X0, Y1), ValCoord<L>(Seed, X1, Y1), Xs);
+
+        return Lerp<L>(Xf0, Xf1, Ys);
+    }
+
+    // FastNoiseLite::GenNoiseSingle, resolved at compile time
+    template <typename L, NoiseKind N>
+    inline typename L::F SingleNoise(typename L::I Seed, typename L::F X, typename L::F Y) {
+        if constexpr (N == NoiseKind::Perlin) {
+            return SinglePerlin<L>(Seed, X, Y);
+        } else if constexpr (N == NoiseKind::Value) {
+            return SingleValue<L>(Seed, X, Y);
+        } else {
+            return SingleSimplex<L>(Seed, X, Y);
+        }
+    }
+
+    // What one octave adds to the sum, weighted strength is always 0 so the amplitude only follows the gain
+    template <typename L, FractalKind Fr>
+    inline typename L::F FractalTerm(typename L::F Noise, float Amp) {
+        if constexpr (Fr == FractalKind::Ridged) {
+            // FastNoiseLite::GenFractalRidged
+            typename L::F Ridge = L::Add(L::Mul(Abs<L>(Noise), L::SetF(-2.0f)), L::SetF(1.0f));
+            return L::Mul(Ridge, L::SetF(Amp));
+        } else {
+            // FastNoiseLite::GenFractalFBm
+            return L::Mul(Noise, L::SetF(Amp));
+        }
+    }
+
+    // Columns [ColBegin, ColEnd) of every row, ColEnd - ColBegin must be a multiple of L::WIDTH.
+    template <typename L, NoiseKind N, FractalKind Fr>
+    inline void GenerateColumns(const Settings& NoiseSettings, const GridDesc& Grid, uint16_t* Out, uint32_t ColBegin, uint32_t ColEnd) {
+        using F = typename L::F;
+        using I = typename L::I;
+
+        const float Bounding = FractalBounding(NoiseSettings);
+
+        for (uint32_t r = 0; r < Grid.Rows; r++) {
+            const float GlobalX = static_cast<float>(Grid.OriginX + static_cast<int32_t>(r));
+            uint16_t* RowOut = Out + (r * Grid.Cols);
+
+            for (uint32_t c = ColBegin; c < ColEnd; c += L::WIDTH) {
+                I GlobalZi = L::AddI(L::SetI(Grid.OriginZ + static_cast<int32_t>(c)), L::Iota());
+
+                // FastNoiseLite::TransformNoiseCoordinate, only OpenSimplex2 is skewed
+                F X = L::Mul(L::SetF(GlobalX), L::SetF(NoiseSettings.Frequency));
+                F Y = L::Mul(L::ToFloat(GlobalZi), L::SetF(NoiseSettings.Frequency));
+                if constexpr (N == NoiseKind::OpenSimplex2) {
+                    F t = L::Mul(L::Add(X, Y), L::SetF(F2));
+                    X = L::Add(X, t);
+                    Y = L::Add(Y, t);
+                }
+
+                F Sum;
+                if constexpr (Fr == FractalKind::None) {
+                    Sum = SingleNoise<L, N>(L::SetI(NoiseSettings.Seed), X, Y);
+                } else {
+                    int32_t Seed = NoiseSettings.Seed;
+                    float Amp = Bounding;
+                    Sum = L::SetF(0.0f);
+
+                    for (int32_t o = 0; o < NoiseSettings.Octaves; o++) {
+                        F Noise = SingleNoise<L, N>(L::SetI(Seed++), X, Y);
+                        Sum = L::Add(Sum, FractalTerm<L, Fr>(Noise, Amp));
+
+                        X = L::Mul(X, L::SetF(NoiseSettings.Lacunarity));
+                        Y = L::Mul(Y, L::SetF(NoiseSettings.Lacunarity));
+                        Amp *= NoiseSettings.Gain;
+                    }
+                }
+
+                // Remap [-1, 1] -> [0, 65535] and quantize
+                F Remapped = L::Mul(L::Mul(L::Add(Sum, L::SetF(1.0f)), L::SetF(0.5f)), L::SetF(65535.0f));
+                L::StoreU16(RowOut + c, Remapped);
+            }
+        }
+    }
+
+    struct ScalarLanes {
+        using F = float;
+        using I = int32_t;
+        using M = bool;
+        static constexpr uint32_t WIDTH = 1;
+
+        static F SetF(float v) { return v; }
+        static I SetI(int32_t v) { return v; }
+        static I Iota() { return 0; }
+        static F ToFloat(I v) { return static_cast<float>(v); }
+        static I FastFloor(F f) { return f >= 0 ? (int32_t)f : (int32_t)f - 1; }
+
+        static F Add(F a, F b) { return a + b; }
+        static F Sub(F a, F b) { return a - b; }
+        static F Mul(F a, F b) { return a * b; }
+
+        // Wrapping integer math, FastNoiseLite relies on signed overflow here
+        static I AddI(I a, I b) { return static_cast<I>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+        static I MulI(I a, I b) { return static_cast<I>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)); }
+        static I Xor(I a, I b) { return a ^ b; }
+        static I And(I a, I b) { return a & b; }
+        static I Sra15(I a) { return a >> 15; }
+        static I Shl19(I a) { return static_cast<I>(static_cast<uint32_t>(a) << 19); }
+
+        static M Greater(F a, F b) { return a > b; }
+        static F Select(M m, F a, F b) { return m ? a : b; }
+        static I SelectI(M m, I a, I b) { return m ? a : b; }
+        static F Gather(const float* Base, I Index) { return Base[Index]; }
+
+        static void StoreU16(uint16_t* Dst, F v) {
+            *Dst = static_cast<uint16_t>(std::clamp(v, 0.0f, 65535.0f));
+        }
+    };
+
+    // Vector body plus scalar tail for the columns that don't fill a whole vector
+    template <typename L, NoiseKind N, FractalKind Fr>
+    void Generate(const Settings& NoiseSettings, const GridDesc& Grid, uint16_t* Out) {
+        const uint32_t VectorCols = Grid.Cols - (Grid.Cols % L::WIDTH);
+        GenerateColumns<L, N, Fr>(NoiseSettings, Grid, Out, 0, VectorCols);
+        if (VectorCols != Grid.Cols) {
+            GenerateColumns<ScalarLanes, N, Fr>(NoiseSettings, Grid, Out, VectorCols, Grid.Cols);
+        }
+    }
+
+    template <typename L, NoiseKind N>
+    GenerateGridFn SelectFractal(FractalKind Fractal) {
+        switch (Fractal) {
+            case FractalKind::FBm:    return Generate<L, N, FractalKind::FBm>;
+            case FractalKind::Ridged: return Generate<L, N, FractalKind::Ridged>;
+            default:                  return Generate<L, N, FractalKind::None>;
+        }
+    }
+
+    // Runtime dispatch table
+    template <typename L>
+    GenerateGridFn Select(NoiseKind Kind, FractalKind Fractal) {
+        switch (Kind) {
+            case NoiseKind::Perlin: return SelectFractal<L, NoiseKind::Perlin>(Fractal);
+            case NoiseKind::Value:  return SelectFractal<L, NoiseKind::Value>(Fractal);
+            default:                return SelectFractal<L, NoiseKind::OpenSimplex2>(Fractal);
+        }
+    }
+};
+};
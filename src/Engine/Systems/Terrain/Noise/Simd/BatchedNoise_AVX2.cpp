@@ -0,0 +1,53 @@
+// Built with -mavx2, only ever called after BatchedNoise::IsSupported(Isa::AVX2)
+
+#include <immintrin.h>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoiseKernel.hpp"
+
+namespace BatchedNoise::Simd {
+    struct AVX2Lanes {
+        using F = __m256;
+        using I = __m256i;
+        using M = __m256;
+        static constexpr uint32_t WIDTH = 8;
+
+        static F SetF(float v) { return _mm256_set1_ps(v); }
+        static I SetI(int32_t v) { return _mm256_set1_epi32(v); }
+        static I Iota() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+        static F ToFloat(I v) { return _mm256_cvtepi32_ps(v); }
+        static I FastFloor(F f) {
+            // Truncate, then take one off the negative lanes (mask is -1), same as FastNoiseLite
+            I Truncated = _mm256_cvttps_epi32(f);
+            I Negative = _mm256_castps_si256(_mm256_cmp_ps(f, _mm256_setzero_ps(), _CMP_LT_OQ));
+            return _mm256_add_epi32(Truncated, Negative);
+        }
+
+        static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+
+        static I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+        static I MulI(I a, I b) { return _mm256_mullo_epi32(a, b); }
+        static I Xor(I a, I b) { return _mm256_xor_si256(a, b); }
+        static I And(I a, I b) { return _mm256_and_si256(a, b); }
+        static I Sra15(I a) { return _mm256_srai_epi32(a, 15); }
+        static I Shl19(I a) { return _mm256_slli_epi32(a, 19); }
+
+        static M Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static F Select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+        static I SelectI(M m, I a, I b) {
+            return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m));
+        }
+        static F Gather(const float* Base, I Index) { return _mm256_i32gather_ps(Base, Index, 4); }
+
+        static void StoreU16(uint16_t* Dst, F v) {
+            I Quantized = _mm256_cvttps_epi32(v);
+            __m128i Packed = _mm_packus_epi32(_mm256_castsi256_si128(Quantized), _mm256_extracti128_si256(Quantized, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(Dst), Packed);
+        }
+    };
+
+    GenerateGridFn Select_AVX2(NoiseKind Kind, FractalKind Fractal) {
+        return Kernel::Select<AVX2Lanes>(Kind, Fractal);
+    }
+};
@@ -0,0 +1,59 @@
+// NEON is baseline on aarch64, no runtime check needed
+
+#include <arm_neon.h>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoiseKernel.hpp"
+
+namespace BatchedNoise::Simd {
+    struct NEONLanes {
+        using F = float32x4_t;
+        using I = int32x4_t;
+        using M = uint32x4_t;
+        static constexpr uint32_t WIDTH = 4;
+
+        static F SetF(float v) { return vdupq_n_f32(v); }
+        static I SetI(int32_t v) { return vdupq_n_s32(v); }
+        static I Iota() {
+            static constexpr int32_t IOTA[4] = { 0, 1, 2, 3 };
+            return vld1q_s32(IOTA);
+        }
+        static F ToFloat(I v) { return vcvtq_f32_s32(v); }
+        static I FastFloor(F f) {
+            I Truncated = vcvtq_s32_f32(f);
+            I Negative = vreinterpretq_s32_u32(vcltq_f32(f, vdupq_n_f32(0.0f)));
+            return vaddq_s32(Truncated, Negative);
+        }
+
+        static F Add(F a, F b) { return vaddq_f32(a, b); }
+        static F Sub(F a, F b) { return vsubq_f32(a, b); }
+        static F Mul(F a, F b) { return vmulq_f32(a, b); }
+
+        static I AddI(I a, I b) { return vaddq_s32(a, b); }
+        static I MulI(I a, I b) { return vmulq_s32(a, b); }
+        static I Xor(I a, I b) { return veorq_s32(a, b); }
+        static I And(I a, I b) { return vandq_s32(a, b); }
+        static I Sra15(I a) { return vshrq_n_s32(a, 15); }
+        static I Shl19(I a) { return vshlq_n_s32(a, 19); }
+
+        static M Greater(F a, F b) { return vcgtq_f32(a, b); }
+        static F Select(M m, F a, F b) { return vbslq_f32(m, a, b); }
+        static I SelectI(M m, I a, I b) { return vbslq_s32(m, a, b); }
+        static F Gather(const float* Base, I Index) {
+            float Values[4] = {
+                Base[vgetq_lane_s32(Index, 0)],
+                Base[vgetq_lane_s32(Index, 1)],
+                Base[vgetq_lane_s32(Index, 2)],
+                Base[vgetq_lane_s32(Index, 3)]
+            };
+            return vld1q_f32(Values);
+        }
+
+        static void StoreU16(uint16_t* Dst, F v) {
+            vst1_u16(Dst, vqmovun_s32(vcvtq_s32_f32(v)));
+        }
+    };
+
+    GenerateGridFn Select_NEON(NoiseKind Kind, FractalKind Fractal) {
+        return Kernel::Select<NEONLanes>(Kind, Fractal);
+    }
+};
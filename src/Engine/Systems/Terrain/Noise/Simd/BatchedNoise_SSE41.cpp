@@ -0,0 +1,59 @@
+// Built with -msse4.1, only ever called after BatchedNoise::IsSupported(Isa::SSE41)
+
+#include <smmintrin.h>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoiseKernel.hpp"
+
+namespace BatchedNoise::Simd {
+    struct SSE41Lanes {
+        using F = __m128;
+        using I = __m128i;
+        using M = __m128;
+        static constexpr uint32_t WIDTH = 4;
+
+        static F SetF(float v) { return _mm_set1_ps(v); }
+        static I SetI(int32_t v) { return _mm_set1_epi32(v); }
+        static I Iota() { return _mm_setr_epi32(0, 1, 2, 3); }
+        static F ToFloat(I v) { return _mm_cvtepi32_ps(v); }
+        static I FastFloor(F f) {
+            I Truncated = _mm_cvttps_epi32(f);
+            I Negative = _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps()));
+            return _mm_add_epi32(Truncated, Negative);
+        }
+
+        static F Add(F a, F b) { return _mm_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+
+        static I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+        static I MulI(I a, I b) { return _mm_mullo_epi32(a, b); }
+        static I Xor(I a, I b) { return _mm_xor_si128(a, b); }
+        static I And(I a, I b) { return _mm_and_si128(a, b); }
+        static I Sra15(I a) { return _mm_srai_epi32(a, 15); }
+        static I Shl19(I a) { return _mm_slli_epi32(a, 19); }
+
+        static M Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+        static F Select(M m, F a, F b) { return _mm_blendv_ps(b, a, m); }
+        static I SelectI(M m, I a, I b) {
+            return _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(b), _mm_castsi128_ps(a), m));
+        }
+        // No gather before AVX2, the table is tiny and stays in L1 anyway
+        static F Gather(const float* Base, I Index) {
+            return _mm_setr_ps(
+                Base[_mm_extract_epi32(Index, 0)],
+                Base[_mm_extract_epi32(Index, 1)],
+                Base[_mm_extract_epi32(Index, 2)],
+                Base[_mm_extract_epi32(Index, 3)]
+            );
+        }
+
+        static void StoreU16(uint16_t* Dst, F v) {
+            __m128i Packed = _mm_packus_epi32(_mm_cvttps_epi32(v), _mm_setzero_si128());
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(Dst), Packed);
+        }
+    };
+
+    GenerateGridFn Select_SSE41(NoiseKind Kind, FractalKind Fractal) {
+        return Kernel::Select<SSE41Lanes>(Kind, Fractal);
+    }
+};
@@ -1,32 +1,132 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 
-#include <vulkan/vulkan.h>
-
 #include "Engine/Systems/Terrain/TerrainConfig.hpp"
 
+// Everything here is constexpr, the renderer's index buffers are built at compile time
 namespace PlaneMeshIndicesGenerator {
-    static inline void GetIndices(uint32_t* IndicesBegin) {
-        int32_t TerrainRes = TerrainConfig::Chunk::RESOLUTION;
-        for (int z = 0; z < TerrainRes - 1; z++) {
-            for (int x = 0; x < TerrainRes - 1; x++) {
-                // Calculate the index of the current vertex and neighbors
-                uint32_t topLeft = (z * TerrainConfig::Chunk::RESOLUTION) + x;
-                uint32_t topRight = topLeft + 1;
-                uint32_t bottomLeft = ((z + 1) * TerrainConfig::Chunk::RESOLUTION) + x;
-                uint32_t bottomRight = bottomLeft + 1;
-
-                // Triangle 1 (Top-Left -> Bottom-Left -> Top-Right)
+    // Orders the chunk grid's triangles can come in, same triangles and winding in all.
+    // InferusBench's "indices" suite reports what each does to the post transform cache.
+    enum class Order : uint8_t {
+        // Row after row, left to right
+        RowMajor,
+        // Rows alternate direction, consecutive triangles always share an edge and a row
+        // turn reuses what was just fetched. The order to cut strips from.
+        Snake,
+        // Columns of INDEX_BAND_QUADS quads, row after row within each. A band's row of
+        // vertices is still cached when the next row needs it, close to the 0.5 ACMR a grid
+        // can get at best.
+        Bands
+    };
+
+    // Two triangles for the quad at (x, z) of a grid Resolution vertices wide, SecondFirst
+    // swaps them so a row walked right to left keeps sharing edges
+    template <typename Index>
+    constexpr Index* EmitQuad(Index* IndicesBegin, uint32_t Resolution, uint32_t x, uint32_t z, bool SecondFirst = false) {
+        // Calculate the index of the current vertex and neighbors
+        Index topLeft = static_cast<Index>((z * Resolution) + x);
+        Index topRight = static_cast<Index>(topLeft + 1);
+        Index bottomLeft = static_cast<Index>(((z + 1) * Resolution) + x);
+        Index bottomRight = static_cast<Index>(bottomLeft + 1);
+
+        // Triangle 1 (Top-Left -> Bottom-Left -> Top-Right)
+        // Triangle 2 (Top-Right -> Bottom-Left -> Bottom-Right)
+        const Index Triangles[2][3] = {
+            { topLeft, bottomLeft, topRight },
+            { topRight, bottomLeft, bottomRight }
+        };
+        for (uint32_t i = 0; i < 2; i++) {
+            const Index* Triangle = Triangles[SecondFirst ? 1 - i : i];
+            *IndicesBegin++ = Triangle[0];
+            *IndicesBegin++ = Triangle[1];
+            *IndicesBegin++ = Triangle[2];
+        }
+        return IndicesBegin;
+    }
+
+    // (Resolution - 1)^2 quads, room for 6 indices each. BandQuads only matters to Bands.
+    template <typename Index>
+    constexpr void GetIndices(Index* IndicesBegin, Order GridOrder, uint32_t Resolution = TerrainConfig::Chunk::RESOLUTION,
+                              uint32_t BandQuads = TerrainConfig::Chunk::INDEX_BAND_QUADS) {
+        const uint32_t Quads = Resolution - 1;
+        switch (GridOrder) {
+            case Order::RowMajor:
+                for (uint32_t z = 0; z < Quads; z++) {
+                    for (uint32_t x = 0; x < Quads; x++) {
+                        IndicesBegin = EmitQuad(IndicesBegin, Resolution, x, z);
+                    }
+                }
+                break;
+            case Order::Snake:
+                for (uint32_t z = 0; z < Quads; z++) {
+                    bool Backwards = z % 2 == 1;
+                    for (uint32_t i = 0; i < Quads; i++) {
+                        uint32_t x = Backwards ? Quads - 1 - i : i;
+                        IndicesBegin = EmitQuad(IndicesBegin, Resolution, x, z, Backwards);
+                    }
+                }
+                break;
+            case Order::Bands:
+                for (uint32_t BandBegin = 0; BandBegin < Quads; BandBegin += BandQuads) {
+                    uint32_t BandEnd = BandBegin + BandQuads;
+                    BandEnd = BandEnd < Quads ? BandEnd : Quads;
+                    for (uint32_t z = 0; z < Quads; z++) {
+                        for (uint32_t x = BandBegin; x < BandEnd; x++) {
+                            IndicesBegin = EmitQuad(IndicesBegin, Resolution, x, z);
+                        }
+                    }
+                }
+                break;
+        }
+    }
+
+    // The chunk grid as the renderer uploads it
+    template <typename Index = TerrainConfig::Chunk::Index, Order GridOrder = Order::Bands>
+    constexpr std::array<Index, TerrainConfig::Chunk::INDICES_COUNT> MakeIndices() {
+        std::array<Index, TerrainConfig::Chunk::INDICES_COUNT> Indices {};
+        GetIndices(Indices.data(), GridOrder);
+        return Indices;
+    }
+
+    // Tessellation patches, four control points each over a (PATCHES + 1)^2 grid, in the
+    // (x, z), (x + 1, z), (x, z + 1), (x + 1, z + 1) order terrain_tess.tesc expects
+    template <typename Index = TerrainConfig::Chunk::Index>
+    constexpr std::array<Index, TerrainConfig::Tessellation::PATCH_INDICES_COUNT> MakeTessellationPatchIndices() {
+        constexpr uint32_t PATCHES = TerrainConfig::Tessellation::PATCHES;
+        std::array<Index, TerrainConfig::Tessellation::PATCH_INDICES_COUNT> Indices {};
+        Index* IndicesBegin = Indices.data();
+        for (uint32_t z = 0; z < PATCHES; z++) {
+            for (uint32_t x = 0; x < PATCHES; x++) {
+                Index topLeft = static_cast<Index>((z * (PATCHES + 1)) + x);
                 *IndicesBegin++ = topLeft;
-                *IndicesBegin++ = bottomLeft;
-                *IndicesBegin++ = topRight;
+                *IndicesBegin++ = static_cast<Index>(topLeft + 1);
+                *IndicesBegin++ = static_cast<Index>(topLeft + PATCHES + 1);
+                *IndicesBegin++ = static_cast<Index>(topLeft + PATCHES + 2);
+            }
+        }
+        return Indices;
+    }
 
-                // Triangle 2 (Top-Right -> Bottom-Left -> Bottom-Right)
-                *IndicesBegin++ = topRight;
-                *IndicesBegin++ = bottomLeft;
-                *IndicesBegin++ = bottomRight;
+    // CDLOD patch, quarter by quarter (x then z halves) so a node whose children are only
+    // partly drawn can draw the rest with a quarter's range. A quarter is 4x4 quads, small
+    // enough for any cache in row order.
+    template <typename Index = TerrainConfig::Chunk::Index>
+    constexpr std::array<Index, TerrainConfig::Lod::PATCH_INDICES_COUNT> MakePatchIndices() {
+        constexpr uint32_t QUADS = TerrainConfig::Lod::PATCH_QUADS;
+        constexpr uint32_t HALF = QUADS / 2;
+        std::array<Index, TerrainConfig::Lod::PATCH_INDICES_COUNT> Indices {};
+        Index* IndicesBegin = Indices.data();
+        for (uint32_t Quarter = 0; Quarter < 4; Quarter++) {
+            uint32_t BeginX = (Quarter % 2) * HALF;
+            uint32_t BeginZ = (Quarter / 2) * HALF;
+            for (uint32_t z = BeginZ; z < BeginZ + HALF; z++) {
+                for (uint32_t x = BeginX; x < BeginX + HALF; x++) {
+                    IndicesBegin = EmitQuad(IndicesBegin, QUADS + 1, x, z);
+                }
             }
         }
+        return Indices;
     }
 }
@@ -1,21 +1,48 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
-#include <vulkan/vulkan.h>
-
 #include "Engine/Systems/Terrain/TerrainTypes.hpp"
 
 namespace TerrainConfig {
     namespace Chunk {
         constexpr uint32_t RESOLUTION = 64;
 
+        // World units covered by one chunk, must match GRID_SIZE on terrain.vert
+        constexpr float WORLD_SIZE = 20.0f;
+        // World height of a full texel, must match HEIGHT_SCALE on terrain.vert
+        constexpr float HEIGHT_SCALE = 5.0f;
+
         constexpr uint32_t INDICES_COUNT = (RESOLUTION - 1) * (RESOLUTION - 1) * 6;
 
-        constexpr uint32_t INDICES_BUFFER_SIZE = INDICES_COUNT * sizeof(uint32_t);
+        // Every terrain index buffer, half the bytes of 32 bit ones for the same triangles
+        using Index = uint16_t;
+        static_assert(RESOLUTION * RESOLUTION <= 65536, "Chunk vertices don't fit 16 bit indices");
+
+        constexpr uint32_t INDICES_BUFFER_SIZE = INDICES_COUNT * sizeof(Index);
+
+        // Quads per band of the chunk's index order (PlaneMeshIndicesGenerator::Order::Bands).
+        // A band's rows of vertices have to stay in the post transform cache until the next
+        // row, 7 does on a 16 entry FIFO. Wider gains little on bigger caches and falls off a
+        // cliff on small ones, see InferusBench's "indices" suite.
+        constexpr uint32_t INDEX_BAND_QUADS = 7;
+    };
+
+    // The terrain's noise, TerrainGenerator::DefaultSettings turns it into BatchedNoise settings
+    namespace Noise {
+        constexpr int32_t SEED = 1337;
+        constexpr float FREQUENCY = .02f;
+        constexpr int32_t OCTAVES = 8;
+        constexpr float LACUNARITY = 2.0f;
+        constexpr float GAIN = 0.5f;
     };
 
     namespace ChunkToHeightmapLinking {
+        // Stays at 4 because every chunk in the diamond is one heightmap array layer.
+        // CDLOD at 40 (10x the view distance) draws about the triangles the grid does at 4,
+        // but that's only measured in InferusBench's "lod" suite: 40 needs 3281 layers, past
+        // maxImageArrayLayers (2048 on most devices). The layer count is the blocker.
         constexpr uint32_t DIAMOND_EXPLORATION_RADIUS = 4;
 
         constexpr uint32_t INSTANCE_COUNT = []{
@@ -26,9 +53,81 @@ namespace TerrainConfig {
         constexpr uint32_t LINKING_BUFFER_SIZE = INSTANCE_COUNT * sizeof(ChunkHeightmapLink);
     };
 
-    namespace Heightmap {
-        constexpr VkFormat HEIGHTMAP_IMAGE_FORMAT = VK_FORMAT_R16_UNORM;
+    // Continuous distance dependent LOD (CDLOD), a quadtree per chunk with the chunk itself as root
+    namespace Lod {
+        // Quads per side of the patch every node is drawn with, must match PATCH_QUADS on
+        // terrain_cdlod.vert. Leaves come out about as dense as the heightmap.
+        constexpr uint32_t PATCH_QUADS = 8;
+        // Quadtree levels, the chunk is LOD_COUNT - 1 and leaves are 0. Must match LOD_COUNT
+        // on terrain_cdlod.vert.
+        constexpr uint32_t LOD_COUNT = 4;
+        static_assert((PATCH_QUADS << (LOD_COUNT - 1)) >= Chunk::RESOLUTION - 1, "Leaves coarser than the heightmap");
+
+        // Distance up to which leaves are drawn, doubling every level
+        constexpr float LEAF_RANGE = 15.0f;
+        // Fraction of a level's range after which its vertices start morphing into the
+        // next level's, the rest of the range is the morph area. Above 0.5 or levels crack.
+        constexpr float MORPH_START = 0.7f;
+
+        // Whole patch, its four quarters one after the other so each is a range of it
+        constexpr uint32_t PATCH_INDICES_COUNT = PATCH_QUADS * PATCH_QUADS * 6;
+        constexpr uint32_t PATCH_INDICES_BUFFER_SIZE = PATCH_INDICES_COUNT * sizeof(Chunk::Index);
+    };
+
+    // Hardware tessellation, every chunk drawn as a few quad patches the GPU subdivides
+    namespace Tessellation {
+        // Patches per chunk side, must match PATCHES on terrain_tess.vert
+        constexpr uint32_t PATCHES = 4;
+        // Subdivisions per patch edge at most, must match MAX_FACTOR on terrain_tess.tesc.
+        // Fully subdivided a patch is as fine as the heightmap, finer only adds vertices.
+        constexpr uint32_t MAX_FACTOR = 16;
+        static_assert(PATCHES * MAX_FACTOR >= Chunk::RESOLUTION - 1, "Patches coarser than the heightmap");
+
+        // On screen length a generated edge aims for, flat stretches get longer ones
+        constexpr float EDGE_PIXELS = 12.0f;
 
+        // Four control points per patch over a (PATCHES + 1)^2 grid
+        constexpr uint32_t PATCH_INDICES_COUNT = PATCHES * PATCHES * 4;
+        constexpr uint32_t PATCH_INDICES_BUFFER_SIZE = PATCH_INDICES_COUNT * sizeof(Chunk::Index);
+    };
+
+    namespace Heightfield {
+        // How far camera casting looks for the terrain, a few times the resident radius
+        constexpr float CAMERA_CAST_DISTANCE = 500.0f;
+        // Chunks TerrainHeightfield::Sample keeps around when it had to generate them
+        constexpr uint32_t GENERATED_CHUNKS = 8;
+    };
+
+    namespace Streaming {
+        // Chunks that may be in flight at once, each owns a tile until the main thread packs it
+        constexpr uint32_t TILE_POOL_SIZE = 64;
+
+        // Microseconds of chunk work (store reads, generation) let in per frame. Starts at
+        // INITIAL, backs off on frames over the target time and creeps back up while
+        // frames have headroom.
+        constexpr float INITIAL_BUDGET_US = 2000.0f;
+        constexpr float MIN_BUDGET_US = 250.0f;
+        constexpr float MAX_BUDGET_US = 8000.0f;
+        constexpr float BUDGET_BACKOFF = 0.5f;
+        constexpr float BUDGET_STEP_US = 100.0f;
+
+        // Cost charged per generated chunk until the pipeline measured a few
+        constexpr float INITIAL_CHUNK_COST_US = 500.0f;
+        // Weight of the newest frame in the moving average of the chunk cost
+        constexpr float CHUNK_COST_SMOOTHING = 0.1f;
+    };
+
+    namespace Store {
+        // Generated chunks are kept on disk and read back instead of regenerated
+        constexpr bool ENABLED = true;
+        constexpr const char* DIRECTORY = "world";
+
+        // Chunks per region file side, REGION_SIZE * REGION_SIZE per file
+        constexpr int32_t REGION_SIZE = 32;
+        constexpr uint32_t MAX_OPEN_REGIONS = 16;
+    };
+
+    namespace Heightmap {
         constexpr size_t HEIGHTMAP_IMAGE_PIXEL_COUNT = TerrainConfig::Chunk::RESOLUTION * TerrainConfig::Chunk::RESOLUTION;
 
         constexpr size_t HEIGHTMAP_ALL_IMAGES_PIXEL_COUNT = HEIGHTMAP_IMAGE_PIXEL_COUNT * TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT;
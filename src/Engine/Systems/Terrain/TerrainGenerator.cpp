@@ -0,0 +1,35 @@
+#include "TerrainGenerator.hpp"
+
+#include <algorithm>
+
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+
+namespace TerrainGenerator {
+    BatchedNoise::Settings DefaultSettings() {
+        return {
+            .Seed = TerrainConfig::Noise::SEED,
+            .Frequency = TerrainConfig::Noise::FREQUENCY,
+            .Octaves = TerrainConfig::Noise::OCTAVES,
+            .Lacunarity = TerrainConfig::Noise::LACUNARITY,
+            .Gain = TerrainConfig::Noise::GAIN
+        };
+    }
+
+    void Generate(const BatchedNoise::Settings& NoiseSettings, glm::ivec2 ChunkPos, uint16_t* Texels) {
+        // Neighbouring chunks share their border texels, hence the RESOLUTION - 1 stride
+        int32_t ChunkStride = TerrainConfig::Chunk::RESOLUTION - 1;
+
+        BatchedNoise::GridDesc Grid = {
+            .OriginX = ChunkStride * ChunkPos.x,
+            .OriginZ = ChunkStride * ChunkPos.y,
+            .Rows = TerrainConfig::Chunk::RESOLUTION,
+            .Cols = TerrainConfig::Chunk::RESOLUTION
+        };
+        BatchedNoise::GenerateGrid(NoiseSettings, Grid, Texels);
+    }
+
+    ChunkBounds Bounds(const uint16_t* Texels) {
+        auto [Min, Max] = std::minmax_element(Texels, Texels + TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT);
+        return { .MinHeight = *Min, .MaxHeight = *Max };
+    }
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+// Chunk generation itself, no renderer, staging or threading attached. The chunk pipeline
+// runs it for streaming and InferusBake for offline worlds, both get the very same texels.
+namespace TerrainGenerator {
+    struct ChunkBounds {
+        uint16_t MinHeight;
+        uint16_t MaxHeight;
+    };
+
+    // What TerrainConfig::Noise describes
+    BatchedNoise::Settings DefaultSettings();
+
+    // RESOLUTION * RESOLUTION texels, laid out like the heightmap slots
+    void Generate(const BatchedNoise::Settings& NoiseSettings, glm::ivec2 ChunkPos, uint16_t* Texels);
+    ChunkBounds Bounds(const uint16_t* Texels);
+};
@@ -0,0 +1,644 @@
+#include "TerrainHeightfield.hpp"
+
+#include <cmath>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+#include "Engine/Systems/Terrain/ChunkResidency.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+
+namespace TerrainHeightfield {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+        constexpr float HEIGHT_SCALE = TerrainConfig::Chunk::HEIGHT_SCALE;
+        // World units between two vertices
+        constexpr float QUAD_SIZE = WORLD_SIZE / float(QUADS);
+        constexpr float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+        constexpr float EMPTY_MIN = std::numeric_limits<float>::infinity();
+        constexpr float EMPTY_MAX = -std::numeric_limits<float>::infinity();
+
+        constexpr uint32_t LevelSide(uint32_t Level) {
+            return PYRAMID_SIDE >> Level;
+        }
+
+        constexpr std::array<uint32_t, PYRAMID_LEVELS + 1> LEVEL_OFFSETS = []{
+            std::array<uint32_t, PYRAMID_LEVELS + 1> Offsets {};
+            for (uint32_t Level = 0; Level < PYRAMID_LEVELS; Level++) {
+                Offsets[Level + 1] = Offsets[Level] + LevelSide(Level) * LevelSide(Level);
+            }
+            return Offsets;
+        }();
+        constexpr uint32_t PYRAMID_NODES = LEVEL_OFFSETS[PYRAMID_LEVELS];
+
+        // Rows run along world x, columns along world z, like the texels (see TerrainGenerator)
+        struct ChunkField {
+            glm::ivec2 ChunkPos;
+            bool Resident;
+            // World height of every vertex terrain.vert places
+            float Heights[RESOLUTION * RESOLUTION];
+            float Min[PYRAMID_NODES];
+            float Max[PYRAMID_NODES];
+        };
+
+        ChunkField Fields[TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT];
+        Stats Counters {};
+
+        // Chunks Sample generated itself (Missing::Generate), least recently used one goes
+        struct GeneratedChunks {
+            std::mutex Lock;
+            ChunkField Fields[TerrainConfig::Heightfield::GENERATED_CHUNKS];
+            uint64_t LastUse[TerrainConfig::Heightfield::GENERATED_CHUNKS];
+            uint64_t Uses;
+            uint16_t Texels[RESOLUTION * RESOLUTION];
+        };
+        GeneratedChunks Generated {};
+        BatchedNoise::Settings GeneratorSettings;
+        bool CanGenerate = false;
+
+        uint32_t NodeIndex(uint32_t Level, uint32_t Row, uint32_t Col) {
+            return LEVEL_OFFSETS[Level] + Row * LevelSide(Level) + Col;
+        }
+
+        const ChunkField* Find(glm::ivec2 ChunkPos) {
+            const ChunkField& Field = Fields[ChunkResidency::Slot(ChunkPos)];
+            return Field.Resident && Field.ChunkPos == ChunkPos ? &Field : nullptr;
+        }
+
+        // Row and column are the quad, FracRow and FracCol where in it
+        float SurfaceHeight(const ChunkField& Field, uint32_t Row, uint32_t Col, float FracRow, float FracCol) {
+            const float* Quad = &Field.Heights[Row * RESOLUTION + Col];
+            float TopLeft = Quad[0];
+            float TopRight = Quad[1];
+            float BottomLeft = Quad[RESOLUTION];
+            float BottomRight = Quad[RESOLUTION + 1];
+
+            // Triangle 1 (Top-Left -> Bottom-Left -> Top-Right) up to the diagonal, triangle 2 past it
+            if (FracRow + FracCol <= 1.0f) {
+                return TopLeft + FracCol * (TopRight - TopLeft) + FracRow * (BottomLeft - TopLeft);
+            }
+            return BottomRight + (1.0f - FracCol) * (BottomLeft - BottomRight) + (1.0f - FracRow) * (TopRight - BottomRight);
+        }
+
+        // Upward normal of the triangle SurfaceHeight interpolates
+        glm::vec3 SurfaceNormal(const ChunkField& Field, uint32_t Row, uint32_t Col, float FracRow, float FracCol) {
+            const float* Quad = &Field.Heights[Row * RESOLUTION + Col];
+            float TopLeft = Quad[0];
+            float TopRight = Quad[1];
+            float BottomLeft = Quad[RESOLUTION];
+            float BottomRight = Quad[RESOLUTION + 1];
+
+            // Height steps per quad along rows (world x) and columns (world z)
+            bool First = FracRow + FracCol <= 1.0f;
+            float AlongRow = First ? BottomLeft - TopLeft : BottomRight - TopRight;
+            float AlongCol = First ? TopRight - TopLeft : BottomRight - BottomLeft;
+            return glm::normalize(glm::vec3(-AlongRow, QUAD_SIZE, -AlongCol));
+        }
+
+        void FieldSample(const ChunkField& Field, glm::vec2 ChunkXZ, float& OutHeight, glm::vec3* OutNormal) {
+            float Row = (ChunkXZ.x - float(Field.ChunkPos.x)) * float(QUADS);
+            float Col = (ChunkXZ.y - float(Field.ChunkPos.y)) * float(QUADS);
+            uint32_t QuadRow = std::min(static_cast<uint32_t>(Row), QUADS - 1);
+            uint32_t QuadCol = std::min(static_cast<uint32_t>(Col), QUADS - 1);
+            OutHeight = SurfaceHeight(Field, QuadRow, QuadCol, Row - float(QuadRow), Col - float(QuadCol));
+            if (OutNormal) {
+                *OutNormal = SurfaceNormal(Field, QuadRow, QuadCol, Row - float(QuadRow), Col - float(QuadCol));
+            }
+        }
+
+        struct Ray {
+            glm::vec3 Origin;
+            glm::vec3 Direction;
+            glm::vec3 InvDirection;
+        };
+
+        Ray MakeRay(glm::vec3 Origin, glm::vec3 Direction) {
+            // Axis aligned rays would make 0 * inf slabs, a nudge keeps every slab finite
+            auto Inverse = [](float d) {
+                constexpr float TINY = 1e-20f;
+                return 1.0f / (std::abs(d) > TINY ? d : std::copysign(TINY, d));
+            };
+            return {
+                .Origin = Origin,
+                .Direction = Direction,
+                .InvDirection = { Inverse(Direction.x), Inverse(Direction.y), Inverse(Direction.z) }
+            };
+        }
+
+        // Where the ray enters the box, when it does before MaxT
+        bool RayBox(const Ray& R, glm::vec3 Min, glm::vec3 Max, float MaxT, float& Enter) {
+            glm::vec3 t0 = (Min - R.Origin) * R.InvDirection;
+            glm::vec3 t1 = (Max - R.Origin) * R.InvDirection;
+            float Near = std::max({ std::min(t0.x, t1.x), std::min(t0.y, t1.y), std::min(t0.z, t1.z), 0.0f });
+            float Far = std::min({ std::max(t0.x, t1.x), std::max(t0.y, t1.y), std::max(t0.z, t1.z), MaxT });
+            Enter = Near;
+            return Near <= Far;
+        }
+
+        // Two sided Moller-Trumbore, a hair of slack on the edges so rays can't slip
+        // between the two triangles of a quad
+        bool RayTriangle(const Ray& R, glm::vec3 a, glm::vec3 b, glm::vec3 c, float& OutT) {
+            constexpr float SLACK = 1e-5f;
+
+            glm::vec3 Edge1 = b - a;
+            glm::vec3 Edge2 = c - a;
+            glm::vec3 P = glm::cross(R.Direction, Edge2);
+            float Determinant = glm::dot(Edge1, P);
+            if (std::abs(Determinant) < 1e-12f) {
+                return false;
+            }
+            float InvDeterminant = 1.0f / Determinant;
+
+            glm::vec3 T = R.Origin - a;
+            float u = glm::dot(T, P) * InvDeterminant;
+            if (u < -SLACK || u > 1.0f + SLACK) {
+                return false;
+            }
+            glm::vec3 Q = glm::cross(T, Edge1);
+            float v = glm::dot(R.Direction, Q) * InvDeterminant;
+            if (v < -SLACK || u + v > 1.0f + SLACK) {
+                return false;
+            }
+            OutT = glm::dot(Edge2, Q) * InvDeterminant;
+            return OutT >= 0.0f;
+        }
+
+        // Both triangles of the quad, in the chunk's quad space: x along rows, z along columns
+        bool RayQuad(const ChunkField& Field, const Ray& Local, uint32_t Row, uint32_t Col, float& Best) {
+            const float* Quad = &Field.Heights[Row * RESOLUTION + Col];
+            glm::vec3 TopLeft = { float(Row), Quad[0], float(Col) };
+            glm::vec3 TopRight = { float(Row), Quad[1], float(Col + 1) };
+            glm::vec3 BottomLeft = { float(Row + 1), Quad[RESOLUTION], float(Col) };
+            glm::vec3 BottomRight = { float(Row + 1), Quad[RESOLUTION + 1], float(Col + 1) };
+
+            bool Found = false;
+            float t;
+            if (RayTriangle(Local, TopLeft, BottomLeft, TopRight, t) && t < Best) {
+                Best = t;
+                Found = true;
+            }
+            if (RayTriangle(Local, TopRight, BottomLeft, BottomRight, t) && t < Best) {
+                Best = t;
+                Found = true;
+            }
+            return Found;
+        }
+
+        // Front to back through the pyramid, the first leaf hit is the closest one. Best
+        // comes in as how far to look and leaves as the hit distance.
+        bool RayField(const ChunkField& Field, const Ray& World, float& Best) {
+            // Quad space keeps t: an affine map of the origin with the direction scaled alike
+            constexpr float TO_QUADS = float(QUADS) / WORLD_SIZE;
+            glm::vec3 Origin = {
+                (World.Origin.x / WORLD_SIZE - float(Field.ChunkPos.x)) * float(QUADS),
+                World.Origin.y,
+                (World.Origin.z / WORLD_SIZE - float(Field.ChunkPos.y)) * float(QUADS)
+            };
+            Ray Local = MakeRay(Origin, { World.Direction.x * TO_QUADS, World.Direction.y, World.Direction.z * TO_QUADS });
+
+            struct Node {
+                uint32_t Level;
+                uint32_t Row;
+                uint32_t Col;
+                float Enter;
+            };
+            // Four children pushed per level at most
+            Node Stack[4 * PYRAMID_LEVELS];
+            uint32_t Top = 0;
+            Stack[Top++] = { .Level = PYRAMID_LEVELS - 1, .Row = 0, .Col = 0, .Enter = 0.0f };
+
+            while (Top > 0) {
+                Node Current = Stack[--Top];
+                if (Current.Enter > Best) {
+                    continue;
+                }
+                if (Current.Level == 0) {
+                    if (RayQuad(Field, Local, Current.Row, Current.Col, Best)) {
+                        return true;
+                    }
+                    continue;
+                }
+
+                Node Children[4];
+                uint32_t ChildCount = 0;
+                uint32_t ChildLevel = Current.Level - 1;
+                float Span = float(1u << ChildLevel);
+                for (uint32_t i = 0; i < 4; i++) {
+                    uint32_t Row = Current.Row * 2 + i / 2;
+                    uint32_t Col = Current.Col * 2 + i % 2;
+                    uint32_t Index = NodeIndex(ChildLevel, Row, Col);
+                    if (Field.Min[Index] > Field.Max[Index]) {
+                        continue;
+                    }
+
+                    glm::vec3 Min = { float(Row) * Span, Field.Min[Index], float(Col) * Span };
+                    glm::vec3 Max = { Min.x + Span, Field.Max[Index], Min.z + Span };
+                    float Enter;
+                    if (RayBox(Local, Min, Max, Best, Enter)) {
+                        Children[ChildCount++] = { .Level = ChildLevel, .Row = Row, .Col = Col, .Enter = Enter };
+                    }
+                }
+
+                // Furthest pushed first so the closest pops next, four at most so insertion sort it is
+                for (uint32_t i = 1; i < ChildCount; i++) {
+                    for (uint32_t j = i; j > 0 && Children[j - 1].Enter < Children[j].Enter; j--) {
+                        std::swap(Children[j - 1], Children[j]);
+                    }
+                }
+                for (uint32_t i = 0; i < ChildCount; i++) {
+                    Stack[Top++] = Children[i];
+                }
+            }
+            return false;
+        }
+
+        void BuildField(ChunkField& Field, const uint16_t* Texels) {
+            // Vertex (r, c) is texel (r, c), terrain.vert fetches it unfiltered
+            for (uint32_t i = 0; i < RESOLUTION * RESOLUTION; i++) {
+                Field.Heights[i] = float(Texels[i]) / 65535.0f * HEIGHT_SCALE;
+            }
+
+            // Leaves bound their quad's four vertices, the padding quads stay empty
+            for (uint32_t r = 0; r < PYRAMID_SIDE; r++) {
+                for (uint32_t c = 0; c < PYRAMID_SIDE; c++) {
+                    uint32_t Index = NodeIndex(0, r, c);
+                    if (r >= QUADS || c >= QUADS) {
+                        Field.Min[Index] = EMPTY_MIN;
+                        Field.Max[Index] = EMPTY_MAX;
+                        continue;
+                    }
+                    const float* Quad = &Field.Heights[r * RESOLUTION + c];
+                    Field.Min[Index] = std::min({ Quad[0], Quad[1], Quad[RESOLUTION], Quad[RESOLUTION + 1] });
+                    Field.Max[Index] = std::max({ Quad[0], Quad[1], Quad[RESOLUTION], Quad[RESOLUTION + 1] });
+                }
+            }
+            for (uint32_t Level = 1; Level < PYRAMID_LEVELS; Level++) {
+                for (uint32_t r = 0; r < LevelSide(Level); r++) {
+                    for (uint32_t c = 0; c < LevelSide(Level); c++) {
+                        uint32_t Children[4] = {
+                            NodeIndex(Level - 1, r * 2, c * 2), NodeIndex(Level - 1, r * 2, c * 2 + 1),
+                            NodeIndex(Level - 1, r * 2 + 1, c * 2), NodeIndex(Level - 1, r * 2 + 1, c * 2 + 1)
+                        };
+                        uint32_t Index = NodeIndex(Level, r, c);
+                        Field.Min[Index] = std::min({ Field.Min[Children[0]], Field.Min[Children[1]], Field.Min[Children[2]], Field.Min[Children[3]] });
+                        Field.Max[Index] = std::max({ Field.Max[Children[0]], Field.Max[Children[1]], Field.Max[Children[2]], Field.Max[Children[3]] });
+                    }
+                }
+            }
+        }
+
+        // Lanes for Sample, SSE2 and NEON are baseline on what we build for (like FrustumCulling).
+        // There's no gather before AVX2, a lane's quad is loaded on its own, it's the
+        // arithmetic around it that goes WIDTH wide.
+#if defined(__SSE2__)
+        struct Lanes {
+            using F = __m128;
+            using M = __m128;
+
+            static F Set(float v) { return _mm_set1_ps(v); }
+            static void LoadXZ(const glm::vec2* Positions, F& X, F& Z) {
+                __m128 a = _mm_loadu_ps(&Positions[0].x);
+                __m128 b = _mm_loadu_ps(&Positions[2].x);
+                X = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+                Z = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            }
+            static void Store(float* Dst, F v) { _mm_storeu_ps(Dst, v); }
+
+            static F Add(F a, F b) { return _mm_add_ps(a, b); }
+            static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+            static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+            static F Div(F a, F b) { return _mm_div_ps(a, b); }
+            static F Min(F a, F b) { return _mm_min_ps(a, b); }
+            static F Sqrt(F a) { return _mm_sqrt_ps(a); }
+            // No roundps before SSE4.1, truncate and step down where that went up
+            static F Floor(F v) {
+                F Truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+                return _mm_sub_ps(Truncated, _mm_and_ps(_mm_cmpgt_ps(Truncated, v), _mm_set1_ps(1.0f)));
+            }
+
+            static M LessEqual(F a, F b) { return _mm_cmple_ps(a, b); }
+            static F Select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+            static F Gather(const float* const* Quads, uint32_t Offset) {
+                return _mm_setr_ps(Quads[0][Offset], Quads[1][Offset], Quads[2][Offset], Quads[3][Offset]);
+            }
+        };
+#elif defined(__ARM_NEON)
+        struct Lanes {
+            using F = float32x4_t;
+            using M = uint32x4_t;
+
+            static F Set(float v) { return vdupq_n_f32(v); }
+            static void LoadXZ(const glm::vec2* Positions, F& X, F& Z) {
+                float32x4x2_t Deinterleaved = vld2q_f32(&Positions[0].x);
+                X = Deinterleaved.val[0];
+                Z = Deinterleaved.val[1];
+            }
+            static void Store(float* Dst, F v) { vst1q_f32(Dst, v); }
+
+            static F Add(F a, F b) { return vaddq_f32(a, b); }
+            static F Sub(F a, F b) { return vsubq_f32(a, b); }
+            static F Mul(F a, F b) { return vmulq_f32(a, b); }
+            static F Div(F a, F b) { return vdivq_f32(a, b); }
+            static F Min(F a, F b) { return vminq_f32(a, b); }
+            static F Sqrt(F a) { return vsqrtq_f32(a); }
+            static F Floor(F v) { return vrndmq_f32(v); }
+
+            static M LessEqual(F a, F b) { return vcleq_f32(a, b); }
+            static F Select(M m, F a, F b) { return vbslq_f32(m, a, b); }
+            static F Gather(const float* const* Quads, uint32_t Offset) {
+                const float Loaded[4] = { Quads[0][Offset], Quads[1][Offset], Quads[2][Offset], Quads[3][Offset] };
+                return vld1q_f32(Loaded);
+            }
+        };
+#else
+        struct Lanes {
+            struct F { float v[4]; };
+            using M = F;
+
+            template <typename Fn>
+            static F Map(Fn&& Op) {
+                F Result;
+                for (uint32_t i = 0; i < 4; i++) {
+                    Result.v[i] = Op(i);
+                }
+                return Result;
+            }
+
+            static F Set(float v) { return { { v, v, v, v } }; }
+            static void LoadXZ(const glm::vec2* Positions, F& X, F& Z) {
+                X = Map([Positions](uint32_t i) { return Positions[i].x; });
+                Z = Map([Positions](uint32_t i) { return Positions[i].y; });
+            }
+            static void Store(float* Dst, F v) { std::copy(v.v, v.v + 4, Dst); }
+
+            static F Add(F a, F b) { return Map([&](uint32_t i) { return a.v[i] + b.v[i]; }); }
+            static F Sub(F a, F b) { return Map([&](uint32_t i) { return a.v[i] - b.v[i]; }); }
+            static F Mul(F a, F b) { return Map([&](uint32_t i) { return a.v[i] * b.v[i]; }); }
+            static F Div(F a, F b) { return Map([&](uint32_t i) { return a.v[i] / b.v[i]; }); }
+            static F Min(F a, F b) { return Map([&](uint32_t i) { return std::min(a.v[i], b.v[i]); }); }
+            static F Sqrt(F a) { return Map([&](uint32_t i) { return std::sqrt(a.v[i]); }); }
+            static F Floor(F a) { return Map([&](uint32_t i) { return std::floor(a.v[i]); }); }
+
+            static M LessEqual(F a, F b) { return Map([&](uint32_t i) { return a.v[i] <= b.v[i] ? 1.0f : 0.0f; }); }
+            static F Select(M m, F a, F b) { return Map([&](uint32_t i) { return m.v[i] != 0.0f ? a.v[i] : b.v[i]; }); }
+            static F Gather(const float* const* Quads, uint32_t Offset) {
+                return Map([Quads, Offset](uint32_t i) { return Quads[i][Offset]; });
+            }
+        };
+#endif
+
+        // Positions whose chunk isn't resident, NaN or generated right here
+        bool SampleMissing(glm::vec2 WorldXZ, Missing OnMissing, float& OutHeight, glm::vec3* OutNormal);
+
+        // WIDTH positions, the chunk lookups are per lane, everything else isn't
+        uint32_t SampleLanes(const glm::vec2* WorldXZ, float* OutHeights, glm::vec3* OutNormals, Missing OnMissing,
+                             const ChunkField*& LastField) {
+            using F = Lanes::F;
+            using M = Lanes::M;
+            constexpr uint32_t WIDTH = 4;
+            static const float FLAT_QUAD[RESOLUTION + 2] = {};
+
+            F X, Z;
+            Lanes::LoadXZ(WorldXZ, X, Z);
+            F ChunkX = Lanes::Div(X, Lanes::Set(WORLD_SIZE));
+            F ChunkZ = Lanes::Div(Z, Lanes::Set(WORLD_SIZE));
+            F FloorX = Lanes::Floor(ChunkX);
+            F FloorZ = Lanes::Floor(ChunkZ);
+
+            // Same steps as FieldSample, so both land on the very same triangle
+            F Row = Lanes::Mul(Lanes::Sub(ChunkX, FloorX), Lanes::Set(float(QUADS)));
+            F Col = Lanes::Mul(Lanes::Sub(ChunkZ, FloorZ), Lanes::Set(float(QUADS)));
+            F QuadRow = Lanes::Min(Lanes::Floor(Row), Lanes::Set(float(QUADS - 1)));
+            F QuadCol = Lanes::Min(Lanes::Floor(Col), Lanes::Set(float(QUADS - 1)));
+            F FracRow = Lanes::Sub(Row, QuadRow);
+            F FracCol = Lanes::Sub(Col, QuadCol);
+
+            float LaneChunkX[WIDTH], LaneChunkZ[WIDTH], LaneRow[WIDTH], LaneCol[WIDTH];
+            Lanes::Store(LaneChunkX, FloorX);
+            Lanes::Store(LaneChunkZ, FloorZ);
+            Lanes::Store(LaneRow, QuadRow);
+            Lanes::Store(LaneCol, QuadCol);
+
+            const float* Quads[WIDTH];
+            uint32_t MissingLanes = 0;
+            for (uint32_t Lane = 0; Lane < WIDTH; Lane++) {
+                glm::ivec2 ChunkPos = { static_cast<int32_t>(LaneChunkX[Lane]), static_cast<int32_t>(LaneChunkZ[Lane]) };
+                if (!LastField || LastField->ChunkPos != ChunkPos) {
+                    LastField = Find(ChunkPos);
+                }
+                if (!LastField) {
+                    MissingLanes |= 1u << Lane;
+                    Quads[Lane] = FLAT_QUAD;
+                    continue;
+                }
+                uint32_t QuadIndex = static_cast<uint32_t>(LaneRow[Lane]) * RESOLUTION + static_cast<uint32_t>(LaneCol[Lane]);
+                Quads[Lane] = &LastField->Heights[QuadIndex];
+            }
+
+            F TopLeft = Lanes::Gather(Quads, 0);
+            F TopRight = Lanes::Gather(Quads, 1);
+            F BottomLeft = Lanes::Gather(Quads, RESOLUTION);
+            F BottomRight = Lanes::Gather(Quads, RESOLUTION + 1);
+
+            // Triangle 1 up to the diagonal, triangle 2 past it, like SurfaceHeight
+            F One = Lanes::Set(1.0f);
+            M First = Lanes::LessEqual(Lanes::Add(FracRow, FracCol), One);
+            F Height1 = Lanes::Add(Lanes::Add(TopLeft, Lanes::Mul(FracCol, Lanes::Sub(TopRight, TopLeft))),
+                                   Lanes::Mul(FracRow, Lanes::Sub(BottomLeft, TopLeft)));
+            F Height2 = Lanes::Add(Lanes::Add(BottomRight, Lanes::Mul(Lanes::Sub(One, FracCol), Lanes::Sub(BottomLeft, BottomRight))),
+                                   Lanes::Mul(Lanes::Sub(One, FracRow), Lanes::Sub(TopRight, BottomRight)));
+            Lanes::Store(OutHeights, Lanes::Select(First, Height1, Height2));
+
+            if (OutNormals) {
+                F AlongRow = Lanes::Select(First, Lanes::Sub(BottomLeft, TopLeft), Lanes::Sub(BottomRight, TopRight));
+                F AlongCol = Lanes::Select(First, Lanes::Sub(TopRight, TopLeft), Lanes::Sub(BottomRight, BottomLeft));
+                F Up = Lanes::Set(QUAD_SIZE);
+                F LengthSquared = Lanes::Add(Lanes::Add(Lanes::Mul(AlongRow, AlongRow), Lanes::Mul(Up, Up)), Lanes::Mul(AlongCol, AlongCol));
+                F InvLength = Lanes::Div(One, Lanes::Sqrt(LengthSquared));
+
+                float NormalX[WIDTH], NormalY[WIDTH], NormalZ[WIDTH];
+                Lanes::Store(NormalX, Lanes::Mul(Lanes::Sub(Lanes::Set(0.0f), AlongRow), InvLength));
+                Lanes::Store(NormalY, Lanes::Mul(Up, InvLength));
+                Lanes::Store(NormalZ, Lanes::Mul(Lanes::Sub(Lanes::Set(0.0f), AlongCol), InvLength));
+                for (uint32_t Lane = 0; Lane < WIDTH; Lane++) {
+                    OutNormals[Lane] = { NormalX[Lane], NormalY[Lane], NormalZ[Lane] };
+                }
+            }
+
+            uint32_t Resolved = WIDTH;
+            while (MissingLanes) {
+                uint32_t Lane = static_cast<uint32_t>(std::countr_zero(MissingLanes));
+                MissingLanes &= MissingLanes - 1;
+                if (!SampleMissing(WorldXZ[Lane], OnMissing, OutHeights[Lane], OutNormals ? &OutNormals[Lane] : nullptr)) {
+                    Resolved--;
+                }
+            }
+            return Resolved;
+        }
+
+        // Lock held. The generated chunk at ChunkPos, generated now when it isn't yet.
+        const ChunkField& GeneratedField(glm::ivec2 ChunkPos) {
+            constexpr uint32_t COUNT = TerrainConfig::Heightfield::GENERATED_CHUNKS;
+
+            uint32_t Victim = 0;
+            for (uint32_t i = 0; i < COUNT; i++) {
+                if (Generated.LastUse[i] > 0 && Generated.Fields[i].ChunkPos == ChunkPos) {
+                    Generated.LastUse[i] = ++Generated.Uses;
+                    return Generated.Fields[i];
+                }
+                if (Generated.LastUse[i] < Generated.LastUse[Victim]) {
+                    Victim = i;
+                }
+            }
+
+            Clock::time_point Begin = Clock::now();
+            ChunkField& Field = Generated.Fields[Victim];
+            TerrainGenerator::Generate(GeneratorSettings, ChunkPos, Generated.Texels);
+            BuildField(Field, Generated.Texels);
+            Field.ChunkPos = ChunkPos;
+            Generated.LastUse[Victim] = ++Generated.Uses;
+
+            Counters.Generated++;
+            Counters.GenerateUs = std::chrono::duration<float, std::micro>(Clock::now() - Begin).count();
+            return Field;
+        }
+
+        bool SampleMissing(glm::vec2 WorldXZ, Missing OnMissing, float& OutHeight, glm::vec3* OutNormal) {
+            if (OnMissing == Missing::Generate && CanGenerate) {
+                glm::vec2 ChunkXZ = WorldXZ / WORLD_SIZE;
+                std::lock_guard<std::mutex> Guard(Generated.Lock);
+                FieldSample(GeneratedField(glm::ivec2(glm::floor(ChunkXZ))), ChunkXZ, OutHeight, OutNormal);
+                return true;
+            }
+
+            OutHeight = NOT_A_NUMBER;
+            if (OutNormal) {
+                *OutNormal = glm::vec3(NOT_A_NUMBER);
+            }
+            return false;
+        }
+    }
+
+    void Create(const BatchedNoise::Settings& NoiseSettings) {
+        GeneratorSettings = NoiseSettings;
+        CanGenerate = true;
+    }
+
+    void Build(uint32_t Slot, glm::ivec2 ChunkPos, const uint16_t* Texels) {
+        Clock::time_point Begin = Clock::now();
+        ChunkField& Field = Fields[Slot];
+        BuildField(Field, Texels);
+
+        if (!Field.Resident) {
+            Counters.ResidentChunks++;
+        }
+        Field.ChunkPos = ChunkPos;
+        Field.Resident = true;
+
+        Counters.Built++;
+        Counters.BuildUs = std::chrono::duration<float, std::micro>(Clock::now() - Begin).count();
+    }
+
+    void Evict(uint32_t Slot) {
+        if (Fields[Slot].Resident) {
+            Fields[Slot].Resident = false;
+            Counters.ResidentChunks--;
+        }
+    }
+
+    bool Height(glm::vec2 WorldXZ, float& OutHeight) {
+        glm::vec2 ChunkXZ = WorldXZ / WORLD_SIZE;
+        const ChunkField* Field = Find(glm::ivec2(glm::floor(ChunkXZ)));
+        if (!Field) {
+            return false;
+        }
+        FieldSample(*Field, ChunkXZ, OutHeight, nullptr);
+        return true;
+    }
+
+    uint32_t Heights(const glm::vec2* WorldXZ, float* OutHeights, uint32_t Count) {
+        return Sample(WorldXZ, Count, OutHeights, nullptr);
+    }
+
+    uint32_t Sample(const glm::vec2* WorldXZ, uint32_t Count, float* OutHeights, glm::vec3* OutNormals, Missing OnMissing) {
+        constexpr uint32_t WIDTH = 4;
+
+        // Positions tend to come in clusters, the last chunk found is tried first
+        const ChunkField* LastField = nullptr;
+        uint32_t Resolved = 0;
+        uint32_t i = 0;
+        for (; i + WIDTH <= Count; i += WIDTH) {
+            Resolved += SampleLanes(&WorldXZ[i], &OutHeights[i], OutNormals ? &OutNormals[i] : nullptr, OnMissing, LastField);
+        }
+        for (; i < Count; i++) {
+            glm::vec2 ChunkXZ = WorldXZ[i] / WORLD_SIZE;
+            const ChunkField* Field = Find(glm::ivec2(glm::floor(ChunkXZ)));
+            glm::vec3* OutNormal = OutNormals ? &OutNormals[i] : nullptr;
+            if (Field) {
+                FieldSample(*Field, ChunkXZ, OutHeights[i], OutNormal);
+                Resolved++;
+            } else {
+                Resolved += SampleMissing(WorldXZ[i], OnMissing, OutHeights[i], OutNormal);
+            }
+        }
+        return Resolved;
+    }
+
+    bool Raycast(glm::vec3 Origin, glm::vec3 Direction, float MaxDistance, Hit& Out) {
+        Ray World = MakeRay(Origin, Direction);
+
+        // Resident chunks whose box the ray crosses, in the order it enters them
+        struct Candidate {
+            const ChunkField* Field;
+            float Enter;
+        };
+        Candidate Candidates[TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT];
+        uint32_t CandidateCount = 0;
+        uint32_t Root = NodeIndex(PYRAMID_LEVELS - 1, 0, 0);
+        for (const ChunkField& Field : Fields) {
+            if (!Field.Resident) {
+                continue;
+            }
+            glm::vec3 Min = { float(Field.ChunkPos.x) * WORLD_SIZE, Field.Min[Root], float(Field.ChunkPos.y) * WORLD_SIZE };
+            glm::vec3 Max = { Min.x + WORLD_SIZE, Field.Max[Root], Min.z + WORLD_SIZE };
+            float Enter;
+            if (RayBox(World, Min, Max, MaxDistance, Enter)) {
+                Candidates[CandidateCount++] = { .Field = &Field, .Enter = Enter };
+            }
+        }
+        std::sort(Candidates, Candidates + CandidateCount, [](const Candidate& a, const Candidate& b) { return a.Enter < b.Enter; });
+
+        // Chunk boxes overlap in height only, so past the first hit's distance nothing can be closer
+        float Best = MaxDistance;
+        const ChunkField* HitField = nullptr;
+        for (uint32_t i = 0; i < CandidateCount && Candidates[i].Enter <= Best; i++) {
+            if (RayField(*Candidates[i].Field, World, Best)) {
+                HitField = Candidates[i].Field;
+            }
+        }
+        if (!HitField) {
+            return false;
+        }
+
+        Out = {
+            .Position = Origin + Direction * Best,
+            .Distance = Best,
+            .ChunkPos = HitField->ChunkPos
+        };
+        return true;
+    }
+
+    Stats GetStats() {
+        return Counters;
+    }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+// CPU side copy of the resident terrain surface, for picking, collision and gameplay rays.
+//
+// The surface is the one terrain.vert draws: a vertex per heightmap texel, its height the
+// texel itself scaled by HEIGHT_SCALE, and two triangles per quad split along the top
+// right to bottom left diagonal like PlaneMeshIndicesGenerator's.
+//
+// Every chunk also keeps a min/max pyramid of its quads, 64x64 quads (the last row and
+// column empty) down to a single node. Rays walk it front to back and only test the
+// triangles of leaves whose box they actually cross (maximum mipmap traversal). Resident
+// chunks are tried in the order the ray enters their box, the first hit is the closest.
+//
+// Slots are built as chunks get packed, from TerrainSystem::Update. Queries are fine from
+// anything ordered after it in the frame graph, like the link table.
+namespace TerrainHeightfield {
+    constexpr uint32_t RESOLUTION = TerrainConfig::Chunk::RESOLUTION;
+    constexpr uint32_t QUADS = RESOLUTION - 1;
+    // Pyramid level 0 is QUADS rounded up to a power of two, one node per quad
+    constexpr uint32_t PYRAMID_SIDE = std::bit_ceil(QUADS);
+    constexpr uint32_t PYRAMID_LEVELS = std::countr_zero(PYRAMID_SIDE) + 1;
+
+    struct Hit {
+        glm::vec3 Position;
+        float Distance;
+        glm::ivec2 ChunkPos;
+    };
+
+    struct Stats {
+        uint32_t ResidentChunks;
+        uint64_t Built;
+        // Last build, per chunk
+        float BuildUs;
+        // Chunks Sample generated itself, the last one's generation and build
+        uint64_t Generated;
+        float GenerateUs;
+    };
+
+    // What Sample does about positions over chunks that aren't resident
+    enum class Missing : uint8_t {
+        // NaN height and normal
+        Skip,
+        // Generated on the spot into a cache of GENERATED_CHUNKS of its own, costs a chunk
+        // generation per chunk, thread safe but one chunk at a time
+        Generate
+    };
+
+    // Settings the Generate fallback generates with, Generate acts like Skip until then
+    void Create(const BatchedNoise::Settings& NoiseSettings);
+
+    // Texels are the chunk's RESOLUTION^2 heightmap as it gets uploaded to Slot
+    void Build(uint32_t Slot, glm::ivec2 ChunkPos, const uint16_t* Texels);
+    // Slot is being retargeted, queries around the old chunk miss from now on
+    void Evict(uint32_t Slot);
+
+    // World height under (x, z), false when the chunk isn't resident
+    bool Height(glm::vec2 WorldXZ, float& OutHeight);
+    // Count heights at once, NaN where the chunk isn't resident. Returns how many resolved.
+    uint32_t Heights(const glm::vec2* WorldXZ, float* OutHeights, uint32_t Count);
+    // Heights and upward normals (of the drawn triangle) at Count positions, four at a
+    // time. OutNormals can be null. Returns how many resolved.
+    uint32_t Sample(const glm::vec2* WorldXZ, uint32_t Count, float* OutHeights, glm::vec3* OutNormals,
+                    Missing OnMissing = Missing::Skip);
+
+    // Closest hit within MaxDistance along Direction (normalized), false when the ray
+    // leaves the resident chunks without touching the surface
+    bool Raycast(glm::vec3 Origin, glm::vec3 Direction, float MaxDistance, Hit& Out);
+
+    Stats GetStats();
+};
@@ -1,50 +1,148 @@
 #include "TerrainSystem.hpp"
 
+#include <vector>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <imgui.h>
 
+#include "Engine/Systems/Terrain/ChunkStore.hpp"
 #include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/ChunkPipeline.hpp"
+#include "Engine/Systems/Terrain/ChunkResidency.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+#include "Engine/Systems/Terrain/TerrainHeightfield.hpp"
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
 
 namespace TerrainSystem {
+    using Clock = std::chrono::steady_clock;
 
-    uint16_t* HeightmapsBuffer_MappedMem;
-    ChunkHeightmapLink* ChunkLinksBuffer_MappedMem;
+    // The renderer's, see FeedTerrainRenderer
+    uint16_t* HeightmapMirror;
+
+    // Authoritative link table, the renderer gets a copy of it through PublishLinks
+    ChunkHeightmapLink Links[TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT];
+    bool LinksDirty = false;
 
     glm::vec3* PlayerPos;
+    const glm::mat4* CameraMVP;
+
+    // Chunk the resident diamond is centered on
+    glm::ivec2 CenterChunk;
+    // Slots packed since the renderer last uploaded
+    std::vector<uint32_t> DirtySlots;
+    uint32_t LastStreamedCount = 0;
+
+    // Chunks that entered range but weren't let in yet, at most one per slot
+    struct PendingChunk {
+        glm::ivec2 ChunkPos;
+        uint32_t Slot;
+    };
+    std::vector<PendingChunk> Backlog;
+
+    // Per frame budget, sized by ReportFrameTime
+    float BudgetUs = TerrainConfig::Streaming::INITIAL_BUDGET_US;
+    float ChunkCostUs = TerrainConfig::Streaming::INITIAL_CHUNK_COST_US;
+    uint64_t LastGenerated = 0;
+    uint64_t LastGenerationNs = 0;
+
+    struct FrameStats {
+        uint32_t Admitted = 0;
+        float ChargedUs = 0.0f;
+        // Store reads happen right on the Update task, generation on the pipeline's jobs
+        float ReadUs = 0.0f;
+        float GenerationUs = 0.0f;
+        uint64_t Generated = 0;
+    };
+    FrameStats LastFrame;
+
+    void StreamChunks(glm::ivec2 NewCenter);
+    bool CastFromCamera(TerrainHeightfield::Hit& Out);
+    void ScheduleBacklog();
+    void PackFinishedChunks();
 
-    FastNoiseLite BaseNoise;
+    // What chunks are generated with, the very same heights FastNoiseLite would give (see
+    // BatchedNoise.hpp and InferusBench's "noise" suite), just a lot faster
+    BatchedNoise::Settings BaseNoiseSettings;
 
-    void Create(glm::vec3* pPlayerPos) {
+    void Create(glm::vec3* pPlayerPos, const glm::mat4* pCameraMVP) {
         PlayerPos = pPlayerPos;
+        CameraMVP = pCameraMVP;
 
-        BaseNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-        BaseNoise.SetFractalType(FastNoiseLite::FractalType_FBm);
-        BaseNoise.SetFractalOctaves(8);
-        BaseNoise.SetFrequency(.02);
+        BaseNoiseSettings = TerrainGenerator::DefaultSettings();
+
+        // Without a store every chunk is simply generated
+        if (TerrainConfig::Store::ENABLED) {
+            ChunkStore::Create(TerrainConfig::Store::DIRECTORY, BaseNoiseSettings);
+        }
+        ChunkPipeline::Create(BaseNoiseSettings);
+        TerrainHeightfield::Create(BaseNoiseSettings);
     }
 
     void Destroy() {
-        // ...
+        // Pipeline jobs may still be writing back into the store
+        ChunkPipeline::Destroy();
+        ChunkStore::Destroy();
+    }
+
+    glm::ivec2 GetPlayerChunk() {
+        return {
+            static_cast<int32_t>(glm::floor(PlayerPos->x / TerrainConfig::Chunk::WORLD_SIZE)),
+            static_cast<int32_t>(glm::floor(PlayerPos->z / TerrainConfig::Chunk::WORLD_SIZE))
+        };
     }
 
     void Update() {
-        // TODO: Add some sort of sync system, update chunk after X seconds, after Y distance
-        // has been travelled from center...
-        // ------------------------------------------------------------------------------------
-        // The best would be always be loading and unloading chunks, what I think could be done
-        // if the Heightmap and ChunkLinks had some scratch space, given the usage of same size
-        // allocations we could just update the other ones and provide a glInstanceIndex offset
-        // on the push constants? Maybe have double or triple buffering on Heightmap and
-        // ChunkLink information? I think the last option seems better.
-        // -- Turns out all that stuff has already been figured out, so I may just pick one or
-        // a combination of them and rock with it. One could also consider do a performance
-        // comparisson and etc.
+        // Generation runs on chunk pipeline jobs, here chunks are only requested and
+        // whatever finished since last frame gets packed into staging. The renderer copies
+        // the link table through PublishLinks and stages it into the frame arena every
+        // frame, so frames in flight keep reading their own copy.
+
+        glm::ivec2 PlayerChunk = GetPlayerChunk();
+        if (PlayerChunk != CenterChunk) {
+            StreamChunks(PlayerChunk);
+        }
+        ScheduleBacklog();
+        PackFinishedChunks();
+    }
+
+    void ReportFrameTime(std::chrono::duration<double> FrameTime, std::chrono::duration<double> TargetTime) {
+        ChunkPipeline::Stats PipelineStats = ChunkPipeline::GetStats();
+        uint64_t Generated = PipelineStats.Generated - LastGenerated;
+        uint64_t GenerationNs = PipelineStats.GenerationNs - LastGenerationNs;
+        LastGenerated = PipelineStats.Generated;
+        LastGenerationNs = PipelineStats.GenerationNs;
+
+        LastFrame.Generated = Generated;
+        LastFrame.GenerationUs = float(GenerationNs) / 1000.0f;
+        if (Generated > 0) {
+            float MeasuredUs = LastFrame.GenerationUs / float(Generated);
+            ChunkCostUs += TerrainConfig::Streaming::CHUNK_COST_SMOOTHING * (MeasuredUs - ChunkCostUs);
+        }
+
+        // An idle terrain says nothing about how much it could get away with
+        if (Backlog.empty() && LastFrame.Admitted == 0 && Generated == 0) {
+            return;
+        }
+
+        // Back off hard on a long frame, grow slowly while there's headroom
+        if (FrameTime > TargetTime) {
+            BudgetUs = std::max(TerrainConfig::Streaming::MIN_BUDGET_US, BudgetUs * TerrainConfig::Streaming::BUDGET_BACKOFF);
+        } else {
+            BudgetUs = std::min(TerrainConfig::Streaming::MAX_BUDGET_US, BudgetUs + TerrainConfig::Streaming::BUDGET_STEP_US);
+        }
+    }
+
+    void UpdateUI() {
+        glm::ivec2 PlayerChunk = CenterChunk;
 
         ImGui::SetNextWindowSize(ImVec2(0.0f, 0.0f), ImGuiCond_FirstUseEver);
         ImGui::Begin("Terrain System");
 
-        uint32_t x = static_cast<uint32_t>(PlayerPos->x/TerrainConfig::Chunk::RESOLUTION);
-        uint32_t z = static_cast<uint32_t>(PlayerPos->z/TerrainConfig::Chunk::RESOLUTION);
+        int32_t x = PlayerChunk.x;
+        int32_t z = PlayerChunk.y;
 
         ImGui::TextDisabled("Current player chunk:");
         ImGui::Indent();
@@ -55,96 +153,249 @@ namespace TerrainSystem {
         ImGui::Separator();
         ImGui::Spacing();
 
-        // Clearly mocked data as of now
+        TerrainHeightfield::Hit CameraHit;
+        Clock::time_point CastBegin = Clock::now();
+        bool CameraHitFound = CastFromCamera(CameraHit);
+        float CastUs = std::chrono::duration<float, std::micro>(Clock::now() - CastBegin).count();
+
+        TerrainHeightfield::Stats HeightfieldStats = TerrainHeightfield::GetStats();
         ImGui::TextDisabled("Camera casting:");
         ImGui::Indent();
-        ImGui::Text("X: %03d Z: %03d", x, z);
+        if (CameraHitFound) {
+            ImGui::Text("X: %03d Z: %03d", CameraHit.ChunkPos.x, CameraHit.ChunkPos.y);
+            ImGui::Text("Hit: %.1f %.1f %.1f, %.1f away",
+                CameraHit.Position.x, CameraHit.Position.y, CameraHit.Position.z, CameraHit.Distance);
+        } else {
+            ImGui::Text("No terrain in range");
+        }
+        ImGui::Text("Cast: %.1f us", CastUs);
+        ImGui::Text("Heightfield: %u chunks, %.0f us last build", HeightfieldStats.ResidentChunks, HeightfieldStats.BuildUs);
+        ImGui::Text("Generated for queries: %llu, %.0f us last", (unsigned long long)HeightfieldStats.Generated, HeightfieldStats.GenerateUs);
+        ImGui::Unindent();
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        ImGui::TextDisabled("Streaming:");
+        ImGui::Indent();
+        ImGui::Text("Resident chunks: %u", TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT);
+        ImGui::Text("Last crossing: %u chunks", LastStreamedCount);
+        ImGui::Text("Backlog: %zu chunks", Backlog.size());
+        ImGui::Text("Budget: %.0f us (%.0f us per generated chunk)", BudgetUs, ChunkCostUs);
+        ImGui::Text("Let in: %u chunks, %.0f us charged", LastFrame.Admitted, LastFrame.ChargedUs);
+        ImGui::Text("Store reads: %.0f us", LastFrame.ReadUs);
+        ImGui::Text("Generation: %.0f us, %llu chunks",
+            LastFrame.GenerationUs, static_cast<unsigned long long>(LastFrame.Generated));
+        ImGui::Unindent();
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        ChunkPipeline::Stats PipelineStats = ChunkPipeline::GetStats();
+        ImGui::TextDisabled("Chunk pipeline:");
+        ImGui::Indent();
+        ImGui::Text("Job system workers: %u", PipelineStats.WorkerCount);
+        ImGui::Text("Queued: %u In flight: %u", PipelineStats.Queued, PipelineStats.InFlight);
+        ImGui::Text("Completed: %llu Cancelled: %llu",
+            static_cast<unsigned long long>(PipelineStats.Completed),
+            static_cast<unsigned long long>(PipelineStats.Cancelled));
+        ImGui::Unindent();
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        ChunkStore::Stats StoreStats = ChunkStore::GetStats();
+        ImGui::TextDisabled("Chunk store:");
+        ImGui::Indent();
+        if (ChunkStore::IsActive()) {
+            ImGui::Text("Hits: %llu Misses: %llu",
+                static_cast<unsigned long long>(StoreStats.Hits),
+                static_cast<unsigned long long>(StoreStats.Misses));
+            ImGui::Text("Written: %llu Open regions: %u",
+                static_cast<unsigned long long>(StoreStats.Writes), StoreStats.OpenRegions);
+            if (StoreStats.StoredBytes > 0) {
+                ImGui::Text("Compression: %.2fx (%.1f KB on disk)",
+                    double(StoreStats.RawBytes) / double(StoreStats.StoredBytes),
+                    double(StoreStats.StoredBytes) / 1024.0);
+            }
+        } else {
+            ImGui::Text("Disabled");
+        }
+        ImGui::Unindent();
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        ImGui::TextDisabled("Noise kernel:");
+        ImGui::Indent();
+        ImGui::Text("%s", BatchedNoise::IsaName(BatchedNoise::GetIsa()));
+        ImGui::Text("%s %s, %d octaves",
+            BatchedNoise::NoiseKindName(BaseNoiseSettings.Kind),
+            BatchedNoise::FractalKindName(BaseNoiseSettings.Fractal),
+            BaseNoiseSettings.Octaves);
         ImGui::Unindent();
 
         ImGui::End();
     }
 
-    void FeedTerrainRenderer(ChunkHeightmapLink* ChunkLinkMap, uint16_t* HeightmapMap) {
-        ChunkLinksBuffer_MappedMem = ChunkLinkMap;
-        HeightmapsBuffer_MappedMem = HeightmapMap;
-        FullWriteChunkData(); // TODO: hacky
+    void FeedTerrainRenderer(uint16_t* Mirror) {
+        HeightmapMirror = Mirror;
+        FullWriteChunkData();
     }
 
-    void WriteChunk(glm::ivec2 ChunkPos, uint16_t* ChunkBegin);
+    const std::vector<uint32_t>& GetDirtySlots() {
+        return DirtySlots;
+    }
 
-    void FullWriteChunkData() {
-        // Diamond scan the area around the player
-        glm::ivec2 player_coord;
-        player_coord.x = PlayerPos->x/TerrainConfig::Chunk::RESOLUTION;
-        player_coord.y = PlayerPos->z/TerrainConfig::Chunk::RESOLUTION;
-
-        uint32_t coords_counter = TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT - 1;    // The last array position
-        // Add the player position as it's the last chunk that should be drawn
-        ChunkLinksBuffer_MappedMem[coords_counter] = {
-            .WorldPos = player_coord,
-            .InstanceId = (uint32_t)coords_counter,
-            .IsVisible = 1
+    void ClearDirtySlots(const std::vector<uint32_t>& Uploaded) {
+        std::erase_if(DirtySlots, [&Uploaded](uint32_t Slot) {
+            return std::binary_search(Uploaded.begin(), Uploaded.end(), Slot);
+        });
+    }
+
+    bool HasPendingUpload() {
+        return LinksDirty || !DirtySlots.empty();
+    }
+
+    void PublishLinks(ChunkHeightmapLink* Dst) {
+        memcpy(Dst, Links, TerrainConfig::ChunkToHeightmapLinking::LINKING_BUFFER_SIZE);
+        LinksDirty = false;
+    }
+
+    // Retargets the chunk's toroidal slot and queues the chunk, it stays hidden until
+    // ScheduleBacklog lets it in and its texels got packed
+    void LoadChunk(glm::ivec2 ChunkPos) {
+        uint32_t Slot = ChunkResidency::Slot(ChunkPos);
+
+        Links[Slot] = {
+            .WorldPos = ChunkPos,
+            .InstanceId = Slot,
+            .IsVisible = 0
         };
-        coords_counter--;
-
-        for (uint32_t i = 0; i < TerrainConfig::ChunkToHeightmapLinking::DIAMOND_EXPLORATION_RADIUS; i++) {
-            int32_t x_pos = player_coord.x + i + 1;
-            int32_t x_neg = player_coord.x - i + 1;
-            for (uint32_t j = 0; j < (TerrainConfig::ChunkToHeightmapLinking::DIAMOND_EXPLORATION_RADIUS - i); j++) {
-                int32_t y_pos = player_coord.y + j;
-                int32_t y_neg = player_coord.y - j;
-
-                // Memory Layout: [Link3][Link2][Link1][Link0]
-                ChunkHeightmapLink* block = &ChunkLinksBuffer_MappedMem[coords_counter - 3];
-
-                // We write sequentially to the memory block (0, 1, 2, 3).
-                block[0] = {
-                    .WorldPos = { x_neg, y_pos },
-                    .InstanceId = (coords_counter - 3),
-                    .IsVisible = 1
-                };
-                block[1] = {
-                    .WorldPos = { x_pos, y_neg },
-                    .InstanceId = (coords_counter - 2),
-                    .IsVisible = 1
-                };
-                block[2] = {
-                    .WorldPos = { x_neg, y_neg },
-                    .InstanceId = (coords_counter - 1),
-                    .IsVisible = 1
-                };
-                block[3] = {
-                    .WorldPos = { x_pos, y_pos },
-                    .InstanceId = (coords_counter),
-                    .IsVisible = 1
-                };
-
-                coords_counter -= 4;
-            }
+        LinksDirty = true;
+        TerrainHeightfield::Evict(Slot);
+
+        // Whatever was pending or in flight for the slot's previous chunk is moot
+        ChunkPipeline::Cancel(Slot);
+        std::erase_if(Backlog, [Slot](const PendingChunk& Pending) { return Pending.Slot == Slot; });
+        Backlog.push_back({ .ChunkPos = ChunkPos, .Slot = Slot });
+    }
+
+    // Stored chunks are copied straight out of the store, anything else goes to the pipeline.
+    // Returns what the chunk is charged against the frame budget.
+    float AdmitChunk(const PendingChunk& Pending) {
+        uint16_t* SlotTexels = &HeightmapMirror[Pending.Slot * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT];
+
+        Clock::time_point Begin = Clock::now();
+        if (ChunkStore::Read(Pending.ChunkPos, SlotTexels)) {
+            TerrainGenerator::ChunkBounds Bounds = TerrainGenerator::Bounds(SlotTexels);
+            Links[Pending.Slot].MinHeight = Bounds.MinHeight / 65535.0f;
+            Links[Pending.Slot].MaxHeight = Bounds.MaxHeight / 65535.0f;
+            Links[Pending.Slot].IsVisible = 1;
+            LinksDirty = true;
+            DirtySlots.push_back(Pending.Slot);
+            TerrainHeightfield::Build(Pending.Slot, Pending.ChunkPos, SlotTexels);
+
+            float ReadUs = std::chrono::duration<float, std::micro>(Clock::now() - Begin).count();
+            LastFrame.ReadUs += ReadUs;
+            return ReadUs;
         }
 
-        // TODO:
-        // Kinda ugly they're on different loops and it's all in the main thread
-        for (uint16_t i = 0; i < TerrainConfig::ChunkToHeightmapLinking::INSTANCE_COUNT; i++) {
-            ChunkHeightmapLink cl = ChunkLinksBuffer_MappedMem[i];
-            WriteChunk(cl.WorldPos, &HeightmapsBuffer_MappedMem[cl.InstanceId * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT]);
+        ChunkPipeline::Request(Pending.ChunkPos, Pending.Slot);
+        return ChunkCostUs;
+    }
+
+    // Lets in the closest pending chunks until the frame budget is spent, the rest waits
+    // for the next frames. At least one chunk goes through however small the budget got.
+    void ScheduleBacklog() {
+        LastFrame.Admitted = 0;
+        LastFrame.ChargedUs = 0.0f;
+        LastFrame.ReadUs = 0.0f;
+        if (Backlog.empty()) {
+            return;
+        }
+
+        // Re-sorted every frame, the player may have moved since the chunks were queued
+        glm::ivec2 Center = CenterChunk;
+        auto Distance = [Center](glm::ivec2 ChunkPos) {
+            return std::abs(ChunkPos.x - Center.x) + std::abs(ChunkPos.y - Center.y);
+        };
+        std::sort(Backlog.begin(), Backlog.end(), [&Distance](const PendingChunk& a, const PendingChunk& b) {
+            return Distance(a.ChunkPos) < Distance(b.ChunkPos);
+        });
+
+        size_t Admitted = 0;
+        while (Admitted < Backlog.size() && (Admitted == 0 || LastFrame.ChargedUs < BudgetUs)) {
+            LastFrame.ChargedUs += AdmitChunk(Backlog[Admitted]);
+            Admitted++;
         }
+        Backlog.erase(Backlog.begin(), Backlog.begin() + Admitted);
+        LastFrame.Admitted = static_cast<uint32_t>(Admitted);
     }
 
-    void WriteChunk(glm::ivec2 ChunkPos, uint16_t* ChunkBegin) {
-        int32_t TerrainRes = TerrainConfig::Chunk::RESOLUTION;
+    void PackFinishedChunks() {
+        ChunkPipeline::Drain(TerrainConfig::Streaming::TILE_POOL_SIZE, [](const ChunkPipeline::ChunkResult& Result) {
+            memcpy(
+                &HeightmapMirror[Result.Slot * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT],
+                Result.Texels,
+                TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE
+            );
 
-        float globalX, globalZ;
-        for (int32_t x = 0; x < TerrainRes; x++) {
-            globalX = x + ((TerrainRes-1) * ChunkPos.x);
-            for (int32_t z = 0; z < TerrainRes; z++) {
-                globalZ = z + ((TerrainRes-1) * ChunkPos.y);
+            Links[Result.Slot].MinHeight = Result.MinHeight / 65535.0f;
+            Links[Result.Slot].MaxHeight = Result.MaxHeight / 65535.0f;
+            Links[Result.Slot].IsVisible = 1;
+            LinksDirty = true;
 
-                float n = BaseNoise.GetNoise(globalX, globalZ);
-                float remapped = (n + 1.0f) * 0.5f * 65535.0f;
+            DirtySlots.push_back(Result.Slot);
+            TerrainHeightfield::Build(Result.Slot, Result.ChunkPos, Result.Texels);
+        });
+    }
+
+    void FullWriteChunkData() {
+        CenterChunk = GetPlayerChunk();
+        DirtySlots.clear();
+        Backlog.clear();
+
+        uint32_t Requested = 0;
+        ChunkResidency::ForEachInRange(CenterChunk, [&Requested](glm::ivec2 ChunkPos) {
+            LoadChunk(ChunkPos);
+            Requested++;
+        });
+        LastStreamedCount = Requested;
+    }
 
-                *ChunkBegin++ = static_cast<uint16_t>(remapped);
+    void StreamChunks(glm::ivec2 NewCenter) {
+        // Only the chunks entering the diamond need work, each one lands on the slot of a
+        // chunk that's leaving, so nothing has to be explicitly evicted. Queuing the slot
+        // also cancels whatever was still pending for the chunk that left.
+        uint32_t Requested = 0;
+        glm::ivec2 OldCenter = CenterChunk;
+
+        ChunkResidency::ForEachInRange(NewCenter, [OldCenter, &Requested](glm::ivec2 ChunkPos) {
+            if (!ChunkResidency::InRange(OldCenter, ChunkPos)) {
+                LoadChunk(ChunkPos);
+                Requested++;
             }
+        });
+
+        CenterChunk = NewCenter;
+        LastStreamedCount = Requested;
+    }
+
+    // Through the middle of the screen, the camera's MVP unprojected at both depth ends
+    bool CastFromCamera(TerrainHeightfield::Hit& Out) {
+        glm::mat4 InverseMVP = glm::inverse(*CameraMVP);
+        glm::vec4 Near = InverseMVP * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glm::vec4 Far = InverseMVP * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        if (Near.w == 0.0f || Far.w == 0.0f) {
+            return false;
         }
+
+        glm::vec3 Direction = glm::normalize(glm::vec3(Far) / Far.w - glm::vec3(Near) / Near.w);
+        return TerrainHeightfield::Raycast(*PlayerPos, Direction, TerrainConfig::Heightfield::CAMERA_CAST_DISTANCE, Out);
     }
 }
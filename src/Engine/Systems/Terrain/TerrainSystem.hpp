@@ -1,18 +1,40 @@
 #pragma once
 
+#include <chrono>
+#include <vector>
 #include <cstdint>
 
 #include <glm/glm.hpp>
-#include <FastNoiseLite.hpp>
 
 #include "Engine/Systems/Terrain/TerrainTypes.hpp"
 
 namespace TerrainSystem {
-    void Create(glm::vec3* PlayerPos);
+    // CameraMVP is what the camera writes its matrix to, camera casting unprojects it
+    void Create(glm::vec3* PlayerPos, const glm::mat4* CameraMVP);
     void Destroy();
 
+    // Streaming and packing, no ImGui/GLFW so it can run on any job system thread
     void Update();
+    // Main thread
+    void UpdateUI();
 
-    void FeedTerrainRenderer(ChunkHeightmapLink* ChunkLinkMap, uint16_t* HeightmapMap);
+    // After the frame ran, sizes the next frames' chunk budget from how long this one took
+    void ReportFrameTime(std::chrono::duration<double> FrameTime, std::chrono::duration<double> TargetTime);
+
+    glm::ivec2 GetPlayerChunk();
+
+    // Mirror is TerrainRenderer::HeightmapMirror, every layer on the CPU. Finished chunks
+    // are packed into their slot there and uploads stage out of it.
+    void FeedTerrainRenderer(uint16_t* Mirror);
     void FullWriteChunkData();
+
+    // Heightmap layers packed and not uploaded yet, the renderer uploads just those
+    const std::vector<uint32_t>& GetDirtySlots();
+    // Uploaded is sorted, whatever the renderer held back stays dirty
+    void ClearDirtySlots(const std::vector<uint32_t>& Uploaded);
+
+    // True when there are packed layers or link changes the renderer hasn't picked up yet
+    bool HasPendingUpload();
+    // Copies the current link table into Dst (one of the renderer's link regions)
+    void PublishLinks(ChunkHeightmapLink* Dst);
 };
@@ -7,5 +7,24 @@
 struct ChunkHeightmapLink {
     glm::ivec2 WorldPos;
     uint32_t InstanceId;
-    uint16_t IsVisible;
+    // 32 bits to match the std430 uint on terrain.vert, no padding bytes left for it to read
+    uint32_t IsVisible;
+    // Normalized height range of the chunk's texels, what culling builds the box from
+    float MinHeight;
+    float MaxHeight;
+    // Keeps the std430 stride at 32, the frame arena alignment stays a multiple of it
+    uint32_t Padding[2];
 };
+static_assert(sizeof(ChunkHeightmapLink) == 32);
+
+// One CDLOD quadtree node, drawn with the shared patch mesh (or a quarter of it). Matches
+// terrain_cdlod.vert.
+struct TerrainLodNode {
+    // Into the links staged for the frame
+    uint32_t Link;
+    uint32_t Lod;
+    // Min corner in the chunk's heightmap uv
+    float OriginU;
+    float OriginV;
+};
+static_assert(sizeof(TerrainLodNode) == 16);
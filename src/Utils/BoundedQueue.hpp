@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free bounded MPMC queue (Dmitry Vyukov's design). Every cell carries a sequence
+// number telling producers and consumers whose turn it is, so neither side ever takes a
+// lock and a full/empty queue is reported instead of waited on.
+template <typename T, size_t Capacity>
+class BoundedQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<size_t> Sequence;
+        T Data;
+    };
+
+    static constexpr size_t MASK = Capacity - 1;
+
+    alignas(64) std::array<Cell, Capacity> Cells;
+    alignas(64) std::atomic<size_t> EnqueuePos;
+    alignas(64) std::atomic<size_t> DequeuePos;
+
+public:
+    BoundedQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            Cells[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+        EnqueuePos.store(0, std::memory_order_relaxed);
+        DequeuePos.store(0, std::memory_order_relaxed);
+    }
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool TryPush(const T& Value) {
+        Cell* Target;
+        size_t Pos = EnqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Target = &Cells[Pos & MASK];
+            size_t Sequence = Target->Sequence.load(std::memory_order_acquire);
+            intptr_t Diff = static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Pos);
+            if (Diff == 0) {
+                if (EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (Diff < 0) {
+                return false;   // Full
+            } else {
+                Pos = EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        Target->Data = Value;
+        Target->Sequence.store(Pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& Out) {
+        Cell* Target;
+        size_t Pos = DequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Target = &Cells[Pos & MASK];
+            size_t Sequence = Target->Sequence.load(std::memory_order_acquire);
+            intptr_t Diff = static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Pos + 1);
+            if (Diff == 0) {
+                if (DequeuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (Diff < 0) {
+                return false;   // Empty
+            } else {
+                Pos = DequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        Out = Target->Data;
+        Target->Sequence.store(Pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    // Only a hint while producers/consumers are running
+    size_t SizeApprox() const {
+        size_t Enqueued = EnqueuePos.load(std::memory_order_relaxed);
+        size_t Dequeued = DequeuePos.load(std::memory_order_relaxed);
+        return Enqueued > Dequeued ? Enqueued - Dequeued : 0;
+    }
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Hash {
+    constexpr uint64_t FNV1A_OFFSET = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV1A_PRIME = 0x100000001b3ull;
+
+    // Not cryptographic, just stable across runs/machines for stamping and comparing data
+    static inline uint64_t Fnv1a(const void* Data, size_t Size, uint64_t Seed = FNV1A_OFFSET) {
+        const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+        uint64_t Hash = Seed;
+        for (size_t i = 0; i < Size; i++) {
+            Hash ^= Bytes[i];
+            Hash *= FNV1A_PRIME;
+        }
+        return Hash;
+    }
+
+    // Hashes the value's bytes. Pointers would hash the address (and win overload resolution
+    // over the buffer version above), so they're kept out.
+    template <typename T> requires (!std::is_pointer_v<T>)
+    static inline uint64_t Fnv1a(const T& Value, uint64_t Seed = FNV1A_OFFSET) {
+        return Fnv1a(&Value, sizeof(T), Seed);
+    }
+}
@@ -14,7 +14,7 @@ namespace IO {
         }
 
         ShaderSize = (uint32_t)File.tellg();
-        Buffer.reserve(ShaderSize);
+        Buffer.resize(ShaderSize);
 
         File.seekg(0);
         File.read(Buffer.data(), ShaderSize);
@@ -0,0 +1,134 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& Path, size_t Size) {
+    Close();
+
+    HANDLE File = CreateFileA(Path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (File == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER CurrentSize;
+    if (!GetFileSizeEx(File, &CurrentSize)) {
+        CloseHandle(File);
+        return false;
+    }
+    if (static_cast<size_t>(CurrentSize.QuadPart) < Size) {
+        LARGE_INTEGER NewSize;
+        NewSize.QuadPart = static_cast<LONGLONG>(Size);
+        if (!SetFilePointerEx(File, NewSize, nullptr, FILE_BEGIN) || !SetEndOfFile(File)) {
+            CloseHandle(File);
+            return false;
+        }
+    }
+
+    HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (!Mapping) {
+        CloseHandle(File);
+        return false;
+    }
+
+    void* View = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size);
+    if (!View) {
+        CloseHandle(Mapping);
+        CloseHandle(File);
+        return false;
+    }
+
+    FileHandle = File;
+    MappingHandle = Mapping;
+    Mapped = static_cast<uint8_t*>(View);
+    MappedSize = Size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (Mapped) {
+        FlushViewOfFile(Mapped, 0);
+        UnmapViewOfFile(Mapped);
+    }
+    if (MappingHandle) { CloseHandle(MappingHandle); }
+    if (FileHandle) { CloseHandle(FileHandle); }
+
+    Mapped = nullptr;
+    MappedSize = 0;
+    MappingHandle = nullptr;
+    FileHandle = nullptr;
+}
+
+void MappedFile::Flush() {
+    if (Mapped) {
+        FlushViewOfFile(Mapped, 0);
+    }
+}
+
+#else
+
+bool MappedFile::Open(const std::string& Path, size_t Size) {
+    Close();
+
+    int Fd = open(Path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (Fd < 0) {
+        return false;
+    }
+
+    struct stat Info;
+    if (fstat(Fd, &Info) != 0) {
+        close(Fd);
+        return false;
+    }
+    // ftruncate leaves a hole, untouched chunks cost no disk space
+    if (static_cast<size_t>(Info.st_size) < Size && ftruncate(Fd, static_cast<off_t>(Size)) != 0) {
+        close(Fd);
+        return false;
+    }
+
+    void* View = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+    if (View == MAP_FAILED) {
+        close(Fd);
+        return false;
+    }
+
+    FileDescriptor = Fd;
+    Mapped = static_cast<uint8_t*>(View);
+    MappedSize = Size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (Mapped) {
+        munmap(Mapped, MappedSize);
+    }
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+    }
+
+    Mapped = nullptr;
+    MappedSize = 0;
+    FileDescriptor = -1;
+}
+
+void MappedFile::Flush() {
+    if (Mapped) {
+        msync(Mapped, MappedSize, MS_ASYNC);
+    }
+}
+
+#endif
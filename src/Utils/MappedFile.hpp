@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read/write shared mapping of a whole file, grown to the requested size on open. Writes land
+// in the page cache and the OS flushes them on its own, Flush only forces it.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Creates the file if missing, files smaller than Size are grown (sparse where supported)
+    bool Open(const std::string& Path, size_t Size);
+    void Close();
+    void Flush();
+
+    bool IsOpen() const { return Mapped != nullptr; }
+    uint8_t* Data() const { return Mapped; }
+    size_t Size() const { return MappedSize; }
+
+private:
+    uint8_t* Mapped = nullptr;
+    size_t MappedSize = 0;
+
+#ifdef _WIN32
+    void* FileHandle = nullptr;
+    void* MappingHandle = nullptr;
+#else
+    int FileDescriptor = -1;
+#endif
+};
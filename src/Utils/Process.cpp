@@ -0,0 +1,115 @@
+#include "Process.hpp"
+
+#include <cerrno>
+#include <filesystem>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <spawn.h>
+    #include <unistd.h>
+    #include <sys/wait.h>
+
+    extern char** environ;
+#endif
+
+namespace Process {
+#ifdef _WIN32
+    // CommandLineToArgvW rules, quote everything and escape what precedes quotes
+    std::string QuoteArg(const std::string& Arg) {
+        std::string Quoted = "\"";
+        size_t Backslashes = 0;
+        for (char Char : Arg) {
+            if (Char == '\\') {
+                Backslashes++;
+                continue;
+            }
+            if (Char == '"') {
+                Quoted.append(Backslashes * 2 + 1, '\\');
+            } else {
+                Quoted.append(Backslashes, '\\');
+            }
+            Backslashes = 0;
+            Quoted += Char;
+        }
+        Quoted.append(Backslashes * 2, '\\');
+        return Quoted + "\"";
+    }
+
+    bool Spawn(const std::vector<std::string>& Args, Child& Out) {
+        std::string CommandLine;
+        for (const std::string& Arg : Args) {
+            CommandLine += (CommandLine.empty() ? "" : " ") + QuoteArg(Arg);
+        }
+
+        STARTUPINFOA StartupInfo = { .cb = sizeof(STARTUPINFOA) };
+        PROCESS_INFORMATION Info = {};
+        if (!CreateProcessA(Args[0].c_str(), CommandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &StartupInfo, &Info)) {
+            return false;
+        }
+
+        CloseHandle(Info.hThread);
+        Out.Handle = Info.hProcess;
+        return true;
+    }
+
+    int Wait(Child& Target) {
+        if (!Target.Handle) {
+            return -1;
+        }
+
+        WaitForSingleObject(Target.Handle, INFINITE);
+        DWORD ExitCode = 0;
+        bool Known = GetExitCodeProcess(Target.Handle, &ExitCode);
+        CloseHandle(Target.Handle);
+        Target.Handle = nullptr;
+        return Known ? static_cast<int>(ExitCode) : -1;
+    }
+
+    std::string ExecutablePath(const char* Fallback) {
+        char Path[MAX_PATH];
+        DWORD Length = GetModuleFileNameA(nullptr, Path, MAX_PATH);
+        return Length > 0 && Length < MAX_PATH ? std::string(Path, Length) : std::string(Fallback);
+    }
+#else
+    bool Spawn(const std::vector<std::string>& Args, Child& Out) {
+        std::vector<char*> Argv;
+        for (const std::string& Arg : Args) {
+            Argv.push_back(const_cast<char*>(Arg.c_str()));
+        }
+        Argv.push_back(nullptr);
+
+        pid_t Pid;
+        if (posix_spawn(&Pid, Args[0].c_str(), nullptr, nullptr, Argv.data(), environ) != 0) {
+            return false;
+        }
+        Out.Pid = Pid;
+        return true;
+    }
+
+    int Wait(Child& Target) {
+        if (Target.Pid < 0) {
+            return -1;
+        }
+
+        int Status = 0;
+        while (waitpid(Target.Pid, &Status, 0) < 0) {
+            if (errno != EINTR) {
+                Target.Pid = -1;
+                return -1;
+            }
+        }
+        Target.Pid = -1;
+        return WIFEXITED(Status) ? WEXITSTATUS(Status) : -1;
+    }
+
+    std::string ExecutablePath(const char* Fallback) {
+        // Linux only, elsewhere argv[0] has to do
+        std::error_code Error;
+        std::filesystem::path Self = std::filesystem::read_symlink("/proc/self/exe", Error);
+        return Error ? std::string(Fallback) : Self.string();
+    }
+#endif
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Just enough child process handling for tools that fan work out to copies of themselves
+namespace Process {
+    struct Child {
+#ifdef _WIN32
+        void* Handle = nullptr;
+#else
+        int Pid = -1;
+#endif
+    };
+
+    // Args[0] is the executable, false if it couldn't be started
+    bool Spawn(const std::vector<std::string>& Args, Child& Out);
+    // Blocks until Target exits, returns its exit code or -1 if it was killed
+    int Wait(Child& Target);
+
+    // Path of the running executable, Fallback (usually argv[0]) if the OS won't tell
+    std::string ExecutablePath(const char* Fallback);
+};
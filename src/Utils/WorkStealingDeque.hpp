@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed capacity Chase-Lev deque (the C11 formulation from Lê et al.). The owning thread
+// pushes and pops at the bottom like a stack, any other thread may steal from the top.
+// T has to be trivially copyable, it's stored in atomics.
+template <typename T, size_t Capacity>
+class WorkStealingDeque {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    static constexpr int64_t MASK = Capacity - 1;
+
+    alignas(64) std::atomic<int64_t> Top = 0;
+    alignas(64) std::atomic<int64_t> Bottom = 0;
+    alignas(64) std::array<std::atomic<T>, Capacity> Buffer;
+
+public:
+    WorkStealingDeque() = default;
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only
+    bool Push(T Value) {
+        int64_t b = Bottom.load(std::memory_order_relaxed);
+        int64_t t = Top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(Capacity)) {
+            return false;   // Full
+        }
+        Buffer[b & MASK].store(Value, std::memory_order_relaxed);
+        // Release store rather than fence + relaxed, same guarantee and sanitizers follow it
+        Bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only
+    bool Pop(T& Out) {
+        int64_t b = Bottom.load(std::memory_order_relaxed) - 1;
+        Bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = Top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            Bottom.store(b + 1, std::memory_order_relaxed);
+            return false;   // Empty
+        }
+
+        Out = Buffer[b & MASK].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last element, race the thieves for it
+            bool Won = Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            Bottom.store(b + 1, std::memory_order_relaxed);
+            return Won;
+        }
+        return true;
+    }
+
+    // Any thread
+    bool Steal(T& Out) {
+        int64_t t = Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = Bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;   // Empty
+        }
+
+        T Value = Buffer[t & MASK].load(std::memory_order_relaxed);
+        if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;   // Lost the race, caller may retry
+        }
+        Out = Value;
+        return true;
+    }
+
+    // Only a hint while the owner/thieves are running
+    size_t SizeApprox() const {
+        int64_t b = Bottom.load(std::memory_order_relaxed);
+        int64_t t = Top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+};
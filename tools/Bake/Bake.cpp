@@ -0,0 +1,167 @@
+#include "Bake.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/Hash.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Systems/Terrain/ChunkStore.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+
+namespace Bake {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int32_t REGION_SIZE = TerrainConfig::Store::REGION_SIZE;
+    // Chunks per job, a region row
+    constexpr size_t JOB_CHUNKS = REGION_SIZE;
+
+    int32_t FloorDiv(int32_t Value, int32_t Divisor) {
+        return Value >= 0 ? Value / Divisor : (Value - Divisor + 1) / Divisor;
+    }
+
+    std::vector<glm::ivec2> ShardRegions(const Options& Bake, uint32_t ShardIndex, uint32_t ShardCount) {
+        glm::ivec2 First = { FloorDiv(Bake.Min.x, REGION_SIZE), FloorDiv(Bake.Min.y, REGION_SIZE) };
+        glm::ivec2 Last = { FloorDiv(Bake.Max.x - 1, REGION_SIZE), FloorDiv(Bake.Max.y - 1, REGION_SIZE) };
+
+        std::vector<glm::ivec2> Regions;
+        uint32_t Index = 0;
+        for (int32_t z = First.y; z <= Last.y; z++) {
+            for (int32_t x = First.x; x <= Last.x; x++) {
+                if (Index++ % ShardCount == ShardIndex) {
+                    Regions.push_back({ x, z });
+                }
+            }
+        }
+        return Regions;
+    }
+
+    std::vector<ChunkRecord> ChunksOf(const Options& Bake, const std::vector<glm::ivec2>& Regions) {
+        std::vector<ChunkRecord> Chunks;
+        for (glm::ivec2 Region : Regions) {
+            int32_t BeginX = std::max(Bake.Min.x, Region.x * REGION_SIZE);
+            int32_t EndX = std::min(Bake.Max.x, (Region.x + 1) * REGION_SIZE);
+            int32_t BeginZ = std::max(Bake.Min.y, Region.y * REGION_SIZE);
+            int32_t EndZ = std::min(Bake.Max.y, (Region.y + 1) * REGION_SIZE);
+
+            for (int32_t z = BeginZ; z < EndZ; z++) {
+                for (int32_t x = BeginX; x < EndX; x++) {
+                    Chunks.push_back({ .ChunkPos = { x, z }, .Hash = 0 });
+                }
+            }
+        }
+        return Chunks;
+    }
+
+    uint64_t ContentHash(const uint16_t* Texels) {
+        return Hash::Fnv1a(Texels, TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE);
+    }
+
+    void ParallelFor(size_t Count, const std::function<void(size_t Begin, size_t End)>& Fn) {
+        JobSystem::Counter Done;
+        for (size_t Begin = 0; Begin < Count; Begin += JOB_CHUNKS) {
+            size_t End = std::min(Begin + JOB_CHUNKS, Count);
+            JobSystem::Run([&Fn, Begin, End] { Fn(Begin, End); }, &Done);
+        }
+        JobSystem::WaitFor(Done);
+    }
+
+    void StartJobSystem(uint32_t Threads) {
+        // The main thread helps through WaitFor, so one less worker than threads asked for (never none)
+        JobSystem::Create(Threads > 1 ? Threads - 1 : Threads);
+    }
+
+    int RunBake(const Options& Bake) {
+        const bool Sharded = Bake.Run == Mode::Shard;
+
+        std::vector<ChunkRecord> Chunks;
+        if (Sharded && ReadShardManifest(Bake, Bake.ShardIndex, Chunks)) {
+            spdlog::info("Shard {} of {} is already baked", Bake.ShardIndex, Bake.ShardCount);
+            return 0;
+        }
+
+        if (ChunkStore::Create(Bake.Directory, Bake.Noise) != InferusResult::SUCCESS) {
+            return 1;
+        }
+        StartJobSystem(Bake.Threads);
+
+        Chunks = Sharded
+            ? ChunksOf(Bake, ShardRegions(Bake, Bake.ShardIndex, Bake.ShardCount))
+            : ChunksOf(Bake, ShardRegions(Bake, 0, 1));
+
+        if (Sharded) {
+            spdlog::info("Baking shard {} of {}, {} chunks into {} ({} threads)",
+                Bake.ShardIndex, Bake.ShardCount, Chunks.size(), Bake.Directory, JobSystem::GetWorkerCount() + 1);
+        } else {
+            spdlog::info("Baking {} chunks x [{}, {}) z [{}, {}) into {} ({} {}, seed {}, {} octaves, {} threads)",
+                Chunks.size(), Bake.Min.x, Bake.Max.x, Bake.Min.y, Bake.Max.y, Bake.Directory,
+                BatchedNoise::NoiseKindName(Bake.Noise.Kind), BatchedNoise::FractalKindName(Bake.Noise.Fractal),
+                Bake.Noise.Seed, Bake.Noise.Octaves, JobSystem::GetWorkerCount() + 1);
+        }
+
+        std::atomic<uint64_t> Generated = 0;
+        std::atomic<uint64_t> Reused = 0;
+        std::atomic<uint64_t> Failed = 0;
+
+        Clock::time_point Begin = Clock::now();
+        ParallelFor(Chunks.size(), [&](size_t First, size_t End) {
+            thread_local std::array<uint16_t, TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT> Texels;
+
+            for (size_t i = First; i < End; i++) {
+                ChunkRecord& Chunk = Chunks[i];
+
+                // Left over from an interrupted run, hashed from what's actually stored
+                if (ChunkStore::Read(Chunk.ChunkPos, Texels.data())) {
+                    Chunk.Hash = ContentHash(Texels.data());
+                    Reused.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                TerrainGenerator::Generate(Bake.Noise, Chunk.ChunkPos, Texels.data());
+                ChunkStore::Write(Chunk.ChunkPos, Texels.data());
+                Chunk.Hash = ContentHash(Texels.data());
+
+                if (!ChunkStore::Contains(Chunk.ChunkPos)) {
+                    Failed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                Generated.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        double Seconds = std::chrono::duration<double>(Clock::now() - Begin).count();
+
+        std::vector<JobSystem::ThreadActivity> Activity = JobSystem::GetThreadActivity();
+        JobSystem::Destroy();
+
+        // Flushed before any manifest vouches for the chunks
+        ChunkStore::Stats StoreStats = ChunkStore::GetStats();
+        ChunkStore::Destroy();
+
+        uint64_t BusyNs = 0;
+        for (const JobSystem::ThreadActivity& Thread : Activity) {
+            BusyNs += Thread.BusyNs;
+        }
+
+        double RawMB = double(StoreStats.RawBytes) / (1024.0 * 1024.0);
+        double StoredMB = double(StoreStats.StoredBytes) / (1024.0 * 1024.0);
+        spdlog::info("Generated {} chunks, {} already baked, in {:.2f}s", Generated.load(), Reused.load(), Seconds);
+        spdlog::info("Throughput: {:.1f} chunks/s, {:.1f} MB/s raw, {:.1f} MB/s stored ({:.2f}x)",
+            Generated.load() / Seconds, RawMB / Seconds, StoredMB / Seconds,
+            StoredMB > 0.0 ? RawMB / StoredMB : 0.0);
+        spdlog::info("Busy cores: {:.2f} of {}", double(BusyNs) / 1e9 / Seconds, Activity.size());
+
+        if (Failed.load() > 0) {
+            spdlog::error("{} chunks couldn't be stored", Failed.load());
+            return 1;
+        }
+
+        if (Sharded && !WriteShardManifest(Bake, Bake.ShardIndex, Chunks)) {
+            return 1;
+        }
+        return 0;
+    }
+};
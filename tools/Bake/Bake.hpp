@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+// InferusBake, headless world baking into a chunk store directory.
+//
+// A bake covers a rectangle of chunks (x1 and z1 excluded). Sharded bakes split it by
+// region, shard i of n owns every n-th region overlapping the rectangle (row major from
+// i), so shards never share a region file and the split only depends on the rectangle
+// and n. Every finished shard leaves a manifest with the content hash of each of its
+// chunks, the merge step checks the shards cover the rectangle exactly and that every
+// stored chunk still hashes to what its shard recorded.
+//
+// Chunks already in the store are never regenerated, so a killed bake or shard restarts
+// from where it stopped and a shard with a valid manifest is skipped altogether.
+namespace Bake {
+    enum class Mode {
+        Single,     // Whole rectangle, one process, no manifest
+        Shard,      // One shard, writes its manifest
+        Driver,     // Spawns a process per shard then merges
+        Merge       // Checks the shard manifests and writes the world manifest
+    };
+
+    struct Options {
+        Mode Run = Mode::Single;
+        std::string Directory;
+        glm::ivec2 Min = { 0, 0 };
+        glm::ivec2 Max = { 0, 0 };
+        BatchedNoise::Settings Noise;
+        // Per process, 0 uses every core
+        uint32_t Threads = 0;
+        uint32_t ShardIndex = 0;
+        uint32_t ShardCount = 1;
+    };
+
+    struct ChunkRecord {
+        glm::ivec2 ChunkPos;
+        uint64_t Hash;
+    };
+
+    // Regions overlapping the rectangle that belong to the shard, Single bakes get all of them
+    std::vector<glm::ivec2> ShardRegions(const Options& Bake, uint32_t ShardIndex, uint32_t ShardCount);
+    // Chunks of the rectangle inside Regions, region by region, row major within each
+    std::vector<ChunkRecord> ChunksOf(const Options& Bake, const std::vector<glm::ivec2>& Regions);
+
+    uint64_t ContentHash(const uint16_t* Texels);
+
+    // Threads counts the main thread, which helps out while waiting
+    void StartJobSystem(uint32_t Threads);
+    // [0, Count) in region row sized jobs, returns when all of them ran
+    void ParallelFor(size_t Count, const std::function<void(size_t Begin, size_t End)>& Fn);
+
+    std::string ShardManifestPath(const Options& Bake, uint32_t ShardIndex);
+    // Written to a temporary then renamed, a manifest on disk is always complete
+    bool WriteShardManifest(const Options& Bake, uint32_t ShardIndex, const std::vector<ChunkRecord>& Chunks);
+    // False if missing, incomplete or made for another bake (rectangle, noise, shard count)
+    bool ReadShardManifest(const Options& Bake, uint32_t ShardIndex, std::vector<ChunkRecord>& Out);
+
+    // Exit codes for main
+    int RunBake(const Options& Bake);
+    int RunDriver(const Options& Bake, const char* Argv0);
+    int RunMerge(const Options& Bake);
+};
@@ -0,0 +1,83 @@
+#include "Bake.hpp"
+
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/Process.hpp"
+
+namespace Bake {
+    // A shard whose process died is restarted this many times before the bake gives up
+    constexpr uint32_t MAX_SHARD_ATTEMPTS = 3;
+
+    std::vector<std::string> ShardArgs(const Options& Bake, const std::string& Executable, uint32_t Shard, uint32_t Threads) {
+        // {} formats floats shortest round trip, children get the exact same noise
+        return {
+            Executable,
+            "--shard", std::to_string(Shard),
+            "--shards", std::to_string(Bake.ShardCount),
+            "--out", Bake.Directory,
+            "--rect", std::to_string(Bake.Min.x), std::to_string(Bake.Min.y), std::to_string(Bake.Max.x), std::to_string(Bake.Max.y),
+            "--seed", std::to_string(Bake.Noise.Seed),
+            "--frequency", fmt::format("{}", Bake.Noise.Frequency),
+            "--octaves", std::to_string(Bake.Noise.Octaves),
+            "--lacunarity", fmt::format("{}", Bake.Noise.Lacunarity),
+            "--gain", fmt::format("{}", Bake.Noise.Gain),
+            "--noise", BatchedNoise::NoiseKindName(Bake.Noise.Kind),
+            "--fractal", BatchedNoise::FractalKindName(Bake.Noise.Fractal),
+            "--threads", std::to_string(Threads)
+        };
+    }
+
+    int RunDriver(const Options& Bake, const char* Argv0) {
+        std::string Executable = Process::ExecutablePath(Argv0);
+
+        // Cores are split between the shard processes unless told otherwise
+        uint32_t Threads = Bake.Threads;
+        if (Threads == 0) {
+            Threads = std::max(1u, std::thread::hardware_concurrency() / Bake.ShardCount);
+        }
+
+        std::vector<uint32_t> Pending;
+        for (uint32_t Shard = 0; Shard < Bake.ShardCount; Shard++) {
+            Pending.push_back(Shard);
+        }
+
+        spdlog::info("Driving {} shard processes, {} threads each", Bake.ShardCount, Threads);
+
+        for (uint32_t Attempt = 1; Attempt <= MAX_SHARD_ATTEMPTS && !Pending.empty(); Attempt++) {
+            std::vector<std::pair<uint32_t, Process::Child>> Running;
+            std::vector<uint32_t> Failed;
+
+            for (uint32_t Shard : Pending) {
+                Process::Child Worker;
+                if (Process::Spawn(ShardArgs(Bake, Executable, Shard, Threads), Worker)) {
+                    Running.emplace_back(Shard, Worker);
+                } else {
+                    spdlog::error("Couldn't start {} for shard {}", Executable, Shard);
+                    Failed.push_back(Shard);
+                }
+            }
+
+            // Each shard only redoes its own chunks, whatever it stored before dying is kept
+            for (auto& [Shard, Worker] : Running) {
+                int ExitCode = Process::Wait(Worker);
+                if (ExitCode != 0) {
+                    spdlog::warn("Shard {} failed (exit code {}), attempt {} of {}", Shard, ExitCode, Attempt, MAX_SHARD_ATTEMPTS);
+                    Failed.push_back(Shard);
+                }
+            }
+
+            Pending = std::move(Failed);
+        }
+
+        if (!Pending.empty()) {
+            spdlog::error("{} shards never finished", Pending.size());
+            return 1;
+        }
+
+        return RunMerge(Bake);
+    }
+};
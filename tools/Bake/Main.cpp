@@ -0,0 +1,183 @@
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "Bake.hpp"
+#include "Engine/Types.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+
+//  InferusBake --out <dir> --rect <x0> <z0> <x1> <z1> [noise options] [--threads <n>]
+//      Whole rectangle in this process
+//  InferusBake ... --processes <n>
+//      Spawns a process per shard, restarts the ones that die, then merges
+//  InferusBake ... --shard <i> --shards <n>
+//      Shard i only, to spread a bake over machines sharing the output directory
+//  InferusBake ... --merge --shards <n>
+//      Checks the shard manifests against the store and writes world.manifest
+namespace Bake {
+    void PrintUsage() {
+        spdlog::info("Usage: InferusBake --out <dir> --rect <x0> <z0> <x1> <z1> [options]");
+        spdlog::info("  --seed <int>          default {}", TerrainConfig::Noise::SEED);
+        spdlog::info("  --frequency <float>   default {}", TerrainConfig::Noise::FREQUENCY);
+        spdlog::info("  --octaves <int>       default {}", TerrainConfig::Noise::OCTAVES);
+        spdlog::info("  --lacunarity <float>  default {}", TerrainConfig::Noise::LACUNARITY);
+        spdlog::info("  --gain <float>        default {}", TerrainConfig::Noise::GAIN);
+        spdlog::info("  --noise <kind>        OpenSimplex2 (default), Perlin or Value");
+        spdlog::info("  --fractal <kind>      None, FBm (default) or Ridged");
+        spdlog::info("  --threads <int>       per process, default every core");
+        spdlog::info("  --processes <int>     shard over that many local processes");
+        spdlog::info("  --shard <int>         bake one shard of --shards");
+        spdlog::info("  --shards <int>        shard count for --shard and --merge");
+        spdlog::info("  --merge               verify the shards and write world.manifest");
+    }
+
+    bool ParseInt(const char* Text, int32_t& Out) {
+        char* End;
+        long Value = strtol(Text, &End, 10);
+        Out = static_cast<int32_t>(Value);
+        return *Text != '\0' && *End == '\0';
+    }
+
+    bool ParseFloat(const char* Text, float& Out) {
+        char* End;
+        Out = strtof(Text, &End);
+        return *Text != '\0' && *End == '\0';
+    }
+
+    bool EqualsIgnoreCase(const char* a, const char* b) {
+        for (; *a != '\0' && *b != '\0'; a++, b++) {
+            if (tolower(static_cast<unsigned char>(*a)) != tolower(static_cast<unsigned char>(*b))) {
+                return false;
+            }
+        }
+        return *a == *b;
+    }
+
+    // Case insensitive match against the names BatchedNoise prints
+    template <typename Kind, typename NameFn>
+    bool ParseKind(const char* Text, Kind Count, NameFn Name, Kind& Out) {
+        for (uint8_t i = 0; i < static_cast<uint8_t>(Count); i++) {
+            if (EqualsIgnoreCase(Text, Name(static_cast<Kind>(i)))) {
+                Out = static_cast<Kind>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    InferusResult ParseOptions(int argc, char** argv, Options& Out) {
+        bool HasRect = false;
+        bool Merge = false;
+        int32_t Shard = -1;
+        int32_t Shards = 0;
+        int32_t Processes = 0;
+        Out.Noise = TerrainGenerator::DefaultSettings();
+
+        for (int i = 1; i < argc; i++) {
+            const char* Arg = argv[i];
+            int Left = argc - i - 1;
+            bool Valid = true;
+
+            if (strcmp(Arg, "--out") == 0 && Left >= 1) {
+                Out.Directory = argv[++i];
+            } else if (strcmp(Arg, "--rect") == 0 && Left >= 4) {
+                Valid = ParseInt(argv[i + 1], Out.Min.x) && ParseInt(argv[i + 2], Out.Min.y)
+                     && ParseInt(argv[i + 3], Out.Max.x) && ParseInt(argv[i + 4], Out.Max.y);
+                HasRect = true;
+                i += 4;
+            } else if (strcmp(Arg, "--seed") == 0 && Left >= 1) {
+                Valid = ParseInt(argv[++i], Out.Noise.Seed);
+            } else if (strcmp(Arg, "--frequency") == 0 && Left >= 1) {
+                Valid = ParseFloat(argv[++i], Out.Noise.Frequency);
+            } else if (strcmp(Arg, "--octaves") == 0 && Left >= 1) {
+                Valid = ParseInt(argv[++i], Out.Noise.Octaves);
+            } else if (strcmp(Arg, "--lacunarity") == 0 && Left >= 1) {
+                Valid = ParseFloat(argv[++i], Out.Noise.Lacunarity);
+            } else if (strcmp(Arg, "--gain") == 0 && Left >= 1) {
+                Valid = ParseFloat(argv[++i], Out.Noise.Gain);
+            } else if (strcmp(Arg, "--noise") == 0 && Left >= 1) {
+                Valid = ParseKind(argv[++i], BatchedNoise::NoiseKind::_NOISE_KIND_COUNT_, BatchedNoise::NoiseKindName, Out.Noise.Kind);
+            } else if (strcmp(Arg, "--fractal") == 0 && Left >= 1) {
+                Valid = ParseKind(argv[++i], BatchedNoise::FractalKind::_FRACTAL_KIND_COUNT_, BatchedNoise::FractalKindName, Out.Noise.Fractal);
+            } else if (strcmp(Arg, "--threads") == 0 && Left >= 1) {
+                int32_t Threads;
+                Valid = ParseInt(argv[++i], Threads) && Threads >= 0;
+                Out.Threads = static_cast<uint32_t>(Threads);
+            } else if (strcmp(Arg, "--processes") == 0 && Left >= 1) {
+                Valid = ParseInt(argv[++i], Processes) && Processes > 0;
+            } else if (strcmp(Arg, "--shard") == 0 && Left >= 1) {
+                Valid = ParseInt(argv[++i], Shard) && Shard >= 0;
+            } else if (strcmp(Arg, "--shards") == 0 && Left >= 1) {
+                Valid = ParseInt(argv[++i], Shards) && Shards > 0;
+            } else if (strcmp(Arg, "--merge") == 0) {
+                Merge = true;
+            } else {
+                spdlog::error("Unknown or incomplete option {}", Arg);
+                return InferusResult::FAIL;
+            }
+
+            if (!Valid) {
+                spdlog::error("Bad value for {}", Arg);
+                return InferusResult::FAIL;
+            }
+        }
+
+        if (Out.Directory.empty() || !HasRect) {
+            spdlog::error("--out and --rect are required");
+            return InferusResult::FAIL;
+        }
+        if (Out.Max.x <= Out.Min.x || Out.Max.y <= Out.Min.y) {
+            spdlog::error("Empty rectangle");
+            return InferusResult::FAIL;
+        }
+        if (Out.Noise.Octaves < 1) {
+            spdlog::error("At least one octave");
+            return InferusResult::FAIL;
+        }
+
+        if (int(Processes > 0) + int(Shard >= 0) + int(Merge) > 1) {
+            spdlog::error("--processes, --shard and --merge don't go together");
+            return InferusResult::FAIL;
+        }
+
+        if (Processes > 0) {
+            if (Shards > 0 && Shards != Processes) {
+                spdlog::error("--processes runs one shard per process, --shards has to match");
+                return InferusResult::FAIL;
+            }
+            Out.Run = Mode::Driver;
+            Out.ShardCount = static_cast<uint32_t>(Processes);
+        } else if (Shard >= 0 || Merge) {
+            if (Shards == 0 || Shard >= Shards) {
+                spdlog::error("--shard and --merge need --shards, and a shard below it");
+                return InferusResult::FAIL;
+            }
+            Out.Run = Merge ? Mode::Merge : Mode::Shard;
+            Out.ShardIndex = Merge ? 0 : static_cast<uint32_t>(Shard);
+            Out.ShardCount = static_cast<uint32_t>(Shards);
+        }
+        return InferusResult::SUCCESS;
+    }
+};
+
+int main(int argc, char** argv) {
+    spdlog::set_pattern("[%H:%M:%S] [%^%l%$] %v");
+
+    Bake::Options Options;
+    if (Bake::ParseOptions(argc, argv, Options) != InferusResult::SUCCESS) {
+        Bake::PrintUsage();
+        return 1;
+    }
+
+    switch (Options.Run) {
+        case Bake::Mode::Driver:
+            return Bake::RunDriver(Options, argv[0]);
+        case Bake::Mode::Merge:
+            return Bake::RunMerge(Options);
+        default:
+            return Bake::RunBake(Options);
+    }
+}
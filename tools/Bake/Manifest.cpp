@@ -0,0 +1,206 @@
+#include "Bake.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "Utils/Hash.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Systems/Terrain/ChunkStore.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+
+// Manifests are plain text, a header describing the bake, one line per chunk and "end".
+// The world manifest has "shards <count>", the chunk count and the world hash instead.
+//
+//  InferusBake shard manifest 1
+//  noise <noise hash>
+//  rect <x0> <z0> <x1> <z1>
+//  shard <index> <count>
+//  chunks <count>
+//  <x> <z> <content hash>
+//  ...
+//  end
+namespace Bake {
+    constexpr uint32_t MANIFEST_VERSION = 1;
+
+    uint64_t ChunkKey(glm::ivec2 ChunkPos) {
+        return (uint64_t(uint32_t(ChunkPos.x)) << 32) | uint64_t(uint32_t(ChunkPos.y));
+    }
+
+    // What the bake was, a manifest is only trusted if its header matches exactly
+    std::string ManifestHeader(const char* Kind, const Options& Bake) {
+        std::string Header = fmt::format("InferusBake {} manifest {}\n", Kind, MANIFEST_VERSION);
+        Header += fmt::format("noise {:016x}\n", ChunkStore::NoiseHash(Bake.Noise));
+        Header += fmt::format("rect {} {} {} {}\n", Bake.Min.x, Bake.Min.y, Bake.Max.x, Bake.Max.y);
+        return Header;
+    }
+
+    std::string ShardHeader(const Options& Bake, uint32_t ShardIndex) {
+        return ManifestHeader("shard", Bake) + fmt::format("shard {} {}\n", ShardIndex, Bake.ShardCount);
+    }
+
+    bool WriteAtomically(const std::filesystem::path& Path, const std::string& Content) {
+        std::filesystem::path Temporary = Path;
+        Temporary += ".tmp";
+        {
+            std::ofstream File(Temporary, std::ios::binary | std::ios::trunc);
+            File << Content;
+            File.flush();
+            if (!File) {
+                spdlog::error("Couldn't write {}", Temporary.string());
+                return false;
+            }
+        }
+
+        std::error_code Error;
+        std::filesystem::rename(Temporary, Path, Error);
+        if (Error) {
+            spdlog::error("Couldn't move {} into place: {}", Path.string(), Error.message());
+            return false;
+        }
+        return true;
+    }
+
+    std::string ShardManifestPath(const Options& Bake, uint32_t ShardIndex) {
+        return (std::filesystem::path(Bake.Directory) / fmt::format("shard.{}.of.{}.manifest", ShardIndex, Bake.ShardCount)).string();
+    }
+
+    bool WriteShardManifest(const Options& Bake, uint32_t ShardIndex, const std::vector<ChunkRecord>& Chunks) {
+        std::string Content = ShardHeader(Bake, ShardIndex);
+        Content += fmt::format("chunks {}\n", Chunks.size());
+        for (const ChunkRecord& Chunk : Chunks) {
+            Content += fmt::format("{} {} {:016x}\n", Chunk.ChunkPos.x, Chunk.ChunkPos.y, Chunk.Hash);
+        }
+        Content += "end\n";
+        return WriteAtomically(ShardManifestPath(Bake, ShardIndex), Content);
+    }
+
+    bool ReadShardManifest(const Options& Bake, uint32_t ShardIndex, std::vector<ChunkRecord>& Out) {
+        std::ifstream File(ShardManifestPath(Bake, ShardIndex));
+        if (!File) {
+            return false;
+        }
+
+        std::string Expected = ShardHeader(Bake, ShardIndex);
+        std::string Header(Expected.size(), '\0');
+        if (!File.read(Header.data(), std::streamsize(Header.size())) || Header != Expected) {
+            return false;
+        }
+
+        std::string Line;
+        size_t Count;
+        if (!std::getline(File, Line) || sscanf(Line.c_str(), "chunks %zu", &Count) != 1) {
+            return false;
+        }
+
+        Out.clear();
+        Out.reserve(Count);
+        for (size_t i = 0; i < Count; i++) {
+            ChunkRecord Chunk;
+            unsigned long long Hash;
+            if (!std::getline(File, Line)
+                || sscanf(Line.c_str(), "%d %d %llx", &Chunk.ChunkPos.x, &Chunk.ChunkPos.y, &Hash) != 3)
+            {
+                return false;
+            }
+            Chunk.Hash = Hash;
+            Out.push_back(Chunk);
+        }
+
+        return std::getline(File, Line) && Line == "end";
+    }
+
+    int RunMerge(const Options& Bake) {
+        // Every shard's claims, keyed by chunk
+        std::unordered_map<uint64_t, uint64_t> Claimed;
+        uint32_t MissingShards = 0;
+        uint64_t Duplicates = 0;
+        uint64_t Outside = 0;
+
+        for (uint32_t Shard = 0; Shard < Bake.ShardCount; Shard++) {
+            std::vector<ChunkRecord> Records;
+            if (!ReadShardManifest(Bake, Shard, Records)) {
+                spdlog::error("Shard {} of {} has no valid manifest", Shard, Bake.ShardCount);
+                MissingShards++;
+                continue;
+            }
+
+            for (const ChunkRecord& Record : Records) {
+                bool Inside = Record.ChunkPos.x >= Bake.Min.x && Record.ChunkPos.x < Bake.Max.x
+                           && Record.ChunkPos.y >= Bake.Min.y && Record.ChunkPos.y < Bake.Max.y;
+                if (!Inside) {
+                    Outside++;
+                } else if (!Claimed.emplace(ChunkKey(Record.ChunkPos), Record.Hash).second) {
+                    Duplicates++;
+                }
+            }
+        }
+
+        if (ChunkStore::Create(Bake.Directory, Bake.Noise) != InferusResult::SUCCESS) {
+            return 1;
+        }
+        StartJobSystem(Bake.Threads);
+
+        // Coverage and content, every chunk of the rectangle has to be claimed and still hash the same
+        std::vector<ChunkRecord> Chunks = ChunksOf(Bake, ShardRegions(Bake, 0, 1));
+        std::atomic<uint64_t> Uncovered = 0;
+        std::atomic<uint64_t> Mismatched = 0;
+
+        ParallelFor(Chunks.size(), [&](size_t Begin, size_t End) {
+            thread_local std::array<uint16_t, TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT> Texels;
+
+            for (size_t i = Begin; i < End; i++) {
+                ChunkRecord& Chunk = Chunks[i];
+                auto Found = Claimed.find(ChunkKey(Chunk.ChunkPos));
+                if (Found == Claimed.end()) {
+                    Uncovered.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                Chunk.Hash = ChunkStore::Read(Chunk.ChunkPos, Texels.data()) ? ContentHash(Texels.data()) : 0;
+                if (Chunk.Hash != Found->second) {
+                    Mismatched.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        JobSystem::Destroy();
+        ChunkStore::Destroy();
+
+        spdlog::info("Merge: {} chunks, {} shards missing, {} uncovered, {} claimed twice, {} outside, {} not matching their hash",
+            Chunks.size(), MissingShards, Uncovered.load(), Duplicates, Outside, Mismatched.load());
+
+        std::filesystem::path WorldPath = std::filesystem::path(Bake.Directory) / "world.manifest";
+        if (MissingShards > 0 || Uncovered.load() > 0 || Duplicates > 0 || Outside > 0 || Mismatched.load() > 0) {
+            // An older world manifest would vouch for what just failed
+            std::error_code Ignored;
+            std::filesystem::remove(WorldPath, Ignored);
+            spdlog::error("World manifest not written, rerun the failed shards and merge again");
+            return 1;
+        }
+
+        // Chunks are in whole-rectangle region order here, the hash doesn't depend on the shard count
+        uint64_t WorldHash = Hash::FNV1A_OFFSET;
+        for (const ChunkRecord& Chunk : Chunks) {
+            WorldHash = Hash::Fnv1a(Chunk.Hash, WorldHash);
+        }
+
+        std::string Content = ManifestHeader("world", Bake);
+        Content += fmt::format("shards {}\n", Bake.ShardCount);
+        Content += fmt::format("chunks {}\n", Chunks.size());
+        Content += fmt::format("hash {:016x}\n", WorldHash);
+        Content += "end\n";
+
+        if (!WriteAtomically(WorldPath, Content)) {
+            return 1;
+        }
+
+        spdlog::info("World hash {:016x}, written to {}", WorldHash, WorldPath.string());
+        return 0;
+    }
+};
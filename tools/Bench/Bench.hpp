@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Shared bits for the InferusBench suites, each suite is a Run* function picked by name on main
+namespace Bench {
+    using Clock = std::chrono::steady_clock;
+
+    // Keeps the optimizer from dropping work whose result is never read
+    template <typename T>
+    inline void DoNotOptimize(const T& Value) {
+        asm volatile("" : : "r,m"(Value) : "memory");
+    }
+
+    inline double SecondsSince(Clock::time_point Begin) {
+        return std::chrono::duration<double>(Clock::now() - Begin).count();
+    }
+
+    int RunCodec();
+    int RunNoise();
+    int RunCull();
+    int RunIndices();
+    int RunHeightfield();
+    int RunLod();
+};
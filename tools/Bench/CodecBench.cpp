@@ -0,0 +1,111 @@
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+#include "Bench.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/HeightmapCodec.hpp"
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+namespace Bench {
+    constexpr uint32_t RESOLUTION = TerrainConfig::Chunk::RESOLUTION;
+    constexpr size_t TILE_TEXELS = TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT;
+    constexpr size_t TILE_SIZE = TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_SIZE;
+    constexpr size_t MAX_ENCODED_SIZE = HeightmapCodec::MaxEncodedSize(RESOLUTION, RESOLUTION);
+
+    // Tiles around the origin, a few regions worth
+    constexpr int32_t AREA_RADIUS = 8;
+    constexpr double MIN_SECONDS = 0.5;
+
+    // Same tiles the chunk pipeline feeds the store with
+    std::vector<uint16_t> GenerateTiles(uint32_t& TileCount) {
+        BatchedNoise::Settings Noise = {
+            .Seed = TerrainConfig::Noise::SEED,
+            .Frequency = TerrainConfig::Noise::FREQUENCY,
+            .Octaves = TerrainConfig::Noise::OCTAVES,
+            .Lacunarity = TerrainConfig::Noise::LACUNARITY,
+            .Gain = TerrainConfig::Noise::GAIN
+        };
+
+        const int32_t ChunkStride = RESOLUTION - 1;
+        const uint32_t Side = AREA_RADIUS * 2;
+        TileCount = Side * Side;
+
+        std::vector<uint16_t> Tiles(TileCount * TILE_TEXELS);
+        for (uint32_t i = 0; i < TileCount; i++) {
+            BatchedNoise::GridDesc Grid = {
+                .OriginX = ChunkStride * (int32_t(i % Side) - AREA_RADIUS),
+                .OriginZ = ChunkStride * (int32_t(i / Side) - AREA_RADIUS),
+                .Rows = RESOLUTION,
+                .Cols = RESOLUTION
+            };
+            BatchedNoise::GenerateGrid(Noise, Grid, &Tiles[i * TILE_TEXELS]);
+        }
+        return Tiles;
+    }
+
+    // Runs Pass over every tile until MIN_SECONDS went by, returns raw bytes per second
+    template <typename Fn>
+    double Throughput(uint32_t TileCount, Fn&& Pass) {
+        uint64_t Rounds = 0;
+        Clock::time_point Begin = Clock::now();
+        double Elapsed = 0.0;
+        do {
+            for (uint32_t i = 0; i < TileCount; i++) {
+                Pass(i);
+            }
+            Rounds++;
+            Elapsed = SecondsSince(Begin);
+        } while (Elapsed < MIN_SECONDS);
+
+        return double(Rounds) * TileCount * TILE_SIZE / Elapsed;
+    }
+
+    int RunCodec() {
+        uint32_t TileCount;
+        std::vector<uint16_t> Tiles = GenerateTiles(TileCount);
+
+        std::vector<uint8_t> Encoded(TileCount * MAX_ENCODED_SIZE);
+        std::vector<size_t> Sizes(TileCount);
+        std::vector<uint16_t> Decoded(TileCount * TILE_TEXELS);
+
+        size_t EncodedTotal = 0;
+        uint32_t RawTiles = 0;
+        for (uint32_t i = 0; i < TileCount; i++) {
+            Sizes[i] = HeightmapCodec::Encode(&Tiles[i * TILE_TEXELS], RESOLUTION, RESOLUTION, &Encoded[i * MAX_ENCODED_SIZE]);
+            EncodedTotal += Sizes[i];
+            RawTiles += Encoded[i * MAX_ENCODED_SIZE] == HeightmapCodec::RAW;
+        }
+
+        // Round trip first, a fast codec that's wrong isn't worth timing
+        for (uint32_t i = 0; i < TileCount; i++) {
+            bool Valid = HeightmapCodec::Decode(&Encoded[i * MAX_ENCODED_SIZE], Sizes[i], RESOLUTION, RESOLUTION, &Decoded[i * TILE_TEXELS]);
+            if (!Valid || memcmp(&Decoded[i * TILE_TEXELS], &Tiles[i * TILE_TEXELS], TILE_SIZE) != 0) {
+                printf("Tile %u doesn't round trip\n", i);
+                return 1;
+            }
+        }
+
+        double EncodeRate = Throughput(TileCount, [&](uint32_t i) {
+            Sizes[i] = HeightmapCodec::Encode(&Tiles[i * TILE_TEXELS], RESOLUTION, RESOLUTION, &Encoded[i * MAX_ENCODED_SIZE]);
+        });
+        double DecodeRate = Throughput(TileCount, [&](uint32_t i) {
+            HeightmapCodec::Decode(&Encoded[i * MAX_ENCODED_SIZE], Sizes[i], RESOLUTION, RESOLUTION, &Decoded[i * TILE_TEXELS]);
+            DoNotOptimize(Decoded[i * TILE_TEXELS]);
+        });
+        double CopyRate = Throughput(TileCount, [&](uint32_t i) {
+            memcpy(&Decoded[i * TILE_TEXELS], &Tiles[i * TILE_TEXELS], TILE_SIZE);
+            DoNotOptimize(Decoded[i * TILE_TEXELS]);
+        });
+
+        const double RawTotal = double(TileCount) * TILE_SIZE;
+        printf("Tiles:   %u (%ux%u, %u stored raw)\n", TileCount, RESOLUTION, RESOLUTION, RawTiles);
+        printf("Size:    %.1f KB -> %.1f KB, ratio %.2fx (%.1f bits/texel)\n",
+            RawTotal / 1024.0, EncodedTotal / 1024.0, RawTotal / EncodedTotal,
+            EncodedTotal * 8.0 / (double(TileCount) * TILE_TEXELS));
+        printf("Encode:  %8.2f GB/s\n", EncodeRate / 1e9);
+        printf("Decode:  %8.2f GB/s (%s)\n", DecodeRate / 1e9, HeightmapCodec::DecoderName());
+        printf("memcpy:  %8.2f GB/s\n", CopyRate / 1e9);
+        return 0;
+    }
+};
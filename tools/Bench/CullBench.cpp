@@ -0,0 +1,101 @@
+#include <vector>
+#include <cstdio>
+#include <random>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+
+#include "Bench.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/FrustumCulling.hpp"
+
+namespace Bench {
+    constexpr double CULL_MIN_SECONDS = 0.25;
+    // What a frame can spend culling chunks
+    constexpr double CULL_BUDGET_MS = 0.1;
+
+    // Square grids of chunks around the origin, heights all over the place
+    FrustumCulling::Boxes GenerateBoxes(uint32_t Side) {
+        constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+        constexpr float HEIGHT_SCALE = TerrainConfig::Chunk::HEIGHT_SCALE;
+
+        std::mt19937 Random(1337);
+        std::uniform_real_distribution<float> Height(0.0f, 1.0f);
+
+        FrustumCulling::Boxes Boxes;
+        Boxes.Resize(Side * Side);
+        for (uint32_t i = 0; i < Side * Side; i++) {
+            float a = Height(Random);
+            float b = Height(Random);
+            glm::vec3 Min = {
+                (float(i % Side) - Side / 2.0f) * WORLD_SIZE,
+                std::min(a, b) * HEIGHT_SCALE,
+                (float(i / Side) - Side / 2.0f) * WORLD_SIZE
+            };
+            glm::vec3 Max = { Min.x + WORLD_SIZE, std::max(a, b) * HEIGHT_SCALE, Min.z + WORLD_SIZE };
+            Boxes.Set(i, Min, Max);
+        }
+        return Boxes;
+    }
+
+    // Camera3D's matrix, looking slightly down across the grid
+    glm::mat4 ViewProjection(float Yaw) {
+        glm::mat4 Projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        Projection[1][1] *= -1.0f;
+
+        glm::vec3 Position = { 0.0f, 10.0f, 0.0f };
+        glm::vec3 LookDir = glm::normalize(glm::vec3(glm::cos(Yaw), -0.2f, glm::sin(Yaw)));
+        glm::mat4 View = glm::lookAtLH(Position, Position - LookDir, glm::vec3(0.0f, 1.0f, 0.0f));
+        return Projection * View;
+    }
+
+    // Milliseconds per call, the camera spins so every call sees a different frustum
+    template <typename Fn>
+    double MsPerCull(const FrustumCulling::Boxes& Boxes, std::vector<uint32_t>& Visible, Fn&& Cull) {
+        uint64_t Calls = 0;
+        Clock::time_point Begin = Clock::now();
+        double Elapsed = 0.0;
+        do {
+            FrustumCulling::Frustum View = FrustumCulling::FromMatrix(ViewProjection(Calls * 0.01f));
+            DoNotOptimize(Cull(View, Boxes, Visible.data()));
+            Calls++;
+            Elapsed = SecondsSince(Begin);
+        } while (Elapsed < CULL_MIN_SECONDS);
+
+        return Elapsed * 1000.0 / double(Calls);
+    }
+
+    int RunCull() {
+        const uint32_t SIDES[] = { 8, 64, 128, 256 };
+
+        printf("%8s %9s %11s %11s %8s\n", "Chunks", "Visible", "Scalar ms", "SIMD ms", "Speedup");
+        for (uint32_t Side : SIDES) {
+            FrustumCulling::Boxes Boxes = GenerateBoxes(Side);
+            std::vector<uint32_t> Visible(Boxes.Count);
+            std::vector<uint32_t> Expected(Boxes.Count);
+
+            // Both paths have to agree before either is worth timing
+            for (float Yaw = 0.0f; Yaw < 6.3f; Yaw += 0.5f) {
+                FrustumCulling::Frustum View = FrustumCulling::FromMatrix(ViewProjection(Yaw));
+                uint32_t Count = FrustumCulling::Cull(View, Boxes, Visible.data());
+                uint32_t ExpectedCount = FrustumCulling::CullScalar(View, Boxes, Expected.data());
+                if (Count != ExpectedCount || !std::equal(Visible.begin(), Visible.begin() + Count, Expected.begin())) {
+                    printf("SIMD and scalar culling disagree on %u chunks\n", Boxes.Count);
+                    return 1;
+                }
+            }
+
+            uint32_t VisibleCount = FrustumCulling::Cull(FrustumCulling::FromMatrix(ViewProjection(0.0f)), Boxes, Visible.data());
+            double ScalarMs = MsPerCull(Boxes, Visible, FrustumCulling::CullScalar);
+            double SimdMs = MsPerCull(Boxes, Visible, FrustumCulling::Cull);
+
+            printf("%8u %9u %11.4f %11.4f %7.1fx%s\n",
+                Boxes.Count, VisibleCount, ScalarMs, SimdMs, ScalarMs / SimdMs,
+                SimdMs > CULL_BUDGET_MS ? "  over budget" : "");
+        }
+        printf("Budget:  %.2f ms per frame\n", CULL_BUDGET_MS);
+        return 0;
+    }
+};
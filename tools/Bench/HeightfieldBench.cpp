@@ -0,0 +1,294 @@
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "Bench.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/ChunkResidency.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+#include "Engine/Systems/Terrain/TerrainHeightfield.hpp"
+
+namespace Bench {
+    constexpr double HEIGHTFIELD_MIN_SECONDS = 0.25;
+    constexpr uint32_t HEIGHTFIELD_CHECKED_RAYS = 200;
+    constexpr uint32_t HEIGHTFIELD_BATCH = 4096;
+    // Agents spread over a few quads each, how gameplay tends to ask
+    constexpr uint32_t HEIGHTFIELD_CLUSTERS = 64;
+
+    // What terrain.vert would place for every resident chunk, the brute force side
+    struct ReferenceChunk {
+        glm::ivec2 ChunkPos;
+        std::vector<uint16_t> Texels;
+    };
+
+    // terrain.vert fetches the vertex's own texel
+    float ReferenceVertexHeight(const ReferenceChunk& Chunk, uint32_t Row, uint32_t Col) {
+        float Texel = float(Chunk.Texels[Row * TerrainConfig::Chunk::RESOLUTION + Col]) / 65535.0f;
+        return Texel * TerrainConfig::Chunk::HEIGHT_SCALE;
+    }
+
+    bool ReferenceTriangle(glm::vec3 Origin, glm::vec3 Direction, glm::vec3 a, glm::vec3 b, glm::vec3 c, float& t) {
+        glm::vec3 Edge1 = b - a;
+        glm::vec3 Edge2 = c - a;
+        glm::vec3 P = glm::cross(Direction, Edge2);
+        float Determinant = glm::dot(Edge1, P);
+        if (std::abs(Determinant) < 1e-12f) {
+            return false;
+        }
+        glm::vec3 T = Origin - a;
+        float u = glm::dot(T, P) / Determinant;
+        glm::vec3 Q = glm::cross(T, Edge1);
+        float v = glm::dot(Direction, Q) / Determinant;
+        t = glm::dot(Edge2, Q) / Determinant;
+        return u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f;
+    }
+
+    // Every triangle of every chunk
+    bool ReferenceRaycast(const std::vector<ReferenceChunk>& Chunks, glm::vec3 Origin, glm::vec3 Direction, float& Best) {
+        constexpr uint32_t QUADS = TerrainConfig::Chunk::RESOLUTION - 1;
+        constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+
+        bool Found = false;
+        for (const ReferenceChunk& Chunk : Chunks) {
+            auto Vertex = [&Chunk](uint32_t Row, uint32_t Col) {
+                return glm::vec3(
+                    (float(Chunk.ChunkPos.x) + float(Row) / float(QUADS)) * WORLD_SIZE,
+                    ReferenceVertexHeight(Chunk, Row, Col),
+                    (float(Chunk.ChunkPos.y) + float(Col) / float(QUADS)) * WORLD_SIZE
+                );
+            };
+            for (uint32_t r = 0; r < QUADS; r++) {
+                for (uint32_t c = 0; c < QUADS; c++) {
+                    float t;
+                    if (ReferenceTriangle(Origin, Direction, Vertex(r, c), Vertex(r + 1, c), Vertex(r, c + 1), t) && t < Best) {
+                        Best = t;
+                        Found = true;
+                    }
+                    if (ReferenceTriangle(Origin, Direction, Vertex(r, c + 1), Vertex(r + 1, c), Vertex(r + 1, c + 1), t) && t < Best) {
+                        Best = t;
+                        Found = true;
+                    }
+                }
+            }
+        }
+        return Found;
+    }
+
+    // Upward normal of the drawn triangle under (x, z), from the vertices terrain.vert places
+    bool ReferenceNormal(const std::vector<ReferenceChunk>& Chunks, glm::vec2 WorldXZ, glm::vec3& Out) {
+        constexpr uint32_t QUADS = TerrainConfig::Chunk::RESOLUTION - 1;
+        constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+
+        glm::vec2 ChunkXZ = WorldXZ / WORLD_SIZE;
+        glm::ivec2 ChunkPos = glm::ivec2(glm::floor(ChunkXZ));
+        auto Chunk = std::find_if(Chunks.begin(), Chunks.end(), [ChunkPos](const ReferenceChunk& c) { return c.ChunkPos == ChunkPos; });
+        if (Chunk == Chunks.end()) {
+            return false;
+        }
+
+        float Row = (ChunkXZ.x - float(ChunkPos.x)) * float(QUADS);
+        float Col = (ChunkXZ.y - float(ChunkPos.y)) * float(QUADS);
+        uint32_t r = std::min(uint32_t(Row), QUADS - 1);
+        uint32_t c = std::min(uint32_t(Col), QUADS - 1);
+        auto Vertex = [&Chunk](uint32_t VertexRow, uint32_t VertexCol) {
+            return glm::vec3(float(VertexRow) / float(QUADS) * WORLD_SIZE, ReferenceVertexHeight(*Chunk, VertexRow, VertexCol), float(VertexCol) / float(QUADS) * WORLD_SIZE);
+        };
+
+        glm::vec3 a, b, d;
+        if ((Row - float(r)) + (Col - float(c)) <= 1.0f) {
+            a = Vertex(r, c); b = Vertex(r + 1, c); d = Vertex(r, c + 1);
+        } else {
+            a = Vertex(r, c + 1); b = Vertex(r + 1, c); d = Vertex(r + 1, c + 1);
+        }
+        // Either winding, it's the upward one
+        Out = glm::normalize(glm::cross(b - a, d - a));
+        if (Out.y < 0.0f) {
+            Out = -Out;
+        }
+        return true;
+    }
+
+    // Eye height above the resident diamond looking a bit down, like the camera does
+    struct HeightfieldRay {
+        glm::vec3 Origin;
+        glm::vec3 Direction;
+    };
+
+    HeightfieldRay RandomRay(std::mt19937& Random, float MaxPitch) {
+        constexpr float SPREAD = TerrainConfig::Chunk::WORLD_SIZE * 2.0f;
+        std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+
+        float Yaw = Unit(Random) * 6.2831853f;
+        float Pitch = 0.05f + Unit(Random) * MaxPitch;
+        return {
+            .Origin = { (Unit(Random) - 0.5f) * SPREAD, TerrainConfig::Chunk::HEIGHT_SCALE * 1.5f, (Unit(Random) - 0.5f) * SPREAD },
+            .Direction = glm::normalize(glm::vec3(std::cos(Yaw), -Pitch, std::sin(Yaw)))
+        };
+    }
+
+    template <typename Fn>
+    double NsPerCall(Fn&& Call) {
+        uint64_t Calls = 0;
+        Clock::time_point Begin = Clock::now();
+        double Elapsed = 0.0;
+        do {
+            for (uint32_t i = 0; i < 64; i++) {
+                Call(Calls++);
+            }
+            Elapsed = SecondsSince(Begin);
+        } while (Elapsed < HEIGHTFIELD_MIN_SECONDS);
+        return Elapsed * 1e9 / double(Calls);
+    }
+
+    int RunHeightfield() {
+        BatchedNoise::Settings Noise = TerrainGenerator::DefaultSettings();
+
+        // The resident diamond around the origin, as streaming would have it
+        std::vector<ReferenceChunk> Chunks;
+        double BuildSeconds = 0.0;
+        ChunkResidency::ForEachInRange(glm::ivec2(0, 0), [&](glm::ivec2 ChunkPos) {
+            ReferenceChunk Chunk = { .ChunkPos = ChunkPos, .Texels = std::vector<uint16_t>(TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT) };
+            TerrainGenerator::Generate(Noise, ChunkPos, Chunk.Texels.data());
+
+            Clock::time_point Begin = Clock::now();
+            TerrainHeightfield::Build(ChunkResidency::Slot(ChunkPos), ChunkPos, Chunk.Texels.data());
+            BuildSeconds += SecondsSince(Begin);
+            Chunks.push_back(std::move(Chunk));
+        });
+        printf("%zu chunks, %.1f us per build\n", Chunks.size(), BuildSeconds * 1e6 / double(Chunks.size()));
+
+        // Same hits as testing every triangle before anything gets timed
+        std::mt19937 Random(1337);
+        uint32_t Hits = 0;
+        for (uint32_t i = 0; i < HEIGHTFIELD_CHECKED_RAYS; i++) {
+            HeightfieldRay Ray = RandomRay(Random, 0.5f);
+            float Expected = TerrainConfig::Heightfield::CAMERA_CAST_DISTANCE;
+            bool ExpectedHit = ReferenceRaycast(Chunks, Ray.Origin, Ray.Direction, Expected);
+
+            TerrainHeightfield::Hit Actual;
+            bool ActualHit = TerrainHeightfield::Raycast(Ray.Origin, Ray.Direction, TerrainConfig::Heightfield::CAMERA_CAST_DISTANCE, Actual);
+            if (ActualHit != ExpectedHit || (ActualHit && std::abs(Actual.Distance - Expected) > 1e-3f)) {
+                printf("Ray %u: %s at %f, every triangle says %s at %f\n", i,
+                    ActualHit ? "hit" : "miss", Actual.Distance, ExpectedHit ? "hit" : "miss", Expected);
+                return 1;
+            }
+
+            float Height;
+            if (ActualHit && (!TerrainHeightfield::Height({ Actual.Position.x, Actual.Position.z }, Height) ||
+                              std::abs(Height - Actual.Position.y) > 1e-3f)) {
+                printf("Ray %u: hit at height %f, the height query says %f\n", i, Actual.Position.y, Height);
+                return 1;
+            }
+            Hits += ActualHit;
+        }
+        printf("%u rays checked against every triangle, %u hits\n\n", HEIGHTFIELD_CHECKED_RAYS, Hits);
+
+        // Steep rays land close, grazing ones walk a lot of pyramid before they do
+        printf("%-22s %10s\n", "", "us/ray");
+        const std::pair<const char*, float> PITCHES[] = { { "picking (steep)", 1.0f }, { "camera (shallow)", 0.3f }, { "grazing", 0.02f } };
+        for (auto [Name, MaxPitch] : PITCHES) {
+            std::vector<HeightfieldRay> Rays(1024);
+            for (HeightfieldRay& Ray : Rays) {
+                Ray = RandomRay(Random, MaxPitch);
+            }
+            double Ns = NsPerCall([&Rays](uint64_t Call) {
+                const HeightfieldRay& Ray = Rays[Call % Rays.size()];
+                TerrainHeightfield::Hit Out;
+                DoNotOptimize(TerrainHeightfield::Raycast(Ray.Origin, Ray.Direction, TerrainConfig::Heightfield::CAMERA_CAST_DISTANCE, Out));
+            });
+            printf("%-22s %10.2f\n", Name, Ns / 1000.0);
+        }
+
+        // Heights all over the diamond, one at a time and in batches
+        std::uniform_real_distribution<float> Spread(-TerrainConfig::Chunk::WORLD_SIZE * 2.0f, TerrainConfig::Chunk::WORLD_SIZE * 2.0f);
+        std::vector<glm::vec2> Positions(HEIGHTFIELD_BATCH);
+        for (glm::vec2& Position : Positions) {
+            Position = { Spread(Random), Spread(Random) };
+        }
+        std::vector<float> Heights(HEIGHTFIELD_BATCH);
+
+        double SingleNs = NsPerCall([&Positions](uint64_t Call) {
+            float Height;
+            DoNotOptimize(TerrainHeightfield::Height(Positions[Call % HEIGHTFIELD_BATCH], Height));
+            DoNotOptimize(Height);
+        });
+        double BatchNs = NsPerCall([&Positions, &Heights](uint64_t) {
+            DoNotOptimize(TerrainHeightfield::Heights(Positions.data(), Heights.data(), HEIGHTFIELD_BATCH));
+        }) / HEIGHTFIELD_BATCH;
+
+        // The lanes have to land on the same triangle as the scalar path
+        std::vector<glm::vec3> Normals(HEIGHTFIELD_BATCH);
+        TerrainHeightfield::Sample(Positions.data(), HEIGHTFIELD_BATCH, Heights.data(), Normals.data());
+        for (uint32_t i = 0; i < HEIGHTFIELD_BATCH; i++) {
+            float Expected;
+            glm::vec3 ExpectedNormal;
+            bool Resident = TerrainHeightfield::Height(Positions[i], Expected);
+            if (Resident != ReferenceNormal(Chunks, Positions[i], ExpectedNormal) || Resident == std::isnan(Heights[i])) {
+                printf("Position %u: resident %d, sampled %f\n", i, Resident, Heights[i]);
+                return 1;
+            }
+            if (Resident && (std::abs(Heights[i] - Expected) > 1e-4f || glm::length(Normals[i] - ExpectedNormal) > 1e-3f)) {
+                printf("Position %u: sampled %f (%f %f %f), expected %f (%f %f %f)\n", i,
+                       Heights[i], Normals[i].x, Normals[i].y, Normals[i].z, Expected, ExpectedNormal.x, ExpectedNormal.y, ExpectedNormal.z);
+                return 1;
+            }
+        }
+        printf("\n%u samples checked against the height query and the triangles' normals\n\n", HEIGHTFIELD_BATCH);
+
+        std::vector<glm::vec2> Clustered(HEIGHTFIELD_BATCH);
+        std::normal_distribution<float> Jitter(0.0f, TerrainConfig::Chunk::WORLD_SIZE / 64.0f);
+        for (uint32_t Cluster = 0; Cluster < HEIGHTFIELD_CLUSTERS; Cluster++) {
+            glm::vec2 Center = { Spread(Random), Spread(Random) };
+            for (uint32_t i = 0; i < HEIGHTFIELD_BATCH / HEIGHTFIELD_CLUSTERS; i++) {
+                Clustered[Cluster * (HEIGHTFIELD_BATCH / HEIGHTFIELD_CLUSTERS) + i] = Center + glm::vec2(Jitter(Random), Jitter(Random));
+            }
+        }
+
+        auto BatchMqps = [&Heights, &Normals](const std::vector<glm::vec2>& Batch, bool WithNormals) {
+            double Ns = NsPerCall([&](uint64_t) {
+                DoNotOptimize(TerrainHeightfield::Sample(Batch.data(), HEIGHTFIELD_BATCH, Heights.data(), WithNormals ? Normals.data() : nullptr));
+            }) / HEIGHTFIELD_BATCH;
+            return 1e3 / Ns;
+        };
+
+        printf("%-22s %10s\n", "", "Mqueries/s");
+        printf("%-22s %10.1f\n", "height", 1e3 / SingleNs);
+        printf("%-22s %10.1f\n", "heights (batch)", 1e3 / BatchNs);
+        printf("%-22s %10.1f\n", "sample", BatchMqps(Positions, false));
+        printf("%-22s %10.1f\n", "sample + normals", BatchMqps(Positions, true));
+        printf("%-22s %10.1f\n", "clustered", BatchMqps(Clustered, false));
+        printf("%-22s %10.1f\n", "clustered + normals", BatchMqps(Clustered, true));
+
+        // Far off the diamond, a generation per chunk and then the fallback's cache (4 chunks, it keeps 8)
+        TerrainHeightfield::Create(Noise);
+        std::vector<glm::vec2> Outside(HEIGHTFIELD_BATCH);
+        std::uniform_real_distribution<float> OutsideSpread(0.0f, TerrainConfig::Chunk::WORLD_SIZE * 1.5f);
+        for (glm::vec2& Position : Outside) {
+            Position = glm::vec2(TerrainConfig::Chunk::WORLD_SIZE * 1000.0f) + glm::vec2(OutsideSpread(Random), OutsideSpread(Random));
+        }
+        if (TerrainHeightfield::Sample(Outside.data(), HEIGHTFIELD_BATCH, Heights.data(), nullptr) != 0) {
+            printf("Positions off the resident chunks resolved without generating\n");
+            return 1;
+        }
+        Clock::time_point GenerateBegin = Clock::now();
+        uint32_t Generated = TerrainHeightfield::Sample(Outside.data(), HEIGHTFIELD_BATCH, Heights.data(), nullptr, TerrainHeightfield::Missing::Generate);
+        double GenerateMs = SecondsSince(GenerateBegin) * 1e3;
+        if (Generated != HEIGHTFIELD_BATCH) {
+            printf("Generating left %u positions out\n", HEIGHTFIELD_BATCH - Generated);
+            return 1;
+        }
+        double CachedNs = NsPerCall([&](uint64_t) {
+            DoNotOptimize(TerrainHeightfield::Sample(Outside.data(), HEIGHTFIELD_BATCH, Heights.data(), nullptr, TerrainHeightfield::Missing::Generate));
+        }) / HEIGHTFIELD_BATCH;
+        TerrainHeightfield::Stats HeightfieldStats = TerrainHeightfield::GetStats();
+        printf("\n%-22s %10.2f ms, %llu chunks at %.0f us\n", "generated (first)", GenerateMs,
+               (unsigned long long)HeightfieldStats.Generated, HeightfieldStats.GenerateUs);
+        printf("%-22s %10.1f Mqueries/s\n", "generated (cached)", 1e3 / CachedNs);
+        return 0;
+    }
+};
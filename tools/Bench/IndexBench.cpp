@@ -0,0 +1,206 @@
+#include <array>
+#include <deque>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include "Bench.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/PlaneMeshIndicesGenerator.hpp"
+
+namespace Bench {
+    using Order = PlaneMeshIndicesGenerator::Order;
+
+    constexpr uint32_t RESOLUTION = TerrainConfig::Chunk::RESOLUTION;
+    constexpr uint32_t VERTEX_COUNT = RESOLUTION * RESOLUTION;
+    constexpr uint32_t TRIANGLE_COUNT = TerrainConfig::Chunk::INDICES_COUNT / 3;
+
+    // Post transform caches are FIFO on most hardware, LRU is what the papers assume
+    enum class Policy { Fifo, Lru };
+
+    struct Cache {
+        Policy Kind;
+        uint32_t Size;
+        const char* Name;
+    };
+
+    constexpr Cache CACHES[] = {
+        { Policy::Fifo, 16, "FIFO 16" },
+        { Policy::Fifo, 32, "FIFO 32" },
+        { Policy::Lru, 32, "LRU 32" },
+    };
+
+    // Vertices transformed for the whole index list
+    uint32_t CountMisses(const std::vector<uint32_t>& Indices, const Cache& Model) {
+        std::deque<uint32_t> Entries;
+        uint32_t Misses = 0;
+        for (uint32_t Vertex : Indices) {
+            auto Hit = std::find(Entries.begin(), Entries.end(), Vertex);
+            if (Hit != Entries.end()) {
+                if (Model.Kind == Policy::Lru) {
+                    Entries.erase(Hit);
+                    Entries.push_front(Vertex);
+                }
+                continue;
+            }
+            Misses++;
+            Entries.push_front(Vertex);
+            if (Entries.size() > Model.Size) {
+                Entries.pop_back();
+            }
+        }
+        return Misses;
+    }
+
+    std::vector<uint32_t> Generate(Order GridOrder, uint32_t BandQuads = TerrainConfig::Chunk::INDEX_BAND_QUADS) {
+        std::vector<uint32_t> Indices(TerrainConfig::Chunk::INDICES_COUNT);
+        PlaneMeshIndicesGenerator::GetIndices(Indices.data(), GridOrder, RESOLUTION, BandQuads);
+        return Indices;
+    }
+
+    // Tipsify (Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and
+    // Reduced Overdraw"), a general optimizer for reference, the grid orders don't need it
+    std::vector<uint32_t> Tipsify(const std::vector<uint32_t>& Indices, uint32_t CacheSize) {
+        std::vector<std::vector<uint32_t>> Adjacency(VERTEX_COUNT);
+        for (uint32_t t = 0; t < TRIANGLE_COUNT; t++) {
+            for (uint32_t i = 0; i < 3; i++) {
+                Adjacency[Indices[t * 3 + i]].push_back(t);
+            }
+        }
+
+        std::vector<uint32_t> Live(VERTEX_COUNT);
+        for (uint32_t v = 0; v < VERTEX_COUNT; v++) {
+            Live[v] = static_cast<uint32_t>(Adjacency[v].size());
+        }
+        std::vector<uint32_t> Stamp(VERTEX_COUNT, 0);
+        std::vector<bool> Emitted(TRIANGLE_COUNT, false);
+        std::vector<uint32_t> DeadEnds;
+        std::vector<uint32_t> Output;
+        Output.reserve(Indices.size());
+
+        uint32_t Time = CacheSize + 1;
+        uint32_t Cursor = 1;
+        int64_t Fanning = 0;
+        while (Fanning >= 0) {
+            std::vector<uint32_t> Candidates;
+            for (uint32_t t : Adjacency[Fanning]) {
+                if (Emitted[t]) {
+                    continue;
+                }
+                for (uint32_t i = 0; i < 3; i++) {
+                    uint32_t v = Indices[t * 3 + i];
+                    Output.push_back(v);
+                    DeadEnds.push_back(v);
+                    Candidates.push_back(v);
+                    Live[v]--;
+                    if (Time - Stamp[v] > CacheSize) {
+                        Stamp[v] = Time++;
+                    }
+                }
+                Emitted[t] = true;
+            }
+
+            // Next fanning vertex: the one still in cache the longest that its triangles won't push out
+            Fanning = -1;
+            int64_t BestPriority = -1;
+            for (uint32_t v : Candidates) {
+                if (Live[v] == 0) {
+                    continue;
+                }
+                int64_t Priority = 0;
+                if (Time - Stamp[v] + 2 * Live[v] <= CacheSize) {
+                    Priority = Time - Stamp[v];
+                }
+                if (Priority > BestPriority) {
+                    BestPriority = Priority;
+                    Fanning = v;
+                }
+            }
+            if (Fanning >= 0) {
+                continue;
+            }
+
+            // Dead end, back to something recently emitted or else the next vertex left
+            while (!DeadEnds.empty() && Fanning < 0) {
+                uint32_t v = DeadEnds.back();
+                DeadEnds.pop_back();
+                if (Live[v] > 0) {
+                    Fanning = v;
+                }
+            }
+            while (Fanning < 0 && Cursor < VERTEX_COUNT) {
+                if (Live[Cursor] > 0) {
+                    Fanning = Cursor;
+                }
+                Cursor++;
+            }
+        }
+        return Output;
+    }
+
+    // Same triangles and winding, whatever the order, rotated so each starts at its lowest index
+    bool SameTriangles(const std::vector<uint32_t>& A, const std::vector<uint32_t>& B) {
+        auto Canonical = [](const std::vector<uint32_t>& Indices) {
+            std::vector<std::array<uint32_t, 3>> Triangles;
+            for (size_t t = 0; t + 2 < Indices.size(); t += 3) {
+                std::array<uint32_t, 3> Triangle = { Indices[t], Indices[t + 1], Indices[t + 2] };
+                while (Triangle[0] != std::min({ Triangle[0], Triangle[1], Triangle[2] })) {
+                    std::rotate(Triangle.begin(), Triangle.begin() + 1, Triangle.end());
+                }
+                Triangles.push_back(Triangle);
+            }
+            std::sort(Triangles.begin(), Triangles.end());
+            return Triangles;
+        };
+        return A.size() == B.size() && Canonical(A) == Canonical(B);
+    }
+
+    void PrintRow(const char* Name, const std::vector<uint32_t>& Indices) {
+        printf("%-14s", Name);
+        for (const Cache& Model : CACHES) {
+            uint32_t Misses = CountMisses(Indices, Model);
+            printf(" %7.3f %6.3f", double(Misses) / TRIANGLE_COUNT, double(Misses) / VERTEX_COUNT);
+        }
+        printf("\n");
+    }
+
+    int RunIndices() {
+        // What the renderer uploads has to be what's measured
+        constexpr auto Uploaded = PlaneMeshIndicesGenerator::MakeIndices();
+        std::vector<uint32_t> Shipped(Uploaded.begin(), Uploaded.end());
+        std::vector<uint32_t> RowMajor = Generate(Order::RowMajor);
+        std::vector<uint32_t> Snake = Generate(Order::Snake);
+        std::vector<uint32_t> Bands = Generate(Order::Bands);
+        std::vector<uint32_t> Tipsified = Tipsify(RowMajor, 16);
+
+        for (const std::vector<uint32_t>* Candidate : { &Shipped, &Snake, &Bands, &Tipsified }) {
+            if (!SameTriangles(RowMajor, *Candidate)) {
+                printf("An order changed the triangles\n");
+                return 1;
+            }
+        }
+
+        printf("%u vertices, %u triangles, %u bytes of indices (%u with 32 bit ones)\n\n",
+               VERTEX_COUNT, TRIANGLE_COUNT, TerrainConfig::Chunk::INDICES_BUFFER_SIZE,
+               uint32_t(TerrainConfig::Chunk::INDICES_COUNT * sizeof(uint32_t)));
+
+        printf("%-14s", "ACMR ATVR");
+        for (const Cache& Model : CACHES) {
+            printf(" %14s", Model.Name);
+        }
+        printf("\n");
+        PrintRow("row major", RowMajor);
+        PrintRow("snake", Snake);
+        PrintRow("bands", Bands);
+        PrintRow("tipsify 16", Tipsified);
+
+        printf("\nBand width against FIFO 16 and 32, ACMR (shipping %u)\n", TerrainConfig::Chunk::INDEX_BAND_QUADS);
+        for (uint32_t BandQuads = 4; BandQuads <= 16; BandQuads++) {
+            std::vector<uint32_t> Indices = Generate(Order::Bands, BandQuads);
+            printf("%4u %7.3f %7.3f\n", BandQuads,
+                   double(CountMisses(Indices, CACHES[0])) / TRIANGLE_COUNT,
+                   double(CountMisses(Indices, CACHES[1])) / TRIANGLE_COUNT);
+        }
+        return 0;
+    }
+};
@@ -0,0 +1,277 @@
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+
+#include "Bench.hpp"
+#include "Engine/Systems/Terrain/TerrainTypes.hpp"
+#include "Engine/Systems/Terrain/CdlodQuadtree.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/FrustumCulling.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+
+namespace Bench {
+    constexpr uint32_t GRID_TRIANGLES = (TerrainConfig::Chunk::RESOLUTION - 1) * (TerrainConfig::Chunk::RESOLUTION - 1) * 2;
+    constexpr uint32_t GRID_VERTICES = TerrainConfig::Chunk::RESOLUTION * TerrainConfig::Chunk::RESOLUTION;
+    // Diamond radii to compare, the shipping one first and 10x its view distance last
+    constexpr int32_t LOD_RADII[] = { int32_t(TerrainConfig::ChunkToHeightmapLinking::DIAMOND_EXPLORATION_RADIUS), 8, 16, 40 };
+    constexpr uint32_t LOD_YAWS = 16;
+    // Viewport height the tessellation factors are worked out for, InferusEngine::HEIGHT
+    constexpr float LOD_VIEWPORT_HEIGHT = 720.0f;
+
+    // The diamond around the origin with real height ranges, what the renderer stages as
+    // links. Layers gets every link's heightmap, InstanceId is its layer.
+    std::vector<ChunkHeightmapLink> DiamondLinks(int32_t Radius, std::vector<uint16_t>& Layers) {
+        constexpr size_t LAYER_SIZE = TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT;
+        BatchedNoise::Settings Noise = TerrainGenerator::DefaultSettings();
+        Layers.clear();
+
+        std::vector<ChunkHeightmapLink> Links;
+        for (int32_t dx = -Radius; dx <= Radius; dx++) {
+            int32_t Span = Radius - std::abs(dx);
+            for (int32_t dz = -Span; dz <= Span; dz++) {
+                Layers.resize(Layers.size() + LAYER_SIZE);
+                uint16_t* Texels = Layers.data() + Layers.size() - LAYER_SIZE;
+                TerrainGenerator::Generate(Noise, glm::ivec2(dx, dz), Texels);
+                auto [Min, Max] = std::minmax_element(Texels, Texels + LAYER_SIZE);
+                Links.push_back({
+                    .WorldPos = glm::ivec2(dx, dz),
+                    .InstanceId = uint32_t(Links.size()),
+                    .IsVisible = 1,
+                    .MinHeight = float(*Min) / 65535.0f,
+                    .MaxHeight = float(*Max) / 65535.0f,
+                    .Padding = {}
+                });
+            }
+        }
+        return Links;
+    }
+
+    // Camera3D's matrix from the middle of the origin chunk, far plane past the diamond
+    FrustumCulling::Frustum LodView(glm::vec3 Position, float Yaw, float Far) {
+        glm::mat4 Projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, Far);
+        Projection[1][1] *= -1.0f;
+
+        glm::vec3 LookDir = glm::normalize(glm::vec3(glm::cos(Yaw), -0.2f, glm::sin(Yaw)));
+        glm::mat4 View = glm::lookAtLH(Position, Position - LookDir, glm::vec3(0.0f, 1.0f, 0.0f));
+        return FrustumCulling::FromMatrix(Projection * View);
+    }
+
+    // terrain_tess.tesc on the CPU, the factors it picks and what the quad domain they
+    // subdivide comes out as
+    namespace Tess {
+        constexpr float FLAT_DENSITY = 0.25f;
+        constexpr float ROUGH_DEVIATION = 0.05f;
+
+        struct Patch {
+            const ChunkHeightmapLink* Link;
+            const uint16_t* Layer;
+            glm::vec3 Camera;
+            float FocalPixels;
+        };
+
+        // The heightmap sampler, linear and clamped to the edge
+        float Height(const uint16_t* Layer, glm::vec2 Uv) {
+            constexpr int32_t RES = TerrainConfig::Chunk::RESOLUTION;
+            float X = std::clamp(Uv.x * float(RES) - 0.5f, 0.0f, float(RES - 1));
+            float Y = std::clamp(Uv.y * float(RES) - 0.5f, 0.0f, float(RES - 1));
+            int32_t X0 = std::min(int32_t(X), RES - 2);
+            int32_t Y0 = std::min(int32_t(Y), RES - 2);
+            float Fx = X - float(X0);
+            float Fy = Y - float(Y0);
+
+            const uint16_t* Row = Layer + Y0 * RES + X0;
+            float Top = float(Row[0]) + (float(Row[1]) - float(Row[0])) * Fx;
+            float Bottom = float(Row[RES]) + (float(Row[RES + 1]) - float(Row[RES])) * Fx;
+            return (Top + (Bottom - Top) * Fy) / 65535.0f;
+        }
+
+        glm::vec3 WorldPosition(const Patch& Source, glm::vec2 Uv) {
+            return {
+                (Uv.y + float(Source.Link->WorldPos.x)) * TerrainConfig::Chunk::WORLD_SIZE,
+                Height(Source.Layer, Uv) * TerrainConfig::Chunk::HEIGHT_SCALE,
+                (Uv.x + float(Source.Link->WorldPos.y)) * TerrainConfig::Chunk::WORLD_SIZE
+            };
+        }
+
+        float EdgeFactor(const Patch& Source, glm::vec2 A, glm::vec2 B) {
+            glm::vec3 Pa = WorldPosition(Source, A);
+            glm::vec3 Pb = WorldPosition(Source, B);
+            if (Pa.x > Pb.x || (Pa.x == Pb.x && Pa.z > Pb.z)) {
+                std::swap(A, B);
+                std::swap(Pa, Pb);
+            }
+
+            float Deviation = 0.0f;
+            for (int32_t i = 1; i < 4; i++) {
+                float t = float(i) * 0.25f;
+                float Along = WorldPosition(Source, A + (B - A) * t).y;
+                Deviation = std::max(Deviation, std::abs(Along - (Pa.y + (Pb.y - Pa.y) * t)));
+            }
+
+            float EdgeLength = glm::length(Pb - Pa);
+            float CameraDistance = std::max(glm::length((Pa + Pb) * 0.5f - Source.Camera), 0.001f);
+            float Pixels = EdgeLength * Source.FocalPixels / CameraDistance;
+            float Rough = std::clamp(Deviation / (EdgeLength * ROUGH_DEVIATION), 0.0f, 1.0f);
+            float Density = FLAT_DENSITY + (1.0f - FLAT_DENSITY) * Rough;
+
+            constexpr float MAX_FACTOR = float(TerrainConfig::Tessellation::MAX_FACTOR);
+            return std::clamp(Pixels / TerrainConfig::Tessellation::EDGE_PIXELS * Density, 1.0f, MAX_FACTOR);
+        }
+
+        // fractional_even_spacing, the segments a level turns into
+        uint32_t Segments(float Level) {
+            return std::max(2u, 2 * uint32_t(std::ceil(Level * 0.5f)));
+        }
+
+        // Every patch of the chunk. Inner levels of n segments leave an (n - 2)^2 grid of
+        // quads inside, the ring around it stitches each outer edge to the inner one's.
+        // Vertices are the domain points, the least TES invocations it can take.
+        void Count(const Patch& Source, double& OutTriangles, double& OutVertices) {
+            constexpr uint32_t PATCHES = TerrainConfig::Tessellation::PATCHES;
+            for (uint32_t z = 0; z < PATCHES; z++) {
+                for (uint32_t x = 0; x < PATCHES; x++) {
+                    glm::vec2 Uv0 = glm::vec2(float(x), float(z)) / float(PATCHES);
+                    glm::vec2 Uv1 = glm::vec2(float(x + 1), float(z)) / float(PATCHES);
+                    glm::vec2 Uv2 = glm::vec2(float(x), float(z + 1)) / float(PATCHES);
+                    glm::vec2 Uv3 = glm::vec2(float(x + 1), float(z + 1)) / float(PATCHES);
+
+                    float Outer[4] = {
+                        EdgeFactor(Source, Uv0, Uv2),
+                        EdgeFactor(Source, Uv0, Uv1),
+                        EdgeFactor(Source, Uv1, Uv3),
+                        EdgeFactor(Source, Uv2, Uv3)
+                    };
+                    uint32_t Edges[4] = { Segments(Outer[0]), Segments(Outer[1]), Segments(Outer[2]), Segments(Outer[3]) };
+                    uint32_t Inner0 = Segments(std::max(Outer[1], Outer[3]));
+                    uint32_t Inner1 = Segments(std::max(Outer[0], Outer[2]));
+
+                    OutTriangles += 2.0 * (Inner0 - 2) * (Inner1 - 2)
+                        + (Edges[0] + Inner1 - 2) + (Edges[2] + Inner1 - 2)
+                        + (Edges[1] + Inner0 - 2) + (Edges[3] + Inner0 - 2);
+                    OutVertices += double(Inner0 - 1) * (Inner1 - 1) + Edges[0] + Edges[1] + Edges[2] + Edges[3];
+                }
+            }
+        }
+    };
+
+    struct LodCount {
+        double GridTriangles = 0.0;
+        double CdlodTriangles = 0.0;
+        double CdlodNodes = 0.0;
+        double SelectUs = 0.0;
+        double TessTriangles = 0.0;
+        double TessVertices = 0.0;
+
+        void Add(const LodCount& Other, double Weight) {
+            GridTriangles += Other.GridTriangles * Weight;
+            CdlodTriangles += Other.CdlodTriangles * Weight;
+            CdlodNodes += Other.CdlodNodes * Weight;
+            SelectUs += Other.SelectUs * Weight;
+            TessTriangles += Other.TessTriangles * Weight;
+            TessVertices += Other.TessVertices * Weight;
+        }
+    };
+
+    LodCount CountTriangles(const std::vector<ChunkHeightmapLink>& Links, const std::vector<uint16_t>& Layers,
+                            const FrustumCulling::Frustum& View, glm::vec3 Camera) {
+        constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+        constexpr float HEIGHT_SCALE = TerrainConfig::Chunk::HEIGHT_SCALE;
+        // TerrainRenderer's FocalPixels for LodView's 90 degrees
+        constexpr float FOCAL_PIXELS = LOD_VIEWPORT_HEIGHT * 0.5f;
+
+        // Grid and tessellation draw the same chunks, whichever are in view
+        LodCount Count;
+        for (const ChunkHeightmapLink& Link : Links) {
+            glm::vec3 Min = { Link.WorldPos.x * WORLD_SIZE, Link.MinHeight * HEIGHT_SCALE, Link.WorldPos.y * WORLD_SIZE };
+            glm::vec3 Max = { Min.x + WORLD_SIZE, Link.MaxHeight * HEIGHT_SCALE, Min.z + WORLD_SIZE };
+            if (!FrustumCulling::IsVisible(View, Min, Max)) {
+                continue;
+            }
+            Count.GridTriangles += GRID_TRIANGLES;
+
+            const uint16_t* Layer = Layers.data() + size_t(Link.InstanceId) * TerrainConfig::Heightmap::HEIGHTMAP_IMAGE_PIXEL_COUNT;
+            Tess::Count({ .Link = &Link, .Layer = Layer, .Camera = Camera, .FocalPixels = FOCAL_PIXELS },
+                        Count.TessTriangles, Count.TessVertices);
+        }
+
+        CdlodQuadtree::Selection Selection;
+        Clock::time_point Begin = Clock::now();
+        for (uint32_t i = 0; i < Links.size(); i++) {
+            CdlodQuadtree::SelectChunk(View, Camera, Links[i], i, Selection);
+        }
+        Count.SelectUs = SecondsSince(Begin) * 1e6;
+        Count.CdlodTriangles = Selection.TriangleCount();
+        Count.CdlodNodes = Selection.NodeCount();
+        return Count;
+    }
+
+    int RunLod() {
+        constexpr float WORLD_SIZE = TerrainConfig::Chunk::WORLD_SIZE;
+        std::vector<uint16_t> Layers;
+
+        // Nothing outside any plane, every chunk around the camera
+        FrustumCulling::Frustum Everything;
+        for (glm::vec4& Plane : Everything.Planes) {
+            Plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+
+        printf("%u triangles per grid chunk, CDLOD ranges", GRID_TRIANGLES);
+        for (uint32_t Lod = 0; Lod + 1 < TerrainConfig::Lod::LOD_COUNT; Lod++) {
+            printf(" %.0f", CdlodQuadtree::Range(Lod));
+        }
+        printf(" then whole chunks\n\n");
+
+        printf("%-7s %7s %9s | %-30s | %-30s | %9s\n", "", "", "", "all around (triangles)", "90 deg view (triangles, avg)", "");
+        printf("%-7s %7s %9s | %10s %10s %8s | %10s %10s %8s | %9s\n",
+               "radius", "chunks", "distance", "grid", "cdlod", "nodes", "grid", "cdlod", "nodes", "select us");
+
+        LodCount Shipping {};
+        std::vector<LodCount> Views;
+        for (int32_t Radius : LOD_RADII) {
+            std::vector<ChunkHeightmapLink> Links = DiamondLinks(Radius, Layers);
+            const ChunkHeightmapLink& Center = Links[Links.size() / 2];
+            glm::vec3 Camera = { WORLD_SIZE * 0.5f, Center.MaxHeight * TerrainConfig::Chunk::HEIGHT_SCALE + 2.0f, WORLD_SIZE * 0.5f };
+            float Far = float(Radius + 1) * WORLD_SIZE * 1.5f;
+
+            LodCount Around = CountTriangles(Links, Layers, Everything, Camera);
+            LodCount Viewed {};
+            for (uint32_t i = 0; i < LOD_YAWS; i++) {
+                Viewed.Add(CountTriangles(Links, Layers, LodView(Camera, float(i) * 6.2831853f / LOD_YAWS, Far), Camera), 1.0 / LOD_YAWS);
+            }
+            if (Shipping.GridTriangles == 0.0) {
+                Shipping = Viewed;
+            }
+            Views.push_back(Viewed);
+
+            printf("%-7d %7zu %9.0f | %10.0f %10.0f %8.0f | %10.0f %10.0f %8.0f | %9.1f\n",
+                   Radius, Links.size(), float(Radius) * WORLD_SIZE,
+                   Around.GridTriangles, Around.CdlodTriangles, Around.CdlodNodes,
+                   Viewed.GridTriangles, Viewed.CdlodTriangles, Viewed.CdlodNodes, Viewed.SelectUs);
+
+            if (Radius == LOD_RADII[std::size(LOD_RADII) - 1]) {
+                printf("\nCDLOD at radius %d draws %.2fx the triangles of the grid at radius %d (90 deg view)\n",
+                       Radius, Viewed.CdlodTriangles / Shipping.GridTriangles, LOD_RADII[0]);
+            }
+        }
+
+        // Vertices are what the vertex shader (grid) or the evaluation shader (tessellation)
+        // runs at least once for, the pipeline statistics of a capture count the real ones
+        printf("\nTessellation, edges aiming for %.0f px at %.0f px high (90 deg view, avg)\n",
+               TerrainConfig::Tessellation::EDGE_PIXELS, LOD_VIEWPORT_HEIGHT);
+        printf("%-7s | %10s %10s | %10s %10s | %9s %9s\n",
+               "radius", "grid tris", "grid verts", "tess tris", "tess verts", "tris", "verts");
+        for (size_t i = 0; i < Views.size(); i++) {
+            const LodCount& Viewed = Views[i];
+            double GridVertices = Viewed.GridTriangles / GRID_TRIANGLES * GRID_VERTICES;
+            printf("%-7d | %10.0f %10.0f | %10.0f %10.0f | %8.2fx %8.2fx\n",
+                   LOD_RADII[i], Viewed.GridTriangles, GridVertices, Viewed.TessTriangles, Viewed.TessVertices,
+                   Viewed.TessTriangles / Viewed.GridTriangles, Viewed.TessVertices / GridVertices);
+        }
+        return 0;
+    }
+};
@@ -0,0 +1,49 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Bench.hpp"
+
+struct Suite {
+    const char* Name;
+    const char* Description;
+    int (*Run)();
+};
+
+constexpr Suite SUITES[] = {
+    { "codec", "Heightmap codec ratio and encode/decode throughput", Bench::RunCodec },
+    { "noise", "Batched noise kernels against FastNoiseLite::GetNoise", Bench::RunNoise },
+    { "cull", "Chunk frustum culling, SIMD against one box at a time", Bench::RunCull },
+    { "indices", "Terrain index orders, ACMR and ATVR under FIFO and LRU caches", Bench::RunIndices },
+    { "heightfield", "Terrain raycasts, height and normal queries against every triangle", Bench::RunHeightfield },
+    { "lod", "Grid against CDLOD and tessellation triangle counts, shipping view distance and up to 10x", Bench::RunLod },
+};
+
+// InferusBench [suite...], every suite when none is given
+int main(int argc, char** argv) {
+    int Result = 0;
+    bool RanAny = false;
+
+    for (const Suite& Current : SUITES) {
+        bool Selected = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            Selected |= strcmp(argv[i], Current.Name) == 0;
+        }
+        if (!Selected) {
+            continue;
+        }
+
+        printf("== %s: %s\n", Current.Name, Current.Description);
+        Result |= Current.Run();
+        RanAny = true;
+        printf("\n");
+    }
+
+    if (!RanAny) {
+        printf("Unknown suite, available:\n");
+        for (const Suite& Current : SUITES) {
+            printf("  %-10s %s\n", Current.Name, Current.Description);
+        }
+        return 1;
+    }
+    return Result;
+}
@@ -0,0 +1,144 @@
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include <FastNoiseLite.hpp>
+
+#include "Bench.hpp"
+#include "Engine/Systems/Terrain/TerrainConfig.hpp"
+#include "Engine/Systems/Terrain/TerrainGenerator.hpp"
+#include "Engine/Systems/Terrain/Noise/BatchedNoise.hpp"
+
+namespace Bench {
+    // One chunk sized grid, plus a few columns so the scalar tail runs too
+    constexpr uint32_t NOISE_ROWS = TerrainConfig::Chunk::RESOLUTION;
+    constexpr uint32_t NOISE_COLS = TerrainConfig::Chunk::RESOLUTION + 3;
+    constexpr double NOISE_MIN_SECONDS = 0.3;
+
+    // The same settings through the runtime configured FastNoiseLite
+    FastNoiseLite ReferenceNoise(const BatchedNoise::Settings& Noise) {
+        constexpr FastNoiseLite::NoiseType NOISE_TYPES[] = {
+            FastNoiseLite::NoiseType_OpenSimplex2, FastNoiseLite::NoiseType_Perlin, FastNoiseLite::NoiseType_Value
+        };
+        constexpr FastNoiseLite::FractalType FRACTAL_TYPES[] = {
+            FastNoiseLite::FractalType_None, FastNoiseLite::FractalType_FBm, FastNoiseLite::FractalType_Ridged
+        };
+
+        FastNoiseLite Reference;
+        Reference.SetSeed(Noise.Seed);
+        Reference.SetFrequency(Noise.Frequency);
+        Reference.SetNoiseType(NOISE_TYPES[static_cast<uint8_t>(Noise.Kind)]);
+        Reference.SetFractalType(FRACTAL_TYPES[static_cast<uint8_t>(Noise.Fractal)]);
+        Reference.SetFractalOctaves(Noise.Octaves);
+        Reference.SetFractalLacunarity(Noise.Lacunarity);
+        Reference.SetFractalGain(Noise.Gain);
+        return Reference;
+    }
+
+    // GetNoise per sample, remapped and saturated like the batched kernels
+    void ReferenceGrid(const FastNoiseLite& Reference, const BatchedNoise::GridDesc& Grid, uint16_t* Out) {
+        for (uint32_t r = 0; r < Grid.Rows; r++) {
+            for (uint32_t c = 0; c < Grid.Cols; c++) {
+                float Noise = Reference.GetNoise(float(Grid.OriginX + int32_t(r)), float(Grid.OriginZ + int32_t(c)));
+                Out[r * Grid.Cols + c] = static_cast<uint16_t>(std::clamp((Noise + 1.0f) * 0.5f * 65535.0f, 0.0f, 65535.0f));
+            }
+        }
+    }
+
+    // Runs Pass on grids walking along X until NOISE_MIN_SECONDS went by, returns samples per second
+    template <typename Fn>
+    double SampleRate(Fn&& Pass) {
+        uint64_t Grids = 0;
+        Clock::time_point Begin = Clock::now();
+        double Elapsed = 0.0;
+        do {
+            BatchedNoise::GridDesc Grid = {
+                .OriginX = int32_t(Grids % 64) * int32_t(NOISE_ROWS),
+                .OriginZ = -int32_t(NOISE_COLS) / 2,
+                .Rows = NOISE_ROWS,
+                .Cols = NOISE_COLS
+            };
+            Pass(Grid);
+            Grids++;
+            Elapsed = SecondsSince(Begin);
+        } while (Elapsed < NOISE_MIN_SECONDS);
+
+        return double(Grids) * NOISE_ROWS * NOISE_COLS / Elapsed;
+    }
+
+    std::vector<BatchedNoise::Isa> SupportedIsas() {
+        std::vector<BatchedNoise::Isa> Isas;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(BatchedNoise::Isa::_ISA_COUNT_); i++) {
+            if (BatchedNoise::IsSupported(static_cast<BatchedNoise::Isa>(i))) {
+                Isas.push_back(static_cast<BatchedNoise::Isa>(i));
+            }
+        }
+        return Isas;
+    }
+
+    int RunNoise() {
+        const std::vector<BatchedNoise::Isa> Isas = SupportedIsas();
+        const BatchedNoise::Isa Best = BatchedNoise::DetectIsa();
+
+        std::vector<uint16_t> Expected(NOISE_ROWS * NOISE_COLS);
+        std::vector<uint16_t> Actual(NOISE_ROWS * NOISE_COLS);
+        int Result = 0;
+
+        printf("Grid %ux%u, %s, Msamples/s\n", NOISE_ROWS, NOISE_COLS, BatchedNoise::IsaName(Best));
+        printf("%-22s %10s %10s %8s\n", "", "GetNoise", "Batched", "Speedup");
+
+        for (uint8_t k = 0; k < static_cast<uint8_t>(BatchedNoise::NoiseKind::_NOISE_KIND_COUNT_); k++) {
+            for (uint8_t f = 0; f < static_cast<uint8_t>(BatchedNoise::FractalKind::_FRACTAL_KIND_COUNT_); f++) {
+                BatchedNoise::Settings Noise = TerrainGenerator::DefaultSettings();
+                Noise.Kind = static_cast<BatchedNoise::NoiseKind>(k);
+                Noise.Fractal = static_cast<BatchedNoise::FractalKind>(f);
+                FastNoiseLite Reference = ReferenceNoise(Noise);
+
+                // Exactness first, every Isa against GetNoise
+                BatchedNoise::GridDesc Probe = { .OriginX = -41, .OriginZ = -1000, .Rows = NOISE_ROWS, .Cols = NOISE_COLS };
+                ReferenceGrid(Reference, Probe, Expected.data());
+                for (BatchedNoise::Isa Target : Isas) {
+                    BatchedNoise::ForceIsa(Target);
+                    BatchedNoise::GenerateGrid(Noise, Probe, Actual.data());
+                    if (Actual != Expected) {
+                        printf("%s %s: %s doesn't match GetNoise\n",
+                            BatchedNoise::NoiseKindName(Noise.Kind), BatchedNoise::FractalKindName(Noise.Fractal),
+                            BatchedNoise::IsaName(Target));
+                        Result = 1;
+                    }
+                }
+
+                BatchedNoise::ForceIsa(Best);
+                double ReferenceRate = SampleRate([&](const BatchedNoise::GridDesc& Grid) {
+                    ReferenceGrid(Reference, Grid, Actual.data());
+                    DoNotOptimize(Actual[0]);
+                });
+                double BatchedRate = SampleRate([&](const BatchedNoise::GridDesc& Grid) {
+                    BatchedNoise::GenerateGrid(Noise, Grid, Actual.data());
+                    DoNotOptimize(Actual[0]);
+                });
+
+                char Name[32];
+                snprintf(Name, sizeof(Name), "%s %s", BatchedNoise::NoiseKindName(Noise.Kind), BatchedNoise::FractalKindName(Noise.Fractal));
+                printf("%-22s %10.1f %10.1f %7.1fx\n",
+                    Name, ReferenceRate / 1e6, BatchedRate / 1e6, BatchedRate / ReferenceRate);
+            }
+        }
+
+        // Production settings on every Isa
+        BatchedNoise::Settings Noise = TerrainGenerator::DefaultSettings();
+        printf("\n%s %s, %d octaves per Isa, Msamples/s\n",
+            BatchedNoise::NoiseKindName(Noise.Kind), BatchedNoise::FractalKindName(Noise.Fractal), Noise.Octaves);
+        for (BatchedNoise::Isa Target : Isas) {
+            BatchedNoise::ForceIsa(Target);
+            double Rate = SampleRate([&](const BatchedNoise::GridDesc& Grid) {
+                BatchedNoise::GenerateGrid(Noise, Grid, Actual.data());
+                DoNotOptimize(Actual[0]);
+            });
+            printf("%-8s %8.1f\n", BatchedNoise::IsaName(Target), Rate / 1e6);
+        }
+
+        BatchedNoise::ForceIsa(Best);
+        return Result;
+    }
+};
@@ -14,7 +14,7 @@ set_toolchains("clang")
 
 -- Custom rule for shader compilation
 rule("compile_shaders")
-    set_extensions(".vert", ".frag", ".comp")
+    set_extensions(".vert", ".frag", ".comp", ".tesc", ".tese")
     on_build_file(function (target, sourcefile, opt)
         import("core.project.depend")
         import("lib.detect.find_program")
@@ -63,6 +63,20 @@ rule("copy_assets")
         end, {files = sourcefile})
     end)
 
+-- Batched noise and its SIMD kernels, picked at runtime by BatchedNoise::DetectIsa
+-- No FMA contraction anywhere, a fused a*b+c rounds differently than FastNoiseLite's, and
+-- GCC (fast) and Clang (on) both contract by default, on aarch64 into fmadd/fmla
+NOISE_CXFLAGS = "-ffp-contract=off"
+function add_noise_files()
+    add_files("src/Engine/Systems/Terrain/Noise/*.cpp", {cxflags = NOISE_CXFLAGS})
+    if is_arch("x86_64", "x64", "i386", "x86") then
+        add_files("src/Engine/Systems/Terrain/Noise/Simd/BatchedNoise_SSE41.cpp", {cxflags = {NOISE_CXFLAGS, "-msse4.1"}})
+        add_files("src/Engine/Systems/Terrain/Noise/Simd/BatchedNoise_AVX2.cpp", {cxflags = {NOISE_CXFLAGS, "-mavx2"}})
+    elseif is_arch("arm64", "arm64-v8a", "aarch64") then
+        add_files("src/Engine/Systems/Terrain/Noise/Simd/BatchedNoise_NEON.cpp", {cxflags = NOISE_CXFLAGS})
+    end
+end
+
 target("InferusEngine")
     set_kind("binary")
     set_default()
@@ -79,10 +93,12 @@ target("InferusEngine")
     -- Treat third-party libs as system headers to suppress their warnings
     add_sysincludedirs("libs", "libs/vma", "libs/glm-1.0.2", "libs/spdlog/include", "libs/fnl", "libs/imgui", "libs/imgui/backends")
 
-    -- Add source files
-    add_files("src/**.cpp")
+    -- Add source files, the noise ones are added below with their own flags
+    add_files("src/**.cpp|Engine/Systems/Terrain/Noise/**.cpp")
     add_includedirs("src")
 
+    add_noise_files()
+
     -- Include directories and set defines
     add_includedirs("src", "libs", "libs/vma", "libs/glm-1.0.2", "libs/spdlog/include", "libs/fnl", "libs/imgui", "libs/imgui/backends")
 
@@ -143,11 +159,78 @@ target("InferusEngine")
 
     -- Add shader and asset files to trigger the custom rules
     -- At the end, to avoid glslc's "No such file or directory"
-    add_files("shaders/**.vert", "shaders/**.frag", "shaders/**.comp", {rule = "compile_shaders"})
+    add_files("shaders/**.vert", "shaders/**.frag", "shaders/**.comp", "shaders/**.tesc", "shaders/**.tese", {rule = "compile_shaders"})
     add_files("resources/**", {rule = "copy_assets"})
 
 target_end()
 
+-- Microbenchmarks for the engine's hot paths, "xmake run InferusBench [suite...]"
+target("InferusBench")
+    set_kind("binary")
+
+    -- Numbers only mean something optimized
+    set_symbols("debug")
+    set_optimize("fastest")
+
+    set_warnings("all", "extra")
+    add_cxflags("-Wpedantic")
+    add_cxflags("-Wshadow")
+
+    add_sysincludedirs("libs", "libs/glm-1.0.2", "libs/spdlog/include", "libs/fnl")
+    add_includedirs("src", "tools/Bench")
+
+    -- NoiseBench holds the FastNoiseLite reference, it has to round like the kernels
+    add_files("tools/Bench/*.cpp|NoiseBench.cpp")
+    add_files("tools/Bench/NoiseBench.cpp", {cxflags = NOISE_CXFLAGS})
+    add_files("src/Engine/Systems/Terrain/HeightmapCodec.cpp")
+    add_files("src/Engine/Systems/Terrain/FrustumCulling.cpp")
+    add_files("src/Engine/Systems/Terrain/TerrainGenerator.cpp")
+    add_files("src/Engine/Systems/Terrain/TerrainHeightfield.cpp")
+    add_files("src/Engine/Systems/Terrain/CdlodQuadtree.cpp")
+    add_noise_files()
+
+    add_defines("GLM_FORCE_RADIANS", "GLM_FORCE_LEFT_HANDED", "GLM_FORCE_DEPTH_ZERO_TO_ONE")
+
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+    set_targetdir("build/$(plat)/$(mode)")
+target_end()
+
+-- Headless world baker, no GLFW, Vulkan or ImGui so it runs on build servers
+-- "xmake run InferusBake --out world --rect -64 -64 64 64"
+target("InferusBake")
+    set_kind("binary")
+
+    set_symbols("debug")
+    set_optimize("fastest")
+
+    set_warnings("all", "extra")
+    add_cxflags("-Wpedantic")
+    add_cxflags("-Wshadow")
+
+    add_sysincludedirs("libs", "libs/glm-1.0.2", "libs/spdlog/include")
+    add_includedirs("src")
+
+    add_files("tools/Bake/*.cpp")
+    add_files("src/Utils/Process.cpp")
+    add_files("src/Utils/MappedFile.cpp")
+    add_files("src/Engine/Core/JobSystem.cpp")
+    add_files("src/Engine/Systems/Terrain/ChunkStore.cpp")
+    add_files("src/Engine/Systems/Terrain/HeightmapCodec.cpp")
+    add_files("src/Engine/Systems/Terrain/TerrainGenerator.cpp")
+    add_noise_files()
+
+    add_defines("GLM_FORCE_RADIANS", "GLM_FORCE_LEFT_HANDED", "GLM_FORCE_DEPTH_ZERO_TO_ONE")
+
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+    set_targetdir("build/$(plat)/$(mode)")
+target_end()
+
 -- Task to kick start rad debugger linked to project binary
 task("rad")
     set_menu({